@@ -21,6 +21,10 @@
 
 #include "sa.h"
 
+#ifdef SOURCE_SADC
+#include "om_stats.h"
+#endif
+
 #ifdef SOURCE_SAR
 #include "pr_stats.h"
 #endif
@@ -76,6 +80,7 @@ struct activity cpu_act = {
 	.f_count_index	= 0,	/* wrap_get_cpu_nr() */
 	.f_count2	= NULL,
 	.f_read		= wrap_read_stat_cpu,
+	.f_om_print	= om_print_cpu_stats,
 #endif
 #ifdef SOURCE_SAR
 	.f_print	= print_cpu_stats,
@@ -123,6 +128,7 @@ struct activity pcsw_act = {
 	.f_count_index	= -1,
 	.f_count2	= NULL,
 	.f_read		= wrap_read_stat_pcsw,
+	.f_om_print	= om_print_pcsw_stats,
 #endif
 #ifdef SOURCE_SAR
 	.f_print	= print_pcsw_stats,
@@ -354,6 +360,7 @@ struct activity memory_act = {
 	.f_count_index	= -1,
 	.f_count2	= NULL,
 	.f_read		= wrap_read_meminfo,
+	.f_om_print	= om_print_memory_stats,
 #endif
 #ifdef SOURCE_SAR
 	.f_print	= print_memory_stats,
@@ -447,6 +454,7 @@ struct activity queue_act = {
 	.f_count_index	= -1,
 	.f_count2	= NULL,
 	.f_read		= wrap_read_loadavg,
+	.f_om_print	= om_print_queue_stats,
 #endif
 #ifdef SOURCE_SAR
 	.f_print	= print_queue_stats,
@@ -533,12 +541,13 @@ struct activity serial_act = {
 struct activity disk_act = {
 	.id		= A_DISK,
 	.options	= AO_COUNTED + AO_GRAPH_PER_ITEM,
-	.magic		= ACTIVITY_MAGIC_BASE + 2,
+	.magic		= A_DISK_MAGIC,
 	.group		= G_DISK,
 #ifdef SOURCE_SADC
 	.f_count_index	= 3,	/* wrap_get_disk_nr() */
 	.f_count2	= NULL,
 	.f_read		= wrap_read_disk,
+	.f_om_print	= om_print_disk_stats,
 #endif
 #ifdef SOURCE_SAR
 	.f_print	= print_disk_stats,
@@ -585,6 +594,7 @@ struct activity net_dev_act = {
 	.f_count_index	= 4,	/* wrap_get_iface_nr() */
 	.f_count2	= NULL,
 	.f_read		= wrap_read_net_dev,
+	.f_om_print	= om_print_net_dev_stats,
 #endif
 #ifdef SOURCE_SAR
 	.f_print	= print_net_dev_stats,
@@ -0,0 +1,745 @@
+/*
+ * arrow_stats.c: Functions used by sadf to write statistics as an Apache
+ * Arrow IPC stream.
+ * (C) 2026 by agent (agent <at> local)
+ *
+ ***************************************************************************
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published  by  the *
+ * Free Software Foundation; either version 2 of the License, or (at  your *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it  will  be  useful,  but *
+ * WITHOUT ANY WARRANTY; without the implied warranty  of  MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License *
+ * for more details.                                                       *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA              *
+ ***************************************************************************
+ *
+ * Each line of statistics displayed by the rendering functions (see
+ * rndr_stats.c) becomes a row made of a timestamp, the hostname, the item
+ * (CPU, device, interface...) and one column per field. Rows are grouped
+ * into record batches of at most ARROW_BATCH_ROWS rows, written to standard
+ * output as one stream. All the rows of a stream share the same schema:
+ * This is why only one activity can be written at a time (most readers
+ * would silently ignore any stream following the first one).
+ *
+ * Stream metadata are flatbuffers. They are written here from front to
+ * back: An object is always located after the objects that reference it,
+ * and references (uoffset_t) are patched once the target has been written.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "sa.h"
+#include "rndr_stats.h"
+#include "arrow_stats.h"
+
+#ifdef USE_NLS
+#include <locale.h>
+#include <libintl.h>
+#define _(string) gettext(string)
+#else
+#define _(string) (string)
+#endif
+
+/* Types of flatbuffer table fields */
+#define FB_NONE	0	/* Absent field */
+#define FB_U8	1
+#define FB_I16	2
+#define FB_I32	3
+#define FB_I64	4
+#define FB_OFF	5	/* Offset to another object, patched later */
+
+/* Description of a field of a flatbuffer table */
+struct fb_slot {
+	int type;
+	unsigned long long val;
+	size_t pos;		/* Position of the field in the buffer (set when written) */
+};
+
+/* Stream being written (NULL until its schema has been written) */
+static struct arrow_stream stream;
+static struct arrow_stream *st = NULL;
+
+/* Fields of the line being rendered */
+static struct arrow_val *row = NULL;
+static int row_nr = 0, row_alloc = 0;
+static char row_item[ARROW_STR_LEN];
+
+/* Timestamp and hostname of current record */
+static unsigned long long rec_time = 0;
+static char rec_host[ARROW_STR_LEN];
+
+/* Buffer where metadata are encoded */
+static struct arrow_buf meta;
+
+/*
+ ***************************************************************************
+ * Append data to a buffer, enlarging it if needed.
+ *
+ * IN:
+ * @b		Buffer.
+ * @p		Data to append (zeros are appended if NULL).
+ * @n		Number of bytes to append.
+ *
+ * RETURNS:
+ * Position of appended data in buffer.
+ ***************************************************************************
+ */
+static size_t arrow_append(struct arrow_buf *b, const void *p, size_t n)
+{
+	size_t pos = b->len;
+
+	if (b->len + n > b->size) {
+		b->size = (b->size * 2 > b->len + n) ? b->size * 2 : b->len + n + 4096;
+		SREALLOC(b->buf, char, b->size);
+	}
+	if (p) {
+		memcpy(b->buf + pos, p, n);
+	}
+	else {
+		memset(b->buf + pos, 0, n);
+	}
+	b->len += n;
+
+	return pos;
+}
+
+/*
+ ***************************************************************************
+ * Append zeros to a buffer so that its length is a multiple of @align.
+ ***************************************************************************
+ */
+static void arrow_pad(struct arrow_buf *b, size_t align)
+{
+	if (b->len % align) {
+		arrow_append(b, NULL, align - b->len % align);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Write data to standard output. Exit if they cannot be written (e.g.
+ * when the filesystem is full) so that a truncated stream is not taken
+ * for a valid one.
+ *
+ * IN:
+ * @p		Data to write.
+ * @n		Number of bytes to write.
+ ***************************************************************************
+ */
+static void arrow_write(const void *p, size_t n)
+{
+	if (n && (fwrite(p, 1, n, stdout) != n)) {
+		perror("fwrite");
+		exit(4);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Write a scalar value in little-endian byte order (as all flatbuffer
+ * scalars are) at a given position in a buffer.
+ *
+ * IN:
+ * @b		Buffer.
+ * @pos		Position where the value is written.
+ * @val		Value.
+ * @size	Size of the value in bytes.
+ ***************************************************************************
+ */
+static void fb_set(struct arrow_buf *b, size_t pos, unsigned long long val, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++, val >>= 8) {
+		b->buf[pos + i] = (char) (val & 0xff);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Append a little-endian scalar value to a buffer.
+ *
+ * RETURNS:
+ * Position of the value in buffer.
+ ***************************************************************************
+ */
+static size_t fb_put(struct arrow_buf *b, unsigned long long val, int size)
+{
+	size_t pos = arrow_append(b, NULL, size);
+
+	fb_set(b, pos, val, size);
+
+	return pos;
+}
+
+/*
+ ***************************************************************************
+ * Make the offset located at @pos reference the object located at
+ * @target.
+ ***************************************************************************
+ */
+static void fb_patch(struct arrow_buf *b, size_t pos, size_t target)
+{
+	fb_set(b, pos, target - pos, 4);
+}
+
+/*
+ ***************************************************************************
+ * Write a flatbuffer table, preceded by its vtable. Fields are laid out
+ * by decreasing size so that each of them is naturally aligned.
+ *
+ * IN:
+ * @b		Buffer.
+ * @slots	Fields of the table, in vtable order.
+ * @nr		Number of fields.
+ *
+ * OUT:
+ * @slots	Position of each field in buffer.
+ *
+ * RETURNS:
+ * Position of the table in buffer.
+ ***************************************************************************
+ */
+static size_t fb_table(struct arrow_buf *b, struct fb_slot slots[], int nr)
+{
+	static const int fb_size[] = {0, 1, 2, 4, 8, 4};
+	int off[8], tsize = 4, i, s;
+	size_t vpos, tpos;
+
+	for (s = 8; s >= 1; s >>= 1) {
+		for (i = 0; i < nr; i++) {
+			if (fb_size[slots[i].type] == s) {
+				tsize = (tsize + s - 1) & ~(s - 1);
+				off[i] = tsize;
+				tsize += s;
+			}
+			else if (slots[i].type == FB_NONE) {
+				off[i] = 0;
+			}
+		}
+	}
+
+	/* vtable: Its size, size of the table, then offset of each field */
+	arrow_pad(b, 2);
+	vpos = fb_put(b, 4 + 2 * nr, 2);
+	fb_put(b, tsize, 2);
+	for (i = 0; i < nr; i++) {
+		fb_put(b, off[i], 2);
+	}
+
+	/* Table: Offset to its vtable, then fields */
+	arrow_pad(b, 8);
+	tpos = fb_put(b, 0, 4);
+	fb_set(b, tpos, tpos - vpos, 4);
+	arrow_append(b, NULL, tsize - 4);
+
+	for (i = 0; i < nr; i++) {
+		if (slots[i].type == FB_NONE)
+			continue;
+		slots[i].pos = tpos + off[i];
+		if (slots[i].type != FB_OFF) {
+			fb_set(b, slots[i].pos, slots[i].val, fb_size[slots[i].type]);
+		}
+	}
+
+	return tpos;
+}
+
+/*
+ ***************************************************************************
+ * Write a flatbuffer string.
+ *
+ * RETURNS:
+ * Position of the string in buffer.
+ ***************************************************************************
+ */
+static size_t fb_string(struct arrow_buf *b, const char *str)
+{
+	size_t pos, len = strlen(str);
+
+	arrow_pad(b, 4);
+	pos = fb_put(b, len, 4);
+	arrow_append(b, str, len + 1);
+
+	return pos;
+}
+
+/*
+ ***************************************************************************
+ * Write the header of a flatbuffer vector.
+ *
+ * IN:
+ * @b		Buffer.
+ * @nr		Number of elements.
+ * @align	Alignment of the elements (4 for offsets to tables, 8 for
+ *		structs made of 64-bit integers).
+ *
+ * RETURNS:
+ * Position of the vector in buffer. Elements start 4 bytes after it.
+ ***************************************************************************
+ */
+static size_t fb_vector(struct arrow_buf *b, int nr, int align)
+{
+	arrow_pad(b, 4);
+	if ((b->len + 4) % align) {
+		arrow_append(b, NULL, 4);
+	}
+
+	return fb_put(b, nr, 4);
+}
+
+/*
+ ***************************************************************************
+ * Write a message (its metadata being in @meta) to the stream. The body
+ * of the message, if any, is written afterwards by the caller.
+ ***************************************************************************
+ */
+static void arrow_write_message(void)
+{
+	char prefix[8];
+	struct arrow_buf p = {prefix, 0, sizeof(prefix)};
+
+	arrow_pad(&meta, 8);
+
+	/* Continuation indicator then metadata size */
+	fb_put(&p, 0xffffffff, 4);
+	fb_put(&p, meta.len, 4);
+	arrow_write(prefix, sizeof(prefix));
+	arrow_write(meta.buf, meta.len);
+}
+
+/*
+ ***************************************************************************
+ * Write a Message table to @meta.
+ *
+ * IN:
+ * @hdr_type	Type of message (schema or record batch).
+ * @body_len	Length of message body.
+ *
+ * RETURNS:
+ * Position of the offset to the message header (to be patched).
+ ***************************************************************************
+ */
+static size_t arrow_message_table(int hdr_type, unsigned long long body_len)
+{
+	struct fb_slot msg[] = {
+		{FB_I16, ARROW_METADATA_V5},	/* version */
+		{FB_U8, hdr_type},		/* header_type */
+		{FB_OFF, 0},			/* header */
+		{FB_I64, body_len}		/* bodyLength */
+	};
+	size_t root;
+
+	meta.len = 0;
+	root = fb_put(&meta, 0, 4);
+	fb_patch(&meta, root, fb_table(&meta, msg, 4));
+
+	return msg[2].pos;
+}
+
+/*
+ ***************************************************************************
+ * Write the schema of current stream.
+ ***************************************************************************
+ */
+static void arrow_write_schema(void)
+{
+	unsigned int one = 1;
+	struct fb_slot sch[] = {
+		{FB_I16, *((unsigned char *) &one) ? 0 : 1},	/* endianness */
+		{FB_OFF, 0}					/* fields */
+	};
+	struct fb_slot fld[] = {
+		{FB_OFF, 0},		/* name */
+		{FB_U8, 0},		/* nullable */
+		{FB_U8, 0},		/* type_type */
+		{FB_OFF, 0},		/* type */
+		{FB_NONE, 0},		/* dictionary */
+		{FB_OFF, 0}		/* children */
+	};
+	struct fb_slot typ[2];
+	size_t hdr, vec;
+	int i;
+
+	hdr = arrow_message_table(ARROW_HDR_SCHEMA, 0);
+	fb_patch(&meta, hdr, fb_table(&meta, sch, 2));
+	vec = fb_vector(&meta, st->cols_nr, 4);
+	fb_patch(&meta, sch[1].pos, vec);
+	for (i = 0; i < st->cols_nr; i++) {
+		fb_put(&meta, 0, 4);
+	}
+
+	for (i = 0; i < st->cols_nr; i++) {
+		fld[1].val = st->cols[i].nullable;
+
+		switch (st->cols[i].type) {
+		case ARROW_TIMESTAMP:
+			fld[2].val = ARROW_TYPE_TIMESTAMP;
+			typ[0].type = FB_I16;		/* unit */
+			typ[0].val = ARROW_UNIT_SECOND;
+			typ[1].type = FB_OFF;		/* timezone */
+			break;
+		case ARROW_FLOAT64:
+			fld[2].val = ARROW_TYPE_FLOAT;
+			typ[0].type = FB_I16;		/* precision */
+			typ[0].val = ARROW_PRECISION_DOUBLE;
+			typ[1].type = FB_NONE;
+			break;
+		case ARROW_UINT64:
+			fld[2].val = ARROW_TYPE_INT;
+			typ[0].type = FB_I32;		/* bitWidth */
+			typ[0].val = 64;
+			typ[1].type = FB_U8;		/* is_signed */
+			typ[1].val = 0;
+			break;
+		default:
+			fld[2].val = ARROW_TYPE_UTF8;
+			typ[0].type = typ[1].type = FB_NONE;
+		}
+
+		fb_patch(&meta, vec + 4 + 4 * i, fb_table(&meta, fld, 6));
+		fb_patch(&meta, fld[0].pos, fb_string(&meta, st->cols[i].name));
+		fb_patch(&meta, fld[3].pos, fb_table(&meta, typ, 2));
+		if (st->cols[i].type == ARROW_TIMESTAMP) {
+			fb_patch(&meta, typ[1].pos, fb_string(&meta, "UTC"));
+		}
+		/* Empty list of children */
+		fb_patch(&meta, fld[5].pos, fb_vector(&meta, 0, 4));
+	}
+
+	arrow_write_message();
+}
+
+/*
+ ***************************************************************************
+ * Write the rows collected so far as a record batch, then empty columns.
+ ***************************************************************************
+ */
+static void arrow_write_batch(void)
+{
+	struct fb_slot rb[] = {
+		{FB_I64, st->rows_nr},	/* length */
+		{FB_OFF, 0},		/* nodes */
+		{FB_OFF, 0}		/* buffers */
+	};
+	struct arrow_buf *bufs[3];
+	unsigned long long body_len = 0, len;
+	static const char zero[8];
+	size_t hdr, vec;
+	int i, j, n;
+
+	/* Compute body length: Buffers are padded to 8 bytes */
+	for (i = 0; i < st->cols_nr; i++) {
+		if (st->cols[i].null_count) {
+			body_len += (st->cols[i].validity.len + 7) & ~7;
+		}
+		body_len += (st->cols[i].offsets.len + 7) & ~7;
+		body_len += (st->cols[i].data.len + 7) & ~7;
+	}
+
+	hdr = arrow_message_table(ARROW_HDR_RECORD_BATCH, body_len);
+	fb_patch(&meta, hdr, fb_table(&meta, rb, 3));
+
+	/* Nodes: Length and null count of each column */
+	vec = fb_vector(&meta, st->cols_nr, 8);
+	fb_patch(&meta, rb[1].pos, vec);
+	for (i = 0; i < st->cols_nr; i++) {
+		fb_put(&meta, st->rows_nr, 8);
+		fb_put(&meta, st->cols[i].null_count, 8);
+	}
+
+	/*
+	 * Buffers: Offset in body and length of the validity bitmap, offsets
+	 * (strings only) and data of each column.
+	 */
+	for (i = n = 0; i < st->cols_nr; i++) {
+		n += (st->cols[i].type == ARROW_UTF8) ? 3 : 2;
+	}
+	vec = fb_vector(&meta, n, 8);
+	fb_patch(&meta, rb[2].pos, vec);
+	for (i = 0, body_len = 0; i < st->cols_nr; i++) {
+		bufs[0] = &st->cols[i].validity;
+		bufs[1] = &st->cols[i].offsets;
+		bufs[2] = &st->cols[i].data;
+		for (j = 0; j < 3; j++) {
+			if ((j == 1) && (st->cols[i].type != ARROW_UTF8))
+				continue;
+			len = ((j > 0) || st->cols[i].null_count) ? bufs[j]->len : 0;
+			fb_put(&meta, body_len, 8);
+			fb_put(&meta, len, 8);
+			body_len += (len + 7) & ~7;
+		}
+	}
+
+	arrow_write_message();
+
+	/* Body */
+	for (i = 0; i < st->cols_nr; i++) {
+		bufs[0] = &st->cols[i].validity;
+		bufs[1] = &st->cols[i].offsets;
+		bufs[2] = &st->cols[i].data;
+		for (j = 0; j < 3; j++) {
+			len = ((j > 0) || st->cols[i].null_count) ? bufs[j]->len : 0;
+			if (len) {
+				arrow_write(bufs[j]->buf, len);
+				arrow_write(zero, ((len + 7) & ~7) - len);
+			}
+			bufs[j]->len = 0;
+		}
+		st->cols[i].null_count = 0;
+		if (st->cols[i].type == ARROW_UTF8) {
+			/* First offset is always 0 */
+			arrow_append(&st->cols[i].offsets, NULL, sizeof(int32_t));
+		}
+	}
+	st->rows_nr = 0;
+}
+
+/*
+ ***************************************************************************
+ * Start the stream, whose columns are those of the line being rendered.
+ ***************************************************************************
+ */
+static void arrow_start_stream(void)
+{
+	static const char *fixed[] = {"timestamp", "hostname", "item"};
+	int i;
+
+	st = &stream;
+	memset(st, 0, sizeof(struct arrow_stream));
+
+	st->cols_nr = ARROW_COL_NR + row_nr;
+	SREALLOC(st->cols, struct arrow_col, sizeof(struct arrow_col) * st->cols_nr);
+	memset(st->cols, 0, sizeof(struct arrow_col) * st->cols_nr);
+
+	for (i = 0; i < st->cols_nr; i++) {
+		if (i < ARROW_COL_NR) {
+			strcpy(st->cols[i].name, fixed[i]);
+			st->cols[i].type = (i == ARROW_COL_TIME) ? ARROW_TIMESTAMP : ARROW_UTF8;
+		}
+		else {
+			strcpy(st->cols[i].name, row[i - ARROW_COL_NR].name);
+			st->cols[i].type = row[i - ARROW_COL_NR].type;
+		}
+		if (st->cols[i].type == ARROW_UTF8) {
+			arrow_append(&st->cols[i].offsets, NULL, sizeof(int32_t));
+		}
+	}
+	/* Item is null for activities with no items ("-") */
+	st->cols[ARROW_COL_ITEM].nullable = TRUE;
+
+	arrow_write_schema();
+}
+
+/*
+ ***************************************************************************
+ * Check if the fields of the line being rendered are the columns of the
+ * stream.
+ *
+ * RETURNS:
+ * TRUE if the line belongs to the stream.
+ ***************************************************************************
+ */
+static int arrow_row_matches(void)
+{
+	int i;
+
+	if (st->cols_nr != ARROW_COL_NR + row_nr)
+		return FALSE;
+
+	for (i = 0; i < row_nr; i++) {
+		if ((row[i].type != st->cols[ARROW_COL_NR + i].type) ||
+		    strcmp(row[i].name, st->cols[ARROW_COL_NR + i].name))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ ***************************************************************************
+ * Terminate the stream: Write its pending rows and end-of-stream marker.
+ ***************************************************************************
+ */
+void arrow_end_stream(void)
+{
+	int i;
+
+	if (st) {
+		if (st->rows_nr) {
+			arrow_write_batch();
+		}
+		meta.len = 0;
+		arrow_write_message();
+
+		for (i = 0; i < st->cols_nr; i++) {
+			free(st->cols[i].validity.buf);
+			free(st->cols[i].offsets.buf);
+			free(st->cols[i].data.buf);
+		}
+		free(st->cols);
+		st = NULL;
+	}
+
+	if (fflush(stdout)) {
+		perror("fflush");
+		exit(4);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Append a value to a column.
+ *
+ * IN:
+ * @c		Column.
+ * @val		Value (NULL for a null value).
+ ***************************************************************************
+ */
+static void arrow_put_value(struct arrow_col *c, struct arrow_val *val)
+{
+	int32_t off;
+
+	if (c->nullable) {
+		/* Validity bitmap: One bit per row, set if value is not null */
+		if (!(st->rows_nr % 8)) {
+			arrow_append(&c->validity, NULL, 1);
+		}
+		if (val) {
+			c->validity.buf[st->rows_nr / 8] |= 1 << (st->rows_nr % 8);
+		}
+		else {
+			c->null_count++;
+		}
+	}
+
+	switch (c->type) {
+	case ARROW_TIMESTAMP:
+	case ARROW_UINT64:
+		arrow_append(&c->data, val ? &val->ull : NULL, sizeof(val->ull));
+		break;
+	case ARROW_FLOAT64:
+		arrow_append(&c->data, val ? &val->dbl : NULL, sizeof(val->dbl));
+		break;
+	default:
+		if (val) {
+			arrow_append(&c->data, val->str, strlen(val->str));
+		}
+		off = (int32_t) c->data.len;
+		arrow_append(&c->offsets, &off, sizeof(off));
+	}
+}
+
+/*
+ ***************************************************************************
+ * Add the line which has just been rendered to current record batch. The
+ * stream is started with the first line.
+ ***************************************************************************
+ */
+static void arrow_add_row(void)
+{
+	struct arrow_val v;
+	int i;
+
+	if (!st) {
+		arrow_start_stream();
+	}
+	else if (!arrow_row_matches()) {
+		fprintf(stderr, _("Statistics with different fields cannot be written to the same Arrow stream\n"));
+		exit(1);
+	}
+
+	v.ull = rec_time;
+	arrow_put_value(&st->cols[ARROW_COL_TIME], &v);
+	strcpy(v.str, rec_host);
+	arrow_put_value(&st->cols[ARROW_COL_HOST], &v);
+	strcpy(v.str, row_item);
+	arrow_put_value(&st->cols[ARROW_COL_ITEM], strcmp(row_item, "-") ? &v : NULL);
+
+	for (i = 0; i < row_nr; i++) {
+		arrow_put_value(&st->cols[ARROW_COL_NR + i], &row[i]);
+	}
+
+	if (++st->rows_nr >= ARROW_BATCH_ROWS) {
+		arrow_write_batch();
+	}
+}
+
+/*
+ ***************************************************************************
+ * Save timestamp and hostname of the record whose statistics are going
+ * to be rendered.
+ *
+ * IN:
+ * @ust_time	Record timestamp (number of seconds since the epoch).
+ * @host	Hostname of the host where the file was created.
+ ***************************************************************************
+ */
+void arrow_set_record(unsigned long long ust_time, char *host)
+{
+	rec_time = ust_time;
+	strncpy(rec_host, host, sizeof(rec_host));
+	rec_host[sizeof(rec_host) - 1] = '\0';
+}
+
+/*
+ ***************************************************************************
+ * Save the value of a field of the line being rendered. The line is added
+ * to current record batch when its last field has been rendered.
+ *
+ * IN:
+ * @item	Item name ("-" if not applicable).
+ * @field	Field name.
+ * @rflags	PT_.... rendering flags.
+ * @lluval	Integer value (used if PT_USEINT is set).
+ * @dval	Double value (used unless PT_USEINT or PT_USESTR is set).
+ * @sval	String value (used if PT_USESTR is set).
+ ***************************************************************************
+ */
+void arrow_add_value(char *item, char *field, int rflags, unsigned long long lluval,
+		     double dval, char *sval)
+{
+	struct arrow_val *v;
+
+	if (row_nr == row_alloc) {
+		row_alloc += 16;
+		SREALLOC(row, struct arrow_val, sizeof(struct arrow_val) * row_alloc);
+	}
+	if (!row_nr) {
+		strncpy(row_item, item, sizeof(row_item));
+		row_item[sizeof(row_item) - 1] = '\0';
+	}
+
+	v = &row[row_nr++];
+	strncpy(v->name, field, sizeof(v->name));
+	v->name[sizeof(v->name) - 1] = '\0';
+
+	if (rflags & PT_USEINT) {
+		v->type = ARROW_UINT64;
+		v->ull = lluval;
+	}
+	else if (rflags & PT_USESTR) {
+		v->type = ARROW_UTF8;
+		strncpy(v->str, sval, sizeof(v->str));
+		v->str[sizeof(v->str) - 1] = '\0';
+	}
+	else {
+		v->type = ARROW_FLOAT64;
+		v->dbl = dval;
+	}
+
+	if (rflags & PT_NEWLIN) {
+		/* Last field of the line */
+		arrow_add_row();
+		row_nr = 0;
+	}
+}
@@ -0,0 +1,95 @@
+/*
+ * arrow_stats.h: Include file used by sadf to write statistics as an
+ * Apache Arrow IPC stream.
+ * (C) 2026 by agent (agent <at> local)
+ */
+
+#ifndef _ARROW_STATS_H
+#define _ARROW_STATS_H
+
+#include "common.h"
+
+/*
+ ***************************************************************************
+ * Definitions for Arrow IPC stream output.
+ ***************************************************************************
+ */
+
+/* Max number of rows in a record batch */
+#define ARROW_BATCH_ROWS	8192
+
+/* Max length of column names and string values */
+#define ARROW_STR_LEN		256
+
+/* Column types */
+#define ARROW_TIMESTAMP	0	/* Timestamp (seconds since the epoch, UTC) */
+#define ARROW_FLOAT64	1
+#define ARROW_UINT64	2
+#define ARROW_UTF8	3
+
+/* Fixed columns, followed by one column per field */
+#define ARROW_COL_TIME	0
+#define ARROW_COL_HOST	1
+#define ARROW_COL_ITEM	2
+#define ARROW_COL_NR	3
+
+/* Values used in Arrow flatbuffers metadata (see Schema.fbs and Message.fbs) */
+#define ARROW_METADATA_V5	4
+#define ARROW_HDR_SCHEMA	1
+#define ARROW_HDR_RECORD_BATCH	3
+#define ARROW_TYPE_INT		2
+#define ARROW_TYPE_FLOAT	3
+#define ARROW_TYPE_UTF8		5
+#define ARROW_TYPE_TIMESTAMP	10
+#define ARROW_PRECISION_DOUBLE	2
+#define ARROW_UNIT_SECOND	0
+
+/* Growable buffer */
+struct arrow_buf {
+	char *buf;
+	size_t len;
+	size_t size;
+};
+
+/* Column of the current record batch */
+struct arrow_col {
+	char name[ARROW_STR_LEN];
+	int type;
+	int nullable;
+	unsigned long long null_count;
+	struct arrow_buf validity;	/* Validity bitmap (nullable columns only) */
+	struct arrow_buf offsets;	/* Offsets in @data (ARROW_UTF8 columns only) */
+	struct arrow_buf data;
+};
+
+/* Stream of rows sharing the same columns */
+struct arrow_stream {
+	struct arrow_col *cols;
+	int cols_nr;
+	/* Number of rows in current record batch */
+	unsigned long long rows_nr;
+};
+
+/* Value of a field in the line being rendered */
+struct arrow_val {
+	char name[ARROW_STR_LEN];
+	int type;
+	unsigned long long ull;
+	double dbl;
+	char str[ARROW_STR_LEN];
+};
+
+/*
+ ***************************************************************************
+ * Prototypes for functions used to write statistics in Arrow format.
+ ***************************************************************************
+ */
+
+void arrow_set_record
+	(unsigned long long, char *);
+void arrow_add_value
+	(char *, char *, int, unsigned long long, double, char *);
+void arrow_end_stream
+	(void);
+
+#endif /* _ARROW_STATS_H */
@@ -25,6 +25,8 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <regex.h>
 #include <sys/utsname.h>
 #include <ctype.h>
 
@@ -52,6 +54,15 @@ void int_handler(int n) { return; }
 
 unsigned long long uptime_cs[2] = {0, 0};
 struct io_cifs *cifs_list = NULL;
+struct io_cifs *cifs_hash[CIFS_HASH_SIZE];
+int cifs_list_sorted = TRUE;	/* FALSE if filesystems have been added to the list */
+
+/* CIFSSTATS file is kept open between samples and read into a reusable buffer */
+int cifs_fd = -1;
+char *cifs_buf = NULL;
+size_t cifs_buf_size = 0;
+
+regex_t mountregex;	/* Compiled --mount string */
 
 int cpu_nr = 0;		/* Nb of processors on the machine */
 int flags = 0;		/* Flag for common options and system state */
@@ -78,10 +89,12 @@ void usage(char *progname)
 #ifdef DEBUG
 	fprintf(stderr, _("Options are:\n"
 			  "[ --dec={ 0 | 1 | 2 } ] [ --human ] [ --pretty ]\n"
+			  "[ --mount=<regex> ]\n"
 			  "[ -h ] [ -k | -m ] [ -t ] [ -V ] [ --debuginfo ]\n"));
 #else
 	fprintf(stderr, _("Options are:\n"
 			  "[ --dec={ 0 | 1 | 2 } ] [ --human ] [ --pretty ]\n"
+			  "[ --mount=<regex> ]\n"
 			  "[ -h ] [ -k | -m ] [ -t ] [ -V ]\n"));
 #endif
 	exit(1);
@@ -118,7 +131,33 @@ void set_cifs_nonexistent(struct io_cifs *clist)
 
 /*
  ***************************************************************************
- * Check if a cifs filesystem is present in the list, and add it if requested.
+ * Compute hash value of a cifs name.
+ *
+ * IN:
+ * @name	cifs name.
+ *
+ * RETURNS:
+ * Hash value, between 0 and CIFS_HASH_SIZE - 1.
+ ***************************************************************************
+ */
+unsigned int cifs_hash_name(char *name)
+{
+	unsigned int h = 5381;
+
+	while (*name) {
+		h = ((h << 5) + h) + (unsigned char) *name++;
+	}
+
+	return (h % CIFS_HASH_SIZE);
+}
+
+/*
+ ***************************************************************************
+ * Find a cifs filesystem using the hash table, and add it if not found.
+ * New filesystems are inserted at the beginning of the list, which will
+ * have to be sorted again (see sort_cifs_list()). Filesystems not matching
+ * the string entered with option --mount are kept in the hash table only
+ * so that the regex is not evaluated again at next sample.
  *
  * IN:
  * @clist	Address of pointer on the start of the linked list.
@@ -127,49 +166,48 @@ void set_cifs_nonexistent(struct io_cifs *clist)
  * RETURNS:
  * Pointer on the io_cifs structure in the list where the cifs is located
  * (whether it was already in the list or if it has been added).
- * NULL if the cifs name is too long or if the cifs doesn't exist and we
- * don't want to add it.
+ * NULL if the cifs name is too long or if it has been excluded.
  ***************************************************************************
  */
 struct io_cifs *add_list_cifs(struct io_cifs **clist, char *name)
 {
-	struct io_cifs *c, *cs;
+	struct io_cifs *c;
+	unsigned int h;
 	int i;
 
 	if (strnlen(name, MAX_NAME_LEN) == MAX_NAME_LEN)
 		/* cifs name is too long */
 		return NULL;
 
-	while (*clist != NULL) {
-		c = *clist;
-		if ((i = strcmp(c->name, name)) == 0) {
-			/* cifs found in list */
+	h = cifs_hash_name(name);
+	for (c = cifs_hash[h]; c != NULL; c = c->hnext) {
+		if (!strcmp(c->name, name)) {
+			/* cifs found */
+			if (c->excluded)
+				return NULL;
 			c->exist = TRUE;
 			return c;
 		}
-		if (i > 0)
-			/*
-			 * If no group defined and we don't use /proc/diskstats,
-			 * insert current device in alphabetical order.
-			 * NB: Using /proc/diskstats ("iostat -p ALL") is a bit better than
-			 * using alphabetical order because sda10 comes after sda9...
-			 */
-			break;
-
-		clist = &(c->next);
 	}
 
-	/* cifs not found */
-	cs = *clist;
-
-	/* Add cifs to the list */
-	if ((*clist = (struct io_cifs *) malloc(IO_CIFS_SIZE)) == NULL) {
+	/* cifs not found: Add it to the hash table */
+	if ((c = (struct io_cifs *) malloc(IO_CIFS_SIZE)) == NULL) {
 		perror("malloc");
 		exit(4);
 	}
-	memset(*clist, 0, IO_CIFS_SIZE);
+	memset(c, 0, IO_CIFS_SIZE);
+
+	strncpy(c->name, name, sizeof(c->name));
+	c->name[sizeof(c->name) - 1] = '\0';
+	c->hnext = cifs_hash[h];
+	cifs_hash[h] = c;
+
+	if (USE_MOUNT_FILTER(flags) && regexec(&mountregex, name, 0, NULL, 0)) {
+		/* cifs name doesn't match string entered on the command line */
+		c->excluded = TRUE;
+		return NULL;
+	}
 
-	c = *clist;
 	for (i = 0; i < 2; i++) {
 		if ((c->cifs_stats[i] = (struct cifs_st *) malloc(CIFS_ST_SIZE)) == NULL) {
 			perror("malloc");
@@ -177,17 +215,194 @@ struct io_cifs *add_list_cifs(struct io_cifs **clist, char *name)
 		}
 		memset(c->cifs_stats[i], 0, CIFS_ST_SIZE);
 	}
-	strncpy(c->name, name, sizeof(c->name));
-	c->name[sizeof(c->name) - 1] = '\0';
 	c->exist = TRUE;
-	c->next = cs;
+
+	/* Add cifs to the list */
+	c->next = *clist;
+	*clist = c;
+	cifs_list_sorted = FALSE;
 
 	return c;
 }
 
+/*
+ ***************************************************************************
+ * Compare two cifs filesystems by name (used by qsort).
+ *
+ * IN:
+ * @a	Pointer on first io_cifs structure pointer.
+ * @b	Pointer on second io_cifs structure pointer.
+ *
+ * RETURNS:
+ * Result of the comparison of the two names.
+ ***************************************************************************
+ */
+int cmp_cifs_name(const void *a, const void *b)
+{
+	return strcmp((*(struct io_cifs **) a)->name, (*(struct io_cifs **) b)->name);
+}
+
+/*
+ ***************************************************************************
+ * Sort the list of cifs filesystems in alphabetical order.
+ *
+ * IN:
+ * @clist	Address of pointer on the start of the linked list.
+ ***************************************************************************
+ */
+void sort_cifs_list(struct io_cifs **clist)
+{
+	struct io_cifs *c, **carray;
+	int i, nr = 0;
+
+	for (c = *clist; c != NULL; c = c->next) {
+		nr++;
+	}
+	if (nr < 2)
+		return;
+
+	if ((carray = (struct io_cifs **) malloc(sizeof(struct io_cifs *) * nr)) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	for (c = *clist, i = 0; c != NULL; c = c->next, i++) {
+		carray[i] = c;
+	}
+
+	qsort(carray, nr, sizeof(struct io_cifs *), cmp_cifs_name);
+
+	for (i = 0; i < nr - 1; i++) {
+		carray[i]->next = carray[i + 1];
+	}
+	carray[nr - 1]->next = NULL;
+	*clist = carray[0];
+
+	free(carray);
+}
+
+/*
+ ***************************************************************************
+ * Free all the cifs entries. The hash table is walked instead of the
+ * linked list so that filesystems excluded with option --mount are also
+ * freed.
+ ***************************************************************************
+ */
+void free_cifs_list(void)
+{
+	struct io_cifs *c, *cnext;
+	int h, i;
+
+	for (h = 0; h < CIFS_HASH_SIZE; h++) {
+		for (c = cifs_hash[h]; c != NULL; c = cnext) {
+			cnext = c->hnext;
+			for (i = 0; i < 2; i++) {
+				free(c->cifs_stats[i]);
+			}
+			free(c);
+		}
+		cifs_hash[h] = NULL;
+	}
+	cifs_list = NULL;
+
+	free(cifs_buf);
+	cifs_buf = NULL;
+	cifs_buf_size = 0;
+}
+
+/*
+ ***************************************************************************
+ * Read the whole contents of CIFSSTATS file. The file is kept open between
+ * samples and read again from its beginning into a reusable buffer.
+ *
+ * RETURNS:
+ * 0 on success, -1 if file couldn't be read.
+ ***************************************************************************
+ */
+int read_cifs_file(void)
+{
+	size_t len = 0;
+	ssize_t n;
+
+	if ((cifs_fd < 0) && ((cifs_fd = open(CIFSSTATS, O_RDONLY)) < 0))
+		return -1;
+
+	if (!cifs_buf_size) {
+		cifs_buf_size = CIFS_BUF_SIZE;
+		SREALLOC(cifs_buf, char, cifs_buf_size);
+	}
+
+	while ((n = pread(cifs_fd, cifs_buf + len, cifs_buf_size - len - 1, len)) > 0) {
+		len += n;
+		if (len == cifs_buf_size - 1) {
+			cifs_buf_size *= 2;
+			SREALLOC(cifs_buf, char, cifs_buf_size);
+		}
+	}
+	cifs_buf[len] = '\0';
+
+#ifdef TEST
+	/* tests/root link changes between samples: Open file again next time */
+	close(cifs_fd);
+	cifs_fd = -1;
+#endif
+
+	if (n < 0) {
+		close(cifs_fd);
+		cifs_fd = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Match a label then read the number following it. Spaces in the label
+ * match any number of whitespace characters (including none), like with
+ * scanf().
+ *
+ * IN:
+ * @p		Current position in the line.
+ * @label	Label to match.
+ *
+ * OUT:
+ * @p		Position following the number read.
+ * @val	Number read.
+ *
+ * RETURNS:
+ * TRUE if the label has been matched and a number has been read.
+ ***************************************************************************
+ */
+int scan_cifs_value(char **p, const char *label, unsigned long long *val)
+{
+	char *s = *p, *e;
+
+	while (isspace((unsigned char) *s)) {
+		s++;
+	}
+	for (; *label; label++) {
+		if (*label == ' ') {
+			while (isspace((unsigned char) *s)) {
+				s++;
+			}
+		}
+		else if (*s++ != *label)
+			return FALSE;
+	}
+
+	*val = strtoull(s, &e, 10);
+	if (e == s)
+		return FALSE;
+
+	*p = e;
+	return TRUE;
+}
+
 /*
  ***************************************************************************
  * Read CIFS-mount directories stats from /proc/fs/cifs/Stats.
+ * The file is parsed in a single pass. Lines belonging to filesystems
+ * excluded with option --mount are skipped.
  *
  * IN:
  * @curr	Index in array for current sample statistics.
@@ -195,94 +410,111 @@ struct io_cifs *add_list_cifs(struct io_cifs **clist, char *name)
  */
 void read_cifs_stat(int curr)
 {
-	FILE *fp;
-	char line[256];
-	char aux[32];
-	int start = 0;
-	long long unsigned aux_open;
-	long long unsigned all_open = 0;
+	char *line, *eol, *p;
+	size_t len;
+	unsigned long long aux_open, v;
+	unsigned long long all_open = 0;
 	char cifs_name[MAX_NAME_LEN];
-	char name_tmp[MAX_NAME_LEN];
 	struct cifs_st scifs;
-	struct io_cifs *ci;
+	struct io_cifs *ci = NULL;
 
-	if ((fp = fopen(CIFSSTATS, "r")) == NULL)
+	if (read_cifs_file() < 0)
 		return;
 
-	sprintf(aux, "%%*d) %%%ds",
-		MAX_NAME_LEN < 200 ? MAX_NAME_LEN - 1 : 200);
-
 	memset(&scifs, 0, CIFS_ST_SIZE);
 
-	while (fgets(line, sizeof(line), fp) != NULL) {
+	for (line = cifs_buf; *line; line = eol) {
 
-		/* Read CIFS directory name */
-		if (isdigit((unsigned char) line[0]) && sscanf(line, aux , name_tmp) == 1) {
-			if (start) {
-				scifs.fopens = all_open;
-				ci = add_list_cifs(&cifs_list, cifs_name);
-				if (ci != NULL) {
-					*ci->cifs_stats[curr] = scifs;
-				}
-				all_open = 0;
-			}
-			else {
-				start = 1;
-			}
-			strncpy(cifs_name, name_tmp, sizeof(cifs_name));
-			cifs_name[sizeof(cifs_name) - 1] = '\0';
-			memset(&scifs, 0, CIFS_ST_SIZE);
+		if ((eol = strchr(line, '\n')) != NULL) {
+			*eol++ = '\0';
 		}
 		else {
-			if (!strncmp(line, "Reads:", 6)) {
-				/*
-				 * SMB1 format: Reads: %llu Bytes: %llu
-				 * SMB2 format: Reads: %llu sent %llu failed
-				 * If this is SMB2 format then only the first variable (rd_ops) will be set.
-				 */
-				sscanf(line, "Reads: %llu Bytes: %llu", &scifs.rd_ops, &scifs.rd_bytes);
-			}
-			else if (!strncmp(line, "Bytes read:", 11)) {
-				sscanf(line, "Bytes read: %llu  Bytes written: %llu",
-				       &scifs.rd_bytes, &scifs.wr_bytes);
-			}
-			else if (!strncmp(line, "Writes:", 7)) {
-				/*
-				 * SMB1 format: Writes: %llu Bytes: %llu
-				 * SMB2 format: Writes: %llu sent %llu failed
-				 * If this is SMB2 format then only the first variable (wr_ops) will be set.
-				 */
-				sscanf(line, "Writes: %llu Bytes: %llu", &scifs.wr_ops, &scifs.wr_bytes);
-			}
-			else if (!strncmp(line, "Opens:", 6)) {
-				sscanf(line, "Opens: %llu Closes:%llu Deletes: %llu",
-				       &aux_open, &scifs.fcloses, &scifs.fdeletes);
-				all_open += aux_open;
-			}
-			else if (!strncmp(line, "Posix Opens:", 12)) {
-				sscanf(line, "Posix Opens: %llu", &aux_open);
-				all_open += aux_open;
+			eol = line + strlen(line);
+		}
+
+		/* Read CIFS directory name ("%d) name") */
+		if (isdigit((unsigned char) line[0])) {
+			for (p = line; isdigit((unsigned char) *p); p++);
+			if (*p == ')') {
+				for (p++; isspace((unsigned char) *p); p++);
+				len = strcspn(p, " \t\r\v\f");
+				if (len) {
+					if (ci != NULL) {
+						/* Save stats of previous filesystem */
+						scifs.fopens = all_open;
+						*ci->cifs_stats[curr] = scifs;
+					}
+					all_open = 0;
+					memset(&scifs, 0, CIFS_ST_SIZE);
+
+					if (len > MAX_NAME_LEN - 1) {
+						len = MAX_NAME_LEN - 1;
+					}
+					memcpy(cifs_name, p, len);
+					cifs_name[len] = '\0';
+
+					/*
+					 * Don't parse statistics of unwanted filesystems
+					 * (ci is NULL).
+					 */
+					ci = add_list_cifs(&cifs_list, cifs_name);
+					continue;
+				}
 			}
-			else if (!strncmp(line, "Open files:", 11)) {
-				sscanf(line, "Open files: %llu total (local), %llu",
-				       &all_open, &aux_open);
-				all_open += aux_open;
+		}
+
+		if (ci == NULL)
+			continue;
+
+		p = line;
+		if (scan_cifs_value(&p, "Reads:", &scifs.rd_ops)) {
+			/*
+			 * SMB1 format: Reads: %llu Bytes: %llu
+			 * SMB2 format: Reads: %llu sent %llu failed
+			 * If this is SMB2 format then only the first variable (rd_ops) will be set.
+			 */
+			scan_cifs_value(&p, "Bytes:", &scifs.rd_bytes);
+		}
+		else if (scan_cifs_value(&p, "Bytes read:", &scifs.rd_bytes)) {
+			scan_cifs_value(&p, "Bytes written:", &scifs.wr_bytes);
+		}
+		else if (scan_cifs_value(&p, "Writes:", &scifs.wr_ops)) {
+			/*
+			 * SMB1 format: Writes: %llu Bytes: %llu
+			 * SMB2 format: Writes: %llu sent %llu failed
+			 * If this is SMB2 format then only the first variable (wr_ops) will be set.
+			 */
+			scan_cifs_value(&p, "Bytes:", &scifs.wr_bytes);
+		}
+		else if (scan_cifs_value(&p, "Opens:", &aux_open)) {
+			all_open += aux_open;
+			if (scan_cifs_value(&p, "Closes:", &scifs.fcloses)) {
+				scan_cifs_value(&p, "Deletes:", &scifs.fdeletes);
 			}
-			else if (!strncmp(line, "Closes:", 7)) {
-				sscanf(line, "Closes: %llu", &scifs.fcloses);
+		}
+		else if (scan_cifs_value(&p, "Posix Opens:", &aux_open)) {
+			all_open += aux_open;
+		}
+		else if (scan_cifs_value(&p, "Open files:", &all_open)) {
+			if (scan_cifs_value(&p, "total (local),", &v)) {
+				all_open += v;
 			}
 		}
+		else {
+			scan_cifs_value(&p, "Closes:", &scifs.fcloses);
+		}
 	}
 
-	if (start) {
+	if (ci != NULL) {
 		scifs.fopens = all_open;
-		ci = add_list_cifs(&cifs_list, cifs_name);
-		if (ci != NULL) {
-			*ci->cifs_stats[curr] = scifs;
-		}
+		*ci->cifs_stats[curr] = scifs;
 	}
 
-	fclose(fp);
+	if (!cifs_list_sorted) {
+		/* New filesystems have been found */
+		sort_cifs_list(&cifs_list);
+		cifs_list_sorted = TRUE;
+	}
 }
 
 /*
@@ -520,6 +752,16 @@ int main(int argc, char **argv)
 			opt++;
 		}
 
+		else if (!strncmp(argv[opt], "--mount=", 8)) {
+			/* Display only filesystems matching the regex */
+			if (USE_MOUNT_FILTER(flags) || !argv[opt][8] ||
+			    regcomp(&mountregex, argv[opt] + 8, REG_EXTENDED | REG_NOSUB)) {
+				usage(argv[0]);
+			}
+			flags |= I_D_MOUNT_FILTER;
+			opt++;
+		}
+
 		else if (!strncmp(argv[opt], "--dec=", 6) && (strlen(argv[opt]) == 7)) {
 			/* Get number of decimal places */
 			dplaces_nr = atoi(argv[opt] + 6);
@@ -621,5 +863,12 @@ int main(int argc, char **argv)
 	/* Main loop */
 	rw_io_stat_loop(count, &rectime);
 
+	/* Free structures */
+	free_cifs_list();
+
+	if (USE_MOUNT_FILTER(flags)) {
+		regfree(&mountregex);
+	}
+
 	return 0;
 }
@@ -19,6 +19,7 @@
 #define I_D_PRETTY		0x010
 #define I_D_DEBUG		0x020
 #define I_D_UNIT		0x040
+#define I_D_MOUNT_FILTER	0x080
 
 #define DISPLAY_TIMESTAMP(m)	(((m) & I_D_TIMESTAMP) == I_D_TIMESTAMP)
 #define DISPLAY_KILOBYTES(m)	(((m) & I_D_KILOBYTES) == I_D_KILOBYTES)
@@ -27,6 +28,13 @@
 #define DISPLAY_PRETTY(m)	(((m) & I_D_PRETTY)    == I_D_PRETTY)
 #define DISPLAY_DEBUG(m)	(((m) & I_D_DEBUG)     == I_D_DEBUG)
 #define DISPLAY_UNIT(m)		(((m) & I_D_UNIT)      == I_D_UNIT)
+#define USE_MOUNT_FILTER(m)	(((m) & I_D_MOUNT_FILTER) == I_D_MOUNT_FILTER)
+
+/* Size of the hash table used to find CIFS filesystems by name */
+#define CIFS_HASH_SIZE		1024
+
+/* Initial size of the buffer used to read CIFSSTATS file */
+#define CIFS_BUF_SIZE		8192
 
 struct cifs_st {
 	unsigned long long rd_bytes     __attribute__ ((aligned (8)));
@@ -43,8 +51,14 @@ struct cifs_st {
 struct io_cifs {
 	char name[MAX_NAME_LEN];
 	int exist;
+	/* TRUE if filesystem has been excluded by option --mount */
+	int excluded;
+	/* Statistics (not allocated for excluded filesystems) */
 	struct cifs_st *cifs_stats[2];
+	/* Next filesystem in alphabetical order */
 	struct io_cifs *next;
+	/* Next filesystem with same hash value */
+	struct io_cifs *hnext;
 };
 
 #define IO_CIFS_SIZE	(sizeof(struct io_cifs))
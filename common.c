@@ -33,6 +33,8 @@
 #include <ctype.h>
 #include <limits.h>
 #include <libgen.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
 
 #include "version.h"
 #include "common.h"
@@ -70,6 +72,11 @@ char sc_normal[MAX_SGR_LEN] = C_NORMAL;
 /* Type of persistent device names used in sar and iostat */
 char persistent_name_type[MAX_FILE_LEN];
 
+#ifndef SOURCE_SADC
+/* Device name cache */
+struct dev_name_cache dn_cache = {.ifd = DN_NO_FD};
+#endif
+
 /*
  ***************************************************************************
  * Print sysstat version number and exit.
@@ -431,6 +438,52 @@ int check_dir(char *dirname)
 	return 0;
 }
 
+/*
+ ***************************************************************************
+ * Check whether a sysfs directory may have changed since it was last
+ * scanned. Its generation (inode, number of links and modification times)
+ * is compared with the one saved at previous scan. As sysfs doesn't always
+ * update those, the directory is also scanned every SYSFS_RESCAN_DELAY
+ * seconds.
+ *
+ * IN:
+ * @dirname	Name of the directory.
+ * @dg		Directory generation saved at previous scan.
+ *
+ * OUT:
+ * @dg		Directory generation, updated if the directory should be
+ *		scanned again.
+ *
+ * RETURNS:
+ * TRUE if the directory should be scanned again.
+ ***************************************************************************
+ */
+int sysfs_dir_changed(char *dirname, struct dir_gen *dg)
+{
+	struct stat st;
+	time_t t;
+
+	t = time(NULL);
+
+	if (stat(dirname, &st) < 0) {
+		/* Directory doesn't exist (yet) */
+		memset(&st, 0, sizeof(struct stat));
+	}
+
+	if ((st.st_dev == dg->st.st_dev) &&
+	    (st.st_ino == dg->st.st_ino) &&
+	    (st.st_nlink == dg->st.st_nlink) &&
+	    (st.st_mtime == dg->st.st_mtime) &&
+	    (st.st_ctime == dg->st.st_ctime) &&
+	    (t >= dg->scan_time) && (t - dg->scan_time < SYSFS_RESCAN_DELAY))
+		return FALSE;
+
+	dg->st = st;
+	dg->scan_time = t;
+
+	return TRUE;
+}
+
 
 #ifndef SOURCE_SADC
 /*
@@ -830,156 +883,380 @@ char *get_persistent_type_dir(char *type)
 
 /*
  ***************************************************************************
- * Get persistent name absolute path.
+ * Read inotify events and invalidate the parts of the device name cache
+ * that may have changed.
+ ***************************************************************************
+ */
+void read_dev_name_events(void)
+{
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	char *ptr;
+	struct inotify_event *ev;
+	ssize_t len;
+	int i;
+
+	while ((len = read(dn_cache.ifd, buf, sizeof(buf))) > 0) {
+		for (ptr = buf; ptr < buf + len;
+		     ptr += sizeof(struct inotify_event) + ev->len) {
+			ev = (struct inotify_event *) ptr;
+
+			if (ev->mask & IN_Q_OVERFLOW) {
+				/* Events have been lost */
+				dn_cache.flags = 0;
+			}
+			for (i = 0; i < DN_WD_NR; i++) {
+				if (ev->wd != dn_cache.wd[i])
+					continue;
+				if (i == DN_WD_DEVMAP) {
+					dn_cache.flags &= ~DN_DEVMAP_READ;
+				}
+				else if (i == DN_WD_PERSIST) {
+					dn_cache.flags &= ~DN_PERSIST_READ;
+				}
+				else {
+					/* Devices added or removed */
+					dn_cache.flags = 0;
+				}
+			}
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Free every entry of the device name cache.
+ ***************************************************************************
+ */
+void free_dev_name_cache(void)
+{
+	struct dev_name_entry *dn;
+	struct persist_name_entry *pn;
+	int i;
+
+	for (i = 0; i < DN_HASH_SIZE; i++) {
+		while ((dn = dn_cache.dev[i]) != NULL) {
+			dn_cache.dev[i] = dn->next;
+			free(dn->sysfs_name);
+			free(dn->dm_name);
+			free(dn);
+		}
+		while ((pn = dn_cache.pretty[i]) != NULL) {
+			dn_cache.pretty[i] = pn->pnext;
+			free(pn);
+		}
+		dn_cache.persist[i] = NULL;
+	}
+}
+
+/*
+ ***************************************************************************
+ * Create the inotify instance used to know when the device name cache
+ * should be invalidated, and watch /dev and /dev/mapper directories.
+ * Inotify is not used in test mode, where the /dev directory changes
+ * without creating any events.
+ ***************************************************************************
+ */
+void init_dev_name_watches(void)
+{
+	dn_cache.wd[DN_WD_PERSIST] = -1;
+
+#ifdef TEST
+	dn_cache.ifd = -1;
+#else
+	dn_cache.ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+	if (dn_cache.ifd < 0)
+		return;
+
+	dn_cache.wd[DN_WD_DEV] = inotify_add_watch(dn_cache.ifd, SLASH_DEV, DN_WATCH_MASK);
+	dn_cache.wd[DN_WD_DEVMAP] = inotify_add_watch(dn_cache.ifd, DEVMAP_DIR, DN_WATCH_MASK);
+}
+
+/*
+ ***************************************************************************
+ * Check that the device name cache is still valid, and invalidate the parts
+ * of it that may have changed.
+ * The /dev, /dev/mapper and /dev/disk/by-<type> directories are watched
+ * with inotify. If inotify cannot be used, the cache is considered as valid
+ * for the current second only.
+ ***************************************************************************
+ */
+void check_dev_name_cache(void)
+{
+	time_t t;
+
+	if (dn_cache.ifd == DN_NO_FD) {
+		/* First call: Try to use inotify */
+		init_dev_name_watches();
+	}
+
+	if (dn_cache.ifd >= 0) {
+		/* Read pending events */
+		read_dev_name_events();
+	}
+	else {
+		/* No inotify: Cache is valid for current second only */
+		t = __time(NULL);
+		if (t != dn_cache.time) {
+			dn_cache.time = t;
+			dn_cache.flags = 0;
+		}
+	}
+
+	if (!(dn_cache.flags & DN_VALID)) {
+		/* Devices may have been added or removed: Flush everything */
+		free_dev_name_cache();
+		dn_cache.flags = DN_VALID;
+	}
+}
+
+/*
+ ***************************************************************************
+ * Compute hash value of a string (for the device name cache).
  *
  * IN:
- * @name	Persistent name.
+ * @str		String.
  *
  * RETURNS:
- * Path to the persistent name, or NULL if file doesn't exist or strings
- * have been truncated.
+ * Hash value, between 0 and DN_HASH_SIZE - 1.
  ***************************************************************************
-*/
-char *get_persistent_name_path(char *name)
+ */
+unsigned int dn_hash_str(char *str)
 {
-	static char path[PATH_MAX];
-	int n;
+	unsigned int h = 5381;
 
-	n = snprintf(path, sizeof(path), "%s/%s",
-		     get_persistent_type_dir(persistent_name_type), name);
-
-	if ((n >= sizeof(path)) || access(path, F_OK)) {
-		return (NULL);
+	while (*str) {
+		h = ((h << 5) + h) + (unsigned char) *str++;
 	}
 
-	return (path);
+	return (h % DN_HASH_SIZE);
 }
 
 /*
  ***************************************************************************
- * Get files from persistent type name directory.
+ * Get the entry of the device name cache for a given device. Entry is
+ * created if it doesn't exist yet.
+ *
+ * IN:
+ * @major	Major number of the device.
+ * @minor	Minor number of the device.
  *
  * RETURNS:
- * List of files in the persistent type name directory in alphabetical order.
+ * Pointer on the entry for the device.
  ***************************************************************************
-*/
-char **get_persistent_names(void)
+ */
+struct dev_name_entry *get_dev_name_entry(unsigned int major, unsigned int minor)
 {
-	int n, i, k = 0;
-	char *dir;
-	char **files = NULL;
-	struct dirent **namelist;
-
-	/* Get directory name for selected persistent type */
-	dir = get_persistent_type_dir(persistent_name_type);
-	if (!dir)
-		return (NULL);
+	struct dev_name_entry *dn;
+	unsigned int h = (major * 31 + minor) % DN_HASH_SIZE;
 
-	n = scandir(dir, &namelist, NULL, alphasort);
-	if (n < 0)
-		return (NULL);
+	for (dn = dn_cache.dev[h]; dn != NULL; dn = dn->next) {
+		if ((dn->major == major) && (dn->minor == minor))
+			return dn;
+	}
 
-	/* If directory is empty, it contains 2 entries: "." and ".." */
-	if (n <= 2)
-		/* Free list and return NULL */
-		goto free_list;
+	if ((dn = (struct dev_name_entry *) calloc(1, sizeof(struct dev_name_entry))) == NULL) {
+		perror("calloc");
+		exit(4);
+	}
+	dn->major = major;
+	dn->minor = minor;
+	dn->next = dn_cache.dev[h];
+	dn_cache.dev[h] = dn;
 
-	/* Ignore the "." and "..", but keep place for one last NULL. */
-	files = (char **) calloc(n - 1, sizeof(char *));
-	if (!files)
-		goto free_list;
+	return dn;
+}
 
-	/*
-	 * i is for traversing namelist, k is for files.
-	 * i != k because we are ignoring "." and ".." entries.
-	 */
-	for (i = 0; i < n; i++) {
-		/* Ignore "." and ".." */
-		if (!strcmp(".", namelist[i]->d_name) ||
-		    !strcmp("..", namelist[i]->d_name))
-			continue;
+/*
+ ***************************************************************************
+ * Fill the device name cache with the names of all the device mapper
+ * devices, using a single pass over the /dev/mapper directory.
+ ***************************************************************************
+ */
+void read_devmap_names(void)
+{
+	DIR *dm_dir;
+	struct dirent *dp;
+	struct dev_name_entry *dn;
+	char filen[MAX_FILE_LEN];
+	struct stat aux;
+	int i;
 
-		files[k] = (char *) calloc(strlen(namelist[i]->d_name) + 1, sizeof(char));
-		if (!files[k])
-			continue;
+	if ((dm_dir = opendir(DEVMAP_DIR)) == NULL) {
+		fprintf(stderr, _("Cannot open %s: %s\n"), DEVMAP_DIR, strerror(errno));
+		exit(4);
+	}
 
-		strcpy(files[k++], namelist[i]->d_name);
+	/* Forget previous names */
+	for (i = 0; i < DN_HASH_SIZE; i++) {
+		for (dn = dn_cache.dev[i]; dn != NULL; dn = dn->next) {
+			free(dn->dm_name);
+			dn->dm_name = NULL;
+		}
 	}
-	files[k] = NULL;
 
-free_list:
+	while ((dp = readdir(dm_dir)) != NULL) {
+		/* For each file in DEVMAP_DIR */
 
-	for (i = 0; i < n; i++) {
-		free(namelist[i]);
+		snprintf(filen, sizeof(filen), "%s/%s", DEVMAP_DIR, dp->d_name);
+		filen[sizeof(filen) - 1] = '\0';
+
+		if ((__stat(filen, &aux) == 0) && aux.st_rdev) {
+			/* Save name for its major and minor numbers (keep the first one) */
+			dn = get_dev_name_entry(__major(aux.st_rdev), __minor(aux.st_rdev));
+			if (!dn->dm_name && ((dn->dm_name = strdup(dp->d_name)) == NULL)) {
+				perror("strdup");
+				exit(4);
+			}
+		}
 	}
-	free(namelist);
+	closedir(dm_dir);
 
-	return (files);
+	dn_cache.flags |= DN_DEVMAP_READ;
 }
 
 /*
  ***************************************************************************
- * Get persistent name from pretty name.
- *
- * IN:
- * @pretty	Pretty name (e.g. sda, sda1, ..).
- *
- * RETURNS:
- * Persistent name.
+ * Fill the device name cache with the persistent names of the devices,
+ * using a single pass over the persistent type name directory.
+ * If several persistent names point at the same device, the first one in
+ * alphabetical order is used.
  ***************************************************************************
-*/
-char *get_persistent_name_from_pretty(char *pretty)
+ */
+void read_persistent_names(void)
 {
-	int i = -1;
+	DIR *dir;
+	struct dirent *dp;
+	struct persist_name_entry *pn, *pp;
+	char *type_dir, *pretty;
+	char link[PATH_MAX], target[PATH_MAX];
 	ssize_t r;
-	char *link, *name;
-	char **persist_names;
-	char target[PATH_MAX];
-	static char persist_name[FILENAME_MAX];
+	int i, n;
+	unsigned int h;
+
+	/* Forget previous names */
+	for (i = 0; i < DN_HASH_SIZE; i++) {
+		while ((pn = dn_cache.pretty[i]) != NULL) {
+			dn_cache.pretty[i] = pn->pnext;
+			free(pn);
+		}
+		dn_cache.persist[i] = NULL;
+	}
+	dn_cache.flags |= DN_PERSIST_READ;
 
-	persist_name[0] = '\0';
+	/* Get directory name for selected persistent type */
+	snprintf(dn_cache.persist_type, sizeof(dn_cache.persist_type), "%s", persistent_name_type);
+	if ((type_dir = get_persistent_type_dir(persistent_name_type)) == NULL)
+		return;
 
-	/* Get list of files from persistent type name directory */
-	persist_names = get_persistent_names();
-	if (!persist_names)
-		return (NULL);
+	if ((dir = opendir(type_dir)) == NULL)
+		return;
 
-	while (persist_names[++i]) {
-		/* Get absolute path for current persistent name */
-		link = get_persistent_name_path(persist_names[i]);
-		if (!link)
+	if (dn_cache.ifd >= 0) {
+		/* Watch this directory (this replaces previous watch if it was the same) */
+		if (dn_cache.wd[DN_WD_PERSIST] >= 0) {
+			inotify_rm_watch(dn_cache.ifd, dn_cache.wd[DN_WD_PERSIST]);
+		}
+		dn_cache.wd[DN_WD_PERSIST] = inotify_add_watch(dn_cache.ifd, type_dir,
+							       DN_WATCH_MASK);
+	}
+
+	while ((dp = readdir(dir)) != NULL) {
+		/* Ignore "." and ".." */
+		if (!strcmp(".", dp->d_name) || !strcmp("..", dp->d_name))
 			continue;
 
-		/* Persistent name is usually a symlink: Read it... */
-		r = readlink(link, target, PATH_MAX);
-		if ((r <= 0) || (r >= PATH_MAX))
+		/* Ignore links pointing at devices which no longer exist */
+		n = snprintf(link, sizeof(link), "%s/%s", type_dir, dp->d_name);
+		if ((n >= sizeof(link)) || access(link, F_OK))
 			continue;
 
+		/* Persistent name is usually a symlink: Read it... */
+		r = readlink(link, target, sizeof(target));
+		if ((r <= 0) || (r >= sizeof(target)))
+			continue;
 		target[r] = '\0';
 
 		/* ... and get device pretty name it points at */
-		name = basename(target);
-		if (!name || (name[0] == '\0'))
+		pretty = basename(target);
+		if (!pretty || (pretty[0] == '\0'))
 			continue;
 
-		if (!strncmp(name, pretty, FILENAME_MAX)) {
-			/* We have found pretty name for current persistent one */
-			strncpy(persist_name, persist_names[i], sizeof(persist_name));
-			persist_name[sizeof(persist_name) - 1] = '\0';
-			break;
+		if ((pn = (struct persist_name_entry *) malloc(sizeof(struct persist_name_entry) +
+							      strlen(dp->d_name) + strlen(pretty) + 2)) == NULL) {
+			perror("malloc");
+			exit(4);
+		}
+		pn->persist = (char *) (pn + 1);
+		strcpy(pn->persist, dp->d_name);
+		pn->pretty = pn->persist + strlen(dp->d_name) + 1;
+		strcpy(pn->pretty, pretty);
+
+		/* Index by pretty name: Keep first persistent name in alphabetical order first */
+		h = dn_hash_str(pn->pretty);
+		pn->pnext = dn_cache.pretty[h];
+		dn_cache.pretty[h] = pn;
+		for (pp = pn->pnext; pp != NULL; pp = pp->pnext) {
+			if (!strcmp(pp->pretty, pn->pretty) && (strcmp(pp->persist, pn->persist) < 0)) {
+				/* Move new entry behind the one that should be found first */
+				dn_cache.pretty[h] = pn->pnext;
+				pn->pnext = pp->pnext;
+				pp->pnext = pn;
+				break;
+			}
 		}
+
+		/* Index by persistent name */
+		h = dn_hash_str(pn->persist);
+		pn->nnext = dn_cache.persist[h];
+		dn_cache.persist[h] = pn;
 	}
+	closedir(dir);
+}
 
-	i = -1;
-	while (persist_names[++i]) {
-		free (persist_names[i]);
+/*
+ ***************************************************************************
+ * Check that persistent names in cache are up to date.
+ ***************************************************************************
+ */
+void check_persistent_names(void)
+{
+	check_dev_name_cache();
+
+	if (!(dn_cache.flags & DN_PERSIST_READ) ||
+	    strcmp(dn_cache.persist_type, persistent_name_type)) {
+		read_persistent_names();
 	}
-	free (persist_names);
+}
 
-	if (strlen(persist_name) <= 0)
-		return (NULL);
+/*
+ ***************************************************************************
+ * Get persistent name from pretty name.
+ *
+ * IN:
+ * @pretty	Pretty name (e.g. sda, sda1, ..).
+ *
+ * RETURNS:
+ * Persistent name.
+ ***************************************************************************
+*/
+char *get_persistent_name_from_pretty(char *pretty)
+{
+	struct persist_name_entry *pn;
+	static char persist_name[FILENAME_MAX];
 
-	return persist_name;
+	check_persistent_names();
+
+	for (pn = dn_cache.pretty[dn_hash_str(pretty)]; pn != NULL; pn = pn->pnext) {
+		if (!strcmp(pn->pretty, pretty)) {
+			/* We have found persistent name for current pretty one */
+			strncpy(persist_name, pn->persist, sizeof(persist_name));
+			persist_name[sizeof(persist_name) - 1] = '\0';
+			return persist_name;
+		}
+	}
+
+	return (NULL);
 }
 
 /*
@@ -995,32 +1272,26 @@ char *get_persistent_name_from_pretty(char *pretty)
 */
 char *get_pretty_name_from_persistent(char *persistent)
 {
-	ssize_t r;
-	char *link, *pretty, target[PATH_MAX];
+	struct persist_name_entry *pn;
+	static char pretty[FILENAME_MAX];
 
-	/* Get absolute path for persistent name */
-	link = get_persistent_name_path(persistent);
-	if (!link)
-		return (NULL);
+	check_persistent_names();
 
-	/* Persistent name is usually a symlink: Read it... */
-	r = readlink(link, target, PATH_MAX);
-	if ((r <= 0) || (r >= PATH_MAX))
-		return (NULL);
-
-	target[r] = '\0';
-
-	/* ... and get device pretty name it points at */
-	pretty = basename(target);
-	if (!pretty || (pretty[0] == '\0'))
-		return (NULL);
+	for (pn = dn_cache.persist[dn_hash_str(persistent)]; pn != NULL; pn = pn->nnext) {
+		if (!strcmp(pn->persist, persistent)) {
+			strncpy(pretty, pn->pretty, sizeof(pretty));
+			pretty[sizeof(pretty) - 1] = '\0';
+			return pretty;
+		}
+	}
 
-	return pretty;
+	return (NULL);
 }
 
 /*
  * **************************************************************************
  * Try to get device real name from sysfs tree.
+ * Name is read only once and then saved in the device name cache.
  *
  * IN:
  * @major	Major number of the device.
@@ -1034,25 +1305,80 @@ char *get_pretty_name_from_persistent(char *persistent)
 char *get_devname_from_sysfs(unsigned int major, unsigned int minor)
 {
 	static char link[256], target[PATH_MAX];
+	struct dev_name_entry *dn;
 	char *devname;
 	ssize_t r;
 
-	snprintf(link, 256, "%s/%u:%u", SYSFS_DEV_BLOCK, major, minor);
+	check_dev_name_cache();
 
-	/* Get full path to device knowing its major and minor numbers */
-	r = readlink(link, target, PATH_MAX);
-	if (r <= 0 || r >= PATH_MAX)
-		return (NULL);
+	dn = get_dev_name_entry(major, minor);
+	if (!dn->sysfs_read) {
+		dn->sysfs_read = TRUE;
+
+		snprintf(link, 256, "%s/%u:%u", SYSFS_DEV_BLOCK, major, minor);
+
+		/* Get full path to device knowing its major and minor numbers */
+		r = readlink(link, target, PATH_MAX);
+		if (r <= 0 || r >= PATH_MAX)
+			return (NULL);
 
-	target[r] = '\0';
+		target[r] = '\0';
+
+		/* Get device name */
+		devname = basename(target);
+		if (!devname || strnlen(devname, FILENAME_MAX) == 0) {
+			return (NULL);
+		}
 
-	/* Get device name */
-	devname = basename(target);
-	if (!devname || strnlen(devname, FILENAME_MAX) == 0) {
+		if ((dn->sysfs_name = strdup(devname)) == NULL) {
+			perror("strdup");
+			exit(4);
+		}
+	}
+
+	if (!dn->sysfs_name)
 		return (NULL);
+
+	/* Return a copy: Cache may be flushed before the name is used */
+	strncpy(target, dn->sysfs_name, sizeof(target));
+	target[sizeof(target) - 1] = '\0';
+
+	return (target);
+}
+
+/*
+ ***************************************************************************
+ * Transform device mapper name: Get the user assigned name of the logical
+ * device instead of the internal device mapper numbering.
+ * Names of all device mapper devices are read at once and saved in the
+ * device name cache.
+ *
+ * IN:
+ * @major	Device major number.
+ * @minor	Device minor number.
+ *
+ * RETURNS:
+ * Assigned name of the logical device.
+ ***************************************************************************
+ */
+char *transform_devmapname(unsigned int major, unsigned int minor)
+{
+	static char name[MAX_NAME_LEN];
+	struct dev_name_entry *dn;
+
+	check_dev_name_cache();
+	if (!(dn_cache.flags & DN_DEVMAP_READ)) {
+		read_devmap_names();
 	}
 
-	return (devname);
+	dn = get_dev_name_entry(major, minor);
+	if (!dn->dm_name)
+		return NULL;
+
+	strncpy(name, dn->dm_name, sizeof(name));
+	name[sizeof(name) - 1] = '\0';
+
+	return name;
 }
 
 /*
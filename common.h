@@ -83,6 +83,7 @@
 #define SYSFS_DEVCPU		PRE "/sys/devices/system/cpu"
 #define SYSFS_TIME_IN_STATE	"cpufreq/stats/time_in_state"
 #define S_STAT			"stat"
+#define S_DEV			"dev"
 #define DEVMAP_DIR		PRE "/dev/mapper"
 #define DEVICES			PRE "/proc/devices"
 #define SYSFS_USBDEV		PRE "/sys/bus/usb/devices"
@@ -94,11 +95,26 @@
 #define SYSFS_MANUFACTURER	"manufacturer"
 #define SYSFS_PRODUCT		"product"
 #define SYSFS_FCHOST		PRE "/sys/class/fc_host"
+#define SYSFS_HWMON		PRE "/sys/class/hwmon"
 
 #define MAX_FILE_LEN		512
 #define MAX_PF_NAME		1024
 #define MAX_NAME_LEN		128
 
+#define UTSNAME_LEN		65
+
+/* Device name cache */
+#define DN_HASH_SIZE		1024
+#define DN_NO_FD		-2	/* Inotify instance not created yet */
+#define DN_VALID		0x01	/* Cache entries are valid */
+#define DN_DEVMAP_READ		0x02	/* Device mapper names have been read */
+#define DN_PERSIST_READ		0x04	/* Persistent names have been read */
+#define DN_WD_DEV		0
+#define DN_WD_DEVMAP		1
+#define DN_WD_PERSIST		2
+#define DN_WD_NR		3
+#define DN_WATCH_MASK		(IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+
 #define IGNORE_VIRTUAL_DEVICES	FALSE
 #define ACCEPT_VIRTUAL_DEVICES	TRUE
 
@@ -213,12 +229,24 @@ extern char persistent_name_type[MAX_FILE_LEN];
 #define IS_COMMENT	3
 #define IS_ZERO		4
 
+/*
+ * Delay (in seconds) after which a sysfs directory is scanned again even if
+ * it doesn't seem to have changed (see sysfs_dir_changed()).
+ */
+#define SYSFS_RESCAN_DELAY	30
+
 /*
  ***************************************************************************
  * Structures definitions
  ***************************************************************************
  */
 
+/* Generation of a sysfs directory when it was last scanned */
+struct dir_gen {
+	struct stat st;
+	time_t scan_time;
+};
+
 /* Structure used for extended disk statistics */
 struct ext_disk_stats {
 	double util;
@@ -226,6 +254,43 @@ struct ext_disk_stats {
 	double arqsz;
 };
 
+/* Names of a device saved in the device name cache */
+struct dev_name_entry {
+	unsigned int major;
+	unsigned int minor;
+	/* Name read from sysfs, or NULL if not found */
+	char *sysfs_name;
+	/* Name in /dev/mapper directory, or NULL if none */
+	char *dm_name;
+	/* TRUE if sysfs has already been read for this device */
+	int sysfs_read;
+	struct dev_name_entry *next;
+};
+
+/* Persistent name of a device, indexed both by pretty and persistent names */
+struct persist_name_entry {
+	char *pretty;
+	char *persist;
+	struct persist_name_entry *pnext;	/* Next entry with same pretty name hash */
+	struct persist_name_entry *nnext;	/* Next entry with same persistent name hash */
+};
+
+/*
+ * Cache of device names, to avoid reading sysfs and scanning /dev
+ * directories for every device at each sample. It is invalidated with
+ * inotify whenever devices are added or removed.
+ */
+struct dev_name_cache {
+	struct dev_name_entry *dev[DN_HASH_SIZE];		/* Hashed by major:minor */
+	struct persist_name_entry *pretty[DN_HASH_SIZE];	/* Hashed by pretty name */
+	struct persist_name_entry *persist[DN_HASH_SIZE];	/* Hashed by persistent name */
+	char persist_type[MAX_FILE_LEN];	/* Persistent name type used to fill cache */
+	time_t time;		/* Time when cache was filled (if inotify is not available) */
+	int ifd;		/* Inotify instance */
+	int wd[DN_WD_NR];	/* Watch descriptors */
+	unsigned int flags;
+};
+
 /*
  ***************************************************************************
  * Functions prototypes
@@ -253,6 +318,8 @@ int get_wwnid_from_pretty
 	(char *, unsigned long long *, unsigned int *);
 int check_dir
 	(char *);
+int sysfs_dir_changed
+	(char *, struct dir_gen *);
 
 #ifndef SOURCE_SADC
 int count_bits
@@ -304,6 +371,8 @@ int set_report_date
 	(struct tm *, char[], int);
 char *strtolower
 	(char *);
+char *transform_devmapname
+	(unsigned int, unsigned int);
 void xprintf
 	(int, const char *, ...);
 void xprintf0
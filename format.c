@@ -55,7 +55,7 @@ struct report_format hdr_fmt = {
 struct report_format db_fmt = {
 	.id		= F_DB_OUTPUT,
 	.options	= FO_LOCAL_TIME + FO_HORIZONTALLY +
-			  FO_SEC_EPOCH + FO_FIELD_LIST,
+			  FO_SEC_EPOCH + FO_FIELD_LIST + FO_CPU_TOPOLOGY,
 	.f_header	= NULL,
 	.f_statistics	= NULL,
 	.f_timestamp	= print_db_timestamp,
@@ -69,7 +69,7 @@ struct report_format db_fmt = {
  */
 struct report_format ppc_fmt = {
 	.id		= F_PPC_OUTPUT,
-	.options	= FO_LOCAL_TIME + FO_SEC_EPOCH,
+	.options	= FO_LOCAL_TIME + FO_SEC_EPOCH + FO_CPU_TOPOLOGY,
 	.f_header	= NULL,
 	.f_statistics	= NULL,
 	.f_timestamp	= print_ppc_timestamp,
@@ -83,7 +83,8 @@ struct report_format ppc_fmt = {
  */
 struct report_format xml_fmt = {
 	.id		= F_XML_OUTPUT,
-	.options	= FO_HEADER_ONLY + FO_LOCAL_TIME + FO_TEST_MARKUP,
+	.options	= FO_HEADER_ONLY + FO_LOCAL_TIME + FO_TEST_MARKUP +
+			  FO_CPU_TOPOLOGY,
 	.f_header	= print_xml_header,
 	.f_statistics	= print_xml_statistics,
 	.f_timestamp	= print_xml_timestamp,
@@ -98,7 +99,7 @@ struct report_format xml_fmt = {
 struct report_format json_fmt = {
 	.id		= F_JSON_OUTPUT,
 	.options	= FO_HEADER_ONLY + FO_LOCAL_TIME + FO_TEST_MARKUP +
-			  FO_LC_NUMERIC_C,
+			  FO_LC_NUMERIC_C + FO_CPU_TOPOLOGY,
 	.f_header	= print_json_header,
 	.f_statistics	= print_json_statistics,
 	.f_timestamp	= print_json_timestamp,
@@ -165,6 +166,34 @@ struct report_format pcp_fmt = {
 	.f_display	= logic1_display_loop
 };
 
+/*
+ * InfluxDB line protocol.
+ */
+struct report_format influx_fmt = {
+	.id		= F_INFLUX_OUTPUT,
+	.options	= FO_NO_TRUE_TIME + FO_LC_NUMERIC_C + FO_CPU_TOPOLOGY,
+	.f_header	= NULL,
+	.f_statistics	= NULL,
+	.f_timestamp	= print_influx_timestamp,
+	.f_restart	= NULL,
+	.f_comment	= NULL,
+	.f_display	= logic2_display_loop
+};
+
+/*
+ * Apache Arrow IPC stream.
+ */
+struct report_format arrow_fmt = {
+	.id		= F_ARROW_OUTPUT,
+	.options	= FO_NO_TRUE_TIME + FO_CPU_TOPOLOGY,
+	.f_header	= NULL,
+	.f_statistics	= NULL,
+	.f_timestamp	= print_arrow_timestamp,
+	.f_restart	= NULL,
+	.f_comment	= NULL,
+	.f_display	= logic2_display_loop
+};
+
 /*
  * Array of output formats.
  */
@@ -177,7 +206,9 @@ struct report_format *fmt[NR_FMT] = {
 	&conv_fmt,
 	&svg_fmt,
 	&raw_fmt,
-	&pcp_fmt
+	&pcp_fmt,
+	&influx_fmt,
+	&arrow_fmt
 };
 #endif
 
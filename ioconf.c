@@ -451,56 +451,3 @@ char *ioc_name(unsigned int major, unsigned int minor)
 	}
 	return (name);
 }
-
-/*
- ***************************************************************************
- * Transform device mapper name: Get the user assigned name of the logical
- * device instead of the internal device mapper numbering.
- *
- * IN:
- * @major	Device major number.
- * @minor	Device minor number.
- *
- * RETURNS:
- * Assigned name of the logical device.
- ***************************************************************************
- */
-char *transform_devmapname(unsigned int major, unsigned int minor)
-{
-	DIR *dm_dir;
-	struct dirent *dp;
-	char filen[MAX_FILE_LEN];
-	char *dm_name = NULL;
-	static char name[MAX_NAME_LEN];
-	struct stat aux;
-	unsigned int dm_major, dm_minor;
-
-	if ((dm_dir = opendir(DEVMAP_DIR)) == NULL) {
-		fprintf(stderr, _("Cannot open %s: %s\n"), DEVMAP_DIR, strerror(errno));
-		exit(4);
-	}
-
-	while ((dp = readdir(dm_dir)) != NULL) {
-		/* For each file in DEVMAP_DIR */
-
-		snprintf(filen, sizeof(filen), "%s/%s", DEVMAP_DIR, dp->d_name);
-		filen[sizeof(filen) - 1] = '\0';
-
-		if (__stat(filen, &aux) == 0) {
-			/* Get its minor and major numbers */
-
-			dm_major = __major(aux.st_rdev);
-			dm_minor = __minor(aux.st_rdev);
-
-			if ((dm_minor == minor) && (dm_major == major)) {
-				strncpy(name, dp->d_name, sizeof(name));
-				name[sizeof(name) - 1] = '\0';
-				dm_name = name;
-				break;
-			}
-		}
-	}
-	closedir(dm_dir);
-
-	return dm_name;
-}
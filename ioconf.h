@@ -86,7 +86,5 @@ int ioc_iswhole
 	(unsigned int, unsigned int);
 char *ioc_name
 	(unsigned int, unsigned int);
-char *transform_devmapname
-	(unsigned int, unsigned int);
 
 #endif
@@ -60,17 +60,26 @@ struct stats_cpu *st_cpu[2];
 unsigned long long uptime_cs[2] = {0, 0};
 unsigned long long tot_jiffies[2] = {0, 0};
 struct io_device *dev_list = NULL;
+struct io_device *dev_hash[IO_DEV_HASH_SIZE];
+struct blk_dev_info *blk_info_hash[IO_DEV_HASH_SIZE];
+struct io_device **group_list = NULL;	/* Groups, in the order they have been defined */
 
 /* Number of decimal places */
 int dplaces_nr = -1;
 
 int group_nr = 0;	/* Nb of device groups */
+int dev_nr = 0;		/* Nb of devices and partitions in the list */
 int cpu_nr = 0;		/* Nb of processors on the machine */
 int flags = 0;		/* Flag for common options and system state */
 
 long interval = 0;
 char timestamp[TIMESTAMP_LEN];
 char alt_dir[MAX_FILE_LEN];
+char sa_file[MAX_FILE_LEN];	/* System activity data file where stats are saved */
+int sa_fd = -1;
+
+struct stats_disk *st_disk = NULL;	/* Disk stats saved in system activity data file */
+__nr_t st_disk_nr = 0;
 
 struct sigaction alrm_act, int_act;
 int sigint_caught = 0;
@@ -91,14 +100,14 @@ void usage(char *progname)
 	fprintf(stderr, _("Options are:\n"
 			  "[ -c ] [ -d ] [ -h ] [ -k | -m ] [ -N ] [ -s ] [ -t ] [ -V ] [ -x ] [ -y ] [ -z ]\n"
 			  "[ { -f | +f } <directory> ] [ -j { ID | LABEL | PATH | UUID | ... } ]\n"
-			  "[ --dec={ 0 | 1 | 2 } ] [ --human ] [ --pretty ] [ -o JSON ]\n"
+			  "[ --dec={ 0 | 1 | 2 } ] [ --human ] [ --pretty ] [ -o JSON ] [ --save=<filename> ]\n"
 			  "[ [ -H ] -g <group_name> ] [ -p [ <device> [,...] | ALL ] ]\n"
 			  "[ <device> [...] | ALL ] [ --debuginfo ]\n"));
 #else
 	fprintf(stderr, _("Options are:\n"
 			  "[ -c ] [ -d ] [ -h ] [ -k | -m ] [ -N ] [ -s ] [ -t ] [ -V ] [ -x ] [ -y ] [ -z ]\n"
 			  "[ { -f | +f } <directory> ] [ -j { ID | LABEL | PATH | UUID | ... } ]\n"
-			  "[ --dec={ 0 | 1 | 2 } ] [ --human ] [ --pretty ] [ -o JSON ]\n"
+			  "[ --dec={ 0 | 1 | 2 } ] [ --human ] [ --pretty ] [ -o JSON ] [ --save=<filename> ]\n"
 			  "[ [ -H ] -g <group_name> ] [ -p [ <device> [,...] | ALL ] ]\n"
 			  "[ <device> [...] | ALL ]\n"));
 #endif
@@ -185,6 +194,51 @@ void set_devices_nonexistent(struct io_device *dlist)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Compute hash value of a device name.
+ *
+ * IN:
+ * @name	Device name.
+ *
+ * RETURNS:
+ * Hash value, between 0 and IO_DEV_HASH_SIZE - 1.
+ ***************************************************************************
+ */
+unsigned int hash_devname(char *name)
+{
+	unsigned int h = 5381;
+
+	while (*name) {
+		h = (h << 5) + h + (unsigned char) *name++;
+	}
+
+	return h % IO_DEV_HASH_SIZE;
+}
+
+/*
+ ***************************************************************************
+ * Look for a device in the list using its name.
+ *
+ * IN:
+ * @name	Device name.
+ *
+ * RETURNS:
+ * Pointer on the io_device structure, or NULL if device is not in the list.
+ ***************************************************************************
+ */
+struct io_device *search_list_device(char *name)
+{
+	struct io_device *d;
+
+	for (d = dev_hash[hash_devname(name)]; d != NULL; d = d->hnext) {
+		if (!strcmp(d->name, name))
+			return d;
+	}
+
+	return NULL;
+}
+
 /*
  ***************************************************************************
  * Check if a device is present in the list, and add it if requested.
@@ -207,15 +261,16 @@ void set_devices_nonexistent(struct io_device *dlist)
 struct io_device *add_list_device(struct io_device **dlist, char *name, int dtype)
 {
 	struct io_device *d, *ds;
+	unsigned int h;
 	int i, rc = 0;
 
 	if (strnlen(name, MAX_NAME_LEN) == MAX_NAME_LEN)
 		/* Device name is too long */
 		return NULL;
 
-	while (*dlist != NULL) {
-		d = *dlist;
-		if ((i = strcmp(d->name, name)) == 0) {
+	h = hash_devname(name);
+	for (d = dev_hash[h]; d != NULL; d = d->hnext) {
+		if (!strcmp(d->name, name)) {
 			/* Device found in list */
 			if ((dtype == T_PART_DEV) && (d->dev_tp == T_DEV)) {
 				d->dev_tp = dtype;
@@ -223,7 +278,13 @@ struct io_device *add_list_device(struct io_device **dlist, char *name, int dtyp
 			d->exist = TRUE;
 			return d;
 		}
-		if (!GROUP_DEFINED(flags) && !DISPLAY_EVERYTHING(flags) && (i > 0))
+	}
+
+	/* Device not found: Look for its position in list */
+	while (*dlist != NULL) {
+		d = *dlist;
+		if (!GROUP_DEFINED(flags) && !DISPLAY_EVERYTHING(flags) &&
+		    (strcmp(d->name, name) > 0))
 			/*
 			 * If no group defined and we don't use /proc/diskstats,
 			 * insert current device in alphabetical order.
@@ -257,11 +318,34 @@ struct io_device *add_list_device(struct io_device **dlist, char *name, int dtyp
 	d->name[MAX_NAME_LEN - 1] = '\0';
 	d->exist = TRUE;
 	d->next = ds;
+	d->hnext = dev_hash[h];
+	dev_hash[h] = d;
 
 	if (dtype == T_GROUP) {
 		d->dev_tp = dtype;
+
+		/* Save group in the list of groups */
+		SREALLOC(group_list, struct io_device *, sizeof(struct io_device *) * (group_nr + 1));
+		group_list[group_nr++] = d;
 	}
 	else  {
+		dev_nr++;
+
+		if (GROUP_DEFINED(flags) && group_nr) {
+			/*
+			 * Device has been added at the end of the list:
+			 * It belongs to the last group defined.
+			 */
+			d->group = group_list[group_nr - 1];
+			if (d->group->glast) {
+				d->group->glast->gnext = d;
+			}
+			else {
+				d->group->gfirst = d;
+			}
+			d->group->glast = d;
+		}
+
 		if (!alt_dir[0] || USE_ALL_DIR(flags)) {
 			rc = is_device(SLASH_SYS, name, ACCEPT_VIRTUAL_DEVICES);
 		}
@@ -323,6 +407,43 @@ int get_major_minor_nr(char filename[], int *major, int *minor)
 	return 0;
 }
 
+/*
+ ***************************************************************************
+ * Set device major and minor numbers if not already known. They are read
+ * from the "dev" attribute of the device in sysfs, or else from the device
+ * file in /dev.
+ *
+ * IN:
+ * @d		Device structure.
+ * @devdir	sysfs directory of the device.
+ ***************************************************************************
+ */
+void set_major_minor_nr(struct io_device *d, char *devdir)
+{
+	FILE *fp;
+	char filename[MAX_PF_NAME];
+	int major, minor, rc = -1;
+
+	if (d->major)
+		/* Already known */
+		return;
+
+	snprintf(filename, sizeof(filename), "%s/%s", devdir, S_DEV);
+	filename[sizeof(filename) - 1] = '\0';
+
+	if ((fp = fopen(filename, "r")) != NULL) {
+		if (fscanf(fp, "%d:%d", &major, &minor) == 2) {
+			rc = 0;
+		}
+		fclose(fp);
+	}
+
+	if ((rc == 0) || (get_major_minor_nr(d->name, &major, &minor) == 0)) {
+		d->major = major;
+		d->minor = minor;
+	}
+}
+
 /*
  ***************************************************************************
  * Read sysfs stat for current block device or partition.
@@ -409,37 +530,42 @@ int read_sysfs_file_stat_work(char *filename, struct io_stats *ios)
  * location.
  *
  * IN:
- * @devname	Device name for which stats have to be read.
- * @ios		Structure where stats will be saved.
- *
- * OUT:
- * @ios		Structure where stats have been saved.
+ * @curr	Index in array for current sample statistics.
+ * @d		Device structure.
  *
  * RETURNS:
  * 0 on success, -1 otherwise.
  ***************************************************************************
  */
-int read_sysfs_file_stat(char *devname, struct io_stats *ios)
+int read_sysfs_file_stat(int curr, struct io_device *d)
 {
 	int rc = 0;
-	char dfile[MAX_PF_NAME];
+	char ddir[MAX_PF_NAME], dfile[MAX_PF_NAME + 8];
 
 	if (!alt_dir[0] || USE_ALL_DIR(flags)) {
 		/* Read stats for current whole device using /sys/block/ directory */
-		snprintf(dfile, sizeof(dfile), "%s/%s/%s/%s",
-			 SLASH_SYS, __BLOCK, devname, S_STAT);
+		snprintf(ddir, sizeof(ddir), "%s/%s/%s",
+			 SLASH_SYS, __BLOCK, d->name);
+		ddir[sizeof(ddir) - 1] = '\0';
+		snprintf(dfile, sizeof(dfile), "%s/%s", ddir, S_STAT);
 		dfile[sizeof(dfile) - 1] = '\0';
 
-		rc = read_sysfs_file_stat_work(dfile, ios);
+		rc = read_sysfs_file_stat_work(dfile, d->dev_stats[curr]);
 	}
 
 	if (alt_dir[0] && (!USE_ALL_DIR(flags) || (USE_ALL_DIR(flags) && (rc < 0)))) {
 		/* Read stats for current whole device using an alternate /sys directory */
-		snprintf(dfile, sizeof(dfile), "%s/%s/%s/%s",
-			 alt_dir, __BLOCK, devname, S_STAT);
+		snprintf(ddir, sizeof(ddir), "%s/%s/%s",
+			 alt_dir, __BLOCK, d->name);
+		ddir[sizeof(ddir) - 1] = '\0';
+		snprintf(dfile, sizeof(dfile), "%s/%s", ddir, S_STAT);
 		dfile[sizeof(dfile) - 1] = '\0';
 
-		rc = read_sysfs_file_stat_work(dfile, ios);
+		rc = read_sysfs_file_stat_work(dfile, d->dev_stats[curr]);
+	}
+
+	if (rc == 0) {
+		set_major_minor_nr(d, ddir);
 	}
 
 	return rc;
@@ -466,7 +592,6 @@ int read_sysfs_device_part_stat_work(int curr, char *dname, char *sysdev)
 	struct io_stats sdev;
 	struct io_device *d;
 	char dfile[MAX_PF_NAME], filename[MAX_PF_NAME + 512];
-	int major, minor;
 
 	snprintf(dfile, sizeof(dfile), "%s/%s/%s", sysdev, __BLOCK, dname);
 	dfile[sizeof(dfile) - 1] = '\0';
@@ -491,13 +616,10 @@ int read_sysfs_device_part_stat_work(int curr, char *dname, char *sysdev)
 		if (d != NULL) {
 			*(d->dev_stats[curr]) = sdev;
 
-			if (!d->major) {
-				/* Get major and minor numbers for given device */
-				if (get_major_minor_nr(d->name, &major, &minor) == 0) {
-					d->major = major;
-					d->minor = minor;
-				}
-			}
+			/* Get major and minor numbers for given partition */
+			snprintf(filename, sizeof(filename), "%s/%s", dfile, drd->d_name);
+			filename[sizeof(filename) - 1] = '\0';
+			set_major_minor_nr(d, filename);
 		}
 	}
 
@@ -557,7 +679,6 @@ int read_sysfs_all_devices_stat_work(int curr, char *sysblock)
 	struct io_stats sdev;
 	struct io_device *d;
 	char dfile[MAX_PF_NAME];
-	int major, minor;
 
 	/* Open __sys/block directory */
 	if ((dir = __opendir(sysblock)) == NULL)
@@ -579,13 +700,10 @@ int read_sysfs_all_devices_stat_work(int curr, char *sysblock)
 		if (d != NULL) {
 			*(d->dev_stats[curr]) = sdev;
 
-			if (!d->major) {
-				/* Get major and minor numbers for given device */
-				if (get_major_minor_nr(d->name, &major, &minor) == 0) {
-					d->major = major;
-					d->minor = minor;
-				}
-			}
+			/* Get major and minor numbers for given device */
+			snprintf(dfile, sizeof(dfile), "%s/%s", sysblock, drd->d_name);
+			dfile[sizeof(dfile) - 1] = '\0';
+			set_major_minor_nr(d, dfile);
 		}
 	}
 
@@ -721,7 +839,7 @@ void read_sysfs_dlist_stat(int curr)
 
 		else if ((dlist->dev_tp == T_PART_DEV) || (dlist->dev_tp == T_DEV)) {
 			/* Read stats for current whole device using /sys/block/ directory */
-			if (read_sysfs_file_stat(dlist->name, dlist->dev_stats[curr]) == 0) {
+			if (read_sysfs_file_stat(curr, dlist) == 0) {
 				dlist->exist = TRUE;
 			}
 
@@ -738,6 +856,188 @@ void read_sysfs_dlist_stat(int curr)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Reset statistics of every group. This has to be done before devices
+ * stats are read.
+ *
+ * IN:
+ * @curr	Index in array for current sample statistics.
+ ***************************************************************************
+ */
+void init_device_groups_stats(int curr)
+{
+	int i;
+
+	for (i = 0; i < group_nr; i++) {
+		memset(group_list[i]->dev_stats[curr], 0, sizeof(struct io_stats));
+		/*
+		 * No devices in the group yet: They are counted again at
+		 * each sample, since some of them may have disappeared.
+		 */
+		group_list[i]->dev_tp = T_GROUP;
+	}
+}
+
+/*
+ ***************************************************************************
+ * Add current device statistics to the group it belongs to.
+ *
+ * IN:
+ * @curr	Index in array for current sample statistics.
+ * @d		Device whose stats have just been read.
+ ***************************************************************************
+ */
+void add_device_group_stats(int curr, struct io_device *d)
+{
+	struct io_device *g = d->group;
+
+	if (g == NULL)
+		/* Device doesn't belong to a group */
+		return;
+
+	/* Increment number of disks in the group */
+	(g->dev_tp)++;
+
+	if (!DISPLAY_UNFILTERED(flags)) {
+		if (!d->dev_stats[curr]->rd_ios &&
+		    !d->dev_stats[curr]->wr_ios &&
+		    !d->dev_stats[curr]->dc_ios &&
+		    !d->dev_stats[curr]->fl_ios)
+			return;
+	}
+
+	g->dev_stats[curr]->rd_ios     += d->dev_stats[curr]->rd_ios;
+	g->dev_stats[curr]->rd_merges  += d->dev_stats[curr]->rd_merges;
+	g->dev_stats[curr]->rd_sectors += d->dev_stats[curr]->rd_sectors;
+	g->dev_stats[curr]->rd_ticks   += d->dev_stats[curr]->rd_ticks;
+	g->dev_stats[curr]->wr_ios     += d->dev_stats[curr]->wr_ios;
+	g->dev_stats[curr]->wr_merges  += d->dev_stats[curr]->wr_merges;
+	g->dev_stats[curr]->wr_sectors += d->dev_stats[curr]->wr_sectors;
+	g->dev_stats[curr]->wr_ticks   += d->dev_stats[curr]->wr_ticks;
+	g->dev_stats[curr]->dc_ios     += d->dev_stats[curr]->dc_ios;
+	g->dev_stats[curr]->dc_merges  += d->dev_stats[curr]->dc_merges;
+	g->dev_stats[curr]->dc_sectors += d->dev_stats[curr]->dc_sectors;
+	g->dev_stats[curr]->dc_ticks   += d->dev_stats[curr]->dc_ticks;
+	g->dev_stats[curr]->fl_ios     += d->dev_stats[curr]->fl_ios;
+	g->dev_stats[curr]->fl_ticks   += d->dev_stats[curr]->fl_ticks;
+	g->dev_stats[curr]->ios_pgr    += d->dev_stats[curr]->ios_pgr;
+	g->dev_stats[curr]->tot_ticks  += d->dev_stats[curr]->tot_ticks;
+	g->dev_stats[curr]->rq_ticks   += d->dev_stats[curr]->rq_ticks;
+}
+
+/*
+ ***************************************************************************
+ * Compute statistics of every group using the list of devices belonging
+ * to each of them. Used when groups stats couldn't be computed while
+ * devices stats were read.
+ *
+ * IN:
+ * @curr	Index in array for current sample statistics.
+ ***************************************************************************
+ */
+void compute_device_groups_stats(int curr)
+{
+	struct io_device *d;
+	int i;
+
+	init_device_groups_stats(curr);
+
+	for (i = 0; i < group_nr; i++) {
+		for (d = group_list[i]->gfirst; d != NULL; d = d->gnext) {
+			if (d->exist) {
+				add_device_group_stats(curr, d);
+			}
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Parse a line from a diskstats file.
+ *
+ * IN:
+ * @line	Line read from diskstats file.
+ *
+ * OUT:
+ * @major	Major number of the device.
+ * @minor	Minor number of the device.
+ * @dev_name	Device name (with slashes replaced with bang characters).
+ * @sdev	Device statistics.
+ *
+ * RETURNS:
+ * 0 if line contains extended statistics, 1 for a partition without
+ * extended statistics, and -1 for an unknown entry.
+ ***************************************************************************
+ */
+int read_diskstats_line(char *line, unsigned int *major, unsigned int *minor,
+			char *dev_name, struct io_stats *sdev)
+{
+	int i;
+	char *slash;
+	unsigned int ios_pgr, tot_ticks, rq_ticks, wr_ticks, dc_ticks, fl_ticks;
+	unsigned long rd_ios, rd_merges_or_rd_sec, rd_ticks_or_wr_sec, wr_ios;
+	unsigned long wr_merges, rd_sec_or_wr_ios, wr_sec;
+	unsigned long dc_ios, dc_merges, dc_sec, fl_ios;
+
+	memset(sdev, 0, sizeof(struct io_stats));
+
+	/* major minor name rio rmerge rsect ruse wio wmerge wsect wuse running use aveq dcio dcmerge dcsect dcuse flio fltm */
+	i = sscanf(line, "%u %u %127s %lu %lu %lu %lu %lu %lu %lu %u %u %u %u %lu %lu %lu %u %lu %u",
+		   major, minor, dev_name,
+		   &rd_ios, &rd_merges_or_rd_sec, &rd_sec_or_wr_ios, &rd_ticks_or_wr_sec,
+		   &wr_ios, &wr_merges, &wr_sec, &wr_ticks, &ios_pgr, &tot_ticks, &rq_ticks,
+		   &dc_ios, &dc_merges, &dc_sec, &dc_ticks,
+		   &fl_ios, &fl_ticks);
+
+	if (i >= 14) {
+		sdev->rd_ios     = rd_ios;
+		sdev->rd_merges  = rd_merges_or_rd_sec;
+		sdev->rd_sectors = rd_sec_or_wr_ios;
+		sdev->rd_ticks   = (unsigned int) rd_ticks_or_wr_sec;
+		sdev->wr_ios     = wr_ios;
+		sdev->wr_merges  = wr_merges;
+		sdev->wr_sectors = wr_sec;
+		sdev->wr_ticks   = wr_ticks;
+		sdev->ios_pgr    = ios_pgr;
+		sdev->tot_ticks  = tot_ticks;
+		sdev->rq_ticks   = rq_ticks;
+
+		if (i >= 18) {
+			/* Discard I/O */
+			sdev->dc_ios     = dc_ios;
+			sdev->dc_merges  = dc_merges;
+			sdev->dc_sectors = dc_sec;
+			sdev->dc_ticks   = dc_ticks;
+		}
+
+		if (i >= 20) {
+			/* Flush I/O */
+			sdev->fl_ios     = fl_ios;
+			sdev->fl_ticks   = fl_ticks;
+		}
+		i = 0;
+	}
+	else if (i == 7) {
+		/* Partition without extended statistics */
+		sdev->rd_ios     = rd_ios;
+		sdev->rd_sectors = rd_merges_or_rd_sec;
+		sdev->wr_ios     = rd_sec_or_wr_ios;
+		sdev->wr_sectors = rd_ticks_or_wr_sec;
+		i = 1;
+	}
+	else
+		/* Unknown entry */
+		return -1;
+
+	/* Some devices may have a slash in their name (eg. cciss/c0d0...) */
+	while ((slash = strchr(dev_name, '/'))) {
+		*slash = '!';
+	}
+
+	return i;
+}
+
 /*
  ***************************************************************************
  * Read stats from the diskstats file. Only used when "-p ALL" has been
@@ -754,67 +1054,20 @@ void read_diskstats_stat_work(int curr, char *diskstats)
 	char line[256], dev_name[MAX_NAME_LEN];
 	struct io_device *d;
 	struct io_stats sdev;
-	int i;
-	unsigned int ios_pgr, tot_ticks, rq_ticks, wr_ticks, dc_ticks, fl_ticks;
-	unsigned long rd_ios, rd_merges_or_rd_sec, rd_ticks_or_wr_sec, wr_ios;
-	unsigned long wr_merges, rd_sec_or_wr_ios, wr_sec;
-	unsigned long dc_ios, dc_merges, dc_sec, fl_ios;
 	unsigned int major, minor;
+	int rc;
 
 	if ((fp = fopen(diskstats, "r")) == NULL)
 		return;
 
 	while (fgets(line, sizeof(line), fp) != NULL) {
 
-		memset(&sdev, 0, sizeof(struct io_stats));
-
-		/* major minor name rio rmerge rsect ruse wio wmerge wsect wuse running use aveq dcio dcmerge dcsect dcuse flio fltm */
-		i = sscanf(line, "%u %u %s %lu %lu %lu %lu %lu %lu %lu %u %u %u %u %lu %lu %lu %u %lu %u",
-			   &major, &minor, dev_name,
-			   &rd_ios, &rd_merges_or_rd_sec, &rd_sec_or_wr_ios, &rd_ticks_or_wr_sec,
-			   &wr_ios, &wr_merges, &wr_sec, &wr_ticks, &ios_pgr, &tot_ticks, &rq_ticks,
-			   &dc_ios, &dc_merges, &dc_sec, &dc_ticks,
-			   &fl_ios, &fl_ticks);
-
-		if (i >= 14) {
-			sdev.rd_ios     = rd_ios;
-			sdev.rd_merges  = rd_merges_or_rd_sec;
-			sdev.rd_sectors = rd_sec_or_wr_ios;
-			sdev.rd_ticks   = (unsigned int) rd_ticks_or_wr_sec;
-			sdev.wr_ios     = wr_ios;
-			sdev.wr_merges  = wr_merges;
-			sdev.wr_sectors = wr_sec;
-			sdev.wr_ticks   = wr_ticks;
-			sdev.ios_pgr    = ios_pgr;
-			sdev.tot_ticks  = tot_ticks;
-			sdev.rq_ticks   = rq_ticks;
-
-			if (i >= 18) {
-				/* Discard I/O */
-				sdev.dc_ios     = dc_ios;
-				sdev.dc_merges  = dc_merges;
-				sdev.dc_sectors = dc_sec;
-				sdev.dc_ticks   = dc_ticks;
-			}
+		if ((rc = read_diskstats_line(line, &major, &minor, dev_name, &sdev)) < 0)
+			/* Unknown entry: Ignore it */
+			continue;
 
-			if (i >= 20) {
-				/* Flush I/O */
-				sdev.fl_ios     = fl_ios;
-				sdev.fl_ticks   = fl_ticks;
-			}
-		}
-		else if (i == 7) {
+		if (rc && DISPLAY_EXTENDED(flags))
 			/* Partition without extended statistics */
-			if (DISPLAY_EXTENDED(flags))
-				continue;
-
-			sdev.rd_ios     = rd_ios;
-			sdev.rd_sectors = rd_merges_or_rd_sec;
-			sdev.wr_ios     = rd_sec_or_wr_ios;
-			sdev.wr_sectors = rd_ticks_or_wr_sec;
-		}
-		else
-			/* Unknown entry: Ignore it */
 			continue;
 
 		d = add_list_device(&dev_list, dev_name, 0);
@@ -829,66 +1082,221 @@ void read_diskstats_stat_work(int curr, char *diskstats)
 
 /*
  ***************************************************************************
- * Read stats from /proc/diskstats or an alternate diskstats file.
- * Only used when "-p ALL" has been entered on the command line.
+ * Get information about a block device from sysfs. This information is
+ * read only once for each device then saved.
+ *
+ * IN:
+ * @major	Major number of the device.
+ * @minor	Minor number of the device.
+ * @dev_name	Device name.
+ *
+ * RETURNS:
+ * Pointer on the structure containing device information.
+ ***************************************************************************
+ */
+struct blk_dev_info *get_blk_dev_info(unsigned int major, unsigned int minor,
+				      char *dev_name)
+{
+	struct blk_dev_info *bi;
+	unsigned int h = (major * 256 + minor) % IO_DEV_HASH_SIZE;
+	char link[MAX_PF_NAME], target[PATH_MAX];
+	char *p;
+	ssize_t r;
+
+	for (bi = blk_info_hash[h]; bi != NULL; bi = bi->next) {
+		if ((bi->major == major) && (bi->minor == minor))
+			return bi;
+	}
+
+	if ((bi = (struct blk_dev_info *) calloc(1, sizeof(struct blk_dev_info))) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	bi->major = major;
+	bi->minor = minor;
+	bi->next = blk_info_hash[h];
+	blk_info_hash[h] = bi;
+
+	/*
+	 * __sys/dev/block/M:m is a link to the device directory, which is
+	 * located in its whole device directory if this is a partition
+	 * (e.g. ../../block/sda/sda1).
+	 */
+	snprintf(link, sizeof(link), "%s/%u:%u", SYSFS_DEV_BLOCK, major, minor);
+	link[sizeof(link) - 1] = '\0';
+
+	r = readlink(link, target, sizeof(target));
+	if ((r <= 0) || (r >= sizeof(target))) {
+		/* Cannot read link: Look for the device in __sys/block directory */
+		bi->whole = is_device(SLASH_SYS, dev_name, ACCEPT_VIRTUAL_DEVICES);
+		return bi;
+	}
+	target[r] = '\0';
+
+	/* Remove trailing slashes then device name */
+	while ((r > 1) && (target[r - 1] == '/')) {
+		target[--r] = '\0';
+	}
+	if ((p = strrchr(target, '/')) != NULL) {
+		*p = '\0';
+	}
+	p = strrchr(target, '/');
+	p = (p ? p + 1 : target);
+
+	if (!strcmp(p, __BLOCK)) {
+		bi->whole = TRUE;
+	}
+	else {
+		strncpy(bi->parent, p, sizeof(bi->parent));
+		bi->parent[sizeof(bi->parent) - 1] = '\0';
+	}
+
+	return bi;
+}
+
+/*
+ ***************************************************************************
+ * Read stats from /proc/diskstats. The file is read in one go through a
+ * file descriptor which is kept open between samples. Only devices
+ * entered on the command line, their partitions if requested and all
+ * whole devices if "ALL" has been entered are saved, unless "-p ALL" has
+ * been used, in which case every device is saved.
  *
  * IN:
  * @curr	Index in array for current sample statistics.
+ *
+ * RETURNS:
+ * 0 on success, and -1 if /proc/diskstats couldn't be read.
  ***************************************************************************
  */
-void read_diskstats_stat(int curr)
+int read_proc_diskstats(int curr)
 {
-	char diskstats[MAX_PF_NAME];
+	static int fd = -1;
+	static char *buf = NULL;
+	static size_t buf_size = 0;
+	char *line, *next, dev_name[MAX_NAME_LEN];
+	struct io_device *d;
+	struct blk_dev_info *bi;
+	struct io_stats sdev;
+	unsigned int major, minor;
+	size_t len = 0;
+	ssize_t n;
+	int rc;
 
-	if (!alt_dir[0] || USE_ALL_DIR(flags)) {
-		/* Read stats from /proc/diskstats */
-		read_diskstats_stat_work(curr, DISKSTATS);
+	if ((fd < 0) && ((fd = open(DISKSTATS, O_RDONLY)) < 0))
+		return -1;
+
+	if (!buf_size) {
+		buf_size = 8192;
+		SREALLOC(buf, char, buf_size);
 	}
 
-	if (alt_dir[0]) {
-		snprintf(diskstats, sizeof(diskstats), "%s/%s", alt_dir, __DISKSTATS);
-		diskstats[sizeof(diskstats) - 1] = '\0';
-		/* Read stats from an alternate diskstats file */
-		read_diskstats_stat_work(curr, diskstats);
+	if (lseek(fd, 0, SEEK_SET) < 0) {
+		close(fd);
+		fd = -1;
+		return -1;
+	}
+
+	/* Read the whole file */
+	while ((n = read(fd, buf + len, buf_size - len - 1)) > 0) {
+		len += n;
+		if (len == buf_size - 1) {
+			buf_size *= 2;
+			SREALLOC(buf, char, buf_size);
+		}
 	}
+	buf[len] = '\0';
+
+#ifdef TEST
+	/* tests/root link changes between samples: Open file again next time */
+	close(fd);
+	fd = -1;
+#endif
+
+	for (line = buf; *line; line = next) {
+		if ((next = strchr(line, '\n')) != NULL) {
+			*(next++) = '\0';
+		}
+		else {
+			next = line + strlen(line);
+		}
+
+		if ((rc = read_diskstats_line(line, &major, &minor, dev_name, &sdev)) < 0)
+			/* Unknown entry: Ignore it */
+			continue;
+
+		if (rc && DISPLAY_EVERYTHING(flags) && DISPLAY_EXTENDED(flags))
+			/* Partition without extended statistics */
+			continue;
+
+		if ((d = search_list_device(dev_name)) == NULL) {
+			if (!DISPLAY_EVERYTHING(flags)) {
+				/*
+				 * Device not entered on the command line. Save it only
+				 * if this is a whole device and "ALL" has been entered,
+				 * or a partition of a device entered with option -p.
+				 */
+				bi = get_blk_dev_info(major, minor, dev_name);
+				if (bi->whole) {
+					if (!DISPLAY_ALL_DEVICES(flags))
+						continue;
+				}
+				else if (!bi->parent[0] ||
+					 ((d = search_list_device(bi->parent)) == NULL) ||
+					 (d->dev_tp != T_PART_DEV))
+					continue;
+			}
+			if ((d = add_list_device(&dev_list, dev_name, 0)) == NULL)
+				continue;
+
+			d->major = major;
+			d->minor = minor;
+		}
+		else if (d->dev_tp >= T_GROUP)
+			/* A group may have the same name as a device */
+			continue;
+		else {
+			d->major = major;
+			d->minor = minor;
+		}
+
+		*d->dev_stats[curr] = sdev;
+		d->exist = TRUE;
+
+		/* Add device stats to its group now */
+		add_device_group_stats(curr, d);
+	}
+
+	return 0;
 }
 
 /*
  ***************************************************************************
- * Add current device statistics to corresponding group.
+ * Read stats from /proc/diskstats or an alternate diskstats file.
+ * Only used when "-p ALL" has been entered on the command line.
  *
  * IN:
  * @curr	Index in array for current sample statistics.
- * @iodev_nr		Number of devices and partitions.
  ***************************************************************************
  */
-void compute_device_groups_stats(int curr, struct io_device *d, struct io_device *g)
+void read_diskstats_stat(int curr)
 {
-	if (!DISPLAY_UNFILTERED(flags)) {
-		if (!d->dev_stats[curr]->rd_ios &&
-		    !d->dev_stats[curr]->wr_ios &&
-		    !d->dev_stats[curr]->dc_ios &&
-		    !d->dev_stats[curr]->fl_ios)
-			return;
+	char diskstats[MAX_PF_NAME];
+
+	if (!alt_dir[0] || USE_ALL_DIR(flags)) {
+		/* Read stats from /proc/diskstats */
+		read_proc_diskstats(curr);
 	}
 
-	g->dev_stats[curr]->rd_ios     += d->dev_stats[curr]->rd_ios;
-	g->dev_stats[curr]->rd_merges  += d->dev_stats[curr]->rd_merges;
-	g->dev_stats[curr]->rd_sectors += d->dev_stats[curr]->rd_sectors;
-	g->dev_stats[curr]->rd_ticks   += d->dev_stats[curr]->rd_ticks;
-	g->dev_stats[curr]->wr_ios     += d->dev_stats[curr]->wr_ios;
-	g->dev_stats[curr]->wr_merges  += d->dev_stats[curr]->wr_merges;
-	g->dev_stats[curr]->wr_sectors += d->dev_stats[curr]->wr_sectors;
-	g->dev_stats[curr]->wr_ticks   += d->dev_stats[curr]->wr_ticks;
-	g->dev_stats[curr]->dc_ios     += d->dev_stats[curr]->dc_ios;
-	g->dev_stats[curr]->dc_merges  += d->dev_stats[curr]->dc_merges;
-	g->dev_stats[curr]->dc_sectors += d->dev_stats[curr]->dc_sectors;
-	g->dev_stats[curr]->dc_ticks   += d->dev_stats[curr]->dc_ticks;
-	g->dev_stats[curr]->fl_ios     += d->dev_stats[curr]->fl_ios;
-	g->dev_stats[curr]->fl_ticks   += d->dev_stats[curr]->fl_ticks;
-	g->dev_stats[curr]->ios_pgr    += d->dev_stats[curr]->ios_pgr;
-	g->dev_stats[curr]->tot_ticks  += d->dev_stats[curr]->tot_ticks;
-	g->dev_stats[curr]->rq_ticks   += d->dev_stats[curr]->rq_ticks;
+	if (alt_dir[0]) {
+		snprintf(diskstats, sizeof(diskstats), "%s/%s", alt_dir, __DISKSTATS);
+		diskstats[sizeof(diskstats) - 1] = '\0';
+		/* Read stats from an alternate diskstats file */
+		read_diskstats_stat_work(curr, diskstats);
+
+		/* Stats read from /proc/diskstats may have been replaced */
+		compute_device_groups_stats(curr);
+	}
 }
 
 /*
@@ -1784,11 +2192,9 @@ void write_stats(int curr, struct tm *rectime, int skip)
 							dtmp = g;
 							g = d;
 							d = dtmp;
-							memset(g->dev_stats[curr], 0, sizeof(struct io_stats));
 						}
 						else {
 							g = d;
-							memset(g->dev_stats[curr], 0, sizeof(struct io_stats));
 							continue;	/* No previous group to display */
 						}
 					}
@@ -1798,13 +2204,6 @@ void write_stats(int curr, struct tm *rectime, int skip)
 					/* Current device is non existent (e.g. it has been unregistered from the system */
 					continue;
 
-				if ((g != NULL) && (h == hl) && (d->dev_tp < T_GROUP)) {
-					/* We are within a group: Increment number of disks in the group */
-					(g->dev_tp)++;
-					/* Add current device stats to group */
-					compute_device_groups_stats(curr, d, g);
-				}
-
 				if (DISPLAY_GROUP_TOTAL_ONLY(flags) && (g != NULL) && (d->dev_tp < T_GROUP))
 					continue;
 
@@ -1908,6 +2307,76 @@ void write_stats(int curr, struct tm *rectime, int skip)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Save current disk statistics in system activity data file, so that they
+ * can be displayed later with sar or sadf. The file header is written
+ * with the first sample.
+ *
+ * IN:
+ * @curr	Index in array for current sample statistics.
+ * @ust_time	Time when current sample statistics were read, in seconds
+ *		since the Epoch.
+ * @rectime	Date and time when current sample statistics were read.
+ ***************************************************************************
+ */
+void write_sa_disk_stats(int curr, time_t ust_time, struct tm *rectime)
+{
+	static int hdr_written = FALSE;
+	struct io_device *d;
+	struct stats_disk *sdi;
+	struct io_stats *ioi;
+	__nr_t nr = 0;
+
+	/* Count number of devices to save (groups are not saved) */
+	for (d = dev_list; d != NULL; d = d->next) {
+		if (d->exist && (d->dev_tp < T_GROUP)) {
+			nr++;
+		}
+	}
+
+	if (nr > st_disk_nr) {
+		SREALLOC(st_disk, struct stats_disk, STATS_DISK_SIZE * nr);
+		st_disk_nr = nr;
+	}
+
+	for (d = dev_list, sdi = st_disk; d != NULL; d = d->next) {
+		if (!d->exist || (d->dev_tp >= T_GROUP))
+			continue;
+
+		ioi = d->dev_stats[curr];
+		memset(sdi, 0, STATS_DISK_SIZE);
+		sdi->major     = d->major;
+		sdi->minor     = d->minor;
+		sdi->nr_ios    = (unsigned long long) ioi->rd_ios +
+				 (unsigned long long) ioi->wr_ios +
+				 (unsigned long long) ioi->dc_ios;
+		sdi->rd_sect   = ioi->rd_sectors;
+		sdi->wr_sect   = ioi->wr_sectors;
+		sdi->dc_sect   = ioi->dc_sectors;
+		sdi->rd_ticks  = ioi->rd_ticks;
+		sdi->wr_ticks  = ioi->wr_ticks;
+		sdi->dc_ticks  = ioi->dc_ticks;
+		sdi->tot_ticks = ioi->tot_ticks;
+		sdi->rq_ticks  = ioi->rq_ticks;
+
+		if (get_wwnid_from_pretty(d->name, sdi->wwn, &(sdi->part_nr)) < 0) {
+			sdi->wwn[0] = 0ULL;
+		}
+		sdi++;
+	}
+
+	if ((!hdr_written &&
+	     (write_disk_file_hdr(sa_fd, cpu_nr + 1, nr, ust_time, rectime) < 0)) ||
+	    (write_disk_record(sa_fd, uptime_cs[curr], ust_time, rectime,
+			       st_disk, nr) < 0)) {
+		fprintf(stderr, _("Cannot write data to system activity file: %s\n"),
+			strerror(errno));
+		exit(2);
+	}
+	hdr_written = TRUE;
+}
+
 /*
  ***************************************************************************
  * Main loop: Read I/O stats from the relevant sources and display them.
@@ -1921,6 +2390,7 @@ void rw_io_stat_loop(long int count, struct tm *rectime)
 {
 	int curr = 1;
 	int skip = 0;
+	time_t ust_time;
 
 	/* Should we skip first report? */
 	if (DISPLAY_OMIT_SINCE_BOOT(flags) && interval > 0) {
@@ -1941,6 +2411,7 @@ void rw_io_stat_loop(long int count, struct tm *rectime)
 	do {
 		/* Every device is potentially nonexistent */
 		set_devices_nonexistent(dev_list);
+		init_device_groups_stats(curr);
 
 		/* Read system uptime */
 		read_uptime(&(uptime_cs[curr]));
@@ -1961,15 +2432,32 @@ void rw_io_stat_loop(long int count, struct tm *rectime)
 		if (DISPLAY_EVERYTHING(flags)) {
 			read_diskstats_stat(curr);
 		}
-		else {
+		else if (alt_dir[0] || (dev_nr < DISKSTATS_MIN_DEV) ||
+			 (read_proc_diskstats(curr) < 0)) {
+			/*
+			 * Alternate directories may not contain a diskstats file:
+			 * Read stats from sysfs in this case. Also read them from
+			 * sysfs when only a few devices are to be read (e.g. for the
+			 * first sample with "ALL", the list being still empty): Opening
+			 * their stat files costs less than parsing the whole
+			 * /proc/diskstats file.
+			 */
 			read_sysfs_dlist_stat(curr);
+			compute_device_groups_stats(curr);
 		}
 
 		/* Get time */
-		get_localtime(rectime, 0);
+		ust_time = get_localtime(rectime, 0);
+
+		if (USE_SA_FILE(flags)) {
+			/* Save disk stats in system activity data file */
+			write_sa_disk_stats(curr, ust_time, rectime);
+		}
 
 		/* Print results */
-		write_stats(curr, rectime, skip);
+		if (DISPLAY_CPU(flags) || DISPLAY_DISK(flags)) {
+			write_stats(curr, rectime, skip);
+		}
 
 		if (!skip) {
 			if (count > 0) {
@@ -1990,7 +2478,9 @@ void rw_io_stat_loop(long int count, struct tm *rectime)
 			}
 			skip = 0;
 		}
-		printf("\n");
+		if (DISPLAY_CPU(flags) || DISPLAY_DISK(flags)) {
+			printf("\n");
+		}
 	}
 	while (count);
 
@@ -2008,7 +2498,7 @@ int main(int argc, char **argv)
 {
 	int it = 0;
 	int opt = 1;
-	int i, report_set = FALSE;
+	int i, report_set = FALSE, display;
 	long count = 1;
 	struct utsname header;
 	struct tm rectime;
@@ -2142,6 +2632,17 @@ int main(int argc, char **argv)
 			}
 		}
 
+		else if (!strncmp(argv[opt], "--save=", 7)) {
+			/* Save stats in a system activity data file */
+			if (USE_SA_FILE(flags) || !argv[opt][7]) {
+				usage(argv[0]);
+			}
+			flags |= I_F_SA_FILE;
+			strncpy(sa_file, argv[opt] + 7, sizeof(sa_file));
+			sa_file[sizeof(sa_file) - 1] = '\0';
+			opt++;
+		}
+
 #ifdef DEBUG
 		else if (!strcmp(argv[opt], "--debuginfo")) {
 			flags |= I_D_DEBUG;
@@ -2292,16 +2793,23 @@ int main(int argc, char **argv)
 	/* Init color strings */
 	init_colors();
 
+	/*
+	 * When stats are saved in a file, reports are displayed only
+	 * if explicitly requested with options -c, -d, -x or -o JSON.
+	 */
+	display = !USE_SA_FILE(flags) || report_set ||
+		  DISPLAY_EXTENDED(flags) || DISPLAY_JSON_OUTPUT(flags);
+
 	/* Default: Display CPU and DISK reports */
-	if (!report_set) {
+	if (!report_set && display) {
 		flags |= I_D_CPU + I_D_DISK;
 	}
 	/*
 	 * Also display DISK reports if options -p, -x or a device has been entered
 	 * on the command line.
 	 */
-	if (DISPLAY_EVERYTHING(flags) || DISPLAY_EXTENDED(flags) ||
-	    DISPLAY_UNFILTERED(flags)) {
+	if ((DISPLAY_EVERYTHING(flags) || DISPLAY_EXTENDED(flags) ||
+	     DISPLAY_UNFILTERED(flags)) && display) {
 		flags |= I_D_DISK;
 	}
 
@@ -2336,19 +2844,35 @@ int main(int argc, char **argv)
 	 */
 	setbuf(stdout, NULL);
 
-	/* Get system name, release number and hostname */
-	__uname(&header);
-	if (print_gal_header(&rectime, header.sysname, header.release,
-			     header.nodename, header.machine, cpu_nr,
-			     DISPLAY_JSON_OUTPUT(flags))) {
-		flags |= I_D_ISO;
+	if (USE_SA_FILE(flags)) {
+		/* Create system activity data file */
+		if ((sa_fd = open(sa_file, O_CREAT | O_WRONLY | O_TRUNC,
+				  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) < 0) {
+			fprintf(stderr, _("Cannot open %s: %s\n"), sa_file, strerror(errno));
+			exit(2);
+		}
+		get_HZ();
 	}
-	if (!DISPLAY_JSON_OUTPUT(flags)) {
-		printf("\n");
+
+	if (display) {
+		/* Get system name, release number and hostname */
+		__uname(&header);
+		if (print_gal_header(&rectime, header.sysname, header.release,
+				     header.nodename, header.machine, cpu_nr,
+				     DISPLAY_JSON_OUTPUT(flags))) {
+			flags |= I_D_ISO;
+		}
+		if (!DISPLAY_JSON_OUTPUT(flags)) {
+			printf("\n");
+		}
 	}
 
 	/* Main loop */
 	rw_io_stat_loop(count, &rectime);
 
+	if (sa_fd >= 0) {
+		close(sa_fd);
+	}
+
 	return 0;
 }
@@ -7,6 +7,7 @@
 #define _IOSTAT_H
 
 #include "common.h"
+#include "rd_stats.h"
 
 /* I_: iostat - D_: Display - F_: Flag */
 #define I_D_CPU			0x000001
@@ -31,6 +32,7 @@
 #define I_D_ZERO_OMIT		0x080000
 #define I_D_UNIT		0x100000
 #define I_D_SHORT_OUTPUT	0x200000
+#define I_F_SA_FILE		0x400000
 
 #define DISPLAY_CPU(m)			(((m) & I_D_CPU)              == I_D_CPU)
 #define DISPLAY_DISK(m)			(((m) & I_D_DISK)             == I_D_DISK)
@@ -54,12 +56,22 @@
 #define DISPLAY_UNIT(m)			(((m) & I_D_UNIT)	      == I_D_UNIT)
 #define DISPLAY_SHORT_OUTPUT(m)		(((m) & I_D_SHORT_OUTPUT)     == I_D_SHORT_OUTPUT)
 #define USE_ALL_DIR(m)			(((m) & I_D_ALL_DIR)          == I_D_ALL_DIR)
+#define USE_SA_FILE(m)			(((m) & I_F_SA_FILE)          == I_F_SA_FILE)
 
 #define T_PART		0
 #define T_DEV		1
 #define T_PART_DEV	2
 #define T_GROUP		3
 
+/* Size of hash tables used to find devices read from /proc/diskstats */
+#define IO_DEV_HASH_SIZE	1024
+
+/*
+ * Min number of devices and partitions to read for /proc/diskstats to be
+ * used instead of one sysfs stat file per device.
+ */
+#define DISKSTATS_MIN_DEV	32
+
 /* Environment variable */
 #define ENV_POSIXLY_CORRECT	"POSIXLY_CORRECT"
 
@@ -117,11 +129,36 @@ struct io_device {
 	int dev_tp;
 	/* TRUE if device exists in /proc/diskstats or /sys. Don't apply for groups. */
 	int exist;
-	/* major and minor numbers are set only for partitions (T_PART), not whole devices */
+	/*
+	 * major and minor numbers are set for every device read from a diskstats file.
+	 * Else they are read from sysfs or from /dev.
+	 */
 	int major;
 	int minor;
 	struct io_stats *dev_stats[2];
 	struct io_device *next;
+	/* Next device in list with same name hash value */
+	struct io_device *hnext;
+	/* Group this device belongs to (NULL if none), and next device in this group */
+	struct io_device *group;
+	struct io_device *gnext;
+	/* Groups only: First and last devices belonging to the group */
+	struct io_device *gfirst;
+	struct io_device *glast;
+};
+
+/*
+ * Block device information read from sysfs, which is not available
+ * in /proc/diskstats. Saved the first time a device is met.
+ */
+struct blk_dev_info {
+	unsigned int major;
+	unsigned int minor;
+	/* TRUE if this is a whole device */
+	int whole;
+	/* Name of whole device this partition belongs to (may be empty) */
+	char parent[MAX_NAME_LEN];
+	struct blk_dev_info *next;
 };
 
 struct ext_io_stats {
@@ -155,4 +192,15 @@ struct ext_io_stats {
 	double darqsz;
 };
 
+/*
+ ***************************************************************************
+ * Functions used to save statistics in a system activity data file
+ * (defined in sa_common.c).
+ ***************************************************************************
+ */
+int write_disk_file_hdr
+	(int, unsigned int, __nr_t, time_t, struct tm *);
+int write_disk_record
+	(int, unsigned long long, time_t, struct tm *, struct stats_disk *, __nr_t);
+
 #endif  /* _IOSTAT_H */
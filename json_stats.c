@@ -36,6 +36,7 @@
 #endif
 
 extern uint64_t flags;
+extern char *cpu_grp_name[];
 
 /*
  ***************************************************************************
@@ -121,6 +122,77 @@ void json_markup_psi(int tab, int action)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Display CPU utilization values for a CPU or a group of CPU in JSON.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @tab		Indentation in output.
+ * @cpuno	Name of the CPU or group of CPU.
+ * @scc		Current CPU statistics.
+ * @scp		CPU statistics used as reference.
+ * @deltot_jiffies
+ *		Number of jiffies spent on the interval by the CPU.
+ ***************************************************************************
+ */
+static void json_print_cpu_values(struct activity *a, int tab, char *cpuno, struct stats_cpu *scc,
+				  struct stats_cpu *scp, unsigned long long deltot_jiffies)
+{
+	if (DISPLAY_CPU_DEF(a->opt_flags)) {
+		xprintf0(tab, "{\"cpu\": \"%s\", "
+			 "\"user\": %.2f, "
+			 "\"nice\": %.2f, "
+			 "\"system\": %.2f, "
+			 "\"iowait\": %.2f, "
+			 "\"steal\": %.2f, "
+			 "\"idle\": %.2f}",
+			 cpuno,
+			 ll_sp_value(scp->cpu_user, scc->cpu_user, deltot_jiffies),
+			 ll_sp_value(scp->cpu_nice, scc->cpu_nice, deltot_jiffies),
+			 ll_sp_value(scp->cpu_sys + scp->cpu_hardirq + scp->cpu_softirq,
+				     scc->cpu_sys + scc->cpu_hardirq + scc->cpu_softirq,
+				     deltot_jiffies),
+			 ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
+			 ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
+			 scc->cpu_idle < scp->cpu_idle ?
+			 0.0 :
+			 ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
+	}
+	else if (DISPLAY_CPU_ALL(a->opt_flags)) {
+		xprintf0(tab, "{\"cpu\": \"%s\", "
+			 "\"usr\": %.2f, "
+			 "\"nice\": %.2f, "
+			 "\"sys\": %.2f, "
+			 "\"iowait\": %.2f, "
+			 "\"steal\": %.2f, "
+			 "\"irq\": %.2f, "
+			 "\"soft\": %.2f, "
+			 "\"guest\": %.2f, "
+			 "\"gnice\": %.2f, "
+			 "\"idle\": %.2f}",
+			 cpuno,
+			 (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
+			 0.0 :
+			 ll_sp_value(scp->cpu_user - scp->cpu_guest,
+				     scc->cpu_user - scc->cpu_guest, deltot_jiffies),
+			 (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
+			 0.0 :
+			 ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
+				     scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies),
+			 ll_sp_value(scp->cpu_sys, scc->cpu_sys, deltot_jiffies),
+			 ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
+			 ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
+			 ll_sp_value(scp->cpu_hardirq, scc->cpu_hardirq, deltot_jiffies),
+			 ll_sp_value(scp->cpu_softirq, scc->cpu_softirq, deltot_jiffies),
+			 ll_sp_value(scp->cpu_guest, scc->cpu_guest, deltot_jiffies),
+			 ll_sp_value(scp->cpu_guest_nice, scc->cpu_guest_nice, deltot_jiffies),
+			 scc->cpu_idle < scp->cpu_idle ?
+			 0.0 :
+			 ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
+	}
+}
+
 /*
  ***************************************************************************
  * Display CPU statistics in JSON.
@@ -136,10 +208,10 @@ void json_markup_psi(int tab, int action)
 __print_funct_t json_print_cpu_stats(struct activity *a, int curr, int tab,
 				     unsigned long long itv)
 {
-	int i;
+	int i, g, grp_nr;
 	int sep = FALSE;
 	unsigned long long deltot_jiffies = 1;
-	struct stats_cpu *scc, *scp;
+	struct stats_cpu *scc, *scp, *sgc, *sgp;
 	unsigned char offline_cpu_bitmap[BITMAP_SIZE(NR_CPUS)] = {0};
 	char cpuno[16];
 
@@ -231,57 +303,31 @@ __print_funct_t json_print_cpu_stats(struct activity *a, int curr, int tab,
 			}
 		}
 
-		if (DISPLAY_CPU_DEF(a->opt_flags)) {
-			xprintf0(tab, "{\"cpu\": \"%s\", "
-				 "\"user\": %.2f, "
-				 "\"nice\": %.2f, "
-				 "\"system\": %.2f, "
-				 "\"iowait\": %.2f, "
-				 "\"steal\": %.2f, "
-				 "\"idle\": %.2f}",
-				 cpuno,
-				 ll_sp_value(scp->cpu_user, scc->cpu_user, deltot_jiffies),
-				 ll_sp_value(scp->cpu_nice, scc->cpu_nice, deltot_jiffies),
-				 ll_sp_value(scp->cpu_sys + scp->cpu_hardirq + scp->cpu_softirq,
-					     scc->cpu_sys + scc->cpu_hardirq + scc->cpu_softirq,
-					     deltot_jiffies),
-				 ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
-				 ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
-				 scc->cpu_idle < scp->cpu_idle ?
-				 0.0 :
-				 ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
-		}
-		else if (DISPLAY_CPU_ALL(a->opt_flags)) {
-			xprintf0(tab, "{\"cpu\": \"%s\", "
-				 "\"usr\": %.2f, "
-				 "\"nice\": %.2f, "
-				 "\"sys\": %.2f, "
-				 "\"iowait\": %.2f, "
-				 "\"steal\": %.2f, "
-				 "\"irq\": %.2f, "
-				 "\"soft\": %.2f, "
-				 "\"guest\": %.2f, "
-				 "\"gnice\": %.2f, "
-				 "\"idle\": %.2f}",
-				 cpuno,
-				 (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
-				 0.0 :
-				 ll_sp_value(scp->cpu_user - scp->cpu_guest,
-					     scc->cpu_user - scc->cpu_guest, deltot_jiffies),
-				 (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
-				 0.0 :
-				 ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
-					     scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies),
-				 ll_sp_value(scp->cpu_sys, scc->cpu_sys, deltot_jiffies),
-				 ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
-				 ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
-				 ll_sp_value(scp->cpu_hardirq, scc->cpu_hardirq, deltot_jiffies),
-				 ll_sp_value(scp->cpu_softirq, scc->cpu_softirq, deltot_jiffies),
-				 ll_sp_value(scp->cpu_guest, scc->cpu_guest, deltot_jiffies),
-				 ll_sp_value(scp->cpu_guest_nice, scc->cpu_guest_nice, deltot_jiffies),
-				 scc->cpu_idle < scp->cpu_idle ?
-				 0.0 :
-				 ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
+		json_print_cpu_values(a, tab, cpuno, scc, scp, deltot_jiffies);
+	}
+
+	/* Now display statistics for each node and/or socket */
+	for (g = 0; g < CPU_GRP_NR; g++) {
+
+		if (!DISPLAY_CPU_GRP(a->opt_flags, g))
+			continue;
+
+		grp_nr = get_cpu_grp_statistics(a, !curr, curr, flags, g,
+						offline_cpu_bitmap, &sgp, &sgc);
+
+		for (i = 1; i <= grp_nr; i++) {
+
+			/* Groups with no CPU (or no activity) are not displayed */
+			if (!(deltot_jiffies = get_per_cpu_interval(sgc + i, sgp + i)))
+				continue;
+
+			if (sep) {
+				printf(",\n");
+			}
+			sep = TRUE;
+
+			snprintf(cpuno, sizeof(cpuno), "%s%d", cpu_grp_name[g], i - 1);
+			json_print_cpu_values(a, tab, cpuno, sgc + i, sgp + i, deltot_jiffies);
 		}
 	}
 
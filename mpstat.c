@@ -25,6 +25,7 @@
 #include <unistd.h>
 #include <signal.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <ctype.h>
 #include <sys/utsname.h>
@@ -67,8 +68,21 @@ struct stats_irq *st_irq[3];
  * Structures used to save, for each interrupt, the number
  * received by each CPU.
  */
-struct stats_irqcpu *st_irqcpu[3];
-struct stats_irqcpu *st_softirqcpu[3];
+struct stats_irqs st_irqcpu[3];
+struct stats_irqs st_softirqcpu[3];
+
+/* Files containing interrupts statistics */
+struct irq_file irq_file = {INTERRUPTS, -1, NULL, 0};
+struct irq_file softirq_file = {SOFTIRQS, -1, NULL, 0};
+
+/*
+ * Values last displayed for each CPU (option --changed).
+ * Index 0 is CPU "all", index 1 is CPU 0, etc.
+ */
+double *cpu_last_pc = NULL;
+double *isum_last = NULL;
+struct cpu_irq_rates *irq_last = NULL;
+struct cpu_irq_rates *softirq_last = NULL;
 
 /*
  * Number of CPU per node, e.g.:
@@ -98,6 +112,11 @@ unsigned int flags = 0;
 long interval = -1, count = 0;
 /* Number of decimal places */
 int dplaces_nr = -1;
+/* Minimum change in values for a CPU to be displayed (option --changed) */
+double changed_threshold = 0.0;
+/* Nb of samples displayed, and TRUE if all CPU must be displayed for current one */
+unsigned long sample_nr = 0;
+int keyframe = TRUE;
 
 /*
  * Nb of processors on the machine.
@@ -137,7 +156,8 @@ void usage(char *progname)
 	fprintf(stderr, _("Options are:\n"
 			  "[ -A ] [ -n ] [ -T ] [ -u ] [ -V ]\n"
 			  "[ -I { SUM | CPU | SCPU | ALL } ] [ -N { <node_list> | ALL } ]\n"
-			  "[ --dec={ 0 | 1 | 2 } ] [ -o JSON ] [ -P { <cpu_list> | ALL } ]\n"));
+			  "[ --dec={ 0 | 1 | 2 } ] [ -o JSON ] [ -P { <cpu_list> | ALL } ]\n"
+			  "[ --changed <threshold> ]\n"));
 	exit(1);
 }
 
@@ -205,19 +225,20 @@ void salloc_mp_struct(int nr_cpus)
 		}
 		memset(st_irq[i], 0, STATS_IRQ_SIZE * nr_cpus);
 
-		if ((st_irqcpu[i] = (struct stats_irqcpu *) malloc(STATS_IRQCPU_SIZE * nr_cpus * irqcpu_nr))
+		/* Per-CPU values are allocated when interrupts are read */
+		if ((st_irqcpu[i].irq = (struct stats_irqcpu *) malloc(STATS_IRQCPU_SIZE * irqcpu_nr))
 		    == NULL) {
 			perror("malloc");
 			exit(4);
 		}
-		memset(st_irqcpu[i], 0, STATS_IRQCPU_SIZE * nr_cpus * irqcpu_nr);
+		memset(st_irqcpu[i].irq, 0, STATS_IRQCPU_SIZE * irqcpu_nr);
 
-		if ((st_softirqcpu[i] = (struct stats_irqcpu *) malloc(STATS_IRQCPU_SIZE * nr_cpus * softirqcpu_nr))
+		if ((st_softirqcpu[i].irq = (struct stats_irqcpu *) malloc(STATS_IRQCPU_SIZE * softirqcpu_nr))
 		     == NULL) {
 			perror("malloc");
 			exit(4);
 		}
-		memset(st_softirqcpu[i], 0, STATS_IRQCPU_SIZE * nr_cpus * softirqcpu_nr);
+		memset(st_softirqcpu[i].irq, 0, STATS_IRQCPU_SIZE * softirqcpu_nr);
 	}
 
 	if ((cpu_bitmap = (unsigned char *) malloc((nr_cpus >> 3) + 1)) == NULL) {
@@ -248,6 +269,43 @@ void salloc_mp_struct(int nr_cpus)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Allocate structures used to save the values last displayed for each CPU
+ * (option --changed).
+ *
+ * IN:
+ * @nr_cpus	Number of CPUs. This is the real number of available CPUs + 1
+ * 		because we also have to allocate a structure for CPU 'all'.
+ ***************************************************************************
+ */
+void salloc_changed_struct(int nr_cpus)
+{
+	if ((cpu_last_pc = (double *) malloc(sizeof(double) * NR_CPU_PC * nr_cpus)) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	memset(cpu_last_pc, 0, sizeof(double) * NR_CPU_PC * nr_cpus);
+
+	if ((isum_last = (double *) malloc(sizeof(double) * nr_cpus)) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	memset(isum_last, 0, sizeof(double) * nr_cpus);
+
+	if ((irq_last = (struct cpu_irq_rates *) malloc(sizeof(struct cpu_irq_rates) * nr_cpus)) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	memset(irq_last, 0, sizeof(struct cpu_irq_rates) * nr_cpus);
+
+	if ((softirq_last = (struct cpu_irq_rates *) malloc(sizeof(struct cpu_irq_rates) * nr_cpus)) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	memset(softirq_last, 0, sizeof(struct cpu_irq_rates) * nr_cpus);
+}
+
 /*
  ***************************************************************************
  * Free structures and bitmap.
@@ -261,220 +319,230 @@ void sfree_mp_struct(void)
 		free(st_cpu[i]);
 		free(st_node[i]);
 		free(st_irq[i]);
-		free(st_irqcpu[i]);
-		free(st_softirqcpu[i]);
+		free(st_irqcpu[i].irq);
+		free(st_irqcpu[i].val);
+		free(st_softirqcpu[i].irq);
+		free(st_softirqcpu[i].val);
 	}
 
 	free(cpu_bitmap);
 	free(node_bitmap);
 	free(cpu_per_node);
 	free(cpu2node);
+
+	free(cpu_last_pc);
+	free(isum_last);
+	if (irq_last) {
+		for (i = 0; i <= cpu_nr; i++) {
+			free(irq_last[i].r);
+			free(softirq_last[i].r);
+		}
+		free(irq_last);
+		free(softirq_last);
+	}
+
+	if (irq_file.fd >= 0) {
+		close(irq_file.fd);
+	}
+	free(irq_file.buf);
+	if (softirq_file.fd >= 0) {
+		close(softirq_file.fd);
+	}
+	free(softirq_file.buf);
 }
 
 /*
  ***************************************************************************
- * Get node placement (which node each CPU belongs to, and total number of
- * CPU that each node has).
+ * Reset interrupts statistics for a sample. All the interrupts become
+ * dummy ones, with no values.
  *
  * IN:
- * @nr_cpus		Number of CPU on this machine.
- *
- * OUT:
- * @cpu_per_node	Number of CPU per node.
- * @cpu2node		The node the CPU belongs to.
- *
- * RETURNS:
- * Highest node number found (e.g., 0 means node 0).
- * A value of -1 means no nodes have been found.
+ * @st_ic	Interrupts statistics for the sample.
+ * @ic_nr	Number of interrupts (hard or soft) per CPU.
  ***************************************************************************
  */
-int get_node_placement(int nr_cpus, int cpu_per_node[], int cpu2node[])
-
+void reset_irqs_sample(struct stats_irqs *st_ic, int ic_nr)
 {
-	DIR *dir;
-	struct dirent *drd;
-	char line[MAX_PF_NAME];
-	int cpu, node, hi_node_nr = -1;
-
-	/* Init number of CPU per node */
-	memset(cpu_per_node, 0, sizeof(int) * (nr_cpus + 1));
-	/* CPU belongs to no node by default */
-	memset(cpu2node, -1, sizeof(int) * nr_cpus);
-
-	/* This is node "all" */
-	cpu_per_node[0] = nr_cpus;
-
-	for (cpu = 0; cpu < nr_cpus; cpu++) {
-		snprintf(line, sizeof(line), "%s/cpu%d", SYSFS_DEVCPU, cpu);
-		line[sizeof(line) - 1] = '\0';
-
-		/* Open relevant /sys directory */
-		if ((dir = opendir(line)) == NULL)
-			return -1;
-
-		/* Get current file entry */
-		while ((drd = readdir(dir)) != NULL) {
-
-			if (!strncmp(drd->d_name, "node", 4) && isdigit(drd->d_name[4])) {
-				node = atoi(drd->d_name + 4);
-				if ((node >= nr_cpus) || (node < 0)) {
-					/* Assume we cannot have more nodes than CPU */
-					closedir(dir);
-					return -1;
-				}
-				cpu_per_node[node + 1]++;
-				cpu2node[cpu] = node;
-				if (node > hi_node_nr) {
-					hi_node_nr = node;
-				}
-				/* Node placement found for current CPU: Go to next CPU directory */
-				break;
-			}
-		}
-
-		/* Close directory */
-		closedir(dir);
-	}
-
-	return hi_node_nr;
+	memset(st_ic->irq, 0, STATS_IRQCPU_SIZE * ic_nr);
+	st_ic->val_nr = 0;
 }
 
 /*
  ***************************************************************************
- * Read system logical topology: Socket number for each logical core is read
- * from the /sys/devices/system/cpu/cpu{N}/topology/physical_package_id file,
- * and the logical core id number is the first number read from the
- * /sys/devices/system/cpu/cpu{N}/topology/thread_siblings_list file.
- * Don't use /sys/devices/system/cpu/cpu{N}/topology/core_id as this is the
- * physical core id (seems to be different from the number displayed by lscpu).
+ * Copy interrupts statistics from one sample to another.
  *
  * IN:
- * @nr_cpus	Number of CPU on this machine.
- * @cpu_topo	Structures where socket and core id numbers will be saved.
+ * @src		Interrupts statistics to copy.
+ * @ic_nr	Number of interrupts (hard or soft) per CPU.
  *
  * OUT:
- * @cpu_topo	Structures where socket and core id numbers have been saved.
+ * @dest	Copy of interrupts statistics.
  ***************************************************************************
  */
-void read_topology(int nr_cpus, struct cpu_topology *cpu_topo)
+void copy_irqs_sample(struct stats_irqs *dest, struct stats_irqs *src, int ic_nr)
 {
-	struct cpu_topology *cpu_topo_i;
-	FILE *fp;
-	char filename[MAX_PF_NAME];
-	int cpu, rc;
+	memcpy(dest->irq, src->irq, STATS_IRQCPU_SIZE * ic_nr);
 
-	/* Init system topology */
-	memset(st_cpu_topology, 0, sizeof(struct cpu_topology) * nr_cpus);
-
-	for (cpu = 0; cpu < nr_cpus; cpu++) {
-
-		cpu_topo_i = cpu_topo + cpu;
-
-		/* Read current CPU's socket number */
-		snprintf(filename, sizeof(filename), "%s/cpu%d/%s", SYSFS_DEVCPU, cpu, PHYS_PACK_ID);
-		filename[sizeof(filename) - 1] = '\0';
-
-		if ((fp = fopen(filename, "r")) != NULL) {
-			rc = fscanf(fp, "%d", &cpu_topo_i->phys_package_id);
-			fclose(fp);
-
-			if (rc < 1) {
-				cpu_topo_i->phys_package_id = -1;
-			}
-		}
-
-		/* Read current CPU's logical core id number */
-		snprintf(filename, sizeof(filename), "%s/cpu%d/%s", SYSFS_DEVCPU, cpu, THREAD_SBL_LST);
-		filename[sizeof(filename) - 1] = '\0';
+	if (dest->val_sz < src->val_nr) {
+		SREALLOC(dest->val, struct irqcpu_val, sizeof(struct irqcpu_val) * src->val_nr);
+		dest->val_sz = src->val_nr;
+	}
+	if (src->val_nr) {
+		memcpy(dest->val, src->val, sizeof(struct irqcpu_val) * src->val_nr);
+	}
+	dest->val_nr = src->val_nr;
+}
 
-		if ((fp = fopen(filename, "r")) != NULL) {
-			rc = fscanf(fp, "%d", &cpu_topo_i->logical_core_id);
-			fclose(fp);
+/*
+ ***************************************************************************
+ * Set the cursor of each interrupt to its first value, so that values can
+ * then be retrieved with get_irqcpu_value() for increasing CPU numbers.
+ *
+ * IN:
+ * @st_ic	Interrupts statistics for the sample.
+ * @ic_nr	Number of interrupts (hard or soft) per CPU.
+ ***************************************************************************
+ */
+void rewind_irqs_sample(struct stats_irqs *st_ic, int ic_nr)
+{
+	int j;
 
-			if (rc < 1) {
-				cpu_topo_i->logical_core_id = -1;
-			}
-		}
+	for (j = 0; j < ic_nr; j++) {
+		st_ic->irq[j].pos = st_ic->irq[j].first;
 	}
 }
 
 /*
  ***************************************************************************
- * Compute node statistics: Split CPU statistics among nodes.
+ * Get the number of interrupts received by a CPU for a given interrupt.
+ * CPU numbers must be given in increasing order between two calls to
+ * rewind_irqs_sample().
  *
  * IN:
- * @src		Structure containing CPU stats to add.
+ * @st_ic	Interrupts statistics for the sample.
+ * @irq		Position of the interrupt in the list.
+ * @cpu		CPU number (0 for CPU 0).
  *
- * OUT:
- * @dest	Structure containing global CPU stats.
+ * RETURNS:
+ * Number of interrupts received by the CPU (0 if no values saved for it).
  ***************************************************************************
  */
-void add_cpu_stats(struct stats_cpu *dest, struct stats_cpu *src)
+unsigned int get_irqcpu_value(struct stats_irqs *st_ic, int irq, unsigned int cpu)
 {
-	dest->cpu_user       += src->cpu_user;
-	dest->cpu_nice       += src->cpu_nice;
-	dest->cpu_sys        += src->cpu_sys;
-	dest->cpu_idle       += src->cpu_idle;
-	dest->cpu_iowait     += src->cpu_iowait;
-	dest->cpu_hardirq    += src->cpu_hardirq;
-	dest->cpu_softirq    += src->cpu_softirq;
-	dest->cpu_steal      += src->cpu_steal;
-	dest->cpu_guest      += src->cpu_guest;
-	dest->cpu_guest_nice += src->cpu_guest_nice;
+	struct stats_irqcpu *p = st_ic->irq + irq;
+	struct irqcpu_val *v;
+
+	while (p->pos < p->first + p->nr) {
+		v = st_ic->val + p->pos;
+		if (v->cpu == cpu)
+			return v->interrupt;
+		if (v->cpu > cpu)
+			break;
+		p->pos++;
+	}
+
+	return 0;
 }
 
 /*
  ***************************************************************************
- * Compute node statistics: Split CPU statistics among nodes.
+ * Check if values for a CPU have changed enough since they were last
+ * displayed (option --changed). If so, they are saved as the new values
+ * last displayed.
  *
  * IN:
- * @prev	Index in array where stats used as reference are.
- * @curr	Index in array for current sample statistics.
+ * @last	Values last displayed.
+ * @val		Current values.
+ * @nr		Number of values.
  *
  * OUT:
- * @st_node	Array where CPU stats for each node have been saved.
+ * @last	Values last displayed, updated if current ones are to be
+ *		displayed.
+ *
+ * RETURNS:
+ * TRUE if current values should be displayed.
  ***************************************************************************
  */
-void set_node_cpu_stats(int prev, int curr)
+int check_changed_values(double last[], double val[], int nr)
 {
-	int cpu;
-	unsigned long long tot_jiffies_p;
-	struct stats_cpu *scp, *scc, *snp, *snc;
-	struct stats_cpu *scc_all = st_cpu[curr];
-	struct stats_cpu *scp_all = st_cpu[prev];
-	struct stats_cpu *snc_all = st_node[curr];
-	struct stats_cpu *snp_all = st_node[prev];
+	int i;
 
-	/* Reset structures */
-	memset(st_node[prev], 0, STATS_CPU_SIZE * (cpu_nr + 1));
-	memset(st_node[curr], 0, STATS_CPU_SIZE * (cpu_nr + 1));
+	if (!DISPLAY_CHANGED_ONLY(flags))
+		return TRUE;
 
-	/* Node 'all' is the same as CPU 'all' */
-	*snp_all = *scp_all;
-	*snc_all = *scc_all;
+	if (!keyframe) {
+		for (i = 0; i < nr; i++) {
+			if (VALUE_CHANGE(val[i], last[i]) >= changed_threshold)
+				break;
+		}
+		if (i == nr)
+			/* No significant change */
+			return FALSE;
+	}
 
-	/* Individual nodes */
-	for (cpu = 0; cpu < cpu_nr; cpu++) {
-		scc = st_cpu[curr] + cpu + 1;
-		scp = st_cpu[prev] + cpu + 1;
-		snp = st_node[prev] + cpu2node[cpu] + 1;
-		snc = st_node[curr] + cpu2node[cpu] + 1;
+	memcpy(last, val, sizeof(double) * nr);
 
+	return TRUE;
+}
 
-		tot_jiffies_p = scp->cpu_user + scp->cpu_nice +
-				scp->cpu_sys + scp->cpu_idle +
-				scp->cpu_iowait + scp->cpu_hardirq +
-				scp->cpu_steal + scp->cpu_softirq;
-		if ((tot_jiffies_p == 0) && (interval != 0))
-			/*
-			 * CPU has just come back online with no ref from
-			 * previous iteration: Skip it.
-			 */
-			continue;
+/*
+ ***************************************************************************
+ * Check if interrupts rates for a CPU have changed enough since they were
+ * last displayed (option --changed). If so, they are saved as the new
+ * rates last displayed.
+ *
+ * IN:
+ * @last	Rates last displayed for the CPU.
+ * @rate	Current rate of each interrupt for the CPU.
+ * @nr		Number of interrupts.
+ * @force	TRUE if rates should be displayed whatever their values.
+ *
+ * OUT:
+ * @last	Rates last displayed, updated if current ones are to be
+ *		displayed.
+ *
+ * RETURNS:
+ * TRUE if current rates should be displayed.
+ ***************************************************************************
+ */
+int check_changed_irq_rates(struct cpu_irq_rates *last, double rate[], int nr,
+			    int force)
+{
+	unsigned int pos = 0;
+	double prev_rate;
+	int j;
+
+	if (!DISPLAY_CHANGED_ONLY(flags))
+		return TRUE;
+
+	if (!keyframe && !force) {
+		for (j = 0; j < nr; j++) {
+			prev_rate = 0.0;
+			if ((pos < last->nr) && (last->r[pos].irq == j)) {
+				prev_rate = last->r[pos++].rate;
+			}
+			if (VALUE_CHANGE(rate[j], prev_rate) >= changed_threshold)
+				break;
+		}
+		if (j == nr)
+			/* No significant change */
+			return FALSE;
+	}
 
-		add_cpu_stats(snp, scp);
-		add_cpu_stats(snc, scc);
+	/* Save non-zero rates */
+	last->nr = 0;
+	for (j = 0; j < nr; j++) {
+		if (rate[j] == 0.0)
+			continue;
+		if (last->nr >= last->sz) {
+			last->sz = last->sz ? last->sz * 2 : 16;
+			SREALLOC(last->r, struct irq_rate, sizeof(struct irq_rate) * last->sz);
+		}
+		last->r[last->nr].irq = j;
+		last->r[last->nr++].rate = rate[j];
 	}
+
+	return TRUE;
 }
 
 /*
@@ -594,6 +662,59 @@ unsigned long long get_global_cpu_mpstats(int prev, int curr,
 	return deltot_jiffies;
 }
 
+/*
+ ***************************************************************************
+ * Compute CPU utilization percentages (%usr, %nice... %idle) for a CPU.
+ *
+ * IN:
+ * @cpu		CPU number (0 is CPU "all", 1 is CPU 0, etc.)
+ * @scc		Current CPU statistics.
+ * @scp		Previous CPU statistics.
+ * @deltot_jiffies
+ *		Number of jiffies spent on the interval by all processors.
+ *
+ * OUT:
+ * @pc		Percentages for the CPU.
+ ***************************************************************************
+ */
+void compute_cpu_pc(int cpu, struct stats_cpu *scc, struct stats_cpu *scp,
+		    unsigned long long deltot_jiffies, double pc[])
+{
+	if (cpu) {
+		/* Recalculate itv for current proc */
+		deltot_jiffies = get_per_cpu_interval(scc, scp);
+
+		if (!deltot_jiffies) {
+			/*
+			 * If the CPU is tickless then there is no change in CPU values
+			 * but the sum of values is not zero.
+			 */
+			memset(pc, 0, sizeof(double) * NR_CPU_PC);
+			pc[NR_CPU_PC - 1] = 100.0;
+			return;
+		}
+	}
+
+	pc[0] = (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
+		0.0 :
+		ll_sp_value(scp->cpu_user - scp->cpu_guest,
+			    scc->cpu_user - scc->cpu_guest, deltot_jiffies);
+	pc[1] = (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
+		0.0 :
+		ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
+			    scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies);
+	pc[2] = ll_sp_value(scp->cpu_sys, scc->cpu_sys, deltot_jiffies);
+	pc[3] = ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies);
+	pc[4] = ll_sp_value(scp->cpu_hardirq, scc->cpu_hardirq, deltot_jiffies);
+	pc[5] = ll_sp_value(scp->cpu_softirq, scc->cpu_softirq, deltot_jiffies);
+	pc[6] = ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies);
+	pc[7] = ll_sp_value(scp->cpu_guest, scc->cpu_guest, deltot_jiffies);
+	pc[8] = ll_sp_value(scp->cpu_guest_nice, scc->cpu_guest_nice, deltot_jiffies);
+	pc[9] = (scc->cpu_idle < scp->cpu_idle) ?
+		0.0 :
+		ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies);
+}
+
 /*
  ***************************************************************************
  * Display CPU statistics in plain format.
@@ -622,6 +743,7 @@ void write_plain_cpu_stats(int dis, unsigned long long deltot_jiffies, int prev,
 	int i;
 	struct stats_cpu *scc, *scp;
 	struct cpu_topology *cpu_topo_i;
+	double pc[NR_CPU_PC];
 
 	if (dis) {
 		printf("\n%-11s  CPU", prev_string);
@@ -646,6 +768,12 @@ void write_plain_cpu_stats(int dis, unsigned long long deltot_jiffies, int prev,
 		scc = st_cpu[curr] + i;
 		scp = st_cpu[prev] + i;
 
+		compute_cpu_pc(i, scc, scp, deltot_jiffies, pc);
+
+		/* CPU "all" is always displayed */
+		if (i && !check_changed_values(cpu_last_pc + i * NR_CPU_PC, pc, NR_CPU_PC))
+			continue;
+
 		printf("%-11s", curr_string);
 
 		if (i == 0) {
@@ -665,50 +793,11 @@ void write_plain_cpu_stats(int dis, unsigned long long deltot_jiffies, int prev,
 				cprintf_in(IS_INT, " %4d", "", cpu_topo_i->phys_package_id);
 				cprintf_in(IS_INT, " %4d", "", cpu2node[i - 1]);
 			}
-
-			/* Recalculate itv for current proc */
-			deltot_jiffies = get_per_cpu_interval(scc, scp);
-
-			if (!deltot_jiffies) {
-				/*
-				 * If the CPU is tickless then there is no change in CPU values
-				 * but the sum of values is not zero.
-				 */
-				cprintf_pc(NO_UNIT, 10, 7, 2,
-					   0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 100.0);
-				printf("\n");
-
-				continue;
-			}
 		}
 
 		cprintf_pc(NO_UNIT, 10, 7, 2,
-			   (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
-			   0.0 :
-			   ll_sp_value(scp->cpu_user - scp->cpu_guest,
-				       scc->cpu_user - scc->cpu_guest, deltot_jiffies),
-			   (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
-			   0.0 :
-			   ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
-				       scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies),
-			   ll_sp_value(scp->cpu_sys,
-				       scc->cpu_sys, deltot_jiffies),
-			   ll_sp_value(scp->cpu_iowait,
-				       scc->cpu_iowait, deltot_jiffies),
-			   ll_sp_value(scp->cpu_hardirq,
-				       scc->cpu_hardirq, deltot_jiffies),
-			   ll_sp_value(scp->cpu_softirq,
-				       scc->cpu_softirq, deltot_jiffies),
-			   ll_sp_value(scp->cpu_steal,
-				       scc->cpu_steal, deltot_jiffies),
-			   ll_sp_value(scp->cpu_guest,
-				       scc->cpu_guest, deltot_jiffies),
-			   ll_sp_value(scp->cpu_guest_nice,
-				       scc->cpu_guest_nice, deltot_jiffies),
-			   (scc->cpu_idle < scp->cpu_idle) ?
-			   0.0 :
-			   ll_sp_value(scp->cpu_idle,
-				       scc->cpu_idle, deltot_jiffies));
+			   pc[0], pc[1], pc[2], pc[3], pc[4],
+			   pc[5], pc[6], pc[7], pc[8], pc[9]);
 		printf("\n");
 	}
 }
@@ -736,6 +825,7 @@ void write_json_cpu_stats(int tab, unsigned long long deltot_jiffies, int prev,
 	char cpu_name[16], topology[1024] = "";
 	struct stats_cpu *scc, *scp;
 	struct cpu_topology *cpu_topo_i;
+	double pc[NR_CPU_PC];
 
 	xprintf(tab++, "\"cpu-load\": [");
 
@@ -753,6 +843,12 @@ void write_json_cpu_stats(int tab, unsigned long long deltot_jiffies, int prev,
 		scc = st_cpu[curr] + i;
 		scp = st_cpu[prev] + i;
 
+		compute_cpu_pc(i, scc, scp, deltot_jiffies, pc);
+
+		/* CPU "all" is always displayed */
+		if (i && !check_changed_values(cpu_last_pc + i * NR_CPU_PC, pc, NR_CPU_PC))
+			continue;
+
 		if (next) {
 			printf(",\n");
 		}
@@ -778,55 +874,14 @@ void write_json_cpu_stats(int tab, unsigned long long deltot_jiffies, int prev,
 					 ", \"core\": \"%d\", \"socket\": \"%d\", \"node\": \"%d\"",
 					 cpu_topo_i->logical_core_id, cpu_topo_i->phys_package_id, cpu2node[i - 1]);
 			}
-
-			/* Recalculate itv for current proc */
-			deltot_jiffies = get_per_cpu_interval(scc, scp);
-
-			if (!deltot_jiffies) {
-				/*
-				 * If the CPU is tickless then there is no change in CPU values
-				 * but the sum of values is not zero.
-				 */
-				xprintf0(tab, "{\"cpu\": \"%d\"%s, \"usr\": 0.00, \"nice\": 0.00, "
-					 "\"sys\": 0.00, \"iowait\": 0.00, \"irq\": 0.00, "
-					 "\"soft\": 0.00, \"steal\": 0.00, \"guest\": 0.00, "
-					 "\"gnice\": 0.00, \"idle\": 100.00}", i - 1, topology);
-				printf("\n");
-
-				continue;
-			}
 		}
 
 		xprintf0(tab, "{\"cpu\": \"%s\"%s, \"usr\": %.2f, \"nice\": %.2f, \"sys\": %.2f, "
 			 "\"iowait\": %.2f, \"irq\": %.2f, \"soft\": %.2f, \"steal\": %.2f, "
 			 "\"guest\": %.2f, \"gnice\": %.2f, \"idle\": %.2f}",
 			 cpu_name, topology,
-			 (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
-			 0.0 :
-			 ll_sp_value(scp->cpu_user - scp->cpu_guest,
-				     scc->cpu_user - scc->cpu_guest, deltot_jiffies),
-			 (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
-			 0.0 :
-			 ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
-				     scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies),
-			 ll_sp_value(scp->cpu_sys,
-				     scc->cpu_sys, deltot_jiffies),
-			 ll_sp_value(scp->cpu_iowait,
-				     scc->cpu_iowait, deltot_jiffies),
-			 ll_sp_value(scp->cpu_hardirq,
-				     scc->cpu_hardirq, deltot_jiffies),
-			 ll_sp_value(scp->cpu_softirq,
-				     scc->cpu_softirq, deltot_jiffies),
-			 ll_sp_value(scp->cpu_steal,
-				     scc->cpu_steal, deltot_jiffies),
-			 ll_sp_value(scp->cpu_guest,
-				     scc->cpu_guest, deltot_jiffies),
-			 ll_sp_value(scp->cpu_guest_nice,
-				     scc->cpu_guest_nice, deltot_jiffies),
-			 (scc->cpu_idle < scp->cpu_idle) ?
-			 0.0 :
-			 ll_sp_value(scp->cpu_idle,
-				     scc->cpu_idle, deltot_jiffies));
+			 pc[0], pc[1], pc[2], pc[3], pc[4],
+			 pc[5], pc[6], pc[7], pc[8], pc[9]);
 	}
 
 	printf("\n");
@@ -1169,6 +1224,7 @@ void write_plain_isumcpu_stats(int dis, unsigned long long itv, int prev, int cu
 	struct stats_cpu *scc, *scp;
 	struct stats_irq *sic, *sip;
 	unsigned long long pc_itv;
+	double intr;
 	int cpu;
 
 	if (dis) {
@@ -1204,23 +1260,21 @@ void write_plain_isumcpu_stats(int dis, unsigned long long itv, int prev, int cu
 			continue;
 		}
 
-		printf("%-11s", curr_string);
-		cprintf_in(IS_INT, " %4d", "", cpu - 1);
-
 		/* Recalculate itv for current proc */
 		pc_itv = get_per_cpu_interval(scc, scp);
 
-		if (!pc_itv) {
-			/* This is a tickless CPU: Value displayed is 0.00 */
-			cprintf_f(NO_UNIT, 1, 9, 2, 0.0);
-			printf("\n");
-		}
-		else {
-			/* Display total number of interrupts for current CPU */
-			cprintf_f(NO_UNIT, 1, 9, 2,
-				  S_VALUE(sip->irq_nr, sic->irq_nr, itv));
-			printf("\n");
-		}
+		/* Value displayed is 0.00 for a tickless CPU */
+		intr = pc_itv ? S_VALUE(sip->irq_nr, sic->irq_nr, itv) : 0.0;
+
+		if (!check_changed_values(isum_last + cpu, &intr, 1))
+			continue;
+
+		printf("%-11s", curr_string);
+		cprintf_in(IS_INT, " %4d", "", cpu - 1);
+
+		/* Display total number of interrupts for current CPU */
+		cprintf_f(NO_UNIT, 1, 9, 2, intr);
+		printf("\n");
 	}
 }
 
@@ -1242,6 +1296,7 @@ void write_json_isumcpu_stats(int tab, unsigned long long itv, int prev, int cur
 	struct stats_cpu *scc, *scp;
 	struct stats_irq *sic, *sip;
 	unsigned long long pc_itv;
+	double intr;
 	int cpu, next = FALSE;
 
 	xprintf(tab++, "\"sum-interrupts\": [");
@@ -1266,11 +1321,6 @@ void write_json_isumcpu_stats(int tab, unsigned long long itv, int prev, int cur
 		if (!(*(cpu_bitmap + (cpu >> 3)) & (1 << (cpu & 0x07))))
 			continue;
 
-		if (next) {
-			printf(",\n");
-		}
-		next = TRUE;
-
 		if ((scc->cpu_user    + scc->cpu_nice + scc->cpu_sys   +
 		     scc->cpu_iowait  + scc->cpu_idle + scc->cpu_steal +
 		     scc->cpu_hardirq + scc->cpu_softirq) == 0) {
@@ -1282,17 +1332,20 @@ void write_json_isumcpu_stats(int tab, unsigned long long itv, int prev, int cur
 		/* Recalculate itv for current proc */
 		pc_itv = get_per_cpu_interval(scc, scp);
 
-		if (!pc_itv) {
-			/* This is a tickless CPU: Value displayed is 0.00 */
-			xprintf0(tab, "{\"cpu\": \"%d\", \"intr\": 0.00}",
-				 cpu - 1);
-		}
-		else {
-			/* Display total number of interrupts for current CPU */
-			xprintf0(tab, "{\"cpu\": \"%d\", \"intr\": %.2f}",
-				 cpu - 1,
-				 S_VALUE(sip->irq_nr, sic->irq_nr, itv));
+		/* Value displayed is 0.00 for a tickless CPU */
+		intr = pc_itv ? S_VALUE(sip->irq_nr, sic->irq_nr, itv) : 0.0;
+
+		if (!check_changed_values(isum_last + cpu, &intr, 1))
+			continue;
+
+		if (next) {
+			printf(",\n");
 		}
+		next = TRUE;
+
+		/* Display total number of interrupts for current CPU */
+		xprintf0(tab, "{\"cpu\": \"%d\", \"intr\": %.2f}",
+			 cpu - 1, intr);
 	}
 	printf("\n");
 	xprintf0(--tab, "]");
@@ -1335,6 +1388,118 @@ void write_isumcpu_stats(int dis, unsigned long long itv, int prev, int curr,
 	}
 }
 
+/*
+ ***************************************************************************
+ * Get the number of interrupts in current list, and check if this list is
+ * the same as the one used as reference. The list of interrupts may change
+ * between two samples (some interrupts may disappear, or new ones be
+ * registered).
+ *
+ * IN:
+ * @st_ic	Array for per-CPU statistics.
+ * @ic_nr	Number of interrupts (hard or soft) per CPU.
+ * @prev	Position in array where statistics used	as reference are.
+ * @curr	Position in array where current statistics are.
+ *
+ * OUT:
+ * @changed	TRUE if the list of interrupts has changed.
+ *
+ * RETURNS:
+ * Number of interrupts in current list.
+ ***************************************************************************
+ */
+int check_irq_list(struct stats_irqs st_ic[], int ic_nr, int prev, int curr,
+		   int *changed)
+{
+	struct stats_irqcpu *p0, *q0;
+	int j;
+
+	*changed = FALSE;
+
+	for (j = 0; j < ic_nr; j++) {
+		p0 = st_ic[curr].irq + j;
+		q0 = st_ic[prev].irq + j;
+		/*
+		 * Note that we compare even empty strings for the case where
+		 * a disappearing interrupt would be the last one in the list.
+		 */
+		if (strcmp(p0->irq_name, q0->irq_name)) {
+			*changed = TRUE;
+		}
+		if (p0->irq_name[0] == '\0')
+			/*
+			 * An empty string for irq_name means it is a remaining interrupt
+			 * which is no longer used, for example because the
+			 * number of interrupts has decreased in /proc/interrupts.
+			 */
+			break;
+	}
+
+	return j;
+}
+
+/*
+ ***************************************************************************
+ * Compute the rate of each interrupt for a given CPU.
+ *
+ * IN:
+ * @st_ic	Array for per-CPU statistics.
+ * @ic_nr	Number of interrupts (hard or soft) per CPU.
+ * @irq_nr	Number of interrupts in current list.
+ * @cpu		CPU number (1 for CPU 0, etc.). Must be given in increasing
+ *		order.
+ * @itv		Interval value.
+ * @prev	Position in array where statistics used	as reference are.
+ * @curr	Position in array where current statistics are.
+ *
+ * OUT:
+ * @rate	Rate of each interrupt for the CPU.
+ ***************************************************************************
+ */
+void compute_irqcpu_rates(struct stats_irqs st_ic[], int ic_nr, int irq_nr,
+			  int cpu, unsigned long long itv, int prev, int curr,
+			  double rate[])
+{
+	struct stats_irqcpu *p0, *q0;
+	unsigned int pv, qv;
+	int j, offset;
+
+	for (j = 0; j < irq_nr; j++) {
+		p0 = st_ic[curr].irq + j;
+		q0 = st_ic[prev].irq + j;
+		offset = j;
+
+		/*
+		 * If we want stats for the time since system startup,
+		 * we have p0->irq_name != q0->irq_name, since q0 structure
+		 * is completely set to zero.
+		 */
+		if (strcmp(p0->irq_name, q0->irq_name) && interval) {
+			/* Check if interrupt exists elsewhere in list */
+			for (offset = 0; offset < ic_nr; offset++) {
+				q0 = st_ic[prev].irq + offset;
+				if (!strcmp(p0->irq_name, q0->irq_name))
+					/* Interrupt found at another position */
+					break;
+			}
+		}
+
+		pv = get_irqcpu_value(&st_ic[curr], j, cpu - 1);
+
+		if (!strcmp(p0->irq_name, q0->irq_name) || !interval) {
+			qv = get_irqcpu_value(&st_ic[prev], offset, cpu - 1);
+		}
+		else {
+			/*
+			 * Instead of printing "N/A", assume that previous value
+			 * for this new interrupt was zero.
+			 */
+			qv = 0;
+		}
+		rate[j] = S_VALUE(qv, pv, itv);
+	}
+}
+
 /*
  ***************************************************************************
  * Display interrupts statistics for each CPU in plain format.
@@ -1354,15 +1519,20 @@ void write_isumcpu_stats(int dis, unsigned long long itv, int prev, int curr,
  * @curr_string	String displayed at the beginning of current sample stats.
  * 		This is the timestamp of the current sample, or "Average"
  * 		when displaying average stats.
+ * @last	Rates last displayed for each CPU (option --changed).
  ***************************************************************************
  */
-void write_plain_irqcpu_stats(struct stats_irqcpu *st_ic[], int ic_nr, int dis,
+void write_plain_irqcpu_stats(struct stats_irqs st_ic[], int ic_nr, int dis,
 			      unsigned long long itv, int prev, int curr,
-			      char *prev_string, char *curr_string)
+			      char *prev_string, char *curr_string,
+			      struct cpu_irq_rates *last)
 {
 	struct stats_cpu *scc;
-	int j = ic_nr, offset, cpu, colwidth[NR_IRQS];
-	struct stats_irqcpu *p, *q, *p0, *q0;
+	int j, cpu, irq_nr, changed, colwidth[ic_nr];
+	double rate[ic_nr];
+	struct stats_irqcpu *p0;
+
+	irq_nr = check_irq_list(st_ic, ic_nr, prev, curr, &changed);
 
 	/*
 	 * Check if number of interrupts has changed.
@@ -1370,42 +1540,20 @@ void write_plain_irqcpu_stats(struct stats_irqcpu *st_ic[], int ic_nr, int dis,
 	 * NB: A zero interval value indicates that we are
 	 * displaying statistics since system startup.
 	 */
-	if (!dis && interval) {
-		for (j = 0; j < ic_nr; j++) {
-			p0 = st_ic[curr] + j;
-			q0 = st_ic[prev] + j;
-			if (strcmp(p0->irq_name, q0->irq_name))
-				/*
-				 * These are two different interrupts: The header must be displayed
-				 * (maybe an interrupt has disappeared, or a new one has just been registered).
-				 * Note that we compare even empty strings for the case where
-				 * a disappearing interrupt would be the last one in the list.
-				 */
-				break;
-		}
-	}
-
-	if (dis || (j < ic_nr)) {
+	if (dis || (changed && interval)) {
 		/* Print header */
 		printf("\n%-11s  CPU", prev_string);
-		for (j = 0; j < ic_nr; j++) {
-			p0 = st_ic[curr] + j;
-			if (p0->irq_name[0] == '\0')
-				/* End of the list of interrupts */
-				break;
+		for (j = 0; j < irq_nr; j++) {
+			p0 = st_ic[curr].irq + j;
 			printf(" %8s/s", p0->irq_name);
 		}
 		printf("\n");
 	}
 
 	/* Calculate column widths */
-	for (j = 0; j < ic_nr; j++) {
-		p0 = st_ic[curr] + j;
-		/*
-		 * Width is IRQ name + 2 for the trailing "/s".
-		 * Width is calculated even for "undefined" interrupts (with
-		 * an empty irq_name string) to quiet code analysis tools.
-		 */
+	for (j = 0; j < irq_nr; j++) {
+		p0 = st_ic[curr].irq + j;
+		/* Width is IRQ name + 2 for the trailing "/s" */
 		colwidth[j] = strlen(p0->irq_name) + 2;
 		/*
 		 * Normal space for printing a number is 11 chars
@@ -1416,6 +1564,9 @@ void write_plain_irqcpu_stats(struct stats_irqcpu *st_ic[], int ic_nr, int dis,
 		}
 	}
 
+	rewind_irqs_sample(&st_ic[curr], ic_nr);
+	rewind_irqs_sample(&st_ic[prev], ic_nr);
+
 	for (cpu = 1; cpu <= cpu_nr; cpu++) {
 
 		scc = st_cpu[curr] + cpu;
@@ -1434,52 +1585,16 @@ void write_plain_irqcpu_stats(struct stats_irqcpu *st_ic[], int ic_nr, int dis,
 			/* Offline CPU found */
 			continue;
 
-		printf("%-11s", curr_string);
-		cprintf_in(IS_INT, "  %3d", "", cpu - 1);
+		compute_irqcpu_rates(st_ic, ic_nr, irq_nr, cpu, itv, prev, curr, rate);
 
-		for (j = 0; j < ic_nr; j++) {
-			p0 = st_ic[curr] + j;	/* irq_name set only for CPU#0 */
-			/*
-			 * An empty string for irq_name means it is a remaining interrupt
-			 * which is no longer used, for example because the
-			 * number of interrupts has decreased in /proc/interrupts.
-			 */
-			if (p0->irq_name[0] == '\0')
-				/* End of the list of interrupts */
-				break;
-			q0 = st_ic[prev] + j;
-			offset = j;
-
-			/*
-			 * If we want stats for the time since system startup,
-			 * we have p0->irq_name != q0->irq_name, since q0 structure
-			 * is completely set to zero.
-			 */
-			if (strcmp(p0->irq_name, q0->irq_name) && interval) {
-				/* Check if interrupt exists elsewhere in list */
-				for (offset = 0; offset < ic_nr; offset++) {
-					q0 = st_ic[prev] + offset;
-					if (!strcmp(p0->irq_name, q0->irq_name))
-						/* Interrupt found at another position */
-						break;
-				}
-			}
+		if (!check_changed_irq_rates(last + cpu, rate, irq_nr, changed))
+			continue;
 
-			p = st_ic[curr] + (cpu - 1) * ic_nr + j;
+		printf("%-11s", curr_string);
+		cprintf_in(IS_INT, "  %3d", "", cpu - 1);
 
-			if (!strcmp(p0->irq_name, q0->irq_name) || !interval) {
-				q = st_ic[prev] + (cpu - 1) * ic_nr + offset;
-				cprintf_f(NO_UNIT, 1, colwidth[j], 2,
-					  S_VALUE(q->interrupt, p->interrupt, itv));
-			}
-			else {
-				/*
-				 * Instead of printing "N/A", assume that previous value
-				 * for this new interrupt was zero.
-				 */
-				cprintf_f(NO_UNIT, 1, colwidth[j], 2,
-					  S_VALUE(0, p->interrupt, itv));
-			}
+		for (j = 0; j < irq_nr; j++) {
+			cprintf_f(NO_UNIT, 1, colwidth[j], 2, rate[j]);
 		}
 		printf("\n");
 	}
@@ -1499,15 +1614,17 @@ void write_plain_irqcpu_stats(struct stats_irqcpu *st_ic[], int ic_nr, int dis,
  *		the very first ones when calculating the average.
  * @curr	Position in array where current statistics will be saved.
  * @type	Activity (M_D_IRQ_CPU or M_D_SOFTIRQS).
+ * @last	Rates last displayed for each CPU (option --changed).
  ***************************************************************************
  */
-void write_json_irqcpu_stats(int tab, struct stats_irqcpu *st_ic[], int ic_nr,
-			     unsigned long long itv, int prev, int curr, int type)
+void write_json_irqcpu_stats(int tab, struct stats_irqs st_ic[], int ic_nr,
+			     unsigned long long itv, int prev, int curr, int type,
+			     struct cpu_irq_rates *last)
 {
 	struct stats_cpu *scc;
-	int j = ic_nr, offset, cpu;
-	struct stats_irqcpu *p, *q, *p0, *q0;
-	int nextcpu = FALSE, nextirq;
+	int j, cpu, irq_nr, changed;
+	double rate[ic_nr];
+	int nextcpu = FALSE;
 
 	if (type == M_D_IRQ_CPU) {
 		xprintf(tab++, "\"individual-interrupts\": [");
@@ -1516,6 +1633,11 @@ void write_json_irqcpu_stats(int tab, struct stats_irqcpu *st_ic[], int ic_nr,
 		xprintf(tab++, "\"soft-interrupts\": [");
 	}
 
+	irq_nr = check_irq_list(st_ic, ic_nr, prev, curr, &changed);
+
+	rewind_irqs_sample(&st_ic[curr], ic_nr);
+	rewind_irqs_sample(&st_ic[prev], ic_nr);
+
 	for (cpu = 1; cpu <= cpu_nr; cpu++) {
 
 		scc = st_cpu[curr] + cpu;
@@ -1534,64 +1656,23 @@ void write_json_irqcpu_stats(int tab, struct stats_irqcpu *st_ic[], int ic_nr,
 			/* Offline CPU found */
 			continue;
 
+		compute_irqcpu_rates(st_ic, ic_nr, irq_nr, cpu, itv, prev, curr, rate);
+
+		if (!check_changed_irq_rates(last + cpu, rate, irq_nr, changed))
+			continue;
+
 		if (nextcpu) {
 			printf(",\n");
 		}
 		nextcpu = TRUE;
-		nextirq = FALSE;
 		xprintf(tab++, "{\"cpu\": \"%d\", \"intr\": [", cpu - 1);
 
-		for (j = 0; j < ic_nr; j++) {
-
-			p0 = st_ic[curr] + j;	/* irq_name set only for CPU#0 */
-			/*
-			 * An empty string for irq_name means it is a remaining interrupt
-			 * which is no longer used, for example because the
-			 * number of interrupts has decreased in /proc/interrupts.
-			 */
-			if (p0->irq_name[0] == '\0')
-				/* End of the list of interrupts */
-				break;
-			q0 = st_ic[prev] + j;
-			offset = j;
-
-			if (nextirq) {
+		for (j = 0; j < irq_nr; j++) {
+			if (j) {
 				printf(",\n");
 			}
-			nextirq = TRUE;
-
-			/*
-			 * If we want stats for the time since system startup,
-			 * we have p0->irq_name != q0->irq_name, since q0 structure
-			 * is completely set to zero.
-			 */
-			if (strcmp(p0->irq_name, q0->irq_name) && interval) {
-				/* Check if interrupt exists elsewhere in list */
-				for (offset = 0; offset < ic_nr; offset++) {
-					q0 = st_ic[prev] + offset;
-					if (!strcmp(p0->irq_name, q0->irq_name))
-						/* Interrupt found at another position */
-						break;
-				}
-			}
-
-			p = st_ic[curr] + (cpu - 1) * ic_nr + j;
-
-			if (!strcmp(p0->irq_name, q0->irq_name) || !interval) {
-				q = st_ic[prev] + (cpu - 1) * ic_nr + offset;
-				xprintf0(tab, "{\"name\": \"%s\", \"value\": %.2f}",
-					 p0->irq_name,
-					 S_VALUE(q->interrupt, p->interrupt, itv));
-			}
-			else {
-				/*
-				 * Instead of printing "N/A", assume that previous value
-				 * for this new interrupt was zero.
-				 */
-				xprintf0(tab, "{\"name\": \"%s\", \"value\": %.2f}",
-					 p0->irq_name,
-					 S_VALUE(0, p->interrupt, itv));
-			}
+			xprintf0(tab, "{\"name\": \"%s\", \"value\": %.2f}",
+				 st_ic[curr].irq[j].irq_name, rate[j]);
 		}
 		printf("\n");
 		xprintf0(--tab, "] }");
@@ -1625,21 +1706,23 @@ void write_json_irqcpu_stats(int tab, struct stats_irqcpu *st_ic[], int ic_nr,
  * @type	Activity (M_D_IRQ_CPU or M_D_SOFTIRQS).
  ***************************************************************************
  */
-void write_irqcpu_stats(struct stats_irqcpu *st_ic[], int ic_nr, int dis,
+void write_irqcpu_stats(struct stats_irqs st_ic[], int ic_nr, int dis,
 			unsigned long long itv, int prev, int curr,
 			char *prev_string, char *curr_string, int tab,
 			int *next, int type)
 {
+	struct cpu_irq_rates *last = (type == M_D_IRQ_CPU) ? irq_last : softirq_last;
+
 	if (DISPLAY_JSON_OUTPUT(flags)) {
 		if (*next) {
 			printf(",\n");
 		}
 		*next = TRUE;
-		write_json_irqcpu_stats(tab, st_ic, ic_nr, itv, prev, curr, type);
+		write_json_irqcpu_stats(tab, st_ic, ic_nr, itv, prev, curr, type, last);
 	}
 	else {
 		write_plain_irqcpu_stats(st_ic, ic_nr, dis, itv, prev, curr,
-					 prev_string, curr_string);
+					 prev_string, curr_string, last);
 	}
 }
 
@@ -1693,7 +1776,9 @@ void write_stats_core(int prev, int curr, int dis,
 
 	/* Print node CPU stats */
 	if (DISPLAY_NODE(actflags)) {
-		set_node_cpu_stats(prev, curr);
+		set_node_cpu_stats(st_cpu[prev], st_cpu[curr], STATS_CPU_SIZE, cpu_nr,
+				   cpu2node, node_nr + 1, st_node[prev], st_node[curr],
+				   interval != 0, offline_cpu_bitmap);
 		write_node_stats(dis, deltot_jiffies, prev, curr, prev_string,
 				 curr_string, tab, &next);
 	}
@@ -1735,6 +1820,9 @@ void write_stats_avg(int curr, int dis)
 
 	strncpy(string, _("Average:"), 16);
 	string[15] = '\0';
+
+	/* Average statistics are always displayed for all CPU */
+	keyframe = TRUE;
 	write_stats_core(2, curr, dis, string, string);
 }
 
@@ -1767,15 +1855,70 @@ void write_stats(int curr, int dis)
 		strftime(cur_time[curr], sizeof(cur_time[curr]), "%X", &(mp_tstamp[curr]));
 	}
 
+	/* With option --changed, display all CPU every CHANGED_KEYFRAME samples */
+	keyframe = !(sample_nr++ % CHANGED_KEYFRAME);
+
 	write_stats_core(!curr, curr, dis, cur_time[!curr], cur_time[curr]);
 }
 
+/*
+ ***************************************************************************
+ * Read the whole contents of /proc/interrupts or /proc/softirqs. The file
+ * is kept open between samples and read again from its beginning.
+ *
+ * IN:
+ * @f		File to read.
+ *
+ * OUT:
+ * @f		Buffer containing file contents.
+ *
+ * RETURNS:
+ * 0 on success, -1 if file couldn't be read.
+ ***************************************************************************
+ */
+int read_irq_file(struct irq_file *f)
+{
+	size_t len = 0;
+	ssize_t n;
+
+	if ((f->fd < 0) && ((f->fd = open(f->name, O_RDONLY)) < 0))
+		return -1;
+
+	if (!f->buf_size) {
+		f->buf_size = INTERRUPTS_LINE + 11 * cpu_nr;
+		SREALLOC(f->buf, char, f->buf_size);
+	}
+
+	while ((n = pread(f->fd, f->buf + len, f->buf_size - len - 1, len)) > 0) {
+		len += n;
+		if (len == f->buf_size - 1) {
+			f->buf_size *= 2;
+			SREALLOC(f->buf, char, f->buf_size);
+		}
+	}
+	f->buf[len] = '\0';
+
+#ifdef TEST
+	/* tests/root link changes between samples: Open file again next time */
+	close(f->fd);
+	f->fd = -1;
+#endif
+
+	if (n < 0) {
+		close(f->fd);
+		f->fd = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
 /*
  ***************************************************************************
  * Read stats from /proc/interrupts or /proc/softirqs.
  *
  * IN:
- * @file	/proc file to read (interrupts or softirqs).
+ * @f		/proc file to read (interrupts or softirqs).
  * @ic_nr	Number of interrupts (hard or soft) per CPU.
  * @curr	Position in array where current statistics will be saved.
  *
@@ -1783,92 +1926,123 @@ void write_stats(int curr, int dis)
  * @st_ic	Array for per-CPU interrupts statistics.
  ***************************************************************************
  */
-void read_interrupts_stat(char *file, struct stats_irqcpu *st_ic[], int ic_nr, int curr)
+void read_interrupts_stat(struct irq_file *f, struct stats_irqs st_ic[], int ic_nr, int curr)
 {
-	FILE *fp;
 	struct stats_irq *st_irq_i;
 	struct stats_irqcpu *p;
-	char *line = NULL, *li;
-	unsigned long irq = 0;
+	struct stats_irqs *st = &st_ic[curr];
+	struct irqcpu_val *v;
+	char *line = NULL, *li, *next;
+	unsigned int irq = 0, val;
 	unsigned int cpu;
 	int cpu_index[cpu_nr], index = 0, len;
-	char *cp, *next;
+	char *cp;
 
 	/* Reset total number of interrupts received by each CPU */
 	for (cpu = 0; cpu < cpu_nr; cpu++) {
 		st_irq_i = st_irq[curr] + cpu + 1;
 		st_irq_i->irq_nr = 0;
 	}
+	st->val_nr = 0;
 
-	if ((fp = fopen(file, "r")) != NULL) {
-
-		SREALLOC(line, char, INTERRUPTS_LINE + 11 * cpu_nr);
+	if (!read_irq_file(f)) {
+		line = f->buf;
 
 		/*
 		 * Parse header line to see which CPUs are online
 		 */
-		while (fgets(line, INTERRUPTS_LINE + 11 * cpu_nr, fp) != NULL) {
-			next = line;
-			while (((cp = strstr(next, "CPU")) != NULL) && (index < cpu_nr)) {
-				cpu = strtol(cp + 3, &next, 10);
+		for (; *line; line = next) {
+			if ((next = strchr(line, '\n')) != NULL) {
+				*(next++) = '\0';
+			}
+			else {
+				next = line + strlen(line);
+			}
+
+			cp = line;
+			while (((cp = strstr(cp, "CPU")) != NULL) && (index < cpu_nr)) {
+				cpu = strtol(cp + 3, &cp, 10);
 				cpu_index[index++] = cpu;
 			}
-			if (index)
+			if (index) {
 				/* Header line found */
+				line = next;
 				break;
+			}
 		}
 
 		/* Parse each line of interrupts statistics data */
-		while ((fgets(line, INTERRUPTS_LINE + 11 * cpu_nr, fp) != NULL) &&
-		       (irq < ic_nr)) {
+		for (; *line && (irq < ic_nr); line = next) {
+			if ((next = strchr(line, '\n')) != NULL) {
+				*(next++) = '\0';
+			}
+			else {
+				next = line + strlen(line);
+			}
 
 			/* Skip over "<irq>:" */
 			if ((cp = strchr(line, ':')) == NULL)
 				/* Chr ':' not found */
 				continue;
-			cp++;
 
-			p = st_ic[curr] + irq;
+			p = st->irq + irq;
 
 			/* Remove possible heading spaces in interrupt's name... */
 			li = line;
 			while (*li == ' ')
 				li++;
 
-			len = strcspn(li, ":");
+			len = cp - li;
 			if (len >= MAX_IRQ_LEN) {
 				len = MAX_IRQ_LEN - 1;
 			}
 			/* ...then save its name */
 			strncpy(p->irq_name, li, len);
 			p->irq_name[len] = '\0';
+			cp++;
 
-			/* For each interrupt: Get number received by each CPU */
+			/* Make sure there is room for a value for each CPU */
+			if (st->val_sz < st->val_nr + index) {
+				st->val_sz = (st->val_nr + index) * 2;
+				SREALLOC(st->val, struct irqcpu_val,
+					 sizeof(struct irqcpu_val) * st->val_sz);
+			}
+			p->first = st->val_nr;
+
+			/*
+			 * For each interrupt: Get number received by each CPU.
+			 * Some lines (e.g. ERR or MIS) may have fewer values than
+			 * there are CPU. Only non-zero values are saved.
+			 */
 			for (cpu = 0; cpu < index; cpu++) {
-				p = st_ic[curr] + cpu_index[cpu] * ic_nr + irq;
+				while ((*cp == ' ') || (*cp == '\t'))
+					cp++;
+				if ((*cp < '0') || (*cp > '9'))
+					break;
+				for (val = 0; (*cp >= '0') && (*cp <= '9'); cp++) {
+					val = val * 10 + (*cp - '0');
+				}
+				if (!val)
+					continue;
+
+				v = st->val + st->val_nr++;
+				v->cpu = cpu_index[cpu];
+				v->interrupt = val;
+
+				/* Compute total number of interrupts received by current CPU */
 				st_irq_i = st_irq[curr] + cpu_index[cpu] + 1;
-				/*
-				 * No need to set (st_irqcpu + cpu * irqcpu_nr)->irq_name:
-				 * This is the same as st_irqcpu->irq_name.
-				 * Now save current interrupt value for current CPU (in stats_irqcpu structure)
-				 * and total number of interrupts received by current CPU (in stats_irq structure).
-				 */
-				p->interrupt = strtoul(cp, &next, 10);
-				st_irq_i->irq_nr += p->interrupt;
-				cp = next;
+				st_irq_i->irq_nr += val;
 			}
+			p->nr = st->val_nr - p->first;
 			irq++;
 		}
-
-		fclose(fp);
-
-		free(line);
 	}
 
 	while (irq < ic_nr) {
 		/* Nb of interrupts per processor has changed */
-		p = st_ic[curr] + irq;
+		p = st->irq + irq;
 		p->irq_name[0] = '\0';	/* This value means this is a dummy interrupt */
+		p->nr = 0;
 		irq++;
 	}
 }
@@ -1936,10 +2110,10 @@ void rw_mpstat_loop(int dis_hdr, int rows)
 	 */
 	if (DISPLAY_IRQ_SUM(actflags) || DISPLAY_IRQ_CPU(actflags)) {
 		/* Read this file to display int per CPU or total nr of int per CPU */
-		read_interrupts_stat(INTERRUPTS, st_irqcpu, irqcpu_nr, 0);
+		read_interrupts_stat(&irq_file, st_irqcpu, irqcpu_nr, 0);
 	}
 	if (DISPLAY_SOFTIRQS(actflags)) {
-		read_interrupts_stat(SOFTIRQS, st_softirqcpu, softirqcpu_nr, 0);
+		read_interrupts_stat(&softirq_file, st_softirqcpu, softirqcpu_nr, 0);
 	}
 
 	if (!interval) {
@@ -1948,9 +2122,9 @@ void rw_mpstat_loop(int dis_hdr, int rows)
 		memset(st_cpu[1], 0, STATS_CPU_SIZE * (cpu_nr + 1));
 		memset(st_node[1], 0, STATS_CPU_SIZE * (cpu_nr + 1));
 		memset(st_irq[1], 0, STATS_IRQ_SIZE * (cpu_nr + 1));
-		memset(st_irqcpu[1], 0, STATS_IRQCPU_SIZE * (cpu_nr + 1) * irqcpu_nr);
+		reset_irqs_sample(&st_irqcpu[1], irqcpu_nr);
 		if (DISPLAY_SOFTIRQS(actflags)) {
-			memset(st_softirqcpu[1], 0, STATS_IRQCPU_SIZE * (cpu_nr + 1) * softirqcpu_nr);
+			reset_irqs_sample(&st_softirqcpu[1], softirqcpu_nr);
 		}
 		write_stats(0, DISP_HDR);
 		if (DISPLAY_JSON_OUTPUT(flags)) {
@@ -1971,10 +2145,9 @@ void rw_mpstat_loop(int dis_hdr, int rows)
 	memcpy(st_cpu[2], st_cpu[0], STATS_CPU_SIZE * (cpu_nr + 1));
 	memcpy(st_node[2], st_node[0], STATS_CPU_SIZE * (cpu_nr + 1));
 	memcpy(st_irq[2], st_irq[0], STATS_IRQ_SIZE * (cpu_nr + 1));
-	memcpy(st_irqcpu[2], st_irqcpu[0], STATS_IRQCPU_SIZE * (cpu_nr + 1) * irqcpu_nr);
+	copy_irqs_sample(&st_irqcpu[2], &st_irqcpu[0], irqcpu_nr);
 	if (DISPLAY_SOFTIRQS(actflags)) {
-		memcpy(st_softirqcpu[2], st_softirqcpu[0],
-		       STATS_IRQCPU_SIZE * (cpu_nr + 1) * softirqcpu_nr);
+		copy_irqs_sample(&st_softirqcpu[2], &st_softirqcpu[0], softirqcpu_nr);
 	}
 
 	/* Set a handler for SIGINT */
@@ -2019,10 +2192,10 @@ void rw_mpstat_loop(int dis_hdr, int rows)
 		 * and compute the total number of interrupts received by each CPU.
 		 */
 		if (DISPLAY_IRQ_SUM(actflags) || DISPLAY_IRQ_CPU(actflags)) {
-			read_interrupts_stat(INTERRUPTS, st_irqcpu, irqcpu_nr, curr);
+			read_interrupts_stat(&irq_file, st_irqcpu, irqcpu_nr, curr);
 		}
 		if (DISPLAY_SOFTIRQS(actflags)) {
-			read_interrupts_stat(SOFTIRQS, st_softirqcpu, softirqcpu_nr, curr);
+			read_interrupts_stat(&softirq_file, st_softirqcpu, softirqcpu_nr, curr);
 		}
 
 		/* Write stats */
@@ -2119,6 +2292,18 @@ int main(int argc, char **argv)
 			}
 		}
 
+		else if (!strcmp(argv[opt], "--changed")) {
+			/* Display only CPU whose values have changed by at least <threshold> */
+			if (!argv[++opt] || DISPLAY_CHANGED_ONLY(flags)) {
+				usage(argv[0]);
+			}
+			changed_threshold = strtod(argv[opt], &t);
+			if ((*t != '\0') || (t == argv[opt]) || (changed_threshold < 0)) {
+				usage(argv[0]);
+			}
+			flags |= F_CHANGED;
+		}
+
 		else if (!strcmp(argv[opt], "-I")) {
 			if (!argv[++opt]) {
 				usage(argv[0]);
@@ -2302,6 +2487,10 @@ int main(int argc, char **argv)
 		interval = 0;
 	}
 
+	if (DISPLAY_CHANGED_ONLY(flags)) {
+		salloc_changed_struct(cpu_nr + 1);
+	}
+
 	if (DISPLAY_JSON_OUTPUT(flags)) {
 		/* Use a decimal point to make JSON code compliant with RFC7159 */
 		setlocale(LC_NUMERIC, "C");
@@ -15,8 +15,6 @@
  */
 
 #define SOFTIRQS	PRE "/proc/softirqs"
-#define PHYS_PACK_ID	"topology/physical_package_id"
-#define THREAD_SBL_LST	"topology/thread_siblings_list"
 
 /*
  ***************************************************************************
@@ -52,12 +50,15 @@
 #define F_OPTION_N	0x08
 /* Display topology */
 #define F_TOPOLOGY	0x10
+/* Indicate that option --changed has been used */
+#define F_CHANGED	0x20
 
 #define USE_OPTION_P(m)		(((m) & F_OPTION_P) == F_OPTION_P)
 #define USE_OPTION_A(m)		(((m) & F_OPTION_A) == F_OPTION_A)
 #define DISPLAY_JSON_OUTPUT(m)	(((m) & F_JSON_OUTPUT) == F_JSON_OUTPUT)
 #define USE_OPTION_N(m)		(((m) & F_OPTION_N) == F_OPTION_N)
 #define DISPLAY_TOPOLOGY(m)	(((m) & F_TOPOLOGY) == F_TOPOLOGY)
+#define DISPLAY_CHANGED_ONLY(m)	(((m) & F_CHANGED) == F_CHANGED)
 
 #define K_SUM	"SUM"
 #define K_CPU	"CPU"
@@ -67,6 +68,18 @@
 
 #define MAX_IRQ_LEN		16
 
+/* Nb of values displayed for each CPU (%usr, %nice... %idle) */
+#define NR_CPU_PC		10
+
+/*
+ * With option --changed, every CHANGED_KEYFRAME samples all the CPU and
+ * interrupts are displayed, even if their values haven't changed.
+ */
+#define CHANGED_KEYFRAME	10
+
+/* Absolute difference between two values */
+#define VALUE_CHANGE(a,b)	((a) > (b) ? (a) - (b) : (b) - (a))
+
 /*
  ***************************************************************************
  * Structures used to store statistics.
@@ -74,25 +87,58 @@
  */
 
 /*
- * stats_irqcpu->irq_name:  IRQ#-A
- * stats_irqcpu->interrupt: number of IRQ#-A for proc 0
- * stats_irqcpu->irq_name:  IRQ#-B
- * stats_irqcpu->interrupt: number of IRQ#-B for proc 0
- * ...
- * stats_irqcpu->irq_name:  (undef'd)
- * stats_irqcpu->interrupt: number of IRQ#-A for proc 1
- * stats_irqcpu->irq_name:  (undef'd)
- * stats_irqcpu->interrupt: number of IRQ#-B for proc 1
- * ...
+ * Number of interrupts received by a given CPU for an interrupt.
+ * Only non-zero values are saved.
+ */
+struct irqcpu_val {
+	unsigned int cpu;
+	unsigned int interrupt;
+};
+
+/*
+ * Interrupt (hard or soft) read from /proc/interrupts or /proc/softirqs.
+ * Its name is saved only once. The number of interrupts received by
+ * each CPU is saved in the @val array of the sample (see below): There are
+ * @nr such values, starting at index @first, sorted by CPU number.
+ * An empty string for @irq_name means that this is a dummy interrupt.
  */
 struct stats_irqcpu {
-	unsigned int interrupt        __attribute__ ((aligned (4)));
 	char         irq_name[MAX_IRQ_LEN];
+	unsigned int first;
+	unsigned int nr;
+	/* Cursor in @val array used when displaying statistics */
+	unsigned int pos;
+};
+
+/* Interrupts statistics (hard or soft) for one sample */
+struct stats_irqs {
+	struct stats_irqcpu *irq;	/* ic_nr structures */
+	struct irqcpu_val   *val;	/* Non-zero values for all interrupts */
+	unsigned int         val_nr;	/* Nb of values saved in @val */
+	unsigned int         val_sz;	/* Nb of values allocated for @val */
+};
+
+/* /proc file containing interrupts statistics, kept open between samples */
+struct irq_file {
+	char   *name;
+	int     fd;
+	char   *buf;
+	size_t  buf_size;
+};
+
+/*
+ * Rates of interrupts last displayed for a CPU (option --changed).
+ * Only non-zero rates are saved, sorted by position of the interrupt.
+ */
+struct irq_rate {
+	unsigned int irq;
+	double       rate;
 };
 
-struct cpu_topology {
-	int phys_package_id;
-	int logical_core_id;
+struct cpu_irq_rates {
+	struct irq_rate *r;
+	unsigned int     nr;
+	unsigned int     sz;
 };
 
 #define STATS_IRQCPU_SIZE      (sizeof(struct stats_irqcpu))
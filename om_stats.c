@@ -0,0 +1,614 @@
+/*
+ * om_stats.c: Functions used by sadc to render statistics in OpenMetrics
+ * text format.
+ * (C) 2026 by agent (agent <at> local)
+ *
+ ***************************************************************************
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published  by  the *
+ * Free Software Foundation; either version 2 of the License, or (at  your *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it  will  be  useful,  but *
+ * WITHOUT ANY WARRANTY; without the implied warranty  of  MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License *
+ * for more details.                                                       *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA              *
+ ***************************************************************************
+ *
+ * Statistics of the last sample collected by sadc are in buf[0], and those
+ * of the previous sample (if any) in buf[1]. Counters are rendered as read
+ * from the kernel, and rates are computed against the previous sample.
+ * @itv is the interval of time between both samples in 1/100th of a second,
+ * or 0 if there is no previous sample, in which case rates are not rendered.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "sa.h"
+#include "om_stats.h"
+
+/* Types of the fields described by a struct om_field */
+#define OM_ULL	0
+#define OM_UL	1
+#define OM_U	2
+
+/* Description of a field rendered as a metric */
+struct om_field {
+	char *name;		/* Metric family name (without prefix and suffix) */
+	char *help;		/* Help string */
+	int offset;		/* Offset of the field in its statistics structure */
+	int type;		/* OM_ULL, OM_UL or OM_U */
+	unsigned long long mul;	/* Value is multiplied by @mul... */
+	unsigned long long div;	/* ...then divided by @div */
+};
+
+/*
+ ***************************************************************************
+ * Append formatted text to an OpenMetrics buffer, enlarging it if needed.
+ *
+ * IN:
+ * @ob		Buffer where text is appended.
+ * @fmt		Format string, followed by its arguments.
+ ***************************************************************************
+ */
+void om_printf(struct om_buf *ob, const char *fmt, ...)
+{
+	va_list args;
+	int n;
+
+	while (1) {
+		va_start(args, fmt);
+		n = vsnprintf(ob->buf + ob->len, ob->size - ob->len, fmt, args);
+		va_end(args);
+
+		if (n < 0)
+			return;
+		if (ob->len + n < ob->size)
+			break;
+
+		/* Buffer too small: Double its size then try again */
+		ob->size = ob->size * 2 + n;
+		SREALLOC(ob->buf, char, ob->size);
+	}
+	ob->len += n;
+}
+
+/*
+ ***************************************************************************
+ * Print the metadata of a metric family.
+ *
+ * IN:
+ * @ob		Buffer where metadata are rendered.
+ * @name	Metric family name (without prefix).
+ * @type	Metric type ("counter" or "gauge").
+ * @unit	Unit of the metric (NULL if none). Metric family name must
+ *		end with the unit.
+ * @help	Help string.
+ ***************************************************************************
+ */
+void om_family(struct om_buf *ob, char *name, char *type, char *unit, char *help)
+{
+	om_printf(ob, "# TYPE " OM_PREFIX "%s %s\n", name, type);
+	if (unit) {
+		om_printf(ob, "# UNIT " OM_PREFIX "%s %s\n", name, unit);
+	}
+	om_printf(ob, "# HELP " OM_PREFIX "%s %s\n", name, help);
+}
+
+/*
+ ***************************************************************************
+ * Copy a label value, escaping characters as required by OpenMetrics.
+ *
+ * IN:
+ * @s		Label value.
+ * @len		Size of the output buffer.
+ *
+ * OUT:
+ * @out		Escaped label value.
+ *
+ * RETURNS:
+ * Pointer on escaped label value.
+ ***************************************************************************
+ */
+char *om_escape(const char *s, char *out, size_t len)
+{
+	size_t i = 0;
+
+	for (; *s && (i < len - 2); s++) {
+		if ((*s == '"') || (*s == '\\')) {
+			out[i++] = '\\';
+			out[i++] = *s;
+		}
+		else if (*s == '\n') {
+			out[i++] = '\\';
+			out[i++] = 'n';
+		}
+		else {
+			out[i++] = *s;
+		}
+	}
+	out[i] = '\0';
+
+	return out;
+}
+
+/*
+ ***************************************************************************
+ * Get the value of a field described by a struct om_field.
+ *
+ * IN:
+ * @st		Statistics structure containing the field.
+ * @f		Field description.
+ *
+ * RETURNS:
+ * Raw value of the field.
+ ***************************************************************************
+ */
+unsigned long long om_get_value(void *st, struct om_field *f)
+{
+	char *p = (char *) st + f->offset;
+
+	switch (f->type) {
+	case OM_ULL:
+		return *((unsigned long long *) p);
+	case OM_UL:
+		return *((unsigned long *) p);
+	default:
+		return *((unsigned int *) p);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Print a sample value of a field described by a struct om_field.
+ *
+ * IN:
+ * @ob		Buffer where the value is rendered.
+ * @f		Field description.
+ * @value	Raw value of the field.
+ ***************************************************************************
+ */
+void om_print_value(struct om_buf *ob, struct om_field *f, unsigned long long value)
+{
+	if (f->div == 1) {
+		om_printf(ob, " %llu\n", value * f->mul);
+	}
+	else {
+		om_printf(ob, " %.3f\n", (double) value * f->mul / f->div);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Render an array of fields for a single-item activity as gauges.
+ *
+ * IN:
+ * @ob		Buffer where statistics are rendered.
+ * @st		Statistics structure.
+ * @fields	Fields to render.
+ * @nr		Number of fields.
+ * @unit	Unit of the metrics (NULL if none).
+ ***************************************************************************
+ */
+void om_print_gauges(struct om_buf *ob, void *st, struct om_field fields[], int nr,
+		     char *unit)
+{
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		om_family(ob, fields[i].name, "gauge", unit, fields[i].help);
+		om_printf(ob, OM_PREFIX "%s", fields[i].name);
+		om_print_value(ob, &fields[i], om_get_value(st, &fields[i]));
+	}
+}
+
+/*
+ ***************************************************************************
+ * Render CPU statistics in OpenMetrics format.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @ob		Buffer where statistics are rendered.
+ * @itv		Interval of time in 1/100th of a second.
+ ***************************************************************************
+ */
+__print_funct_t om_print_cpu_stats(struct activity *a, struct om_buf *ob,
+				   unsigned long long itv)
+{
+	int i, j;
+	struct stats_cpu *scc, *scp;
+	unsigned long long vc[10], vp[10], tot;
+	char cpu[16];
+	char *modes[] = {"user", "nice", "system", "iowait", "steal",
+			 "irq", "softirq", "guest", "guest_nice", "idle"};
+
+	om_family(ob, "cpu_seconds", "counter", "seconds",
+		  "Time spent by CPUs in each mode.");
+
+	for (i = 0; i < a->nr[0]; i++) {
+		scc = (struct stats_cpu *) ((char *) a->buf[0] + i * a->msize);
+
+		if (i && !(scc->cpu_user + scc->cpu_nice + scc->cpu_sys + scc->cpu_idle +
+			   scc->cpu_iowait + scc->cpu_steal + scc->cpu_hardirq + scc->cpu_softirq))
+			/* Offline CPU */
+			continue;
+
+		if (i) {
+			snprintf(cpu, sizeof(cpu), "%d", i - 1);
+		}
+		else {
+			strcpy(cpu, "all");
+		}
+
+		/* Guest time is already included in user time: Don't count it twice */
+		vc[0] = scc->cpu_user - scc->cpu_guest;
+		vc[1] = scc->cpu_nice - scc->cpu_guest_nice;
+		vc[2] = scc->cpu_sys;
+		vc[3] = scc->cpu_iowait; vc[4] = scc->cpu_steal;   vc[5] = scc->cpu_hardirq;
+		vc[6] = scc->cpu_softirq; vc[7] = scc->cpu_guest;  vc[8] = scc->cpu_guest_nice;
+		vc[9] = scc->cpu_idle;
+
+		for (j = 0; j < 10; j++) {
+			om_printf(ob, OM_PREFIX "cpu_seconds_total{cpu=\"%s\",mode=\"%s\"} %.2f\n",
+				  cpu, modes[j], (double) vc[j] / HZ);
+		}
+	}
+
+	if (!itv)
+		return;
+
+	om_family(ob, "cpu_utilization_ratio", "gauge", "ratio",
+		  "Fraction of time spent by CPUs in each mode during last interval.");
+
+	for (i = 0; (i < a->nr[0]) && (i < a->nr[1]); i++) {
+		scc = (struct stats_cpu *) ((char *) a->buf[0] + i * a->msize);
+		scp = (struct stats_cpu *) ((char *) a->buf[1] + i * a->msize);
+
+		/* Guest time is already included in user time: Don't count it twice */
+		vc[0] = scc->cpu_user - scc->cpu_guest;	vp[0] = scp->cpu_user - scp->cpu_guest;
+		vc[1] = scc->cpu_nice - scc->cpu_guest_nice;
+		vp[1] = scp->cpu_nice - scp->cpu_guest_nice;
+		vc[2] = scc->cpu_sys;	  vp[2] = scp->cpu_sys;
+		vc[3] = scc->cpu_iowait;  vp[3] = scp->cpu_iowait;
+		vc[4] = scc->cpu_steal;	  vp[4] = scp->cpu_steal;
+		vc[5] = scc->cpu_hardirq; vp[5] = scp->cpu_hardirq;
+		vc[6] = scc->cpu_softirq; vp[6] = scp->cpu_softirq;
+		vc[7] = scc->cpu_guest;	  vp[7] = scp->cpu_guest;
+		vc[8] = scc->cpu_guest_nice; vp[8] = scp->cpu_guest_nice;
+		vc[9] = scc->cpu_idle;	  vp[9] = scp->cpu_idle;
+
+		for (tot = 0, j = 0; j < 10; j++) {
+			if (vc[j] < vp[j])
+				/* CPU may have been put offline then back online */
+				break;
+			tot += vc[j] - vp[j];
+		}
+		if ((j < 10) || !tot)
+			continue;
+
+		if (i) {
+			snprintf(cpu, sizeof(cpu), "%d", i - 1);
+		}
+		else {
+			strcpy(cpu, "all");
+		}
+
+		for (j = 0; j < 10; j++) {
+			om_printf(ob, OM_PREFIX "cpu_utilization_ratio{cpu=\"%s\",mode=\"%s\"} %.4f\n",
+				  cpu, modes[j], (double) (vc[j] - vp[j]) / tot);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Render task creation and context switch statistics in OpenMetrics format.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @ob		Buffer where statistics are rendered.
+ * @itv		Interval of time in 1/100th of a second.
+ ***************************************************************************
+ */
+__print_funct_t om_print_pcsw_stats(struct activity *a, struct om_buf *ob,
+				    unsigned long long itv)
+{
+	struct stats_pcsw
+		*spc = (struct stats_pcsw *) a->buf[0],
+		*spp = (struct stats_pcsw *) a->buf[1];
+
+	om_family(ob, "context_switches", "counter", NULL,
+		  "Number of context switches.");
+	om_printf(ob, OM_PREFIX "context_switches_total %llu\n", spc->context_switch);
+	om_family(ob, "forks", "counter", NULL,
+		  "Number of tasks created.");
+	om_printf(ob, OM_PREFIX "forks_total %lu\n", spc->processes);
+
+	if (!itv || (a->nr[1] <= 0))
+		return;
+
+	om_family(ob, "context_switches_per_second", "gauge", NULL,
+		  "Context switches per second during last interval.");
+	om_printf(ob, OM_PREFIX "context_switches_per_second %.2f\n",
+		  S_VALUE(spp->context_switch, spc->context_switch, itv));
+	om_family(ob, "forks_per_second", "gauge", NULL,
+		  "Tasks created per second during last interval.");
+	om_printf(ob, OM_PREFIX "forks_per_second %.2f\n",
+		  S_VALUE(spp->processes, spc->processes, itv));
+}
+
+/*
+ ***************************************************************************
+ * Render memory and swap space utilization statistics in OpenMetrics
+ * format.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @ob		Buffer where statistics are rendered.
+ * @itv		Interval of time in 1/100th of a second.
+ ***************************************************************************
+ */
+__print_funct_t om_print_memory_stats(struct activity *a, struct om_buf *ob,
+				      unsigned long long itv)
+{
+	static struct om_field fields[] = {
+		{"memory_total_bytes", "Total amount of memory.",
+		 offsetof(struct stats_memory, tlmkb), OM_ULL, 1024, 1},
+		{"memory_free_bytes", "Amount of free memory.",
+		 offsetof(struct stats_memory, frmkb), OM_ULL, 1024, 1},
+		{"memory_available_bytes", "Estimate of memory available for starting new applications.",
+		 offsetof(struct stats_memory, availablekb), OM_ULL, 1024, 1},
+		{"memory_buffers_bytes", "Amount of memory used as buffers by the kernel.",
+		 offsetof(struct stats_memory, bufkb), OM_ULL, 1024, 1},
+		{"memory_cached_bytes", "Amount of memory used to cache data by the kernel.",
+		 offsetof(struct stats_memory, camkb), OM_ULL, 1024, 1},
+		{"memory_committed_bytes", "Amount of memory needed for current workload.",
+		 offsetof(struct stats_memory, comkb), OM_ULL, 1024, 1},
+		{"memory_active_bytes", "Amount of active memory.",
+		 offsetof(struct stats_memory, activekb), OM_ULL, 1024, 1},
+		{"memory_inactive_bytes", "Amount of inactive memory.",
+		 offsetof(struct stats_memory, inactkb), OM_ULL, 1024, 1},
+		{"memory_dirty_bytes", "Amount of memory waiting to get written back to disk.",
+		 offsetof(struct stats_memory, dirtykb), OM_ULL, 1024, 1},
+		{"swap_total_bytes", "Total amount of swap space.",
+		 offsetof(struct stats_memory, tlskb), OM_ULL, 1024, 1},
+		{"swap_free_bytes", "Amount of free swap space.",
+		 offsetof(struct stats_memory, frskb), OM_ULL, 1024, 1}
+	};
+
+	om_print_gauges(ob, a->buf[0], fields, sizeof(fields) / sizeof(fields[0]), "bytes");
+}
+
+/*
+ ***************************************************************************
+ * Render queue and load statistics in OpenMetrics format.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @ob		Buffer where statistics are rendered.
+ * @itv		Interval of time in 1/100th of a second.
+ ***************************************************************************
+ */
+__print_funct_t om_print_queue_stats(struct activity *a, struct om_buf *ob,
+				     unsigned long long itv)
+{
+	struct stats_queue *sqc = (struct stats_queue *) a->buf[0];
+	static struct om_field fields[] = {
+		{"run_queue_length", "Number of tasks waiting for run time.",
+		 offsetof(struct stats_queue, nr_running), OM_ULL, 1, 1},
+		{"tasks", "Number of tasks in the task list.",
+		 offsetof(struct stats_queue, nr_threads), OM_ULL, 1, 1},
+		{"blocked_tasks", "Number of tasks currently blocked, waiting for I/O to complete.",
+		 offsetof(struct stats_queue, procs_blocked), OM_ULL, 1, 1}
+	};
+
+	om_print_gauges(ob, sqc, fields, sizeof(fields) / sizeof(fields[0]), NULL);
+
+	om_family(ob, "load_average", "gauge", NULL,
+		  "System load average.");
+	om_printf(ob, OM_PREFIX "load_average{period=\"1m\"} %.2f\n",
+		  (double) sqc->load_avg_1 / 100);
+	om_printf(ob, OM_PREFIX "load_average{period=\"5m\"} %.2f\n",
+		  (double) sqc->load_avg_5 / 100);
+	om_printf(ob, OM_PREFIX "load_average{period=\"15m\"} %.2f\n",
+		  (double) sqc->load_avg_15 / 100);
+}
+
+/*
+ ***************************************************************************
+ * Look for the structure in previous sample corresponding to current disk.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @sdc		Current disk statistics.
+ *
+ * RETURNS:
+ * Pointer on previous statistics for this disk, or NULL if not found.
+ ***************************************************************************
+ */
+struct stats_disk *om_find_prev_disk(struct activity *a, struct stats_disk *sdc)
+{
+	int j;
+	struct stats_disk *sdp;
+
+	for (j = 0; j < a->nr[1]; j++) {
+		sdp = (struct stats_disk *) ((char *) a->buf[1] + j * a->msize);
+		if ((sdp->major == sdc->major) && (sdp->minor == sdc->minor))
+			return sdp;
+	}
+
+	return NULL;
+}
+
+/*
+ ***************************************************************************
+ * Render disks statistics in OpenMetrics format.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @ob		Buffer where statistics are rendered.
+ * @itv		Interval of time in 1/100th of a second.
+ ***************************************************************************
+ */
+__print_funct_t om_print_disk_stats(struct activity *a, struct om_buf *ob,
+				    unsigned long long itv)
+{
+	int i, j;
+	struct stats_disk *sdc, *sdp;
+	unsigned long long vc, vp;
+	static struct om_field fields[] = {
+		{"disk_ios", "Number of I/O requests completed.",
+		 offsetof(struct stats_disk, nr_ios), OM_ULL, 1, 1},
+		{"disk_read_bytes", "Number of bytes read.",
+		 offsetof(struct stats_disk, rd_sect), OM_UL, 512, 1},
+		{"disk_written_bytes", "Number of bytes written.",
+		 offsetof(struct stats_disk, wr_sect), OM_UL, 512, 1},
+		{"disk_discarded_bytes", "Number of bytes discarded.",
+		 offsetof(struct stats_disk, dc_sect), OM_UL, 512, 1},
+		{"disk_io_time_seconds", "Time spent doing I/Os.",
+		 offsetof(struct stats_disk, tot_ticks), OM_U, 1, 1000}
+	};
+	static char *units[] = {NULL, "bytes", "bytes", "bytes", "seconds"};
+	static char *rate_help[] = {
+		"I/O requests completed per second during last interval.",
+		"Bytes read per second during last interval.",
+		"Bytes written per second during last interval.",
+		"Bytes discarded per second during last interval.",
+		"Fraction of time the device was busy during last interval."
+	};
+	static char *rate_names[] = {
+		"disk_ios_per_second", "disk_read_bytes_per_second",
+		"disk_written_bytes_per_second", "disk_discarded_bytes_per_second",
+		"disk_utilization_ratio"
+	};
+	int nr = sizeof(fields) / sizeof(fields[0]);
+
+	for (j = 0; j < nr; j++) {
+		om_family(ob, fields[j].name, "counter", units[j], fields[j].help);
+
+		for (i = 0; i < a->nr[0]; i++) {
+			sdc = (struct stats_disk *) ((char *) a->buf[0] + i * a->msize);
+
+			om_printf(ob, OM_PREFIX "%s_total{major=\"%u\",minor=\"%u\"}",
+				  fields[j].name, sdc->major, sdc->minor);
+			om_print_value(ob, &fields[j], om_get_value(sdc, &fields[j]));
+		}
+	}
+
+	if (!itv)
+		return;
+
+	for (j = 0; j < nr; j++) {
+		om_family(ob, rate_names[j], "gauge", (j == nr - 1) ? "ratio" : NULL,
+			  rate_help[j]);
+
+		for (i = 0; i < a->nr[0]; i++) {
+			sdc = (struct stats_disk *) ((char *) a->buf[0] + i * a->msize);
+
+			if ((sdp = om_find_prev_disk(a, sdc)) == NULL)
+				/* New disk */
+				continue;
+
+			vc = om_get_value(sdc, &fields[j]);
+			vp = om_get_value(sdp, &fields[j]);
+			if (vc < vp)
+				continue;
+
+			om_printf(ob, OM_PREFIX "%s{major=\"%u\",minor=\"%u\"} %.4f\n",
+				  rate_names[j], sdc->major, sdc->minor,
+				  (j == nr - 1) ? (double) (vc - vp) / (itv * 10)
+						: S_VALUE(vp, vc, itv) * fields[j].mul);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Render network interfaces statistics in OpenMetrics format.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @ob		Buffer where statistics are rendered.
+ * @itv		Interval of time in 1/100th of a second.
+ ***************************************************************************
+ */
+__print_funct_t om_print_net_dev_stats(struct activity *a, struct om_buf *ob,
+				       unsigned long long itv)
+{
+	int i, j, k;
+	struct stats_net_dev *sndc, *sndp;
+	unsigned long long vc, vp;
+	char iface[MAX_IFACE_LEN * 2];
+	static struct om_field fields[] = {
+		{"network_receive_packets", "Number of packets received.",
+		 offsetof(struct stats_net_dev, rx_packets), OM_ULL, 1, 1},
+		{"network_transmit_packets", "Number of packets transmitted.",
+		 offsetof(struct stats_net_dev, tx_packets), OM_ULL, 1, 1},
+		{"network_receive_bytes", "Number of bytes received.",
+		 offsetof(struct stats_net_dev, rx_bytes), OM_ULL, 1, 1},
+		{"network_transmit_bytes", "Number of bytes transmitted.",
+		 offsetof(struct stats_net_dev, tx_bytes), OM_ULL, 1, 1}
+	};
+	static char *units[] = {NULL, NULL, "bytes", "bytes"};
+	static char *rate_names[] = {
+		"network_receive_packets_per_second", "network_transmit_packets_per_second",
+		"network_receive_bytes_per_second", "network_transmit_bytes_per_second"
+	};
+	static char *rate_help[] = {
+		"Packets received per second during last interval.",
+		"Packets transmitted per second during last interval.",
+		"Bytes received per second during last interval.",
+		"Bytes transmitted per second during last interval."
+	};
+	int nr = sizeof(fields) / sizeof(fields[0]);
+
+	for (j = 0; j < nr; j++) {
+		om_family(ob, fields[j].name, "counter", units[j], fields[j].help);
+
+		for (i = 0; i < a->nr[0]; i++) {
+			sndc = (struct stats_net_dev *) ((char *) a->buf[0] + i * a->msize);
+
+			om_printf(ob, OM_PREFIX "%s_total{interface=\"%s\"}", fields[j].name,
+				  om_escape(sndc->interface, iface, sizeof(iface)));
+			om_print_value(ob, &fields[j], om_get_value(sndc, &fields[j]));
+		}
+	}
+
+	if (!itv)
+		return;
+
+	for (j = 0; j < nr; j++) {
+		om_family(ob, rate_names[j], "gauge", NULL, rate_help[j]);
+
+		for (i = 0; i < a->nr[0]; i++) {
+			sndc = (struct stats_net_dev *) ((char *) a->buf[0] + i * a->msize);
+
+			/* Look for the same interface in previous sample */
+			for (k = 0; k < a->nr[1]; k++) {
+				sndp = (struct stats_net_dev *) ((char *) a->buf[1] + k * a->msize);
+				if (!strcmp(sndc->interface, sndp->interface))
+					break;
+			}
+			if (k >= a->nr[1])
+				/* New interface */
+				continue;
+
+			vc = om_get_value(sndc, &fields[j]);
+			vp = om_get_value(sndp, &fields[j]);
+			if (vc < vp)
+				continue;
+
+			om_printf(ob, OM_PREFIX "%s{interface=\"%s\"} %.2f\n", rate_names[j],
+				  om_escape(sndc->interface, iface, sizeof(iface)),
+				  S_VALUE(vp, vc, itv));
+		}
+	}
+}
@@ -0,0 +1,50 @@
+/*
+ * om_stats.h: Include file used by sadc to render statistics in OpenMetrics
+ * text format.
+ * (C) 2026 by agent (agent <at> local)
+ */
+
+#ifndef _OM_STATS_H
+#define _OM_STATS_H
+
+#include "common.h"
+
+/*
+ ***************************************************************************
+ * Definitions for OpenMetrics exposition.
+ ***************************************************************************
+ */
+
+/* Initial size of the buffer where statistics are rendered */
+#define OM_BUF_SIZE	65536
+
+/* Prefix of all metric names */
+#define OM_PREFIX	"sysstat_"
+
+/* Content type sent in HTTP responses */
+#define OM_CONTENT_TYPE	"application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+/*
+ ***************************************************************************
+ * Prototypes for functions used to render statistics in OpenMetrics format.
+ ***************************************************************************
+ */
+
+void om_printf
+	(struct om_buf *, const char *, ...);
+
+/* Functions used to render statistics in OpenMetrics format */
+__print_funct_t om_print_cpu_stats
+	(struct activity *, struct om_buf *, unsigned long long);
+__print_funct_t om_print_pcsw_stats
+	(struct activity *, struct om_buf *, unsigned long long);
+__print_funct_t om_print_memory_stats
+	(struct activity *, struct om_buf *, unsigned long long);
+__print_funct_t om_print_queue_stats
+	(struct activity *, struct om_buf *, unsigned long long);
+__print_funct_t om_print_disk_stats
+	(struct activity *, struct om_buf *, unsigned long long);
+__print_funct_t om_print_net_dev_stats
+	(struct activity *, struct om_buf *, unsigned long long);
+
+#endif /* _OM_STATS_H */
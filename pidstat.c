@@ -23,6 +23,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
 #include <dirent.h>
@@ -57,11 +58,14 @@ char *sccsid(void) { return (SCCSID); }
 unsigned long long tot_jiffies[3] = {0, 0, 0};
 unsigned long long uptime_cs[3] = {0, 0, 0};
 struct st_pid *pid_list = NULL;
+struct st_pid *grp_list = NULL;	/* Groups of tasks (option --group-by) */
 
 struct tm ps_tstamp[3];
 char commstr[MAX_COMM_LEN];
 char userstr[MAX_USER_LEN];
 char procstr[MAX_COMM_LEN];
+regex_t commregex, procregex;	/* Compiled -C and -G strings */
+int commregex_ok = FALSE, procregex_ok = FALSE;
 
 int cpu_nr = 0;			/* Nb of processors on the machine */
 unsigned long tlmkb;		/* Total memory in kB */
@@ -76,6 +80,14 @@ int signal_caught = 0;
 
 int dplaces_nr = -1;		/* Number of decimal places */
 
+unsigned int top_nr = 0;	/* Number of tasks to display (option --top) */
+int top_field = TOP_CPU;	/* Metric used to rank tasks */
+
+char ofile[MAX_FILE_LEN];	/* Data file where statistics are saved (option -o) */
+char ifile[MAX_FILE_LEN];	/* Data file statistics are read from (option -f) */
+FILE *ofp = NULL;
+int tm_start = -1, tm_end = -1;	/* Time range (in seconds since midnight) */
+
 /*
  ***************************************************************************
  * Print usage and exit.
@@ -93,7 +105,9 @@ void usage(char *progname)
 			  "[ -d ] [ -H ] [ -h ] [ -I ] [ -l ] [ -R ] [ -r ] [ -s ] [ -t ] [ -U [ <username> ] ]\n"
 			  "[ -u ] [ -V ] [ -v ] [ -w ] [ -C <command> ] [ -G <process_name> ]\n"
 			  "[ -p { <pid> [,...] | SELF | ALL } ] [ -T { TASK | CHILD | ALL } ]\n"
-			  "[ --dec={ 0 | 1 | 2 } ] [ --human ]\n"));
+			  "[ --dec={ 0 | 1 | 2 } ] [ --human ] [ --group-by={ comm | user | cgroup } ]\n"
+			  "[ --top <n>[:{ %%CPU | RSS | kB_rd/s | cswch/s }] ]\n"
+			  "[ -o <filename> | -f <filename> [ --start=<hh:mm[:ss]> ] [ --end=<hh:mm[:ss]> ] ]\n"));
 	exit(1);
 }
 
@@ -146,6 +160,12 @@ void sfree_pid(struct st_pid **plist, int force)
 					free(p->pstats[i]);
 				}
 			}
+			if (p->cgroup) {
+				free(p->cgroup);
+			}
+			if (p->key) {
+				free(p->key);
+			}
 			free(p);
 		}
 		else {
@@ -209,6 +229,37 @@ void check_flags(void)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Allocate a new structure for a task or a group of tasks, with its
+ * statistics structures.
+ *
+ * RETURNS:
+ * Pointer on the new structure (initialized to zero).
+ ***************************************************************************
+ */
+struct st_pid *alloc_pid(void)
+{
+	struct st_pid *p;
+	int i;
+
+	if ((p = (struct st_pid *) malloc(sizeof(struct st_pid))) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	memset(p, 0, sizeof(struct st_pid));
+
+	for (i = 0; i < 3; i++) {
+		if ((p->pstats[i] = (struct pid_stats *) malloc(sizeof(struct pid_stats))) == NULL) {
+			perror("malloc");
+			exit(4);
+		}
+		memset(p->pstats[i], 0, PID_STATS_SIZE);
+	}
+
+	return p;
+}
+
 /*
  ***************************************************************************
  * Look for the PID in the list and store it if necessary.
@@ -230,7 +281,6 @@ void check_flags(void)
 struct st_pid *add_list_pid(struct st_pid **plist, pid_t pid, pid_t tgid)
 {
 	struct st_pid *p, *ps, *tgid_p = NULL;
-	int i;
 	int tgid_found = FALSE;
 
 	if (!pid)
@@ -298,20 +348,7 @@ struct st_pid *add_list_pid(struct st_pid **plist, pid_t pid, pid_t tgid)
 	ps = *plist;
 
 	/* Add PID to the list */
-	if ((*plist = (struct st_pid *) malloc(sizeof(struct st_pid))) == NULL) {
-		perror("malloc");
-		exit(4);
-	}
-	memset(*plist, 0, sizeof(struct st_pid));
-
-	p = *plist;
-	for (i = 0; i < 3; i++) {
-		if ((p->pstats[i] = (struct pid_stats *) malloc(sizeof(struct pid_stats))) == NULL) {
-			perror("malloc");
-			exit(4);
-		}
-		memset(p->pstats[i], 0, PID_STATS_SIZE);
-	}
+	p = *plist = alloc_pid();
 	p->pid = pid;
 	p->next = ps;
 	if (tgid_p) {
@@ -324,6 +361,7 @@ struct st_pid *add_list_pid(struct st_pid **plist, pid_t pid, pid_t tgid)
 /*
  ***************************************************************************
  * Get pointer on task's command string.
+ * If this is a group of tasks then return the key of the group.
  * If this is a thread then return the short command name so that threads
  * can still be identified.
  *
@@ -333,7 +371,10 @@ struct st_pid *add_list_pid(struct st_pid **plist, pid_t pid, pid_t tgid)
  */
 char *get_tcmd(struct st_pid *plist)
 {
-	if (DISPLAY_CMDLINE(pidflag) && strlen(plist->cmdline) && !plist->tgid)
+	if (plist->key)
+		/* Group of tasks (option --group-by) */
+		return plist->key;
+	else if (DISPLAY_CMDLINE(pidflag) && strlen(plist->cmdline) && !plist->tgid)
 		/* Option "-l" used */
 		return plist->cmdline;
 	else
@@ -373,6 +414,36 @@ void print_comm(struct st_pid *plist)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Get the name of the user owning a task. The name is looked up only once
+ * and then saved in the task's structure until its UID changes.
+ *
+ * IN:
+ * @plist	Pointer on the linked list where PID is saved.
+ *
+ * RETURNS:
+ * User name, or NULL if the UID has no corresponding name.
+ ***************************************************************************
+ */
+char *get_pid_username(struct st_pid *plist)
+{
+	struct passwd *pwdent;
+
+	if (!IS_USER_CHECKED(plist->flags)) {
+		if ((pwdent = __getpwuid(plist->uid)) != NULL) {
+			strncpy(plist->username, pwdent->pw_name, sizeof(plist->username) - 1);
+			plist->username[sizeof(plist->username) - 1] = '\0';
+		}
+		else {
+			plist->username[0] = '\0';
+		}
+		plist->flags |= F_USER_CHECKED;
+	}
+
+	return (plist->username[0] ? plist->username : NULL);
+}
+
 /*
  ***************************************************************************
  * Read /proc/meminfo.
@@ -411,6 +482,7 @@ int read_proc_pid_stat(pid_t pid, struct st_pid *plist,
 	char filename[128];
 	static char buffer[1024 + 1];
 	char *start, *end;
+	unsigned long long start_time = plist->start_time;
 	struct pid_stats *pst = plist->pstats[curr];
 
 	if (tgid) {
@@ -438,25 +510,34 @@ int read_proc_pid_stat(pid_t pid, struct st_pid *plist,
 	commsz = end - start;
 	if (commsz >= MAX_COMM_LEN)
 		return 1;
-	memcpy(plist->comm, start, commsz);
-	plist->comm[commsz] = '\0';
+	if (strncmp(plist->comm, start, commsz) || plist->comm[commsz]) {
+		/* New command name: Identity of the task has changed */
+		memcpy(plist->comm, start, commsz);
+		plist->comm[commsz] = '\0';
+		plist->flags &= ~F_ID_CACHE;
+	}
 	start = end + 2;
 
 	rc = sscanf(start,
 		    "%*s %*d %*d %*d %*d %*d %*u %llu %llu"
-		    " %llu %llu %llu %llu %lld %lld %*d %*d %u %*u %*d %llu %llu"
+		    " %llu %llu %llu %llu %lld %lld %*d %*d %u %*u %llu %llu %llu"
 		    " %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u"
 		    " %*u %u %u %u %llu %llu %lld\n",
 		    &pst->minflt, &pst->cminflt, &pst->majflt, &pst->cmajflt,
 		    &pst->utime,  &pst->stime, &pst->cutime, &pst->cstime,
-		    thread_nr, &pst->vsz, &pst->rss, &pst->processor,
-		    &pst->priority, &pst->policy,
+		    thread_nr, &plist->start_time, &pst->vsz, &pst->rss,
+		    &pst->processor, &pst->priority, &pst->policy,
 		    &pst->blkio_swapin_delays, &pst->gtime, &pst->cgtime);
 
-	if (rc < 15)
+	if (rc < 16)
 		return 1;
 
-	if (rc < 17) {
+	if (start_time && (plist->start_time != start_time)) {
+		/* PID has been reused by another task */
+		plist->flags &= ~F_ID_CACHE;
+	}
+
+	if (rc < 18) {
 		/* gtime and cgtime fields are unavailable in file */
 		pst->gtime = pst->cgtime = 0;
 	}
@@ -535,6 +616,7 @@ int read_proc_pid_status(pid_t pid, struct st_pid *plist, pid_t tgid, int curr)
 {
 	FILE *fp;
 	char filename[128], line[256];
+	uid_t uid;
 	struct pid_stats *pst = plist->pstats[curr];
 
 	if (tgid) {
@@ -551,7 +633,11 @@ int read_proc_pid_status(pid_t pid, struct st_pid *plist, pid_t tgid, int curr)
 	while (fgets(line, sizeof(line), fp) != NULL) {
 
 		if (!strncmp(line, "Uid:", 4)) {
-			sscanf(line + 5, "%u", &plist->uid);
+			if ((sscanf(line + 5, "%u", &uid) == 1) && (uid != plist->uid)) {
+				/* Username will have to be looked up again */
+				plist->uid = uid;
+				plist->flags &= ~F_USER_CHECKED;
+			}
 		}
 		else if (!strncmp(line, "Threads:", 8)) {
 			sscanf(line + 9, "%u", &pst->threads);
@@ -683,6 +769,8 @@ int read_proc_pid_cmdline(pid_t pid, struct st_pid *plist, pid_t tgid)
 		/* proc/.../cmdline was empty */
 		plist->cmdline[0] = '\0';
 	}
+	plist->flags |= F_CMDLINE_READ;
+
 	return 0;
 }
 
@@ -799,6 +887,71 @@ int read_proc_pid_fd(pid_t pid, struct st_pid *plist, pid_t tgid, int curr)
 	return 0;
 }
 
+/*
+ ***************************************************************************
+ * Read control group of a process from /proc/#/cgroup.
+ * The path in the unified (v2) hierarchy is used if available. Otherwise
+ * the path in the first hierarchy listed in file is used.
+ * The control group is read only once and then kept until the identity of
+ * the task changes.
+ *
+ * IN:
+ * @pid		Process whose control group is to be read.
+ * @plist	Pointer on the linked list where PID is saved.
+ *
+ * RETURNS:
+ * 0 if control group has been successfully read (or if there is no
+ * cgroup file for this process), and 1 otherwise.
+ ***************************************************************************
+ */
+int read_proc_pid_cgroup(pid_t pid, struct st_pid *plist)
+{
+	FILE *fp;
+	char filename[128], line[MAX_PF_NAME], path[MAX_PF_NAME];
+	char *p;
+
+	sprintf(filename, PID_CGROUP, pid);
+
+	path[0] = '\0';
+	if ((fp = fopen(filename, "r")) == NULL) {
+		if (errno != ENOENT)
+			return 1;
+		/*
+		 * The other files of the process have already been read:
+		 * The kernel has no cgroup support (or the file is hidden).
+		 * Put the task in the "-" group rather than ignoring it.
+		 */
+	}
+	else {
+		while (fgets(line, sizeof(line), fp) != NULL) {
+			/* Line format is: hierarchy-ID:controller-list:cgroup-path */
+			if (((p = strchr(line, ':')) == NULL) ||
+			    ((p = strchr(p + 1, ':')) == NULL))
+				continue;
+
+			if (!path[0] || !strncmp(line, "0::", 3)) {
+				strncpy(path, p + 1, sizeof(path) - 1);
+				path[sizeof(path) - 1] = '\0';
+				path[strcspn(path, "\n")] = '\0';
+				if (!strncmp(line, "0::", 3))
+					break;
+			}
+		}
+		fclose(fp);
+	}
+
+	if (plist->cgroup) {
+		free(plist->cgroup);
+	}
+	if ((plist->cgroup = strdup(path[0] ? path : "-")) == NULL) {
+		perror("strdup");
+		exit(4);
+	}
+	plist->flags |= F_CGROUP_READ;
+
+	return 0;
+}
+
 /*
  ***************************************************************************
  * Read various stats for given PID.
@@ -828,7 +981,8 @@ int read_pid_stats(pid_t pid, struct st_pid *plist, unsigned int *thread_nr,
 	 */
 	read_proc_pid_sched(pid, plist, tgid, curr);
 
-	if (DISPLAY_CMDLINE(pidflag) && !plist->cmdline[0]) {
+	if ((DISPLAY_CMDLINE(pidflag) || SAVE_TO_FILE(pidflag)) &&
+	    !IS_CMDLINE_READ(plist->flags)) {
 		if (read_proc_pid_cmdline(pid, plist, tgid))
 			return 1;
 	}
@@ -836,6 +990,11 @@ int read_pid_stats(pid_t pid, struct st_pid *plist, unsigned int *thread_nr,
 	if (read_proc_pid_status(pid, plist, tgid, curr))
 		return 1;
 
+	if (GROUP_BY_CGROUP(pidflag) && !tgid && !IS_CGROUP_READ(plist->flags)) {
+		if (read_proc_pid_cgroup(pid, plist))
+			return 1;
+	}
+
 	if (DISPLAY_STACK(actflag)) {
 		if (read_proc_pid_smap(pid, plist, tgid, curr))
 			return 1;
@@ -863,7 +1022,7 @@ int read_pid_stats(pid_t pid, struct st_pid *plist, unsigned int *thread_nr,
  * @curr	Index in array for current sample statistics.
  ***************************************************************************
  */
-void read_task_stats(pid_t pid, struct st_pid *plist, int curr)
+void scan_task_stats(pid_t pid, struct st_pid *plist, int curr)
 {
 	DIR *dir;
 	pid_t tid;
@@ -872,6 +1031,8 @@ void read_task_stats(pid_t pid, struct st_pid *plist, int curr)
 	unsigned int thr_nr;
 	struct st_pid *tlist;
 
+	plist->task_scan_nr = 0;
+
 	/* Open /proc/#/task directory */
 	sprintf(filename, PROC_TASK, pid);
 	if ((dir = __opendir(filename)) == NULL)
@@ -900,145 +1061,485 @@ void read_task_stats(pid_t pid, struct st_pid *plist, int curr)
 
 /*
  ***************************************************************************
- * Read various stats.
+ * Read stats for the threads of a process already found in the list during
+ * a previous sample, without scanning its /proc/#/task directory again.
  *
  * IN:
+ * @pid		Process number whose threads stats are to be read.
+ * @plist	Pointer on the linked list where PID is saved.
  * @curr	Index in array for current sample statistics.
+ *
+ * RETURNS:
+ * 0 if stats have been read for every known thread, and 1 if a thread has
+ * terminated or has been replaced with another one with the same TID.
  ***************************************************************************
  */
-void read_stats(int curr)
+int reuse_task_stats(pid_t pid, struct st_pid *plist, int curr)
 {
-	DIR *dir;
-	struct dirent *drp;
 	unsigned int thr_nr;
-	pid_t pid;
-	struct st_pid *plist;
-	struct stats_cpu *st_cpu;
-
-	/*
-	 * Allocate two structures for CPU statistics.
-	 * No need to init them (done by read_stat_cpu() function).
-	 */
-	if ((st_cpu = (struct stats_cpu *) malloc(STATS_CPU_SIZE * 2)) == NULL) {
-		perror("malloc");
-		exit(4);
-	}
-	/* Read statistics for CPUs "all" */
-	read_stat_cpu(st_cpu, 1);
+	unsigned long long start_time;
+	struct st_pid *tlist;
 
-	/*
-	 * Compute the total number of jiffies spent by all processors.
-	 * NB: Don't add cpu_guest/cpu_guest_nice because cpu_user/cpu_nice
-	 * already include them.
-	 */
-	tot_jiffies[curr] = st_cpu->cpu_user + st_cpu->cpu_nice +
-			    st_cpu->cpu_sys + st_cpu->cpu_idle +
-			    st_cpu->cpu_iowait + st_cpu->cpu_hardirq +
-			    st_cpu->cpu_steal + st_cpu->cpu_softirq;
-	free(st_cpu);
+	for (tlist = plist->next; (tlist != NULL) && (tlist->tgid == plist);
+	     tlist = tlist->next) {
 
-	if (DISPLAY_ALL_PID(pidflag)) {
+		start_time = tlist->start_time;
+		tlist->exist = TRUE;
 
-		/* Open /proc directory */
-		if ((dir = __opendir(PROC)) == NULL) {
-			perror("opendir");
-			exit(4);
+		if (read_pid_stats(tlist->pid, tlist, &thr_nr, pid, curr) ||
+		    (tlist->start_time != start_time)) {
+			/* Thread doesn't exist or is a new one */
+			tlist->exist = FALSE;
+			return 1;
 		}
+	}
 
-		/* Get directory entries */
-		while ((drp = __readdir(dir)) != NULL) {
-			if (!isdigit(drp->d_name[0])) {
-				continue;
-			}
-
-			pid = atoi(drp->d_name);
+	return 0;
+}
 
-			plist = add_list_pid(&pid_list, pid, 0);
-			if (!plist)
-				continue;
-			plist->exist = TRUE;
+/*
+ ***************************************************************************
+ * Read stats for threads of a given process.
+ * The /proc/#/task directory is scanned only when needed: A single-threaded
+ * process has only one thread whose TID is the PID, and the threads of a
+ * multi-threaded process are those already known if their number and start
+ * times haven't changed. The directory is still scanned every
+ * TASK_RESCAN_NR samples to make sure the list is accurate.
+ *
+ * IN:
+ * @pid		Process number whose threads stats are to be read.
+ * @plist	Pointer on the linked list where PID is saved.
+ * @thr_nr	Number of threads of the process.
+ * @curr	Index in array for current sample statistics.
+ ***************************************************************************
+ */
+void read_task_stats(pid_t pid, struct st_pid *plist, unsigned int thr_nr,
+		     int curr)
+{
+	unsigned int known_nr = 0, tmp;
+	struct st_pid *tlist;
 
-			if (read_pid_stats(pid, plist, &thr_nr, 0, curr)) {
-				/* PID has terminated */
-				plist->exist = FALSE;
+	/* Count threads already known for this process */
+	for (tlist = plist->next; (tlist != NULL) && (tlist->tgid == plist);
+	     tlist = tlist->next) {
+		known_nr++;
+	}
 
-			} else if (DISPLAY_TID(pidflag)) {
-				/* Read stats for threads in task subdirectory */
-				read_task_stats(pid, plist, curr);
-			}
+	if (known_nr && (known_nr == thr_nr) &&
+	    (++(plist->task_scan_nr) < TASK_RESCAN_NR)) {
+		/* Same number of threads: Try to read stats for known TIDs */
+		if (!reuse_task_stats(pid, plist, curr))
+			return;
+	}
+	else if (thr_nr == 1) {
+		/* Single-threaded process: Its only thread is the process itself */
+		plist->task_scan_nr = 0;
+		tlist = add_list_pid(&pid_list, pid, pid);
+		if (tlist) {
+			tlist->exist = TRUE;
+			if (!read_pid_stats(pid, tlist, &tmp, pid, curr))
+				return;
+			tlist->exist = FALSE;
 		}
-
-		/* Close /proc directory */
-		__closedir(dir);
 	}
 
-	else if (DISPLAY_PID(pidflag)) {
-		/* Read stats for each PID in the list */
-		for (plist = pid_list; plist != NULL; plist = plist->next) {
+	/* Scan /proc/#/task directory */
+	scan_task_stats(pid, plist, curr);
+}
 
-			if (plist->tgid)
-				/*
-				 * Ignore TIDs.
-				 * The user can only enter PIDs on the command line.
-				 * If there is a TID then this is because the user has
-				 * used option -t, and the TID has been inserted in the
-				 * list by read_task_stats() function below.
-				 */
-				continue;
+/*
+ ***************************************************************************
+ * Check that a task matches the strings entered on the command line with
+ * options -C, -G and -U. The results of -C and -G matching are kept until
+ * the identity of the task changes.
+ *
+ * IN:
+ * @plist	Pointer on the linked list where PID is saved.
+ *
+ * RETURNS:
+ * TRUE if the task matches all the strings, FALSE otherwise.
+ ***************************************************************************
+ */
+int match_pid_strings(struct st_pid *plist)
+{
+	char *pc;
 
-			if (read_pid_stats(plist->pid, plist, &thr_nr, 0, curr)) {
-				/* PID has terminated */
-				plist->exist = FALSE;
+	if (COMMAND_STRING(pidflag)) {
+		if (!IS_COMM_CHECKED(plist->flags)) {
+			/* Match result is kept until the identity of the task changes */
+			pc = get_tcmd(plist);	/* Get pointer on task's command string */
+			if (commregex_ok && !regexec(&commregex, pc, 0, NULL, 0)) {
+				plist->flags |= F_COMM_MATCHED;
 			}
-			else {
-				plist->exist = TRUE;
+			plist->flags |= F_COMM_CHECKED;
+		}
 
-				if (DISPLAY_TID(pidflag)) {
-					read_task_stats(plist->pid, plist, curr);
+		if (!IS_COMM_MATCHED(plist->flags))
+			/* regex pattern not found in command name */
+			return FALSE;
+	}
+
+	if (PROCESS_STRING(pidflag)) {
+		if (!plist->tgid) {
+			/* This PID is a process ("thread group leader") */
+			if (!IS_PROC_CHECKED(plist->flags)) {
+				pc = get_tcmd(plist);	/* Get pointer on task's command string */
+				if (procregex_ok && !regexec(&procregex, pc, 0, NULL, 0)) {
+					plist->flags |= F_PROC_MATCHED;
 				}
+				plist->flags |= F_PROC_CHECKED;
 			}
+
+			if (!IS_PROC_MATCHED(plist->flags))
+				/* regex pattern not found in command name */
+				return FALSE;
+
 		}
+		else if (!IS_PID_DISPLAYED(plist->tgid->flags))
+			/* This pid is a thread and is not part of a process to display */
+			return FALSE;
 	}
 
-	/* Free unused PID structures */
-	sfree_pid(&pid_list, FALSE);
+	if (USER_STRING(pidflag)) {
+		if ((pc = get_pid_username(plist)) != NULL) {
+			if (strcmp(pc, userstr))
+				/* This PID doesn't belong to user */
+				return FALSE;
+		}
+	}
+
+	return TRUE;
 }
 
 /*
  ***************************************************************************
- * Get current PID to display.
- * First, check that PID exists. *Then* check that it's an active process
- * and/or that the string (entered on the command line with option -C)
- * is found in command name, or that the process string (entered on the
- * command line with option -G) is found either in its command name (in case
- * PID is a process) or in command name of its thread leader (in case
- * PID is a thread).
+ * Get the key identifying the group a process belongs to (option
+ * --group-by).
  *
  * IN:
- * @prev	Index in array where stats used as reference are.
- * @curr	Index in array for current sample statistics.
- * @activity	Current activity to display (CPU, memory...).
- * 		Can be more than one if stats are displayed on one line.
- * @pflag	Flag indicating whether stats are to be displayed for
- * 		individual tasks or for all their children.
  * @plist	Pointer on the linked list where PID is saved.
+ * @key		Buffer where the key is saved if it has to be built.
+ * @len		Size of @key buffer.
  *
  * RETURNS:
- *  0 if PID no longer exists.
- * -1 if PID exists but should not be displayed.
- *  1 if PID can be displayed.
+ * Pointer on the key.
  ***************************************************************************
  */
-int get_pid_to_display(int prev, int curr, unsigned int activity, unsigned int pflag,
-		       struct st_pid *plist)
+char *get_group_key(struct st_pid *plist, char *key, int len)
 {
-	int rc;
 	char *pc;
-	regex_t regex;
-	struct passwd *pwdent;
-	struct pid_stats *pstc = plist->pstats[curr], *pstp = plist->pstats[prev];
 
-	if (!plist->exist)
+	if (GROUP_BY_USER(pidflag)) {
+		if ((pc = get_pid_username(plist)) != NULL)
+			return pc;
+
+		/* No user name: Use UID instead */
+		snprintf(key, len, "%u", (unsigned int) plist->uid);
+		return key;
+	}
+
+	if (GROUP_BY_CGROUP(pidflag))
+		return (plist->cgroup ? plist->cgroup : "-");
+
+	return get_tcmd(plist);
+}
+
+/*
+ ***************************************************************************
+ * Compute hash value of a group key.
+ *
+ * IN:
+ * @key		Key of the group.
+ *
+ * RETURNS:
+ * Hash value, between 0 and GRP_HASH_SIZE - 1.
+ ***************************************************************************
+ */
+unsigned int hash_group_key(char *key)
+{
+	unsigned int h = 5381;
+
+	while (*key) {
+		h = ((h << 5) + h) + (unsigned char) *key++;
+	}
+
+	return (h % GRP_HASH_SIZE);
+}
+
+/*
+ ***************************************************************************
+ * Add statistics of a process to those of its group. Values that are
+ * counters are increased by what the process has accumulated since previous
+ * sample. Other values (memory, stack, threads...) are added as is.
+ *
+ * IN:
+ * @grp		Pointer on the structure of the group.
+ * @plist	Pointer on the linked list where PID is saved.
+ * @prev	Index in array where stats used as reference are.
+ * @curr	Index in array for current sample statistics.
+ ***************************************************************************
+ */
+void add_pid_to_group(struct st_pid *grp, struct st_pid *plist, int prev, int curr)
+{
+	struct pid_stats *pstc = plist->pstats[curr], *pstp = plist->pstats[prev];
+	struct pid_stats *gst = grp->pstats[curr];
+
+#define ADD_DELTA(f)	do {						\
+				if (pstc->f > pstp->f) {		\
+					gst->f += pstc->f - pstp->f;	\
+				}					\
+			} while (0)
+
+	ADD_DELTA(minflt);
+	ADD_DELTA(cminflt);
+	ADD_DELTA(majflt);
+	ADD_DELTA(cmajflt);
+	ADD_DELTA(utime);
+	ADD_DELTA(cutime);
+	ADD_DELTA(stime);
+	ADD_DELTA(cstime);
+	ADD_DELTA(gtime);
+	ADD_DELTA(cgtime);
+	ADD_DELTA(wtime);
+	ADD_DELTA(nvcsw);
+	ADD_DELTA(nivcsw);
+	ADD_DELTA(blkio_swapin_delays);
+	if (!NO_PID_IO(plist->flags)) {
+		ADD_DELTA(read_bytes);
+		ADD_DELTA(write_bytes);
+		ADD_DELTA(cancelled_write_bytes);
+	}
+#undef ADD_DELTA
+
+	gst->vsz        += pstc->vsz;
+	gst->rss        += pstc->rss;
+	gst->stack_size += pstc->stack_size;
+	gst->stack_ref  += pstc->stack_ref;
+	gst->threads    += pstc->threads;
+	if (!NO_PID_FD(plist->flags)) {
+		gst->fd_nr += pstc->fd_nr;
+	}
+
+	grp->task_nr++;
+}
+
+/*
+ ***************************************************************************
+ * Aggregate statistics of processes by command name, user or control group
+ * (option --group-by). Each group is saved in a st_pid structure so that
+ * it can be displayed like a single task. Groups that no longer contain any
+ * processes are freed.
+ *
+ * IN:
+ * @curr	Index in array for current sample statistics.
+ ***************************************************************************
+ */
+void aggregate_pid_stats(int curr)
+{
+	static struct st_pid *grp_hash[GRP_HASH_SIZE];
+	struct st_pid *plist, *grp, **last = &grp_list;
+	struct pid_stats *gst;
+	char key[32], *pk;
+	unsigned int h;
+
+	memset(grp_hash, 0, sizeof(grp_hash));
+
+	for (grp = grp_list; grp != NULL; grp = grp->next) {
+		/* Groups are potentially empty */
+		grp->exist = FALSE;
+		grp->task_nr = 0;
+
+		/* Counters start from their values at previous sample */
+		gst = grp->pstats[curr];
+		*gst = *(grp->pstats[!curr]);
+		gst->vsz = gst->rss = gst->stack_size = gst->stack_ref = 0;
+		gst->threads = gst->fd_nr = 0;
+
+		h = hash_group_key(grp->key);
+		grp->hnext = grp_hash[h];
+		grp_hash[h] = grp;
+
+		last = &(grp->next);
+	}
+
+	for (plist = pid_list; plist != NULL; plist = plist->next) {
+
+		if (!plist->exist || plist->tgid || !match_pid_strings(plist))
+			continue;
+
+		pk = get_group_key(plist, key, sizeof(key));
+		h = hash_group_key(pk);
+
+		for (grp = grp_hash[h]; grp != NULL; grp = grp->hnext) {
+			if (!strcmp(grp->key, pk))
+				break;
+		}
+
+		if (!grp) {
+			/* New group: Add it at the end of the list */
+			grp = *last = alloc_pid();
+			last = &(grp->next);
+			/* Key is saved as is: Control groups paths may be very long */
+			if ((grp->key = strdup(pk)) == NULL) {
+				perror("strdup");
+				exit(4);
+			}
+			grp->hnext = grp_hash[h];
+			grp_hash[h] = grp;
+		}
+
+		if (!grp->exist) {
+			grp->exist = TRUE;
+			grp->uid = plist->uid;
+		}
+		add_pid_to_group(grp, plist, !curr, curr);
+	}
+
+	/* Free empty groups */
+	sfree_pid(&grp_list, FALSE);
+}
+
+/*
+ ***************************************************************************
+ * Read various stats.
+ *
+ * IN:
+ * @curr	Index in array for current sample statistics.
+ ***************************************************************************
+ */
+void read_stats(int curr)
+{
+	DIR *dir;
+	struct dirent *drp;
+	unsigned int thr_nr;
+	pid_t pid;
+	struct st_pid *plist;
+	struct stats_cpu *st_cpu;
+
+	/*
+	 * Allocate two structures for CPU statistics.
+	 * No need to init them (done by read_stat_cpu() function).
+	 */
+	if ((st_cpu = (struct stats_cpu *) malloc(STATS_CPU_SIZE * 2)) == NULL) {
+		perror("malloc");
+		exit(4);
+	}
+	/* Read statistics for CPUs "all" */
+	read_stat_cpu(st_cpu, 1);
+
+	/*
+	 * Compute the total number of jiffies spent by all processors.
+	 * NB: Don't add cpu_guest/cpu_guest_nice because cpu_user/cpu_nice
+	 * already include them.
+	 */
+	tot_jiffies[curr] = st_cpu->cpu_user + st_cpu->cpu_nice +
+			    st_cpu->cpu_sys + st_cpu->cpu_idle +
+			    st_cpu->cpu_iowait + st_cpu->cpu_hardirq +
+			    st_cpu->cpu_steal + st_cpu->cpu_softirq;
+	free(st_cpu);
+
+	if (DISPLAY_ALL_PID(pidflag)) {
+
+		/* Open /proc directory */
+		if ((dir = __opendir(PROC)) == NULL) {
+			perror("opendir");
+			exit(4);
+		}
+
+		/* Get directory entries */
+		while ((drp = __readdir(dir)) != NULL) {
+			if (!isdigit(drp->d_name[0])) {
+				continue;
+			}
+
+			pid = atoi(drp->d_name);
+
+			plist = add_list_pid(&pid_list, pid, 0);
+			if (!plist)
+				continue;
+			plist->exist = TRUE;
+
+			if (read_pid_stats(pid, plist, &thr_nr, 0, curr)) {
+				/* PID has terminated */
+				plist->exist = FALSE;
+
+			} else if (DISPLAY_TID(pidflag)) {
+				/* Read stats for threads in task subdirectory */
+				read_task_stats(pid, plist, thr_nr, curr);
+			}
+		}
+
+		/* Close /proc directory */
+		__closedir(dir);
+	}
+
+	else if (DISPLAY_PID(pidflag)) {
+		/* Read stats for each PID in the list */
+		for (plist = pid_list; plist != NULL; plist = plist->next) {
+
+			if (plist->tgid)
+				/*
+				 * Ignore TIDs.
+				 * The user can only enter PIDs on the command line.
+				 * If there is a TID then this is because the user has
+				 * used option -t, and the TID has been inserted in the
+				 * list by read_task_stats() function below.
+				 */
+				continue;
+
+			if (read_pid_stats(plist->pid, plist, &thr_nr, 0, curr)) {
+				/* PID has terminated */
+				plist->exist = FALSE;
+			}
+			else {
+				plist->exist = TRUE;
+
+				if (DISPLAY_TID(pidflag)) {
+					read_task_stats(plist->pid, plist, thr_nr, curr);
+				}
+			}
+		}
+	}
+
+	/* Free unused PID structures */
+	sfree_pid(&pid_list, FALSE);
+
+	if (GROUP_TASKS(pidflag)) {
+		aggregate_pid_stats(curr);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Get current PID to display.
+ * First, check that PID exists. *Then* check that it's an active process
+ * and/or that the string (entered on the command line with option -C)
+ * is found in command name, or that the process string (entered on the
+ * command line with option -G) is found either in its command name (in case
+ * PID is a process) or in command name of its thread leader (in case
+ * PID is a thread).
+ *
+ * IN:
+ * @prev	Index in array where stats used as reference are.
+ * @curr	Index in array for current sample statistics.
+ * @activity	Current activity to display (CPU, memory...).
+ * 		Can be more than one if stats are displayed on one line.
+ * @pflag	Flag indicating whether stats are to be displayed for
+ * 		individual tasks or for all their children.
+ * @plist	Pointer on the linked list where PID is saved.
+ *
+ * RETURNS:
+ *  0 if PID no longer exists.
+ * -1 if PID exists but should not be displayed.
+ *  1 if PID can be displayed.
+ ***************************************************************************
+ */
+int get_pid_to_display(int prev, int curr, unsigned int activity, unsigned int pflag,
+		       struct st_pid *plist)
+{
+	struct pid_stats *pstc = plist->pstats[curr], *pstp = plist->pstats[prev];
+
+	if (!plist->exist)
 		/* PID no longer exists */
 		return 0;
 
@@ -1047,7 +1548,7 @@ int get_pid_to_display(int prev, int curr, unsigned int activity, unsigned int p
 		plist->flags &= ~F_PID_DISPLAYED;
 	}
 
-	if ((DISPLAY_ALL_PID(pidflag) || DISPLAY_TID(pidflag)) &&
+	if ((DISPLAY_ALL_PID(pidflag) || DISPLAY_TID(pidflag) || GROUP_TASKS(pidflag)) &&
 		DISPLAY_ACTIVE_PID(pidflag)) {
 		int isActive = FALSE;
 
@@ -1144,48 +1645,16 @@ int get_pid_to_display(int prev, int curr, unsigned int activity, unsigned int p
 			return -1;
 	}
 
-	if (COMMAND_STRING(pidflag)) {
-		if (regcomp(&regex, commstr, REG_EXTENDED | REG_NOSUB) != 0)
-			/* Error in preparing regex structure */
-			return -1;
-
-		pc = get_tcmd(plist);	/* Get pointer on task's command string */
-		rc = regexec(&regex, pc, 0, NULL, 0);
-		regfree(&regex);
-
-		if (rc)
-			/* regex pattern not found in command name */
-			return -1;
-	}
-
-	if (PROCESS_STRING(pidflag)) {
-		if (!plist->tgid) {
-			/* This PID is a process ("thread group leader") */
-			if (regcomp(&regex, procstr, REG_EXTENDED | REG_NOSUB) != 0)
-				/* Error in preparing regex structure */
-				return -1;
-
-			pc = get_tcmd(plist);	/* Get pointer on task's command string */
-			rc = regexec(&regex, pc, 0, NULL, 0);
-			regfree(&regex);
-
-			if (rc)
-				/* regex pattern not found in command name */
-				return -1;
-
-		}
-		else if (!IS_PID_DISPLAYED(plist->tgid->flags))
-			/* This pid is a thread and is not part of a process to display */
-			return -1;
-	}
+	if (!GROUP_TASKS(pidflag) && !match_pid_strings(plist))
+		/*
+		 * Strings entered with options -C, -G and -U have already
+		 * been used to select the tasks making up the groups.
+		 */
+		return -1;
 
-	if (USER_STRING(pidflag)) {
-		if ((pwdent = __getpwuid(plist->uid)) != NULL) {
-			if (strcmp(pwdent->pw_name, userstr))
-				/* This PID doesn't belong to user */
-				return -1;
-		}
-	}
+	if (DISPLAY_TOP(pidflag) && !IS_PID_TOP(plist->flags))
+		/* Task is not among the top N tasks */
+		return -1;
 
 	plist->flags |= F_PID_DISPLAYED;
 	return 1;
@@ -1203,10 +1672,25 @@ int get_pid_to_display(int prev, int curr, unsigned int activity, unsigned int p
 void __print_line_id(struct st_pid *plist, char c)
 {
 	char format[32];
-	struct passwd *pwdent;
+	char *username;
+
+	if (GROUP_TASKS(pidflag)) {
+		/* Display UID (if grouped by user) and number of tasks in group */
+		if (!GROUP_BY_USER(pidflag)) {
+			cprintf_in(IS_STR, DISPLAY_USERNAME(pidflag) ? " %8s" : " %5s", "-", 0);
+		}
+		else if (DISPLAY_USERNAME(pidflag) && ((username = get_pid_username(plist)) != NULL)) {
+			cprintf_in(IS_STR, " %8s", username, 0);
+		}
+		else {
+			cprintf_in(IS_INT, " %5d", "", plist->uid);
+		}
+		cprintf_in(IS_INT, " %9u", "", plist->task_nr);
+		return;
+	}
 
-	if (DISPLAY_USERNAME(pidflag) && ((pwdent = __getpwuid(plist->uid)) != NULL)) {
-		cprintf_in(IS_STR, " %8s", pwdent->pw_name, 0);
+	if (DISPLAY_USERNAME(pidflag) && ((username = get_pid_username(plist)) != NULL)) {
+		cprintf_in(IS_STR, " %8s", username, 0);
 	}
 	else {
 		cprintf_in(IS_INT, " %5d", "", plist->uid);
@@ -1251,6 +1735,20 @@ void print_line_id(char *timestamp, struct st_pid *plist)
 	__print_line_id(plist, '-');
 }
 
+/*
+ ***************************************************************************
+ * Get the list of entries to display: Groups of tasks if option --group-by
+ * has been used, individual tasks otherwise.
+ *
+ * RETURNS:
+ * Pointer on the start of the linked list.
+ ***************************************************************************
+ */
+struct st_pid *get_display_list(void)
+{
+	return (GROUP_TASKS(pidflag) ? grp_list : pid_list);
+}
+
 /*
  ***************************************************************************
  * Display all statistics for tasks in one line format.
@@ -1305,10 +1803,10 @@ int write_pid_task_all_stats(int prev, int curr, int dis,
 		if (DISPLAY_RT(actflag)) {
 			printf(" prio policy");
 		}
-		printf("  Command\n");
+		printf("  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if (get_pid_to_display(prev, curr, actflag, P_TASK, plist) <= 0)
 			continue;
@@ -1334,7 +1832,12 @@ int write_pid_task_all_stats(int prev, int curr, int dis,
 				   SP_VALUE(pstp->utime + pstp->stime,
 					    pstc->utime + pstc->stime, itv * HZ / 100));
 
-			cprintf_in(IS_INT, "   %3d", "", pstc->processor);
+			if (!GROUP_TASKS(pidflag)) {
+				cprintf_in(IS_INT, "   %3d", "", pstc->processor);
+			}
+			else {
+				cprintf_in(IS_STR, "%s", "     -", 0);
+			}
 		}
 
 		if (DISPLAY_MEM(actflag)) {
@@ -1447,10 +1950,10 @@ int write_pid_child_all_stats(int prev, int curr, int dis,
 			printf("    usr-ms system-ms  guest-ms");
 		if (DISPLAY_MEM(actflag))
 			printf(" minflt-nr majflt-nr");
-		printf("  Command\n");
+		printf("  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if (get_pid_to_display(prev, curr, actflag, P_CHILD, plist) <= 0)
 			continue;
@@ -1522,10 +2025,10 @@ int write_pid_task_cpu_stats(int prev, int curr, int dis, int disp_avg,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf("    %%usr %%system  %%guest   %%wait    %%CPU   CPU  Command\n");
+		printf("    %%usr %%system  %%guest   %%wait    %%CPU   CPU  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if (get_pid_to_display(prev, curr, P_A_CPU, P_TASK, plist) <= 0)
 			continue;
@@ -1550,7 +2053,7 @@ int write_pid_task_cpu_stats(int prev, int curr, int dis, int disp_avg,
 			   SP_VALUE(pstp->utime + pstp->stime,
 				    pstc->utime + pstc->stime, itv * HZ / 100));
 
-		if (!disp_avg) {
+		if (!disp_avg && !GROUP_TASKS(pidflag)) {
 			cprintf_in(IS_INT, "   %3d", "", pstc->processor);
 		}
 		else {
@@ -1593,10 +2096,10 @@ int write_pid_child_cpu_stats(int prev, int curr, int dis, int disp_avg,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf("    usr-ms system-ms  guest-ms  Command\n");
+		printf("    usr-ms system-ms  guest-ms  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if ((rc = get_pid_to_display(prev, curr, P_A_CPU, P_CHILD, plist)) == 0)
 			/* PID no longer exists */
@@ -1683,10 +2186,10 @@ int write_pid_task_memory_stats(int prev, int curr, int dis, int disp_avg,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf("  minflt/s  majflt/s     VSZ     RSS   %%MEM  Command\n");
+		printf("  minflt/s  majflt/s     VSZ     RSS   %%MEM  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if ((rc = get_pid_to_display(prev, curr, P_A_MEM, P_TASK, plist)) == 0)
 			/* PID no longer exists */
@@ -1768,10 +2271,10 @@ int write_pid_child_memory_stats(int prev, int curr, int dis, int disp_avg,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf(" minflt-nr majflt-nr  Command\n");
+		printf(" minflt-nr majflt-nr  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if ((rc = get_pid_to_display(prev, curr, P_A_MEM, P_CHILD, plist)) == 0)
 			/* PID no longer exists */
@@ -1840,10 +2343,10 @@ int write_pid_stack_stats(int prev, int curr, int dis, int disp_avg,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf(" StkSize  StkRef  Command\n");
+		printf(" StkSize  StkRef  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if ((rc = get_pid_to_display(prev, curr, P_A_STACK, P_NULL, plist)) == 0)
 			/* PID no longer exists */
@@ -1916,10 +2419,10 @@ int write_pid_io_stats(int prev, int curr, int dis, int disp_avg,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf("   kB_rd/s   kB_wr/s kB_ccwr/s iodelay  Command\n");
+		printf("   kB_rd/s   kB_wr/s kB_ccwr/s iodelay  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if ((rc = get_pid_to_display(prev, curr, P_A_IO, P_NULL, plist)) == 0)
 			/* PID no longer exists */
@@ -2006,10 +2509,10 @@ int write_pid_ctxswitch_stats(int prev, int curr, int dis,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf("   cswch/s nvcswch/s  Command\n");
+		printf("   cswch/s nvcswch/s  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if (get_pid_to_display(prev, curr, P_A_CTXSW, P_NULL, plist) <= 0)
 			continue;
@@ -2059,10 +2562,10 @@ int write_pid_rt_stats(int prev, int curr, int dis,
 
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
-		printf(" prio policy  Command\n");
+		printf(" prio policy  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if (get_pid_to_display(prev, curr, P_A_RT, P_NULL, plist) <= 0)
 			continue;
@@ -2113,10 +2616,10 @@ int write_pid_ktab_stats(int prev, int curr, int dis, int disp_avg,
 	if (dis) {
 		PRINT_ID_HDR(prev_string, pidflag);
 		printf(" threads   fd-nr");
-		printf("  Command\n");
+		printf("  %s\n", CMD_HDR(pidflag));
 	}
 
-	for (plist = pid_list; plist != NULL; plist = plist->next) {
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
 
 		if ((rc = get_pid_to_display(prev, curr, P_A_KTAB, P_NULL, plist)) == 0)
 			/* PID no longer exists */
@@ -2163,6 +2666,124 @@ int write_pid_ktab_stats(int prev, int curr, int dis, int disp_avg,
 	return again;
 }
 
+/*
+ ***************************************************************************
+ * Get the value of the metric used to rank tasks (option --top).
+ *
+ * IN:
+ * @prev	Index in array where stats used as reference are.
+ * @curr	Index in array for current sample statistics.
+ * @disp_avg	TRUE if average stats are displayed.
+ * @plist	Pointer on the linked list where PID is saved.
+ *
+ * RETURNS:
+ * Value of the metric. Values for different tasks can be compared since
+ * they are computed on the same interval of time.
+ ***************************************************************************
+ */
+unsigned long long get_top_value(int prev, int curr, int disp_avg,
+				 struct st_pid *plist)
+{
+	struct pid_stats *pstc = plist->pstats[curr], *pstp = plist->pstats[prev];
+	unsigned long long vc, vp;
+
+	switch (top_field) {
+
+	case TOP_RSS:
+		if (disp_avg && plist->rc_asum_count)
+			return (plist->total_rss / plist->rc_asum_count);
+		return pstc->rss;
+
+	case TOP_RD:
+		if (NO_PID_IO(plist->flags))
+			return 0;
+		vc = pstc->read_bytes;
+		vp = pstp->read_bytes;
+		break;
+
+	case TOP_CSWCH:
+		vc = pstc->nvcsw;
+		vp = pstp->nvcsw;
+		break;
+
+	default:
+		/* User time already includes guest time */
+		vc = pstc->utime + pstc->stime;
+		vp = pstp->utime + pstp->stime;
+		if (!DISPLAY_TASK_STATS(tskflag)) {
+			vc += pstc->cutime + pstc->cstime;
+			vp += pstp->cutime + pstp->cstime;
+		}
+	}
+
+	return (vc > vp ? vc - vp : 0);
+}
+
+/*
+ ***************************************************************************
+ * Select the top N tasks (option --top) among those that can be displayed
+ * and mark them with flag F_PID_TOP. A min-heap of (at most) N entries is
+ * used so that the whole list of tasks doesn't need to be sorted.
+ *
+ * IN:
+ * @prev	Index in array where stats used as reference are.
+ * @curr	Index in array for current sample statistics.
+ * @disp_avg	TRUE if average stats are displayed.
+ ***************************************************************************
+ */
+void select_top_pid(int prev, int curr, int disp_avg)
+{
+	static struct top_entry *heap = NULL;
+	static unsigned int heap_size = 0;
+	struct top_entry e;
+	struct st_pid *plist;
+	unsigned int n = 0, i, j;
+	int rc;
+
+	for (plist = get_display_list(); plist != NULL; plist = plist->next) {
+
+		/* Don't let a previous selection prevent the task from being displayed */
+		plist->flags |= F_PID_TOP;
+		rc = get_pid_to_display(prev, curr, actflag,
+					DISPLAY_TASK_STATS(tskflag) ? P_TASK : P_CHILD, plist);
+		plist->flags &= ~F_PID_TOP;
+		if (rc <= 0)
+			continue;
+
+		e.value = get_top_value(prev, curr, disp_avg, plist);
+		e.plist = plist;
+
+		if (n < top_nr) {
+			if (n == heap_size) {
+				heap_size = heap_size ? MINIMUM(heap_size * 2, top_nr)
+						      : MINIMUM(64, top_nr);
+				SREALLOC(heap, struct top_entry, sizeof(struct top_entry) * heap_size);
+			}
+			/* Add new entry and move it up */
+			for (i = n++; i && (heap[(i - 1) / 2].value > e.value); i = (i - 1) / 2) {
+				heap[i] = heap[(i - 1) / 2];
+			}
+			heap[i] = e;
+		}
+		else if (e.value > heap[0].value) {
+			/* Replace smallest entry and move new entry down */
+			for (i = 0; (j = 2 * i + 1) < n; i = j) {
+				if ((j + 1 < n) && (heap[j + 1].value < heap[j].value)) {
+					j++;
+				}
+				if (heap[j].value >= e.value)
+					break;
+				heap[i] = heap[j];
+			}
+			heap[i] = e;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		heap[i].plist->flags |= F_PID_TOP;
+	}
+}
+
 /*
  ***************************************************************************
  * Display statistics.
@@ -2198,6 +2819,11 @@ int write_stats_core(int prev, int curr, int dis, int disp_avg,
 
 	itv = get_interval(uptime_cs[prev], uptime_cs[curr]);
 
+	if (DISPLAY_TOP(pidflag)) {
+		/* Select tasks to display */
+		select_top_pid(prev, curr, disp_avg);
+	}
+
 	if (DISPLAY_ONELINE(pidflag)) {
 		if (DISPLAY_TASK_STATS(tskflag)) {
 			again += write_pid_task_all_stats(prev, curr, dis, prev_string, curr_string,
@@ -2338,6 +2964,383 @@ int write_stats(int curr, int dis)
 				 cur_time[!curr], cur_time[curr]));
 }
 
+/*
+ ***************************************************************************
+ * Display an error message and exit.
+ ***************************************************************************
+ */
+void p_write_error(void)
+{
+	fprintf(stderr, _("Cannot write data to pidstat file: %s\n"),
+		strerror(errno));
+	exit(2);
+}
+
+/*
+ ***************************************************************************
+ * Write the header of a pidstat data file.
+ *
+ * IN:
+ * @fp		Pointer on data file.
+ ***************************************************************************
+ */
+void write_pid_file_header(FILE *fp)
+{
+	struct pid_file_header fh;
+	struct utsname header;
+
+	memset(&fh, 0, PID_FILE_HEADER_SIZE);
+	fh.magic = PIDSTAT_MAGIC;
+	fh.tlmkb = tlmkb;
+	fh.hz = HZ;
+	fh.cpu_nr = cpu_nr;
+	fh.actflag = actflag;
+	fh.pidflag = pidflag & P_D_TID;
+	fh.rec_size = PID_RECORD_HEADER_SIZE;
+	fh.task_size = PID_TASK_HEADER_SIZE;
+	fh.pid_stats_size = PID_STATS_SIZE;
+
+	__uname(&header);
+	strncpy(fh.sysname, header.sysname, sizeof(fh.sysname));
+	fh.sysname[sizeof(fh.sysname) - 1] = '\0';
+	strncpy(fh.nodename, header.nodename, sizeof(fh.nodename));
+	fh.nodename[sizeof(fh.nodename) - 1] = '\0';
+	strncpy(fh.release, header.release, sizeof(fh.release));
+	fh.release[sizeof(fh.release) - 1] = '\0';
+	strncpy(fh.machine, header.machine, sizeof(fh.machine));
+	fh.machine[sizeof(fh.machine) - 1] = '\0';
+
+	if (fwrite(&fh, PID_FILE_HEADER_SIZE, 1, fp) != 1) {
+		p_write_error();
+	}
+}
+
+/*
+ ***************************************************************************
+ * Save statistics of current sample for every task to a pidstat data file.
+ *
+ * IN:
+ * @fp		Pointer on data file.
+ * @curr	Index in array for current sample statistics.
+ *
+ * RETURNS:
+ * Number of tasks saved.
+ ***************************************************************************
+ */
+unsigned int write_pid_record(FILE *fp, int curr)
+{
+	struct pid_record_header rh;
+	struct pid_task_header th;
+	struct st_pid *plist;
+
+	memset(&rh, 0, PID_RECORD_HEADER_SIZE);
+	rh.ust_time = (unsigned long long) mktime(&ps_tstamp[curr]);
+	rh.uptime_cs = uptime_cs[curr];
+	rh.tot_jiffies = tot_jiffies[curr];
+
+	for (plist = pid_list; plist != NULL; plist = plist->next) {
+		if (!plist->exist)
+			continue;
+		rh.task_nr++;
+		rh.task_len += PID_TASK_HEADER_SIZE + PID_STATS_SIZE +
+			       strlen(plist->comm) + strlen(plist->cmdline);
+	}
+
+	if (fwrite(&rh, PID_RECORD_HEADER_SIZE, 1, fp) != 1) {
+		p_write_error();
+	}
+
+	for (plist = pid_list; plist != NULL; plist = plist->next) {
+		if (!plist->exist)
+			continue;
+
+		memset(&th, 0, PID_TASK_HEADER_SIZE);
+		th.start_time = plist->start_time;
+		th.pid = plist->pid;
+		th.tgid = plist->tgid ? plist->tgid->pid : 0;
+		th.uid = plist->uid;
+		th.flags = plist->flags & F_PID_FILE_MASK;
+		th.comm_len = strlen(plist->comm);
+		th.cmdline_len = strlen(plist->cmdline);
+
+		if ((fwrite(&th, PID_TASK_HEADER_SIZE, 1, fp) != 1) ||
+		    (fwrite(plist->pstats[curr], PID_STATS_SIZE, 1, fp) != 1) ||
+		    (fwrite(plist->comm, 1, th.comm_len, fp) != th.comm_len) ||
+		    (fwrite(plist->cmdline, 1, th.cmdline_len, fp) != th.cmdline_len)) {
+			p_write_error();
+		}
+	}
+
+	/* Make data available to readers as soon as possible */
+	if (fflush(fp)) {
+		p_write_error();
+	}
+
+	return rh.task_nr;
+}
+
+/*
+ ***************************************************************************
+ * Read the header of a pidstat data file and check that it is consistent
+ * with current options.
+ *
+ * IN:
+ * @fp		Pointer on data file.
+ *
+ * OUT:
+ * @fh		Header of the data file.
+ ***************************************************************************
+ */
+void read_pid_file_header(FILE *fp, struct pid_file_header *fh)
+{
+	if ((fread(fh, PID_FILE_HEADER_SIZE, 1, fp) != 1) ||
+	    (fh->magic != PIDSTAT_MAGIC) ||
+	    (fh->rec_size != PID_RECORD_HEADER_SIZE) ||
+	    (fh->task_size != PID_TASK_HEADER_SIZE) ||
+	    (fh->pid_stats_size != PID_STATS_SIZE) || !fh->hz) {
+		fprintf(stderr, _("Invalid pidstat data file: %s\n"), ifile);
+		if (fh->magic == PIDSTAT_MAGIC_SWAPPED) {
+			fprintf(stderr, _("Endian format mismatch\n"));
+		}
+		exit(3);
+	}
+	fh->sysname[sizeof(fh->sysname) - 1] = '\0';
+	fh->nodename[sizeof(fh->nodename) - 1] = '\0';
+	fh->release[sizeof(fh->release) - 1] = '\0';
+	fh->machine[sizeof(fh->machine) - 1] = '\0';
+
+	if ((actflag & ~fh->actflag) ||
+	    (DISPLAY_TID(pidflag) && !DISPLAY_TID(fh->pidflag))) {
+		fprintf(stderr, _("Requested activities not available in file %s\n"),
+			ifile);
+		exit(1);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Read the next record saved in a pidstat data file, and update the list of
+ * tasks with its contents.
+ *
+ * IN:
+ * @fp		Pointer on data file.
+ * @pid_sel	List of PID entered on the command line with option -p, or
+ * 		NULL if all the tasks saved in file should be considered.
+ * @curr	Index in array for current sample statistics.
+ *
+ * RETURNS:
+ * 0 if a record has been read, 1 if end of file has been reached, and 2
+ * if the record is past the end of the time range entered on the command
+ * line. In the two last cases, current statistics are left unchanged.
+ ***************************************************************************
+ */
+int read_pid_record(FILE *fp, struct st_pid *pid_sel, int curr)
+{
+	struct pid_record_header rh;
+	struct pid_task_header th;
+	struct st_pid *plist, *psel;
+	struct tm rectime;
+	static char *buf = NULL;
+	static unsigned int buf_size = 0;
+	char *ptr, *comm, *cmdline;
+	time_t ust_time;
+	unsigned int i;
+
+	if (fread(&rh, PID_RECORD_HEADER_SIZE, 1, fp) != 1)
+		return 1;
+
+	ust_time = (time_t) rh.ust_time;
+	localtime_r(&ust_time, &rectime);
+	if ((tm_end >= 0) &&
+	    (rectime.tm_hour * 3600 + rectime.tm_min * 60 + rectime.tm_sec > tm_end))
+		return 2;
+
+	/* Read all the tasks at once */
+	if (rh.task_len > buf_size) {
+		if ((buf = (char *) realloc(buf, rh.task_len)) == NULL) {
+			perror("realloc");
+			exit(4);
+		}
+		buf_size = rh.task_len;
+	}
+	if (rh.task_len && (fread(buf, rh.task_len, 1, fp) != 1))
+		/* Record may be incomplete if file is currently being written */
+		return 1;
+
+	ps_tstamp[curr] = rectime;
+	uptime_cs[curr] = rh.uptime_cs;
+	tot_jiffies[curr] = rh.tot_jiffies;
+
+	/* Every PID is potentially nonexistent */
+	set_pid_nonexistent(pid_list);
+
+	for (i = 0, ptr = buf; i < rh.task_nr; i++) {
+
+		if (ptr + PID_TASK_HEADER_SIZE + PID_STATS_SIZE > buf + rh.task_len)
+			goto invalid_file;
+		memcpy(&th, ptr, PID_TASK_HEADER_SIZE);
+		ptr += PID_TASK_HEADER_SIZE;
+		if ((th.comm_len >= MAX_COMM_LEN) || (th.cmdline_len >= MAX_CMDLINE_LEN) ||
+		    (ptr + PID_STATS_SIZE + th.comm_len + th.cmdline_len > buf + rh.task_len))
+			goto invalid_file;
+
+		comm = ptr + PID_STATS_SIZE;
+		cmdline = comm + th.comm_len;
+
+		if (th.tgid && !DISPLAY_TID(pidflag))
+			/* Threads not requested */
+			goto next_task;
+
+		if (!th.tgid && pid_sel) {
+			/* Check that this process has been entered with option -p */
+			for (psel = pid_sel; psel != NULL; psel = psel->next) {
+				if (psel->pid == th.pid)
+					break;
+			}
+			if (!psel)
+				goto next_task;
+		}
+
+		plist = add_list_pid(&pid_list, th.pid, th.tgid);
+		if (!plist)
+			goto next_task;
+		plist->exist = TRUE;
+
+		memcpy(plist->pstats[curr], ptr, PID_STATS_SIZE);
+
+		if ((plist->start_time != th.start_time) ||
+		    strncmp(plist->comm, comm, th.comm_len) || plist->comm[th.comm_len] ||
+		    strncmp(plist->cmdline, cmdline, th.cmdline_len) ||
+		    plist->cmdline[th.cmdline_len]) {
+			/* New task or identity has changed */
+			plist->start_time = th.start_time;
+			memcpy(plist->comm, comm, th.comm_len);
+			plist->comm[th.comm_len] = '\0';
+			memcpy(plist->cmdline, cmdline, th.cmdline_len);
+			plist->cmdline[th.cmdline_len] = '\0';
+			plist->flags &= ~F_ID_CACHE;
+			plist->flags |= F_CMDLINE_READ;
+		}
+		if (plist->uid != th.uid) {
+			plist->uid = th.uid;
+			plist->flags &= ~F_USER_CHECKED;
+		}
+		plist->flags = (plist->flags & ~F_PID_FILE_MASK) | (th.flags & F_PID_FILE_MASK);
+
+next_task:
+		ptr += PID_STATS_SIZE + th.comm_len + th.cmdline_len;
+	}
+
+	/* Free unused PID structures */
+	sfree_pid(&pid_list, FALSE);
+
+	if (GROUP_TASKS(pidflag)) {
+		aggregate_pid_stats(curr);
+	}
+
+	return 0;
+
+invalid_file:
+	fprintf(stderr, _("Invalid pidstat data file: %s\n"), ifile);
+	exit(3);
+}
+
+/*
+ ***************************************************************************
+ * Main loop: Read PID stats from a data file and display them.
+ *
+ * IN:
+ * @dis_hdr	Set to TRUE if the header line must always be printed.
+ * @rows	Number of rows of screen.
+ ***************************************************************************
+ */
+void rw_pidstat_file_loop(int dis_hdr, int rows)
+{
+	int curr = 1, dis = 1;
+	int again, rc, rec_nr = 0;
+	unsigned long lines = rows;
+	FILE *ifp;
+	struct pid_file_header fh;
+	struct st_pid *plist, *pid_sel = NULL;
+
+	if ((ifp = fopen(ifile, "r")) == NULL) {
+		fprintf(stderr, _("Cannot open %s: %s\n"), ifile, strerror(errno));
+		exit(2);
+	}
+	read_pid_file_header(ifp, &fh);
+
+	/* Use values from the machine where the file was created */
+	hz = fh.hz;
+	cpu_nr = fh.cpu_nr;
+	tlmkb = fh.tlmkb;
+
+	if (!DISPLAY_ALL_PID(pidflag)) {
+		/* PID entered with option -p are used to select tasks in file */
+		pid_sel = pid_list;
+		pid_list = NULL;
+	}
+
+	/* Look for the first record within time range. It will be used as reference */
+	do {
+		if (read_pid_record(ifp, pid_sel, 0))
+			/* No data to display */
+			goto close_file;
+	}
+	while ((tm_start >= 0) &&
+	       (ps_tstamp[0].tm_hour * 3600 + ps_tstamp[0].tm_min * 60 + ps_tstamp[0].tm_sec < tm_start));
+
+	print_gal_header(&(ps_tstamp[0]), fh.sysname, fh.release,
+			 fh.nodename, fh.machine, cpu_nr,
+			 PLAIN_OUTPUT);
+
+	/* Save the first stats read. Will be used to compute the average */
+	ps_tstamp[2] = ps_tstamp[0];
+	tot_jiffies[2] = tot_jiffies[0];
+	uptime_cs[2] = uptime_cs[0];
+	for (plist = pid_list; plist != NULL; plist = plist->next) {
+		memcpy(plist->pstats[2], plist->pstats[0], PID_STATS_SIZE);
+	}
+	for (plist = grp_list; plist != NULL; plist = plist->next) {
+		memcpy(plist->pstats[2], plist->pstats[0], PID_STATS_SIZE);
+	}
+
+	while (!(rc = read_pid_record(ifp, pid_sel, curr))) {
+
+		if (!dis_hdr) {
+			dis = lines / rows;
+			if (dis) {
+				lines %= rows;
+			}
+			lines++;
+		}
+
+		/* Print results */
+		again = write_stats(curr, dis);
+		rec_nr++;
+
+		if (!again)
+			goto close_file;
+
+		curr ^= 1;
+	}
+
+	if (!rec_nr) {
+		if (rc == 1) {
+			/* File contains only one sample: Display since boot time */
+			ps_tstamp[1] = ps_tstamp[0];
+			write_stats(0, DISP_HDR);
+		}
+	}
+	else if (!DISPLAY_ONELINE(pidflag)) {
+		/* Write stats average */
+		write_stats_avg(curr ^ 1, dis_hdr);
+	}
+
+close_file:
+	fclose(ifp);
+	sfree_pid(&pid_sel, TRUE);
+}
+
 /*
  ***************************************************************************
  * Main loop: Read and display PID stats.
@@ -2363,10 +3366,18 @@ void rw_pidstat_loop(int dis_hdr, int rows)
 		read_proc_meminfo();
 	}
 
+	if (SAVE_TO_FILE(pidflag)) {
+		/* Save file header and first sample */
+		write_pid_file_header(ofp);
+		write_pid_record(ofp, 0);
+	}
+
 	if (!interval) {
-		/* Display since boot time */
-		ps_tstamp[1] = ps_tstamp[0];
-		write_stats(0, DISP_HDR);
+		if (!SAVE_TO_FILE(pidflag)) {
+			/* Display since boot time */
+			ps_tstamp[1] = ps_tstamp[0];
+			write_stats(0, DISP_HDR);
+		}
 		exit(0);
 	}
 
@@ -2383,6 +3394,9 @@ void rw_pidstat_loop(int dis_hdr, int rows)
 	for (plist = pid_list; plist != NULL; plist = plist->next) {
 		memcpy(plist->pstats[2], plist->pstats[0], PID_STATS_SIZE);
 	}
+	for (plist = grp_list; plist != NULL; plist = plist->next) {
+		memcpy(plist->pstats[2], plist->pstats[0], PID_STATS_SIZE);
+	}
 
 	/* Set a handler for SIGINT */
 	memset(&int_act, 0, sizeof(int_act));
@@ -2409,16 +3423,22 @@ void rw_pidstat_loop(int dis_hdr, int rows)
 		/* Read stats */
 		read_stats(curr);
 
-		if (!dis_hdr) {
-			dis = lines / rows;
-			if (dis) {
-				lines %= rows;
-			}
-			lines++;
+		if (SAVE_TO_FILE(pidflag)) {
+			/* Save stats to file instead of displaying them */
+			again = write_pid_record(ofp, curr) || DISPLAY_ALL_PID(pidflag);
 		}
+		else {
+			if (!dis_hdr) {
+				dis = lines / rows;
+				if (dis) {
+					lines %= rows;
+				}
+				lines++;
+			}
 
-		/* Print results */
-		again = write_stats(curr, dis);
+			/* Print results */
+			again = write_stats(curr, dis);
+		}
 
 		if (!again)
 			return;
@@ -2447,13 +3467,35 @@ void rw_pidstat_loop(int dis_hdr, int rows)
 	 * The one line format uses a raw time value rather than time strings
 	 * so the average doesn't really fit.
 	 */
-	if (!DISPLAY_ONELINE(pidflag))
+	if (!DISPLAY_ONELINE(pidflag) && !SAVE_TO_FILE(pidflag))
 	{
 		/* Write stats average */
 		write_stats_avg(curr, dis_hdr);
 	}
 }
 
+/*
+ ***************************************************************************
+ * Parse a time entered on the command line with options --start and --end.
+ *
+ * IN:
+ * @str		Time string, with the format hh:mm[:ss].
+ *
+ * RETURNS:
+ * Number of seconds since midnight, or -1 if the time is invalid.
+ ***************************************************************************
+ */
+int parse_pid_time(char *str)
+{
+	int hh, mm, ss = 0;
+
+	if ((sscanf(str, "%d:%d:%d", &hh, &mm, &ss) < 2) ||
+	    (hh < 0) || (hh > 23) || (mm < 0) || (mm > 59) || (ss < 0) || (ss > 59))
+		return -1;
+
+	return (hh * 3600 + mm * 60 + ss);
+}
+
 /*
  ***************************************************************************
  * Start a program that will be monitored by pidstat.
@@ -2601,11 +3643,93 @@ int main(int argc, char **argv)
 			}
 		}
 
+		else if (!strncmp(argv[opt], "--group-by=", 11)) {
+			if (GROUP_TASKS(pidflag)) {
+				usage(argv[0]);
+			}
+			t = argv[opt++] + 11;
+			if (!strcmp(t, K_G_COMM)) {
+				pidflag |= P_D_GRP_COMM;
+			}
+			else if (!strcmp(t, K_G_USER)) {
+				pidflag |= P_D_GRP_USER;
+			}
+			else if (!strcmp(t, K_G_CGROUP)) {
+				pidflag |= P_D_GRP_CGROUP;
+			}
+			else {
+				usage(argv[0]);
+			}
+		}
+
+		else if (!strcmp(argv[opt], "--top")) {
+			if (!argv[++opt] || DISPLAY_TOP(pidflag)) {
+				usage(argv[0]);
+			}
+			if ((t = strchr(argv[opt], ':')) != NULL) {
+				*(t++) = '\0';
+				if (!strcmp(t, K_TOP_CPU)) {
+					top_field = TOP_CPU;
+				}
+				else if (!strcmp(t, K_TOP_RSS)) {
+					top_field = TOP_RSS;
+				}
+				else if (!strcmp(t, K_TOP_RD)) {
+					top_field = TOP_RD;
+				}
+				else if (!strcmp(t, K_TOP_CSWCH)) {
+					top_field = TOP_CSWCH;
+				}
+				else {
+					usage(argv[0]);
+				}
+			}
+			if (!argv[opt][0] || (strspn(argv[opt], DIGITS) != strlen(argv[opt]))) {
+				usage(argv[0]);
+			}
+			top_nr = atoi(argv[opt++]);
+			if (top_nr < 1) {
+				usage(argv[0]);
+			}
+			pidflag |= P_D_TOP;
+		}
+
 		else if (!strcmp(argv[opt], "--human")) {
 			pidflag |= P_D_UNIT;
 			opt++;
 		}
 
+		else if (!strcmp(argv[opt], "-o") || !strcmp(argv[opt], "-f")) {
+			if (!argv[opt + 1] || ofile[0] || ifile[0]) {
+				usage(argv[0]);
+			}
+			if (argv[opt][1] == 'o') {
+				/* Save stats to file */
+				strncpy(ofile, argv[++opt], sizeof(ofile) - 1);
+				pidflag |= P_F_OFILE;
+			}
+			else {
+				/* Read stats from file */
+				strncpy(ifile, argv[++opt], sizeof(ifile) - 1);
+				pidflag |= P_F_IFILE;
+			}
+			opt++;
+		}
+
+		else if (!strncmp(argv[opt], "--start=", 8)) {
+			if ((tm_start = parse_pid_time(argv[opt] + 8)) < 0) {
+				usage(argv[0]);
+			}
+			opt++;
+		}
+
+		else if (!strncmp(argv[opt], "--end=", 6)) {
+			if ((tm_end = parse_pid_time(argv[opt] + 6)) < 0) {
+				usage(argv[0]);
+			}
+			opt++;
+		}
+
 		else if (!strncmp(argv[opt], "--dec=", 6) && (strlen(argv[opt]) == 7)) {
 			/* Get number of decimal places */
 			dplaces_nr = atoi(argv[opt] + 6);
@@ -2772,6 +3896,31 @@ int main(int argc, char **argv)
 		/* Interval not set => display stats since boot time */
 		interval = 0;
 	}
+	else if (READ_FROM_FILE(pidflag)) {
+		/* Samples are those saved in file */
+		usage(argv[0]);
+	}
+
+	if (((tm_start >= 0) || (tm_end >= 0)) && !READ_FROM_FILE(pidflag)) {
+		/* Time range can only be used with data files */
+		usage(argv[0]);
+	}
+
+	if (GROUP_TASKS(pidflag) &&
+	    (DISPLAY_TID(pidflag) || SAVE_TO_FILE(pidflag) || DISPLAY_RT(actflag) ||
+	     (GROUP_BY_CGROUP(pidflag) && READ_FROM_FILE(pidflag)))) {
+		/*
+		 * Groups are made of processes only, and they are not saved in
+		 * data files. Control groups are not saved in data files either.
+		 * Priority and policy cannot be summed up for a group of tasks.
+		 */
+		usage(argv[0]);
+	}
+
+	if (DISPLAY_TOP(pidflag) && (top_field == TOP_RD) && !DISPLAY_IO(actflag)) {
+		/* I/O statistics are needed to rank tasks by kB_rd/s */
+		usage(argv[0]);
+	}
 
 	if (!DISPLAY_PID(pidflag)) {
 		dis_hdr = 1;
@@ -2780,8 +3929,13 @@ int main(int argc, char **argv)
 	/* Check flags and set default values */
 	check_flags();
 
-	/* Count nb of proc */
-	cpu_nr = get_cpu_nr(~0, FALSE);
+	/* Prepare regex structures used to select tasks with options -C and -G */
+	if (COMMAND_STRING(pidflag)) {
+		commregex_ok = !regcomp(&commregex, commstr, REG_EXTENDED | REG_NOSUB);
+	}
+	if (PROCESS_STRING(pidflag)) {
+		procregex_ok = !regcomp(&procregex, procstr, REG_EXTENDED | REG_NOSUB);
+	}
 
 	if (dis_hdr < 0) {
 		dis_hdr = 0;
@@ -2795,9 +3949,6 @@ int main(int argc, char **argv)
 		}
 	}
 
-	/* Get time */
-	get_localtime(&(ps_tstamp[0]), 0);
-
 	/*
 	 * Don't buffer data if redirected to a pipe.
 	 * Note: With musl-c, the behavior of this function is undefined except
@@ -2805,17 +3956,48 @@ int main(int argc, char **argv)
 	 */
 	setbuf(stdout, NULL);
 
-	/* Get system name, release number and hostname */
-	__uname(&header);
-	print_gal_header(&(ps_tstamp[0]), header.sysname, header.release,
-			 header.nodename, header.machine, cpu_nr,
-			 PLAIN_OUTPUT);
+	if (READ_FROM_FILE(pidflag)) {
+		/* Display stats saved in file */
+		rw_pidstat_file_loop(dis_hdr, rows);
+	}
+	else {
+		/* Count nb of proc */
+		cpu_nr = get_cpu_nr(~0, FALSE);
+
+		/* Get time */
+		get_localtime(&(ps_tstamp[0]), 0);
 
-	/* Main loop */
-	rw_pidstat_loop(dis_hdr, rows);
+		if (SAVE_TO_FILE(pidflag)) {
+			if ((ofp = fopen(ofile, "w")) == NULL) {
+				fprintf(stderr, _("Cannot open %s: %s\n"), ofile, strerror(errno));
+				exit(2);
+			}
+		}
+		else {
+			/* Get system name, release number and hostname */
+			__uname(&header);
+			print_gal_header(&(ps_tstamp[0]), header.sysname, header.release,
+					 header.nodename, header.machine, cpu_nr,
+					 PLAIN_OUTPUT);
+		}
+
+		/* Main loop */
+		rw_pidstat_loop(dis_hdr, rows);
+
+		if (ofp) {
+			fclose(ofp);
+		}
+	}
 
 	/* Free structures */
 	sfree_pid(&pid_list, TRUE);
+	sfree_pid(&grp_list, TRUE);
+	if (commregex_ok) {
+		regfree(&commregex);
+	}
+	if (procregex_ok) {
+		regfree(&procregex);
+	}
 
 	return 0;
 }
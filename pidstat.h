@@ -70,6 +70,12 @@
 #define P_F_PROCSTR	0x0400
 #define P_D_UNIT	0x0800
 #define P_D_SEC_EPOCH	0x1000
+#define P_F_OFILE	0x2000
+#define P_F_IFILE	0x4000
+#define P_D_GRP_COMM	0x8000
+#define P_D_GRP_USER	0x10000
+#define P_D_GRP_CGROUP	0x20000
+#define P_D_TOP		0x40000
 
 #define DISPLAY_PID(m)		(((m) & P_D_PID) == P_D_PID)
 #define DISPLAY_ALL_PID(m)	(((m) & P_D_ALL_PID) == P_D_ALL_PID)
@@ -84,15 +90,70 @@
 #define PROCESS_STRING(m)	(((m) & P_F_PROCSTR) == P_F_PROCSTR)
 #define DISPLAY_UNIT(m)		(((m) & P_D_UNIT) == P_D_UNIT)
 #define PRINT_SEC_EPOCH(m)	(((m) & P_D_SEC_EPOCH) == P_D_SEC_EPOCH)
+#define SAVE_TO_FILE(m)		(((m) & P_F_OFILE) == P_F_OFILE)
+#define READ_FROM_FILE(m)	(((m) & P_F_IFILE) == P_F_IFILE)
+#define GROUP_BY_COMM(m)	(((m) & P_D_GRP_COMM) == P_D_GRP_COMM)
+#define GROUP_BY_USER(m)	(((m) & P_D_GRP_USER) == P_D_GRP_USER)
+#define GROUP_BY_CGROUP(m)	(((m) & P_D_GRP_CGROUP) == P_D_GRP_CGROUP)
+#define GROUP_TASKS(m)		(((m) & (P_D_GRP_COMM | P_D_GRP_USER | P_D_GRP_CGROUP)) != 0)
+#define DISPLAY_TOP(m)		(((m) & P_D_TOP) == P_D_TOP)
+
+/* Keywords for option --group-by */
+#define K_G_COMM	"comm"
+#define K_G_USER	"user"
+#define K_G_CGROUP	"cgroup"
+
+/* Metrics used to rank tasks (option --top) */
+#define TOP_CPU		0
+#define TOP_RSS		1
+#define TOP_RD		2
+#define TOP_CSWCH	3
+
+#define K_TOP_CPU	"%CPU"
+#define K_TOP_RSS	"RSS"
+#define K_TOP_RD	"kB_rd/s"
+#define K_TOP_CSWCH	"cswch/s"
+
+/* Name of the last column (command name or key of group of tasks) */
+#define CMD_HDR(m)	(GROUP_BY_CGROUP(m) ? "Cgroup" : \
+			(GROUP_BY_USER(m)   ? "User" : "Command"))
 
 /* Per-process flags */
 #define F_NO_PID_IO	0x01
 #define F_NO_PID_FD	0x02
 #define F_PID_DISPLAYED	0x04
+#define F_CMDLINE_READ	0x08
+#define F_USER_CHECKED	0x10
+#define F_COMM_CHECKED	0x20
+#define F_COMM_MATCHED	0x40
+#define F_PROC_CHECKED	0x80
+#define F_PROC_MATCHED	0x100
+#define F_CGROUP_READ	0x200
+#define F_PID_TOP	0x400
 
 #define NO_PID_IO(m)		(((m) & F_NO_PID_IO) == F_NO_PID_IO)
 #define NO_PID_FD(m)		(((m) & F_NO_PID_FD) == F_NO_PID_FD)
 #define IS_PID_DISPLAYED(m)	(((m) & F_PID_DISPLAYED) == F_PID_DISPLAYED)
+#define IS_CMDLINE_READ(m)	(((m) & F_CMDLINE_READ) == F_CMDLINE_READ)
+#define IS_USER_CHECKED(m)	(((m) & F_USER_CHECKED) == F_USER_CHECKED)
+#define IS_COMM_CHECKED(m)	(((m) & F_COMM_CHECKED) == F_COMM_CHECKED)
+#define IS_COMM_MATCHED(m)	(((m) & F_COMM_MATCHED) == F_COMM_MATCHED)
+#define IS_PROC_CHECKED(m)	(((m) & F_PROC_CHECKED) == F_PROC_CHECKED)
+#define IS_PROC_MATCHED(m)	(((m) & F_PROC_MATCHED) == F_PROC_MATCHED)
+#define IS_CGROUP_READ(m)	(((m) & F_CGROUP_READ) == F_CGROUP_READ)
+#define IS_PID_TOP(m)		(((m) & F_PID_TOP) == F_PID_TOP)
+
+/*
+ * Flags describing cached identity of a task (command line, username, cgroup
+ * and results of -C/-G matching). They are cleared when the task is found to
+ * have changed (PID reused, new command name or new UID).
+ */
+#define F_ID_CACHE	(F_CMDLINE_READ | F_USER_CHECKED | F_COMM_CHECKED | \
+			 F_COMM_MATCHED | F_PROC_CHECKED | F_PROC_MATCHED | \
+			 F_CGROUP_READ)
+
+/* Size of the hash table used to find groups of tasks (option --group-by) */
+#define GRP_HASH_SIZE	1024
 
 
 #define PROC		PRE "/proc"
@@ -104,6 +165,7 @@
 #define PID_SMAP	PRE "/proc/%u/smaps"
 #define PID_FD		PRE "/proc/%u/fd"
 #define PID_SCHED	PRE "/proc/%u/schedstat"
+#define PID_CGROUP	PRE "/proc/%u/cgroup"
 
 #define PROC_TASK	PRE "/proc/%u/task"
 #define TASK_STAT	PRE "/proc/%u/task/%u/stat"
@@ -122,7 +184,10 @@
 							else {					\
 								printf("   UID");		\
 							}					\
-   							if (DISPLAY_TID(_flag_)) {		\
+							if (GROUP_TASKS(_flag_)) {		\
+								printf("   task-nr");		\
+							}					\
+   							else if (DISPLAY_TID(_flag_)) {		\
 								printf("      TGID       TID");	\
 							}					\
 							else {					\
@@ -191,6 +256,12 @@ struct pid_stats {
 
 #define PID_STATS_SIZE	(sizeof(struct pid_stats))
 
+/*
+ * Number of samples after which the task directory of a multi-threaded
+ * process is scanned again even if its number of threads hasn't changed.
+ */
+#define TASK_RESCAN_NR	10
+
 struct st_pid {
 	unsigned long long total_vsz;
 	unsigned long long total_rss;
@@ -198,6 +269,7 @@ struct st_pid {
 	unsigned long long total_stack_ref;
 	unsigned long long total_threads;
 	unsigned long long total_fd_nr;
+	unsigned long long start_time;	/* Task start time (in clock ticks after system boot) */
 	pid_t		   pid;
 	uid_t		   uid;
 	int		   exist;	/* TRUE if PID exists */
@@ -208,11 +280,96 @@ struct st_pid {
 	unsigned int	   tf_asum_count;
 	unsigned int	   sk_asum_count;
 	unsigned int	   delay_asum_count;
+	unsigned int	   task_scan_nr;	/* Nb of samples since task directory was last scanned */
+	unsigned int	   task_nr;	/* Number of tasks in group (option --group-by) */
 	struct pid_stats  *pstats[3];
 	struct st_pid	  *tgid;	/* If current task is a TID, pointer to its TGID. NULL otherwise. */
 	struct st_pid	  *next;
+	struct st_pid	  *hnext;	/* Next group with the same hash value */
+	char		  *cgroup;	/* Control group of the task. NULL if not read */
+	char		  *key;		/* Key of the group (option --group-by). NULL for a task */
 	char		   comm[MAX_COMM_LEN];
 	char		   cmdline[MAX_CMDLINE_LEN];
+	char		   username[MAX_USER_LEN];	/* Empty if UID has no name */
 };
 
+/* Entry of the heap used to select the top N tasks (option --top) */
+struct top_entry {
+	unsigned long long value;
+	struct st_pid	  *plist;
+};
+
+/*
+ * Magic number for pidstat data files.
+ * Should be modified whenever the format of a pidstat data file
+ * (header, record or pid_stats structures) changes.
+ */
+#define PIDSTAT_MAGIC		0xd5a1
+#define PIDSTAT_MAGIC_SWAPPED	(((PIDSTAT_MAGIC << 8) | (PIDSTAT_MAGIC >> 8)) & 0xffff)
+
+/* Flags saved in data file for each task */
+#define F_PID_FILE_MASK	(F_NO_PID_IO | F_NO_PID_FD)
+
+/*
+ * Header of a pidstat data file (created with option -o).
+ * It is followed by a list of records, one per sample.
+ */
+struct pid_file_header {
+	/* Total memory in kB */
+	unsigned long long tlmkb		__attribute__ ((aligned (8)));
+	/* Value of HZ on the machine where the file was created */
+	unsigned int	   hz			__attribute__ ((packed));
+	/* Number of CPU on the machine where the file was created */
+	unsigned int	   cpu_nr		__attribute__ ((packed));
+	/* Activities saved in file */
+	unsigned int	   actflag		__attribute__ ((packed));
+	/* P_D_TID if threads statistics have been saved */
+	unsigned int	   pidflag		__attribute__ ((packed));
+	/* Size of the structures saved in file */
+	unsigned int	   rec_size		__attribute__ ((packed));
+	unsigned int	   task_size		__attribute__ ((packed));
+	unsigned int	   pid_stats_size	__attribute__ ((packed));
+	unsigned short	   magic		__attribute__ ((packed));
+	char		   sysname[UTSNAME_LEN];
+	char		   nodename[UTSNAME_LEN];
+	char		   release[UTSNAME_LEN];
+	char		   machine[UTSNAME_LEN];
+};
+
+#define PID_FILE_HEADER_SIZE	(sizeof(struct pid_file_header))
+
+/*
+ * Header of a record (i.e. a sample) saved in a pidstat data file.
+ * It is followed by @task_nr tasks, each one made of a pid_task_header
+ * structure, a pid_stats structure, and the command name and command line
+ * (not null-terminated).
+ */
+struct pid_record_header {
+	/* Time of the sample (number of seconds since the epoch) */
+	unsigned long long ust_time		__attribute__ ((aligned (8)));
+	/* System uptime in 1/100th of a second */
+	unsigned long long uptime_cs		__attribute__ ((packed));
+	/* Number of jiffies spent by all processors */
+	unsigned long long tot_jiffies		__attribute__ ((packed));
+	/* Number of tasks saved in record */
+	unsigned int	   task_nr		__attribute__ ((packed));
+	/* Size in bytes of the tasks data following the header */
+	unsigned int	   task_len		__attribute__ ((packed));
+};
+
+#define PID_RECORD_HEADER_SIZE	(sizeof(struct pid_record_header))
+
+struct pid_task_header {
+	unsigned long long start_time		__attribute__ ((aligned (8)));
+	unsigned int	   pid			__attribute__ ((packed));
+	/* TGID number if this task is a thread, 0 otherwise */
+	unsigned int	   tgid			__attribute__ ((packed));
+	unsigned int	   uid			__attribute__ ((packed));
+	unsigned int	   flags		__attribute__ ((packed));
+	unsigned int	   comm_len		__attribute__ ((packed));
+	unsigned int	   cmdline_len		__attribute__ ((packed));
+};
+
+#define PID_TASK_HEADER_SIZE	(sizeof(struct pid_task_header))
+
 #endif  /* _PIDSTAT_H */
@@ -40,6 +40,7 @@ extern uint64_t flags;
 extern int  dish;
 extern char timestamp[][TIMESTAMP_LEN];
 extern unsigned long avg_count;
+extern char *cpu_grp_name[];
 
 /*
  ***************************************************************************
@@ -104,6 +105,59 @@ void print_hdr_line(char *p_timestamp, struct activity *a, int pos, int iwidth,
 	printf("\n");
 }
 
+/*
+ ***************************************************************************
+ * Display CPU utilization values for a CPU or a group of CPU.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @scc		Current CPU statistics.
+ * @scp		CPU statistics used as reference.
+ * @deltot_jiffies
+ *		Number of jiffies spent on the interval by the CPU.
+ ***************************************************************************
+ */
+static void print_cpu_values(struct activity *a, struct stats_cpu *scc, struct stats_cpu *scp,
+			     unsigned long long deltot_jiffies)
+{
+	if (DISPLAY_CPU_DEF(a->opt_flags)) {
+		cprintf_pc(DISPLAY_UNIT(flags), 6, 9, 2,
+			   ll_sp_value(scp->cpu_user, scc->cpu_user, deltot_jiffies),
+			   ll_sp_value(scp->cpu_nice, scc->cpu_nice, deltot_jiffies),
+			   ll_sp_value(scp->cpu_sys + scp->cpu_hardirq + scp->cpu_softirq,
+				       scc->cpu_sys + scc->cpu_hardirq + scc->cpu_softirq,
+				       deltot_jiffies),
+			   ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
+			   ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
+			   scc->cpu_idle < scp->cpu_idle ?
+			   0.0 :
+			   ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
+		printf("\n");
+	}
+	else if (DISPLAY_CPU_ALL(a->opt_flags)) {
+		cprintf_pc(DISPLAY_UNIT(flags), 10, 9, 2,
+			   (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
+			   0.0 :
+			   ll_sp_value(scp->cpu_user - scp->cpu_guest,
+				       scc->cpu_user - scc->cpu_guest, deltot_jiffies),
+				       (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
+			   0.0 :
+			   ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
+				       scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies),
+			   ll_sp_value(scp->cpu_sys, scc->cpu_sys, deltot_jiffies),
+			   ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
+			   ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
+			   ll_sp_value(scp->cpu_hardirq, scc->cpu_hardirq, deltot_jiffies),
+			   ll_sp_value(scp->cpu_softirq, scc->cpu_softirq, deltot_jiffies),
+			   ll_sp_value(scp->cpu_guest, scc->cpu_guest, deltot_jiffies),
+			   ll_sp_value(scp->cpu_guest_nice, scc->cpu_guest_nice, deltot_jiffies),
+			   scc->cpu_idle < scp->cpu_idle ?
+			   0.0 :
+			   ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
+		printf("\n");
+	}
+}
+
 /*
  ***************************************************************************
  * Display CPU statistics.
@@ -111,6 +165,8 @@ void print_hdr_line(char *p_timestamp, struct activity *a, int pos, int iwidth,
  * the CPU was online. As a consequence, the sum (%user + %nice + ... + %idle)
  * will always be 100% on the time interval even if the CPU has been offline
  * most of the time.
+ * Statistics for each node and/or socket are displayed after individual CPU
+ * ones if option --topology has been used and CPU topology is known.
  *
  * IN:
  * @a		Activity structure with statistics.
@@ -123,10 +179,11 @@ void print_hdr_line(char *p_timestamp, struct activity *a, int pos, int iwidth,
 __print_funct_t print_cpu_stats(struct activity *a, int prev, int curr,
 				unsigned long long itv)
 {
-	int i;
+	int i, g, grp_nr;
 	unsigned long long deltot_jiffies = 1;
-	struct stats_cpu *scc, *scp;
+	struct stats_cpu *scc, *scp, *sgc, *sgp;
 	unsigned char offline_cpu_bitmap[BITMAP_SIZE(NR_CPUS)] = {0};
+	char grp_name[16];
 
 	if (dish) {
 		print_hdr_line(timestamp[!curr], a, FIRST + DISPLAY_CPU_ALL(a->opt_flags), 7, 9);
@@ -226,41 +283,29 @@ __print_funct_t print_cpu_stats(struct activity *a, int prev, int curr,
 			}
 		}
 
-		if (DISPLAY_CPU_DEF(a->opt_flags)) {
-			cprintf_pc(DISPLAY_UNIT(flags), 6, 9, 2,
-				   ll_sp_value(scp->cpu_user, scc->cpu_user, deltot_jiffies),
-				   ll_sp_value(scp->cpu_nice, scc->cpu_nice, deltot_jiffies),
-				   ll_sp_value(scp->cpu_sys + scp->cpu_hardirq + scp->cpu_softirq,
-					       scc->cpu_sys + scc->cpu_hardirq + scc->cpu_softirq,
-					       deltot_jiffies),
-				   ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
-				   ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
-				   scc->cpu_idle < scp->cpu_idle ?
-				   0.0 :
-				   ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
-			printf("\n");
-		}
-		else if (DISPLAY_CPU_ALL(a->opt_flags)) {
-			cprintf_pc(DISPLAY_UNIT(flags), 10, 9, 2,
-				   (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
-				   0.0 :
-				   ll_sp_value(scp->cpu_user - scp->cpu_guest,
-					       scc->cpu_user - scc->cpu_guest, deltot_jiffies),
-					       (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
-				   0.0 :
-				   ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
-					       scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies),
-				   ll_sp_value(scp->cpu_sys, scc->cpu_sys, deltot_jiffies),
-				   ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
-				   ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
-				   ll_sp_value(scp->cpu_hardirq, scc->cpu_hardirq, deltot_jiffies),
-				   ll_sp_value(scp->cpu_softirq, scc->cpu_softirq, deltot_jiffies),
-				   ll_sp_value(scp->cpu_guest, scc->cpu_guest, deltot_jiffies),
-				   ll_sp_value(scp->cpu_guest_nice, scc->cpu_guest_nice, deltot_jiffies),
-				   scc->cpu_idle < scp->cpu_idle ?
-				   0.0 :
-				   ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies));
-			printf("\n");
+		print_cpu_values(a, scc, scp, deltot_jiffies);
+	}
+
+	/* Now display statistics for each node and/or socket */
+	for (g = 0; g < CPU_GRP_NR; g++) {
+
+		if (!DISPLAY_CPU_GRP(a->opt_flags, g))
+			continue;
+
+		grp_nr = get_cpu_grp_statistics(a, prev, curr, flags, g,
+						offline_cpu_bitmap, &sgp, &sgc);
+
+		for (i = 1; i <= grp_nr; i++) {
+
+			/* Groups with no CPU (or no activity) are not displayed */
+			if (!(deltot_jiffies = get_per_cpu_interval(sgc + i, sgp + i)))
+				continue;
+
+			printf("%-11s", timestamp[curr]);
+			snprintf(grp_name, sizeof(grp_name), "%s%d", cpu_grp_name[g], i - 1);
+			cprintf_in(IS_STR, " %7s", grp_name, 0);
+
+			print_cpu_values(a, sgc + i, sgp + i, deltot_jiffies);
 		}
 	}
 }
@@ -21,6 +21,10 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
 
 #include "common.h"
 #include "rd_stats.h"
@@ -36,65 +40,500 @@
 
 #if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
 #include "sensors/sensors.h"
+
+/* A value (input, min or max) of a sensor */
+struct sn_value {
+	const sensors_chip_name *chip;
+	int number;	/* libsensors subfeature number, -1 if no such subfeature */
+	int fd;		/* hwmon file, -1 if value is read through libsensors */
+	double scale;	/* Value read from hwmon file is divided by this */
+};
+
+/* A sensor (fan, temperature or voltage input) */
+struct sn_feature {
+	char device[MAX_SENSORS_DEV_LEN];
+	struct sn_value val[SN_VAL_NR];
+};
+
+/*
+ * Chips and subfeatures enumerated with libsensors, shared by fan,
+ * temperature and voltage inputs activities. Enumeration is done again
+ * only when the set of hwmon devices changes.
+ */
+struct sn_cache {
+	struct sn_feature *feat[SN_TYPE_NR];
+	int nr[SN_TYPE_NR];		/* Number of sensors of each type */
+	int nr_alloc[SN_TYPE_NR];	/* Number of structures allocated */
+	unsigned int gen;		/* hwmon devices generation */
+	int gen_read;			/* TRUE if generation has been read for current sample */
+	int valid;
+	/*
+	 * Names of the features which have a compute or ignore statement
+	 * in libsensors configuration files. Their hwmon files are not used.
+	 */
+	char **rule_feat;
+	int rule_nr;
+};
+
+struct sn_cache sn_cache;
 #endif
 
+#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
 /*
  ***************************************************************************
- * Read fan statistics.
+ * Compute a generation number for the set of hwmon devices. It is a hash
+ * of the names of the entries in /sys/class/hwmon directory.
+ *
+ * RETURNS:
+ * Generation number.
+ ***************************************************************************
+ */
+unsigned int get_hwmon_generation(void)
+{
+	DIR *dir;
+	struct dirent *drd;
+	unsigned int h = 5381;
+	char *c;
+
+	if ((dir = opendir(SYSFS_HWMON)) == NULL)
+		return 0;
+
+	while ((drd = readdir(dir)) != NULL) {
+		/* Entries order may vary: Combine names hashes with xor */
+		unsigned int hn = 5381;
+
+		for (c = drd->d_name; *c; c++) {
+			hn = ((hn << 5) + hn) + (unsigned char) *c;
+		}
+		h ^= hn;
+	}
+	closedir(dir);
+
+	return h;
+}
+
+/*
+ ***************************************************************************
+ * Check if a feature has a compute or ignore statement in libsensors
+ * configuration files.
  *
  * IN:
- * @st_pwr_fan	Structure where stats will be saved.
- * @nr_alloc	Total number of structures allocated. Value is >= 1.
+ * @name	Name of the feature (e.g. "temp1").
+ *
+ * RETURNS:
+ * TRUE if the feature has such a statement.
+ ***************************************************************************
+ */
+int sn_feature_has_rule(const char *name)
+{
+	int i;
+
+	for (i = 0; i < sn_cache.rule_nr; i++) {
+		if (!strcmp(sn_cache.rule_feat[i], name))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*
+ ***************************************************************************
+ * Read a libsensors configuration file and save the name of the features
+ * which have a compute or ignore statement. Chip statements are not taken
+ * into account: A feature name is saved whatever the chip it applies to.
+ *
+ * IN:
+ * @filename	Name of the configuration file.
+ ***************************************************************************
+ */
+void read_sn_conf_file(char *filename)
+{
+	FILE *fp;
+	char line[1024], *stmt, *name, *c;
+
+	if ((fp = fopen(filename, "r")) == NULL)
+		return;
+
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if ((c = strchr(line, '#')) != NULL) {
+			/* Remove comment */
+			*c = '\0';
+		}
+
+		if (((stmt = strtok(line, " \t\n")) == NULL) ||
+		    (strcmp(stmt, "compute") && strcmp(stmt, "ignore")) ||
+		    ((name = strtok(NULL, " \t\n\",")) == NULL))
+			continue;
+
+		if (sn_feature_has_rule(name))
+			/* Feature already saved */
+			continue;
+
+		SREALLOC(sn_cache.rule_feat, char *, sizeof(char *) * (sn_cache.rule_nr + 1));
+		if ((sn_cache.rule_feat[sn_cache.rule_nr] = strdup(name)) == NULL) {
+			perror("strdup");
+			exit(4);
+		}
+		sn_cache.rule_nr++;
+	}
+
+	fclose(fp);
+}
+
+/*
+ ***************************************************************************
+ * Free the list of features which have a compute or ignore statement.
+ ***************************************************************************
+ */
+void free_sn_rules(void)
+{
+	int i;
+
+	for (i = 0; i < sn_cache.rule_nr; i++) {
+		free(sn_cache.rule_feat[i]);
+	}
+	free(sn_cache.rule_feat);
+	sn_cache.rule_feat = NULL;
+	sn_cache.rule_nr = 0;
+}
+
+/*
+ ***************************************************************************
+ * Read the configuration files that libsensors reads, to know which
+ * features have a compute or ignore statement.
+ ***************************************************************************
+ */
+void read_sn_conf(void)
+{
+	DIR *dir;
+	struct dirent *drd;
+	char filename[MAX_PF_NAME];
+
+	free_sn_rules();
+
+	/* The old configuration file is read only if the new one doesn't exist */
+	if (access(SN_CONF_FILE, F_OK) == 0) {
+		read_sn_conf_file(SN_CONF_FILE);
+	}
+	else {
+		read_sn_conf_file(SN_CONF_FILE_OLD);
+	}
+
+	if ((dir = opendir(SN_CONF_DIR)) == NULL)
+		return;
+
+	while ((drd = readdir(dir)) != NULL) {
+		if (drd->d_name[0] == '.')
+			continue;
+
+		snprintf(filename, sizeof(filename), "%s/%s", SN_CONF_DIR, drd->d_name);
+		filename[sizeof(filename) - 1] = '\0';
+		read_sn_conf_file(filename);
+	}
+	closedir(dir);
+}
+
+/*
+ ***************************************************************************
+ * Free the sensors enumeration cache and close hwmon files.
+ ***************************************************************************
+ */
+void free_sn_cache(void)
+{
+	int t, i, k;
+
+	for (t = 0; t < SN_TYPE_NR; t++) {
+		for (i = 0; i < sn_cache.nr[t]; i++) {
+			for (k = 0; k < SN_VAL_NR; k++) {
+				if (sn_cache.feat[t][i].val[k].fd >= 0) {
+					close(sn_cache.feat[t][i].val[k].fd);
+				}
+			}
+		}
+		free(sn_cache.feat[t]);
+		sn_cache.feat[t] = NULL;
+		sn_cache.nr[t] = sn_cache.nr_alloc[t] = 0;
+	}
+	sn_cache.valid = FALSE;
+}
+
+/*
+ ***************************************************************************
+ * Read a value from a hwmon file kept open.
+ *
+ * IN:
+ * @fd		hwmon file descriptor.
+ * @scale	Scale factor to apply to the value read.
  *
  * OUT:
- * @st_pwr_fan Structure with statistics.
+ * @val		Value read.
  *
  * RETURNS:
- * Number of fans read, or -1 if the buffer was too small and needs to be
- * reallocated.
+ * 0 on success, -1 otherwise.
  ***************************************************************************
  */
-__nr_t read_fan(struct stats_pwr_fan *st_pwr_fan, __nr_t nr_alloc)
+int read_hwmon_value(int fd, double scale, double *val)
+{
+	char buf[32], *e;
+	ssize_t n;
+	double v;
+
+	if ((n = pread(fd, buf, sizeof(buf) - 1, 0)) <= 0)
+		return -1;
+	buf[n] = '\0';
+
+	v = strtod(buf, &e);
+	if (e == buf)
+		return -1;
+
+	*val = v / scale;
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Save a subfeature in the cache and open its hwmon file. The hwmon file
+ * is used only if the feature has no compute or ignore statement in
+ * libsensors configuration files, and if the value read from it is the
+ * same as the one returned by libsensors.
+ *
+ * IN:
+ * @chip	Chip the subfeature belongs to.
+ * @sub		Subfeature.
+ * @scale	Scale factor for values read from hwmon file.
+ * @use_hwmon	FALSE if the value should always be read through
+ *		libsensors.
+ *
+ * OUT:
+ * @sv		Cached value.
+ ***************************************************************************
+ */
+void cache_sn_value(const sensors_chip_name *chip, const sensors_subfeature *sub,
+		    double scale, int use_hwmon, struct sn_value *sv)
+{
+	char filename[MAX_PF_NAME];
+	double lsv, hwv;
+
+	sv->chip = chip;
+	sv->number = sub->number;
+	sv->scale = scale;
+	sv->fd = -1;
+
+	if (!use_hwmon || (chip->path == NULL) ||
+	    sensors_get_value(chip, sub->number, &lsv))
+		return;
+
+	snprintf(filename, sizeof(filename), "%s/%s", chip->path, sub->name);
+	filename[sizeof(filename) - 1] = '\0';
+	if ((sv->fd = open(filename, O_RDONLY)) < 0)
+		return;
+
+	if (read_hwmon_value(sv->fd, scale, &hwv) || (hwv != lsv)) {
+		/* Use libsensors to read this value */
+		close(sv->fd);
+		sv->fd = -1;
+	}
+}
+
+/*
+ ***************************************************************************
+ * Enumerate chips and subfeatures again if the set of hwmon devices has
+ * changed since last enumeration. libsensors is initialized again in this
+ * case so that it can find new chips.
+ ***************************************************************************
+ */
+void update_sn_cache(void)
 {
-#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
-	__nr_t fan_read = 0;
 	const sensors_chip_name *chip;
 	const sensors_feature *feature;
 	const sensors_subfeature *sub;
-	struct stats_pwr_fan *st_pwr_fan_i;
+	struct sn_feature *sf;
+	unsigned int gen;
 	int chip_nr = 0;
-	int i, j;
+	int i, j, k, t, use_hwmon;
+	double scale;
 
-	memset(st_pwr_fan, 0, STATS_PWR_FAN_SIZE);
+	if (sn_cache.valid && sn_cache.gen_read)
+		/* hwmon devices generation already checked for current sample */
+		return;
+
+	gen = get_hwmon_generation();
+	sn_cache.gen_read = TRUE;
+
+	if (sn_cache.valid) {
+		if (gen == sn_cache.gen)
+			return;
+
+		/* hwmon devices have changed */
+		free_sn_cache();
+		sensors_cleanup();
+		sensors_init(NULL);
+	}
+
+	/* libsensors configuration is read again by sensors_init() */
+	read_sn_conf();
 
 	while ((chip = sensors_get_detected_chips(NULL, &chip_nr))) {
 		i = 0;
 		while ((feature = sensors_get_features(chip, &i))) {
 			if (feature->type == SENSORS_FEATURE_FAN) {
-				j = 0;
-				if (fan_read + 1 > nr_alloc)
-					return -1;
-				st_pwr_fan_i = st_pwr_fan + fan_read++;
-				sensors_snprintf_chip_name(st_pwr_fan_i->device, MAX_SENSORS_DEV_LEN, chip);
-
-				while ((sub = sensors_get_all_subfeatures(chip, feature, &j))) {
-					if ((sub->type == SENSORS_SUBFEATURE_FAN_INPUT) &&
-					    (sub->flags & SENSORS_MODE_R)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_fan_i->rpm)) {
-							st_pwr_fan_i->rpm = 0;
-						}
-					}
-					else if ((sub->type == SENSORS_SUBFEATURE_FAN_MIN)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_fan_i->rpm_min)) {
-							st_pwr_fan_i->rpm_min = 0;
-						}
+				t = SN_FAN;
+				scale = 1.0;
+			}
+			else if (feature->type == SENSORS_FEATURE_TEMP) {
+				t = SN_TEMP;
+				scale = SN_HWMON_SCALE;
+			}
+			else if (feature->type == SENSORS_FEATURE_IN) {
+				t = SN_IN;
+				scale = SN_HWMON_SCALE;
+			}
+			else
+				continue;
+
+			if (sn_cache.nr[t] >= sn_cache.nr_alloc[t]) {
+				sn_cache.nr_alloc[t] = sn_cache.nr_alloc[t] ? sn_cache.nr_alloc[t] * 2 : 8;
+				SREALLOC(sn_cache.feat[t], struct sn_feature,
+					 sizeof(struct sn_feature) * sn_cache.nr_alloc[t]);
+			}
+			sf = sn_cache.feat[t] + sn_cache.nr[t]++;
+			sensors_snprintf_chip_name(sf->device, MAX_SENSORS_DEV_LEN, chip);
+			for (k = 0; k < SN_VAL_NR; k++) {
+				sf->val[k].number = -1;
+				sf->val[k].fd = -1;
+			}
+			use_hwmon = !sn_feature_has_rule(feature->name);
+
+			j = 0;
+			while ((sub = sensors_get_all_subfeatures(chip, feature, &j))) {
+				switch (sub->type) {
+
+				case SENSORS_SUBFEATURE_FAN_INPUT:
+				case SENSORS_SUBFEATURE_TEMP_INPUT:
+				case SENSORS_SUBFEATURE_IN_INPUT:
+					if (sub->flags & SENSORS_MODE_R) {
+						cache_sn_value(chip, sub, scale, use_hwmon,
+							       &sf->val[SN_INPUT]);
 					}
+					break;
+
+				case SENSORS_SUBFEATURE_FAN_MIN:
+				case SENSORS_SUBFEATURE_TEMP_MIN:
+				case SENSORS_SUBFEATURE_IN_MIN:
+					cache_sn_value(chip, sub, scale, use_hwmon,
+						       &sf->val[SN_MIN]);
+					break;
+
+				case SENSORS_SUBFEATURE_TEMP_MAX:
+				case SENSORS_SUBFEATURE_IN_MAX:
+					cache_sn_value(chip, sub, scale, use_hwmon,
+						       &sf->val[SN_MAX]);
+					break;
+
+				default:
+					break;
 				}
 			}
 		}
 	}
 
-	return fan_read;
+	sn_cache.gen = gen;
+	sn_cache.valid = TRUE;
+}
+
+/*
+ ***************************************************************************
+ * Get a sensor value, either from its hwmon file or through libsensors.
+ *
+ * IN:
+ * @sv		Cached value.
+ *
+ * RETURNS:
+ * Value read, or 0 if it couldn't be read.
+ ***************************************************************************
+ */
+double get_sn_value(struct sn_value *sv)
+{
+	double val;
+
+	if (sv->number < 0)
+		return 0;
+
+	if ((sv->fd >= 0) && !read_hwmon_value(sv->fd, sv->scale, &val))
+		return val;
+
+	if (sensors_get_value(sv->chip, sv->number, &val))
+		return 0;
+
+	return val;
+}
+#endif /* HAVE_SENSORS */
+
+/*
+ ***************************************************************************
+ * Indicate that a new sample is being read: The set of hwmon devices will
+ * be checked again the next time sensors are read.
+ ***************************************************************************
+ */
+void sensors_new_sample(void)
+{
+#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
+	sn_cache.gen_read = FALSE;
+#endif /* HAVE_SENSORS */
+}
+
+/*
+ ***************************************************************************
+ * Free the sensors enumeration cache.
+ ***************************************************************************
+ */
+void free_sensors_cache(void)
+{
+#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
+	free_sn_cache();
+	free_sn_rules();
+#endif /* HAVE_SENSORS */
+}
+
+/*
+ ***************************************************************************
+ * Read fan statistics.
+ *
+ * IN:
+ * @st_pwr_fan	Structure where stats will be saved.
+ * @nr_alloc	Total number of structures allocated. Value is >= 1.
+ *
+ * OUT:
+ * @st_pwr_fan Structure with statistics.
+ *
+ * RETURNS:
+ * Number of fans read, or -1 if the buffer was too small and needs to be
+ * reallocated.
+ ***************************************************************************
+ */
+__nr_t read_fan(struct stats_pwr_fan *st_pwr_fan, __nr_t nr_alloc)
+{
+#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
+	struct stats_pwr_fan *st_pwr_fan_i;
+	struct sn_feature *sf;
+	int i;
+
+	memset(st_pwr_fan, 0, STATS_PWR_FAN_SIZE);
+
+	update_sn_cache();
+	if (sn_cache.nr[SN_FAN] > nr_alloc)
+		return -1;
+
+	for (i = 0; i < sn_cache.nr[SN_FAN]; i++) {
+		sf = sn_cache.feat[SN_FAN] + i;
+		st_pwr_fan_i = st_pwr_fan + i;
+
+		memcpy(st_pwr_fan_i->device, sf->device, MAX_SENSORS_DEV_LEN);
+		st_pwr_fan_i->rpm = get_sn_value(&sf->val[SN_INPUT]);
+		st_pwr_fan_i->rpm_min = get_sn_value(&sf->val[SN_MIN]);
+	}
+
+	return sn_cache.nr[SN_FAN];
 #else
 	return 0;
 #endif /* HAVE_SENSORS */
@@ -119,49 +558,27 @@ __nr_t read_fan(struct stats_pwr_fan *st_pwr_fan, __nr_t nr_alloc)
 __nr_t read_temp(struct stats_pwr_temp *st_pwr_temp, __nr_t nr_alloc)
 {
 #if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
-	__nr_t temp_read = 0;
-	const sensors_chip_name *chip;
-	const sensors_feature *feature;
-	const sensors_subfeature *sub;
 	struct stats_pwr_temp *st_pwr_temp_i;
-	int chip_nr = 0;
-	int i, j;
+	struct sn_feature *sf;
+	int i;
 
 	memset(st_pwr_temp, 0, STATS_PWR_TEMP_SIZE);
 
-	while ((chip = sensors_get_detected_chips(NULL, &chip_nr))) {
-		i = 0;
-		while ((feature = sensors_get_features(chip, &i))) {
-			if (feature->type == SENSORS_FEATURE_TEMP) {
-				j = 0;
-				if (temp_read + 1 > nr_alloc)
-					return -1;
-				st_pwr_temp_i = st_pwr_temp + temp_read++;
-				sensors_snprintf_chip_name(st_pwr_temp_i->device, MAX_SENSORS_DEV_LEN, chip);
-
-				while ((sub = sensors_get_all_subfeatures(chip, feature, &j))) {
-					if ((sub->type == SENSORS_SUBFEATURE_TEMP_INPUT) &&
-						(sub->flags & SENSORS_MODE_R)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_temp_i->temp)) {
-							st_pwr_temp_i->temp = 0;
-						}
-					}
-					else if ((sub->type == SENSORS_SUBFEATURE_TEMP_MIN)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_temp_i->temp_min)) {
-							st_pwr_temp_i->temp_min = 0;
-						}
-					}
-					else if ((sub->type == SENSORS_SUBFEATURE_TEMP_MAX)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_temp_i->temp_max)) {
-							st_pwr_temp_i->temp_max = 0;
-						}
-					}
-				}
-			}
-		}
+	update_sn_cache();
+	if (sn_cache.nr[SN_TEMP] > nr_alloc)
+		return -1;
+
+	for (i = 0; i < sn_cache.nr[SN_TEMP]; i++) {
+		sf = sn_cache.feat[SN_TEMP] + i;
+		st_pwr_temp_i = st_pwr_temp + i;
+
+		memcpy(st_pwr_temp_i->device, sf->device, MAX_SENSORS_DEV_LEN);
+		st_pwr_temp_i->temp = get_sn_value(&sf->val[SN_INPUT]);
+		st_pwr_temp_i->temp_min = get_sn_value(&sf->val[SN_MIN]);
+		st_pwr_temp_i->temp_max = get_sn_value(&sf->val[SN_MAX]);
 	}
 
-	return temp_read;
+	return sn_cache.nr[SN_TEMP];
 #else
 	return 0;
 #endif /* HAVE_SENSORS */
@@ -186,86 +603,32 @@ __nr_t read_temp(struct stats_pwr_temp *st_pwr_temp, __nr_t nr_alloc)
 __nr_t read_in(struct stats_pwr_in *st_pwr_in, __nr_t nr_alloc)
 {
 #if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
-	__nr_t in_read = 0;
-	const sensors_chip_name *chip;
-	const sensors_feature *feature;
-	const sensors_subfeature *sub;
 	struct stats_pwr_in *st_pwr_in_i;
-	int chip_nr = 0;
-	int i, j;
+	struct sn_feature *sf;
+	int i;
 
 	memset(st_pwr_in, 0, STATS_PWR_IN_SIZE);
 
-	while ((chip = sensors_get_detected_chips(NULL, &chip_nr))) {
-		i = 0;
-		while ((feature = sensors_get_features(chip, &i))) {
-			if (feature->type == SENSORS_FEATURE_IN) {
-				j = 0;
-				if (in_read + 1 > nr_alloc)
-					return -1;
-				st_pwr_in_i = st_pwr_in + in_read++;
-				sensors_snprintf_chip_name(st_pwr_in_i->device, MAX_SENSORS_DEV_LEN, chip);
-
-				while ((sub = sensors_get_all_subfeatures(chip, feature, &j))) {
-					if ((sub->type == SENSORS_SUBFEATURE_IN_INPUT) &&
-						(sub->flags & SENSORS_MODE_R)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_in_i->in)) {
-							st_pwr_in_i->in = 0;
-						}
-					}
-					else if ((sub->type == SENSORS_SUBFEATURE_IN_MIN)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_in_i->in_min)) {
-							st_pwr_in_i->in_min = 0;
-						}
-					}
-					else if ((sub->type == SENSORS_SUBFEATURE_IN_MAX)) {
-						if (sensors_get_value(chip, sub->number, &st_pwr_in_i->in_max)) {
-							st_pwr_in_i->in_max = 0;
-						}
-					}
-				}
-			}
-		}
+	update_sn_cache();
+	if (sn_cache.nr[SN_IN] > nr_alloc)
+		return -1;
+
+	for (i = 0; i < sn_cache.nr[SN_IN]; i++) {
+		sf = sn_cache.feat[SN_IN] + i;
+		st_pwr_in_i = st_pwr_in + i;
+
+		memcpy(st_pwr_in_i->device, sf->device, MAX_SENSORS_DEV_LEN);
+		st_pwr_in_i->in = get_sn_value(&sf->val[SN_INPUT]);
+		st_pwr_in_i->in_min = get_sn_value(&sf->val[SN_MIN]);
+		st_pwr_in_i->in_max = get_sn_value(&sf->val[SN_MAX]);
 	}
 
-	return in_read;
+	return sn_cache.nr[SN_IN];
 #else
 	return 0;
 #endif /* HAVE_SENSORS */
 }
 
-#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
-/*
- ***************************************************************************
- * Count the number of sensors of given type on the machine.
- *
- * IN:
- * @type	Type of sensors.
- *
- * RETURNS:
- * Number of sensors.
- ***************************************************************************
- */
-__nr_t get_sensors_nr(sensors_feature_type type) {
-	__nr_t count = 0;
-	const sensors_chip_name *chip;
-	const sensors_feature *feature;
-	int chip_nr = 0;
-	int i;
-
-	while ((chip = sensors_get_detected_chips(NULL, &chip_nr))) {
-		i = 0;
-		while ((feature = sensors_get_features(chip, &i))) {
-			if (feature->type == type) {
-				count++;
-			}
-		}
-	}
-
-	return count;
-}
-#endif /* HAVE_SENSORS */
-
 /*
  ***************************************************************************
  * Count the number of fans on the machine.
@@ -277,7 +640,8 @@ __nr_t get_sensors_nr(sensors_feature_type type) {
 __nr_t get_fan_nr(void)
 {
 #if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
-	return get_sensors_nr(SENSORS_FEATURE_FAN);
+	update_sn_cache();
+	return sn_cache.nr[SN_FAN];
 #else
 	return 0;
 #endif /* HAVE_SENSORS */
@@ -294,7 +658,8 @@ __nr_t get_fan_nr(void)
 __nr_t get_temp_nr(void)
 {
 #if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
-	return get_sensors_nr(SENSORS_FEATURE_TEMP);
+	update_sn_cache();
+	return sn_cache.nr[SN_TEMP];
 #else
 	return 0;
 #endif /* HAVE_SENSORS */
@@ -311,7 +676,8 @@ __nr_t get_temp_nr(void)
 __nr_t get_in_nr(void)
 {
 #if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
-	return get_sensors_nr(SENSORS_FEATURE_IN);
+	update_sn_cache();
+	return sn_cache.nr[SN_IN];
 #else
 	return 0;
 #endif /* HAVE_SENSORS */
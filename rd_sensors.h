@@ -56,6 +56,32 @@ struct stats_pwr_in {
 #define STATS_PWR_IN_UL		0
 #define STATS_PWR_IN_U		0
 
+/*
+ ***************************************************************************
+ * Sensors enumeration cache
+ ***************************************************************************
+ */
+
+/* Types of sensors saved in the cache */
+#define SN_FAN		0
+#define SN_TEMP		1
+#define SN_IN		2
+#define SN_TYPE_NR	3
+
+/* Values saved for each sensor */
+#define SN_INPUT	0
+#define SN_MIN		1
+#define SN_MAX		2
+#define SN_VAL_NR	3
+
+/* hwmon files contain millidegrees Celsius and millivolts */
+#define SN_HWMON_SCALE	1000.0
+
+/* Configuration files read by libsensors when none is given to sensors_init() */
+#define SN_CONF_FILE		"/etc/sensors3.conf"
+#define SN_CONF_FILE_OLD	"/etc/sensors.conf"
+#define SN_CONF_DIR		"/etc/sensors.d"
+
 /*
  ***************************************************************************
  * Prototypes for functions used to read sensors statistics
@@ -68,6 +94,10 @@ __nr_t read_temp
 	(struct stats_pwr_temp *, __nr_t);
 __nr_t read_in
 	(struct stats_pwr_in *, __nr_t);
+void free_sensors_cache
+	(void);
+void sensors_new_sample
+	(void);
 
 /*
  ***************************************************************************
@@ -25,6 +25,8 @@
 #include <errno.h>
 #include <dirent.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
@@ -476,9 +478,248 @@ unsigned long long get_per_cpu_interval(struct stats_cpu *scc,
 		 ishift);
 }
 
+/*
+ ***************************************************************************
+ * Add CPU statistics to those of another CPU (or group of CPU).
+ *
+ * IN:
+ * @src		Structure containing CPU stats to add.
+ *
+ * OUT:
+ * @dest	Structure containing global CPU stats.
+ ***************************************************************************
+ */
+void add_cpu_stats(struct stats_cpu *dest, struct stats_cpu *src)
+{
+	dest->cpu_user       += src->cpu_user;
+	dest->cpu_nice       += src->cpu_nice;
+	dest->cpu_sys        += src->cpu_sys;
+	dest->cpu_idle       += src->cpu_idle;
+	dest->cpu_iowait     += src->cpu_iowait;
+	dest->cpu_hardirq    += src->cpu_hardirq;
+	dest->cpu_softirq    += src->cpu_softirq;
+	dest->cpu_steal      += src->cpu_steal;
+	dest->cpu_guest      += src->cpu_guest;
+	dest->cpu_guest_nice += src->cpu_guest_nice;
+}
+
+/*
+ ***************************************************************************
+ * Compute node statistics: Split CPU statistics among nodes.
+ * Nodes may actually be any group of CPU (e.g. physical packages).
+ *
+ * IN:
+ * @prev_buf	Buffer containing CPU stats used as reference: CPU "all"
+ *		first, then each individual CPU.
+ * @curr_buf	Buffer containing current CPU stats.
+ * @msize	Size of a CPU structure in buffers. May be greater than
+ *		STATS_CPU_SIZE if stats have been read from a file.
+ * @nr_cpus	Number of individual CPU in buffers.
+ * @cpu2node	The node each CPU belongs to (-1 if none).
+ * @nr_nodes	Number of nodes (highest node number + 1).
+ * @skip_new	TRUE if CPU with no previous stats (e.g. which have just
+ *		come back online) should be skipped.
+ * @offline_cpu_bitmap
+ *		CPU bitmap for offline CPU. Offline CPU are not added to
+ *		their node.
+ *
+ * OUT:
+ * @snp_all	Array (with @nr_nodes + 1 items) where reference CPU stats
+ *		for each node have been saved. First item is node "all".
+ * @snc_all	Array where current CPU stats for each node have been saved.
+ ***************************************************************************
+ */
+void set_node_cpu_stats(void *prev_buf, void *curr_buf, size_t msize, int nr_cpus,
+			int cpu2node[], int nr_nodes, struct stats_cpu *snp_all,
+			struct stats_cpu *snc_all, int skip_new,
+			unsigned char offline_cpu_bitmap[])
+{
+	int cpu;
+	unsigned long long tot_jiffies_p;
+	struct stats_cpu *scp, *scc, *snp, *snc;
+
+	/* Reset structures */
+	memset(snp_all, 0, STATS_CPU_SIZE * (nr_nodes + 1));
+	memset(snc_all, 0, STATS_CPU_SIZE * (nr_nodes + 1));
+
+	/* Node 'all' is the same as CPU 'all' */
+	*snp_all = *((struct stats_cpu *) prev_buf);
+	*snc_all = *((struct stats_cpu *) curr_buf);
+
+	/* Individual nodes */
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+
+		if ((cpu2node[cpu] < 0) || (cpu2node[cpu] >= nr_nodes))
+			/* CPU belongs to no known node */
+			continue;
+
+		if (offline_cpu_bitmap[(cpu + 1) >> 3] & (1 << ((cpu + 1) & 0x07)))
+			/* Offline CPU: Don't add it to its node */
+			continue;
+
+		scc = (struct stats_cpu *) ((char *) curr_buf + (cpu + 1) * msize);
+		scp = (struct stats_cpu *) ((char *) prev_buf + (cpu + 1) * msize);
+		snp = snp_all + cpu2node[cpu] + 1;
+		snc = snc_all + cpu2node[cpu] + 1;
+
+		tot_jiffies_p = scp->cpu_user + scp->cpu_nice +
+				scp->cpu_sys + scp->cpu_idle +
+				scp->cpu_iowait + scp->cpu_hardirq +
+				scp->cpu_steal + scp->cpu_softirq;
+		if ((tot_jiffies_p == 0) && skip_new)
+			/*
+			 * CPU has just come back online with no ref from
+			 * previous iteration: Skip it.
+			 */
+			continue;
+
+		add_cpu_stats(snp, scp);
+		add_cpu_stats(snc, scc);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Get node placement (which node each CPU belongs to, and total number of
+ * CPU that each node has).
+ *
+ * IN:
+ * @nr_cpus		Number of CPU on this machine.
+ *
+ * OUT:
+ * @cpu_per_node	Number of CPU per node.
+ * @cpu2node		The node the CPU belongs to.
+ *
+ * RETURNS:
+ * Highest node number found (e.g., 0 means node 0).
+ * A value of -1 means no nodes have been found.
+ ***************************************************************************
+ */
+int get_node_placement(int nr_cpus, int cpu_per_node[], int cpu2node[])
+
+{
+	DIR *dir;
+	struct dirent *drd;
+	char line[MAX_PF_NAME];
+	int cpu, node, hi_node_nr = -1;
+
+	/* Init number of CPU per node */
+	memset(cpu_per_node, 0, sizeof(int) * (nr_cpus + 1));
+	/* CPU belongs to no node by default */
+	memset(cpu2node, -1, sizeof(int) * nr_cpus);
+
+	/* This is node "all" */
+	cpu_per_node[0] = nr_cpus;
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		snprintf(line, sizeof(line), "%s/cpu%d", SYSFS_DEVCPU, cpu);
+		line[sizeof(line) - 1] = '\0';
+
+		/* Open relevant /sys directory */
+		if ((dir = opendir(line)) == NULL)
+			return -1;
+
+		/* Get current file entry */
+		while ((drd = readdir(dir)) != NULL) {
+
+			if (!strncmp(drd->d_name, "node", 4) && isdigit(drd->d_name[4])) {
+				node = atoi(drd->d_name + 4);
+				if ((node >= nr_cpus) || (node < 0)) {
+					/* Assume we cannot have more nodes than CPU */
+					closedir(dir);
+					return -1;
+				}
+				cpu_per_node[node + 1]++;
+				cpu2node[cpu] = node;
+				if (node > hi_node_nr) {
+					hi_node_nr = node;
+				}
+				/* Node placement found for current CPU: Go to next CPU directory */
+				break;
+			}
+		}
+
+		/* Close directory */
+		closedir(dir);
+	}
+
+	return hi_node_nr;
+}
+
+/*
+ ***************************************************************************
+ * Read system logical topology: Socket number for each logical core is read
+ * from the /sys/devices/system/cpu/cpu{N}/topology/physical_package_id file,
+ * and the logical core id number is the first number read from the
+ * /sys/devices/system/cpu/cpu{N}/topology/thread_siblings_list file.
+ * Don't use /sys/devices/system/cpu/cpu{N}/topology/core_id as this is the
+ * physical core id (seems to be different from the number displayed by lscpu).
+ *
+ * IN:
+ * @nr_cpus	Number of CPU on this machine.
+ * @cpu_topo	Structures where socket and core id numbers will be saved.
+ *
+ * OUT:
+ * @cpu_topo	Structures where socket and core id numbers have been saved.
+ ***************************************************************************
+ */
+void read_topology(int nr_cpus, struct cpu_topology *cpu_topo)
+{
+	struct cpu_topology *cpu_topo_i;
+	FILE *fp;
+	char filename[MAX_PF_NAME];
+	int cpu, rc;
+
+	/* Init system topology */
+	memset(cpu_topo, 0, sizeof(struct cpu_topology) * nr_cpus);
+
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+
+		cpu_topo_i = cpu_topo + cpu;
+
+		/* Read current CPU's socket number */
+		snprintf(filename, sizeof(filename), "%s/cpu%d/%s", SYSFS_DEVCPU, cpu, PHYS_PACK_ID);
+		filename[sizeof(filename) - 1] = '\0';
+
+		if ((fp = fopen(filename, "r")) != NULL) {
+			rc = fscanf(fp, "%d", &cpu_topo_i->phys_package_id);
+			fclose(fp);
+
+			if (rc < 1) {
+				cpu_topo_i->phys_package_id = -1;
+			}
+		}
+
+		/* Read current CPU's logical core id number */
+		snprintf(filename, sizeof(filename), "%s/cpu%d/%s", SYSFS_DEVCPU, cpu, THREAD_SBL_LST);
+		filename[sizeof(filename) - 1] = '\0';
+
+		if ((fp = fopen(filename, "r")) != NULL) {
+			rc = fscanf(fp, "%d", &cpu_topo_i->logical_core_id);
+			fclose(fp);
+
+			if (rc < 1) {
+				cpu_topo_i->logical_core_id = -1;
+			}
+		}
+	}
+}
+
 #ifdef SOURCE_SADC
 /*---------------- BEGIN: FUNCTIONS USED BY SADC ONLY ---------------------*/
 
+/* USB devices metadata cache (see read_bus_usb_dev()) */
+struct usb_dev_cache *usb_cache = NULL;
+int usb_cache_nr = 0;
+int usb_cache_alloc = 0;
+
+/* FC hosts cache (see read_fchost()) */
+struct fchost_cache *fch_cache = NULL;
+int fch_cache_nr = 0;
+char *fch_stat_files[FC_STAT_NR] = {FC_RX_FRAMES, FC_TX_FRAMES, FC_RX_WORDS, FC_TX_WORDS};
+struct dir_gen fch_dir_gen;
+int fch_rescan = TRUE;
+
 /*
  ***************************************************************************
  * Replace octal codes in string with their corresponding characters.
@@ -2449,6 +2690,91 @@ void read_usb_stats(struct stats_pwr_usb *st_pwr_usb, char *usb_device)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Get USB device data, using the USB devices metadata cache. A device is
+ * read again only if its entry in /sys/bus/usb/devices has been created
+ * again (i.e. its inode number has changed), e.g. when another device
+ * has been plugged into the same port.
+ *
+ * IN:
+ * @st_pwr_usb		Structure where stats will be saved.
+ * @usb_device		File name for current USB device.
+ * @ino			Inode number of the file.
+ *
+ * OUT:
+ * @st_pwr_usb		Structure with statistics.
+ ***************************************************************************
+ */
+void get_usb_dev_stats(struct stats_pwr_usb *st_pwr_usb, char *usb_device,
+		       unsigned long long ino)
+{
+	struct usb_dev_cache *uc = NULL;
+	int i;
+
+	if (strnlen(usb_device, MAX_NAME_LEN) == MAX_NAME_LEN) {
+		/* Name too long: Don't cache device */
+		read_usb_stats(st_pwr_usb, usb_device);
+		return;
+	}
+
+	for (i = 0; i < usb_cache_nr; i++) {
+		if (!strcmp(usb_cache[i].name, usb_device)) {
+			uc = usb_cache + i;
+			break;
+		}
+	}
+
+#ifndef TEST
+	/* Inode numbers are not available with tests/root "_list" files */
+	if ((uc != NULL) && (uc->ino == ino)) {
+		/* Device already known */
+		*st_pwr_usb = uc->st_usb;
+		uc->seen = TRUE;
+		return;
+	}
+#endif
+
+	if (uc == NULL) {
+		/* New device: Add it to the cache */
+		if (usb_cache_nr >= usb_cache_alloc) {
+			usb_cache_alloc = usb_cache_alloc ? usb_cache_alloc * 2 : 8;
+			SREALLOC(usb_cache, struct usb_dev_cache,
+				 sizeof(struct usb_dev_cache) * usb_cache_alloc);
+		}
+		uc = usb_cache + usb_cache_nr++;
+		strcpy(uc->name, usb_device);
+	}
+
+	memset(&uc->st_usb, 0, STATS_PWR_USB_SIZE);
+	read_usb_stats(&uc->st_usb, usb_device);
+	uc->ino = ino;
+	uc->seen = TRUE;
+	*st_pwr_usb = uc->st_usb;
+}
+
+/*
+ ***************************************************************************
+ * Remove from the USB devices metadata cache the devices that have not
+ * been found at current sample (they have been unplugged).
+ ***************************************************************************
+ */
+void purge_usb_cache(void)
+{
+	int i, j = 0;
+
+	for (i = 0; i < usb_cache_nr; i++) {
+		if (usb_cache[i].seen) {
+			usb_cache[i].seen = FALSE;
+			if (i != j) {
+				usb_cache[j] = usb_cache[i];
+			}
+			j++;
+		}
+	}
+	usb_cache_nr = j;
+}
+
 /*
  ***************************************************************************
  * Read USB devices statistics.
@@ -2486,14 +2812,21 @@ __nr_t read_bus_usb_dev(struct stats_pwr_usb *st_pwr_usb, __nr_t nr_alloc)
 				break;
 			}
 
-			/* Read current USB device data */
+			/* Get current USB device data */
 			st_pwr_usb_i = st_pwr_usb + usb_read++;
-			read_usb_stats(st_pwr_usb_i, drd->d_name);
+			get_usb_dev_stats(st_pwr_usb_i, drd->d_name,
+					  (unsigned long long) drd->d_ino);
 		}
 	}
 
 	/* Close directory */
 	__closedir(dir);
+
+	if (usb_read >= 0) {
+		/* Forget devices that have been unplugged */
+		purge_usb_cache();
+	}
+
 	return usb_read;
 }
 
@@ -2614,6 +2947,154 @@ __nr_t read_filesystem(struct stats_filesystem *st_filesystem, __nr_t nr_alloc)
 	return fs_read;
 }
 
+/*
+ ***************************************************************************
+ * Close the statistics directory and counters files of a FC host.
+ *
+ * IN:
+ * @fc		FC host.
+ ***************************************************************************
+ */
+void close_fchost_fds(struct fchost_cache *fc)
+{
+	int k;
+
+	for (k = 0; k < FC_STAT_NR; k++) {
+		if (fc->fd[k] >= 0) {
+			close(fc->fd[k]);
+		}
+		fc->fd[k] = FC_NO_FD;
+	}
+	if (fc->dirfd >= 0) {
+		close(fc->dirfd);
+	}
+	fc->dirfd = FC_NO_FD;
+}
+
+/*
+ ***************************************************************************
+ * Read the list of FC hosts. Files already open for hosts still present
+ * are kept open. Those of hosts that have disappeared are closed.
+ ***************************************************************************
+ */
+void scan_fchost(void)
+{
+	DIR *dir;
+	struct dirent *drd;
+	struct fchost_cache *new_cache = NULL, *fc;
+	int new_nr = 0, new_alloc = 0;
+	int i, k;
+
+	/* Each host, if present, will have its own hostX entry within SYSFS_FCHOST */
+	if ((dir = __opendir(SYSFS_FCHOST)) != NULL) {
+
+		while ((drd = __readdir(dir)) != NULL) {
+
+			if (strncmp(drd->d_name, "host", 4) ||
+			    (strnlen(drd->d_name, MAX_NAME_LEN) == MAX_NAME_LEN))
+				continue;
+
+			if (new_nr >= new_alloc) {
+				new_alloc = new_alloc ? new_alloc * 2 : 8;
+				SREALLOC(new_cache, struct fchost_cache,
+					 sizeof(struct fchost_cache) * new_alloc);
+			}
+			fc = new_cache + new_nr++;
+
+			/* Keep files open if host was already known */
+			for (i = 0; i < fch_cache_nr; i++) {
+				if (!strcmp(fch_cache[i].name, drd->d_name))
+					break;
+			}
+			if (i < fch_cache_nr) {
+				*fc = fch_cache[i];
+				fch_cache[i].dirfd = FC_NO_FD;
+				for (k = 0; k < FC_STAT_NR; k++) {
+					fch_cache[i].fd[k] = FC_NO_FD;
+					if (fc->fd[k] == FC_NO_FILE) {
+						/* Counter file may exist now: Try to open it again */
+						fc->fd[k] = FC_NO_FD;
+					}
+				}
+			}
+			else {
+				strcpy(fc->name, drd->d_name);
+				fc->dirfd = FC_NO_FD;
+				for (k = 0; k < FC_STAT_NR; k++) {
+					fc->fd[k] = FC_NO_FD;
+				}
+			}
+		}
+
+		__closedir(dir);
+	}
+
+	/* Close files of hosts that have disappeared */
+	for (i = 0; i < fch_cache_nr; i++) {
+		close_fchost_fds(fch_cache + i);
+	}
+	free(fch_cache);
+
+	fch_cache = new_cache;
+	fch_cache_nr = new_nr;
+}
+
+/*
+ ***************************************************************************
+ * Read a FC host counter. Counters are returned as hex values by sysfs
+ * (e.g. 0x72400). The statistics directory of the host and the counter
+ * file are opened the first time then kept open, and the counter is read
+ * again from the beginning of the file at each sample.
+ *
+ * IN:
+ * @fc		FC host.
+ * @k		Index of the counter.
+ *
+ * RETURNS:
+ * Value of the counter (0 if it couldn't be read).
+ ***************************************************************************
+ */
+unsigned long read_fchost_counter(struct fchost_cache *fc, int k)
+{
+	char filename[MAX_PF_NAME], buf[64];
+	ssize_t n = -1;
+	int retry;
+
+	if (fc->fd[k] == FC_NO_FILE)
+		return 0;
+
+	for (retry = 0; retry < 2; retry++) {
+		if (fc->dirfd < 0) {
+			snprintf(filename, sizeof(filename), FC_STATS_DIR,
+				 SYSFS_FCHOST, fc->name);
+			if ((fc->dirfd = open(filename, O_RDONLY | O_DIRECTORY)) < 0) {
+				/* Host has disappeared: Read hosts list again next time */
+				fch_rescan = TRUE;
+				return 0;
+			}
+		}
+
+		if (fc->fd[k] < 0) {
+			if ((fc->fd[k] = openat(fc->dirfd, fch_stat_files[k], O_RDONLY)) < 0) {
+				fc->fd[k] = (errno == ENOENT) ? FC_NO_FILE : FC_NO_FD;
+				return 0;
+			}
+		}
+
+		if ((n = pread(fc->fd[k], buf, sizeof(buf) - 1, 0)) >= 0)
+			break;
+
+		/* Host may have been removed and added again: Reopen its files */
+		close_fchost_fds(fc);
+	}
+
+	if (n < 0)
+		return 0;
+	buf[n] = '\0';
+
+	return strtoul(buf, NULL, 16);
+}
+
 /*
  ***************************************************************************
  * Read Fibre Channel HBA statistics.
@@ -2632,81 +3113,40 @@ __nr_t read_filesystem(struct stats_filesystem *st_filesystem, __nr_t nr_alloc)
  */
 __nr_t read_fchost(struct stats_fchost *st_fc, __nr_t nr_alloc)
 {
-	DIR *dir;
-	FILE *fp;
-	struct dirent *drd;
 	struct stats_fchost *st_fc_i;
-	__nr_t fch_read = 0;
-	char fcstat_filename[MAX_PF_NAME];
-	char line[256];
-	unsigned long rx_frames, tx_frames, rx_words, tx_words;
-
-	/* Each host, if present, will have its own hostX entry within SYSFS_FCHOST */
-	if ((dir = __opendir(SYSFS_FCHOST)) == NULL)
-		return 0; /* No FC hosts */
+	struct fchost_cache *fc;
+	int i;
 
 	/*
-	 * Read each of the counters via sysfs, where they are
-	 * returned as hex values (e.g. 0x72400).
+	 * Read FC hosts list again only if it may have changed,
+	 * or if a FC host has disappeared.
 	 */
-	while ((drd = __readdir(dir)) != NULL) {
-		rx_frames = tx_frames = rx_words = tx_words = 0;
-
-		if (!strncmp(drd->d_name, "host", 4)) {
-
-			if (fch_read + 1 > nr_alloc) {
-				fch_read = -1;
-				break;
-			}
-
-			snprintf(fcstat_filename, MAX_PF_NAME, FC_RX_FRAMES,
-				 SYSFS_FCHOST, drd->d_name);
-			if ((fp = fopen(fcstat_filename, "r"))) {
-				if (fgets(line, sizeof(line), fp)) {
-					sscanf(line, "%lx", &rx_frames);
-				}
-				fclose(fp);
-			}
+	if (sysfs_dir_changed(SYSFS_FCHOST, &fch_dir_gen) || fch_rescan) {
+		scan_fchost();
+		fch_rescan = FALSE;
+	}
 
-			snprintf(fcstat_filename, MAX_PF_NAME, FC_TX_FRAMES,
-				 SYSFS_FCHOST, drd->d_name);
-			if ((fp = fopen(fcstat_filename, "r"))) {
-				if (fgets(line, sizeof(line), fp)) {
-					sscanf(line, "%lx", &tx_frames);
-				}
-				fclose(fp);
-			}
+	if (fch_cache_nr > nr_alloc)
+		return -1;
 
-			snprintf(fcstat_filename, MAX_PF_NAME, FC_RX_WORDS,
-				 SYSFS_FCHOST, drd->d_name);
-			if ((fp = fopen(fcstat_filename, "r"))) {
-				if (fgets(line, sizeof(line), fp)) {
-					sscanf(line, "%lx", &rx_words);
-				}
-				fclose(fp);
-			}
+	for (i = 0; i < fch_cache_nr; i++) {
+		fc = fch_cache + i;
+		st_fc_i = st_fc + i;
 
-			snprintf(fcstat_filename, MAX_PF_NAME, FC_TX_WORDS,
-				 SYSFS_FCHOST, drd->d_name);
-			if ((fp = fopen(fcstat_filename, "r"))) {
-				if (fgets(line, sizeof(line), fp)) {
-					sscanf(line, "%lx", &tx_words);
-				}
-				fclose(fp);
-			}
+		st_fc_i->f_rxframes = read_fchost_counter(fc, FC_STAT_RX_FRAMES);
+		st_fc_i->f_txframes = read_fchost_counter(fc, FC_STAT_TX_FRAMES);
+		st_fc_i->f_rxwords  = read_fchost_counter(fc, FC_STAT_RX_WORDS);
+		st_fc_i->f_txwords  = read_fchost_counter(fc, FC_STAT_TX_WORDS);
+		memcpy(st_fc_i->fchost_name, fc->name, sizeof(st_fc_i->fchost_name));
+		st_fc_i->fchost_name[sizeof(st_fc_i->fchost_name) - 1] = '\0';
 
-			st_fc_i = st_fc + fch_read++;
-			st_fc_i->f_rxframes = rx_frames;
-			st_fc_i->f_txframes = tx_frames;
-			st_fc_i->f_rxwords  = rx_words;
-			st_fc_i->f_txwords  = tx_words;
-			memcpy(st_fc_i->fchost_name, drd->d_name, sizeof(st_fc_i->fchost_name));
-			st_fc_i->fchost_name[sizeof(st_fc_i->fchost_name) - 1] = '\0';
-		}
+#ifdef TEST
+		/* tests/root link changes between samples: Open files again next time */
+		close_fchost_fds(fc);
+#endif
 	}
 
-	__closedir(dir);
-	return fch_read;
+	return fch_cache_nr;
 }
 
 /*
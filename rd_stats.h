@@ -67,13 +67,16 @@
 #define NET_SNMP	PRE "/proc/net/snmp"
 #define NET_SNMP6	PRE "/proc/net/snmp6"
 #define CPUINFO		PRE "/proc/cpuinfo"
+#define PHYS_PACK_ID	"topology/physical_package_id"
+#define THREAD_SBL_LST	"topology/thread_siblings_list"
 #define MTAB		PRE "/etc/mtab"
 #define IF_DUPLEX	PRE "/sys/class/net/%s/duplex"
 #define IF_SPEED	PRE "/sys/class/net/%s/speed"
-#define FC_RX_FRAMES	"%s/%s/statistics/rx_frames"
-#define FC_TX_FRAMES	"%s/%s/statistics/tx_frames"
-#define FC_RX_WORDS	"%s/%s/statistics/rx_words"
-#define FC_TX_WORDS	"%s/%s/statistics/tx_words"
+#define FC_STATS_DIR	"%s/%s/statistics"
+#define FC_RX_FRAMES	"rx_frames"
+#define FC_TX_FRAMES	"tx_frames"
+#define FC_RX_WORDS	"rx_words"
+#define FC_TX_WORDS	"tx_words"
 
 /*
  ***************************************************************************
@@ -114,6 +117,12 @@ struct stats_cpu {
 #define STATS_CPU_UL	0
 #define STATS_CPU_U	0
 
+/* Structure for CPU logical topology (socket and logical core id numbers) */
+struct cpu_topology {
+	int phys_package_id;
+	int logical_core_id;
+};
+
 /*
  * Structure for task creation and context switch statistics.
  * The attribute (aligned(8)) is necessary so that sizeof(structure) has
@@ -657,6 +666,17 @@ struct stats_pwr_usb {
 #define STATS_PWR_USB_UL	0
 #define STATS_PWR_USB_U		4
 
+/*
+ * Entry of the USB devices metadata cache. USB devices attributes don't
+ * change during the device lifetime, so they are read only once.
+ */
+struct usb_dev_cache {
+	char		   name[MAX_NAME_LEN];	/* Name in /sys/bus/usb/devices */
+	unsigned long long ino;			/* Inode number of this entry */
+	int		   seen;		/* Device found at current sample */
+	struct stats_pwr_usb st_usb;
+};
+
 /* Structure for filesystems statistics */
 struct stats_filesystem {
 	unsigned long long f_blocks;
@@ -688,6 +708,26 @@ struct stats_fchost {
 #define STATS_FCHOST_UL		4
 #define STATS_FCHOST_U		0
 
+/* Fibre Channel HBA counters read from FC_STATS_DIR */
+#define FC_STAT_RX_FRAMES	0
+#define FC_STAT_TX_FRAMES	1
+#define FC_STAT_RX_WORDS	2
+#define FC_STAT_TX_WORDS	3
+#define FC_STAT_NR		4
+
+#define FC_NO_FD		-1	/* File not open yet */
+#define FC_NO_FILE		-2	/* File doesn't exist */
+
+/*
+ * FC host whose statistics directory and counters files are kept open
+ * between samples.
+ */
+struct fchost_cache {
+	char name[MAX_NAME_LEN];
+	int  dirfd;
+	int  fd[FC_STAT_NR];
+};
+
 /* Structure for softnet statistics */
 struct stats_softnet {
 	unsigned int processed;
@@ -755,11 +795,20 @@ struct stats_psi_mem {
  ***************************************************************************
  */
 
+void add_cpu_stats
+	(struct stats_cpu *, struct stats_cpu *);
 void compute_ext_disk_stats
 	(struct stats_disk *, struct stats_disk *, unsigned long long,
 	 struct ext_disk_stats *);
+int get_node_placement
+	(int, int [], int []);
 unsigned long long get_per_cpu_interval
 	(struct stats_cpu *, struct stats_cpu *);
+void read_topology
+	(int, struct cpu_topology *);
+void set_node_cpu_stats
+	(void *, void *, size_t, int, int [], int, struct stats_cpu *,
+	 struct stats_cpu *, int, unsigned char []);
 __nr_t read_stat_cpu
 	(struct stats_cpu *, __nr_t);
 __nr_t read_stat_irq
@@ -26,6 +26,7 @@
 #include "sa.h"
 #include "ioconf.h"
 #include "rndr_stats.h"
+#include "arrow_stats.h"
 
 #ifdef USE_NLS
 #include <locale.h>
@@ -38,6 +39,7 @@
 char *seps[] =  {"\t", ";"};
 
 extern uint64_t flags;
+extern char *cpu_grp_name[];
 
 /*
  ***************************************************************************
@@ -80,11 +82,149 @@ static Cons *cons(tcons t, ...)
 	return(&c);
 }
 
+/*
+ ***************************************************************************
+ * Copy a string to a buffer, escaping characters that have a special
+ * meaning in InfluxDB line protocol.
+ *
+ * IN:
+ * @str		String to escape.
+ * @esc		Characters to escape with a backslash.
+ * @size	Size of output buffer.
+ *
+ * OUT:
+ * @out		Escaped string.
+ *
+ * RETURNS:
+ * Pointer on the escaped string.
+ ***************************************************************************
+ */
+char *influx_escape(const char *str, const char *esc, char *out, size_t size)
+{
+	size_t i = 0;
+
+	for (; *str && (i < size - 2); str++) {
+		if (strchr(esc, *str)) {
+			out[i++] = '\\';
+		}
+		out[i++] = *str;
+	}
+	out[i] = '\0';
+
+	return out;
+}
+
+/*
+ ***************************************************************************
+ * Format the ppc text of a value ("<item>\t<field>") then split it.
+ *
+ * IN:
+ * @pptxt	printf-format text for ppc output.
+ * @mid		pptxt format args as a Cons.
+ * @size	Size of output buffer.
+ *
+ * OUT:
+ * @txt		Item name (unless there is no item, in which case @txt is
+ *		the field name).
+ *
+ * RETURNS:
+ * Pointer on the field name.
+ ***************************************************************************
+ */
+static char *split_pptxt(const char *pptxt, Cons *mid, char *txt, size_t size)
+{
+	char *field;
+
+	if (mid) {
+		if (mid->t == iv) {
+			snprintf(txt, size, pptxt, mid->a.i, mid->b.i);
+		}
+		else {
+			snprintf(txt, size, pptxt, mid->a.s, mid->b.s);
+		}
+	}
+	else {
+		snprintf(txt, size, "%s", pptxt);
+	}
+
+	if ((field = strchr(txt, '\t')) != NULL) {
+		*(field++) = '\0';
+		return field;
+	}
+
+	return txt;
+}
+
+/*
+ ***************************************************************************
+ * render_influx():
+ *
+ * given:    pre  - "<measurement>,host=<host>\t<timestamp>\t<tag key>"
+ *	     rflags - PT_.... rendering flags
+ *	     pptxt - printf-format text for ppc output ("<item>\t<field>")
+ *	     mid - pptxt format args as a Cons.
+ *	     lluval - %llu printable arg (PT_USEINT must be set)
+ *	     dval  - %.2f printable arg (used unless PT_USEINT is set)
+ *	     sval - %s printable arg (PT_USESTR must be set)
+ *
+ * does:     print a line of InfluxDB line protocol, one field at a time:
+ *	     measurement,host=<host>[,<tag key>=<item>] field=value[,...] timestamp
+ *	     Values rendered on the same db line make up the field set of
+ *	     one point. Item "-" means that there is no item to tag.
+ *
+ * return:   void.
+ ***************************************************************************
+ */
+static void render_influx(char *pre, int rflags, const char *pptxt, Cons *mid,
+			  unsigned long long lluval, double dval, char *sval)
+{
+	static int newline = 1;
+	char txt[256], esc[512], *field, *ts, *key;
+
+	field = split_pptxt(pptxt, mid, txt, sizeof(txt));
+	ts = strchr(pre, '\t');
+
+	if (newline) {
+		/* Measurement, host tag and item tag */
+		printf("%.*s", ts ? (int) (ts - pre) : (int) strlen(pre), pre);
+		if (ts && (field != txt) && strcmp(txt, "-") &&
+		    ((key = strchr(ts + 1, '\t')) != NULL)) {
+			printf(",%s=%s", key + 1, influx_escape(txt, ", =", esc, sizeof(esc)));
+		}
+		printf(" ");
+	}
+	else {
+		printf(",");
+	}
+
+	printf("%s=", influx_escape(field, ", =", esc, sizeof(esc)));
+	if (rflags & PT_USEINT) {
+		printf("%llui", lluval);
+	}
+	else if (rflags & PT_USESTR) {
+		printf("\"%s\"", influx_escape(sval, "\"\\", esc, sizeof(esc)));
+	}
+	else if (rflags & PT_USERND) {
+		printf("%.0f", dval);
+	}
+	else {
+		printf("%.2f", dval);
+	}
+
+	/* Terminate the point with its timestamp? */
+	newline = (rflags & PT_NEWLIN);
+	if (newline) {
+		printf(" %.*s\n", ts ? (int) strcspn(ts + 1, "\t") : 0, ts ? ts + 1 : "");
+	}
+}
+
 /*
  ***************************************************************************
  * render():
  *
- * given:    isdb - flag, true if db printing, false if ppc printing
+ * given:    isdb - RNDR_DB if db printing, RNDR_PPC if ppc printing,
+ *		    RNDR_INFLUX if InfluxDB line protocol printing,
+ *		    RNDR_ARROW if values are saved in an Arrow record batch
  *	     pre  - prefix string for output entries
  *	     rflags - PT_.... rendering flags
  *	     pptxt - printf-format text required for ppc output (may be null)
@@ -106,6 +246,17 @@ static void render(int isdb, char *pre, int rflags, const char *pptxt,
 {
 	static int newline = 1;
 	const char *txt[]  = {pptxt, dbtxt};
+	char itxt[256], *field;
+
+	if (isdb == RNDR_INFLUX) {
+		render_influx(pre, rflags, pptxt, mid, lluval, dval, sval);
+		return;
+	}
+	if (isdb == RNDR_ARROW) {
+		field = split_pptxt(pptxt, mid, itxt, sizeof(itxt));
+		arrow_add_value((field != itxt) ? itxt : "-", field, rflags, lluval, dval, sval);
+		return;
+	}
 
 	/* Start a new line? */
 	if (newline && !DISPLAY_HORIZONTALLY(flags)) {
@@ -153,6 +304,141 @@ static void render(int isdb, char *pre, int rflags, const char *pptxt,
 	}
 }
 
+/*
+ ***************************************************************************
+ * Display statistics for each node and/or socket in selected format.
+ * Global CPU statistics must have been computed before.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @isdb	Flag, true if db printing, false if ppc printing.
+ * @pre		Prefix string for output entries
+ * @curr	Index in array for current sample statistics.
+ * @offline_cpu_bitmap
+ *		CPU bitmap for offline CPU.
+ ***************************************************************************
+ */
+static void render_cpu_grp_stats(struct activity *a, int isdb, char *pre, int curr,
+				 unsigned char offline_cpu_bitmap[])
+{
+	int g, i, grp_nr;
+	unsigned long long deltot_jiffies;
+	struct stats_cpu *sgc, *sgp, *scc, *scp;
+	char grp_name[16];
+	int pt_newlin
+		= (DISPLAY_HORIZONTALLY(flags) ? PT_NOFLAG : PT_NEWLIN);
+
+	for (g = 0; g < CPU_GRP_NR; g++) {
+
+		if (!DISPLAY_CPU_GRP(a->opt_flags, g))
+			continue;
+
+		grp_nr = get_cpu_grp_statistics(a, !curr, curr, flags, g,
+						offline_cpu_bitmap, &sgp, &sgc);
+
+		for (i = 1; i <= grp_nr; i++) {
+
+			scc = sgc + i;
+			scp = sgp + i;
+
+			/* Groups with no CPU (or no activity) are not displayed */
+			if (!(deltot_jiffies = get_per_cpu_interval(scc, scp)))
+				continue;
+
+			snprintf(grp_name, sizeof(grp_name), "%s%d", cpu_grp_name[g], i - 1);
+
+			if (DISPLAY_CPU_DEF(a->opt_flags)) {
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%user", "%s", cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_user, scc->cpu_user, deltot_jiffies),
+				       NULL);
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%nice", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_nice, scc->cpu_nice, deltot_jiffies),
+				       NULL);
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%system", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_sys + scp->cpu_hardirq + scp->cpu_softirq,
+						   scc->cpu_sys + scc->cpu_hardirq + scc->cpu_softirq,
+						   deltot_jiffies),
+				       NULL);
+			}
+			else if (DISPLAY_CPU_ALL(a->opt_flags)) {
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%usr", "%s", cons(sv, grp_name, NULL),
+				       NOVAL,
+				       (scc->cpu_user - scc->cpu_guest) < (scp->cpu_user - scp->cpu_guest) ?
+				       0.0 :
+				       ll_sp_value(scp->cpu_user - scp->cpu_guest,
+						   scc->cpu_user - scc->cpu_guest, deltot_jiffies),
+				       NULL);
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%nice", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       (scc->cpu_nice - scc->cpu_guest_nice) < (scp->cpu_nice - scp->cpu_guest_nice) ?
+				       0.0 :
+				       ll_sp_value(scp->cpu_nice - scp->cpu_guest_nice,
+						   scc->cpu_nice - scc->cpu_guest_nice, deltot_jiffies),
+				       NULL);
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%sys", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_sys, scc->cpu_sys, deltot_jiffies),
+				       NULL);
+			}
+
+			render(isdb, pre, PT_NOFLAG,
+			       "%s\t%%iowait", NULL, cons(sv, grp_name, NULL),
+			       NOVAL,
+			       ll_sp_value(scp->cpu_iowait, scc->cpu_iowait, deltot_jiffies),
+			       NULL);
+
+			render(isdb, pre, PT_NOFLAG,
+			       "%s\t%%steal", NULL, cons(sv, grp_name, NULL),
+			       NOVAL,
+			       ll_sp_value(scp->cpu_steal, scc->cpu_steal, deltot_jiffies),
+			       NULL);
+
+			if (DISPLAY_CPU_ALL(a->opt_flags)) {
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%irq", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_hardirq, scc->cpu_hardirq, deltot_jiffies),
+				       NULL);
+
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%soft", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_softirq, scc->cpu_softirq, deltot_jiffies),
+				       NULL);
+
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%guest", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_guest, scc->cpu_guest, deltot_jiffies),
+				       NULL);
+
+				render(isdb, pre, PT_NOFLAG,
+				       "%s\t%%gnice", NULL, cons(sv, grp_name, NULL),
+				       NOVAL,
+				       ll_sp_value(scp->cpu_guest_nice, scc->cpu_guest_nice, deltot_jiffies),
+				       NULL);
+			}
+
+			render(isdb, pre, pt_newlin,
+			       "%s\t%%idle", NULL, cons(sv, grp_name, NULL),
+			       NOVAL,
+			       (scc->cpu_idle < scp->cpu_idle) ?
+			       0.0 :
+			       ll_sp_value(scp->cpu_idle, scc->cpu_idle, deltot_jiffies),
+			       NULL);
+		}
+	}
+}
+
 /*
  ***************************************************************************
  * Display CPU statistics in selected format.
@@ -460,6 +746,9 @@ __print_funct_t render_cpu_stats(struct activity *a, int isdb, char *pre,
 			}
 		}
 	}
+
+	/* Display statistics for each node and/or socket */
+	render_cpu_grp_stats(a, isdb, pre, curr, offline_cpu_bitmap);
 }
 
 /*
@@ -761,6 +1050,7 @@ __print_funct_t render_memory_stats(struct activity *a, int isdb, char *pre,
 		= (DISPLAY_HORIZONTALLY(flags) ? PT_NOFLAG : PT_NEWLIN);
 	int ptn;
 	unsigned long long nousedmem;
+	char spre[UTSNAME_LEN * 2 + 256];
 
 	if (DISPLAY_MEMORY(a->opt_flags)) {
 
@@ -843,6 +1133,16 @@ __print_funct_t render_memory_stats(struct activity *a, int isdb, char *pre,
 
 	if (DISPLAY_SWAP(a->opt_flags)) {
 
+		if (isdb == RNDR_INFLUX) {
+			/*
+			 * Memory and swap space statistics are displayed in
+			 * separate passes: Give swap points their own measurement
+			 * so that they don't overwrite memory points.
+			 */
+			snprintf(spre, sizeof(spre), "memory_swap%s", pre + strcspn(pre, ","));
+			pre = spre;
+		}
+
 		render(isdb, pre, PT_USEINT,
 		       "-\tkbswpfree", NULL, NULL,
 		       smc->frskb, DNOVAL, NULL);
@@ -2842,32 +3142,60 @@ __print_funct_t render_pwr_wghfreq_stats(struct activity *a, int isdb, char *pre
 __print_funct_t render_pwr_usb_stats(struct activity *a, int isdb, char *pre,
 				     int curr, unsigned long long itv)
 {
-	int i;
-	struct stats_pwr_usb *suc;
-	char id[9];
+	int i, j, seq, n;
+	struct stats_pwr_usb *suc, *sup;
+	char id[9], ipre[UTSNAME_LEN * 2 + 320], *upre = pre;
 
 	for (i = 0; i < a->nr[curr]; i++) {
 		suc = (struct stats_pwr_usb *) ((char *) a->buf[curr] + i * a->msize);
 
-		sprintf(id, "%x", suc->vendor_id);
-		render(isdb, pre, PT_USESTR,
-		       "bus%d\tidvendor",
-		       "%d",
-		       cons(iv, suc->bus_nr, NOVAL),
-		       NOVAL,
-		       NOVAL,
-		       id);
+		if (isdb == RNDR_INFLUX) {
+			/*
+			 * Several devices may be plugged on the same bus: Tag them
+			 * with their vendor and product IDs too, so that each device
+			 * has its own series. Identical devices on the same bus
+			 * are numbered in the order in which they were read.
+			 */
+			for (j = seq = 0; j < i; j++) {
+				sup = (struct stats_pwr_usb *) ((char *) a->buf[curr] + j * a->msize);
+				if ((sup->bus_nr == suc->bus_nr) &&
+				    (sup->vendor_id == suc->vendor_id) &&
+				    (sup->product_id == suc->product_id)) {
+					seq++;
+				}
+			}
+			n = strcspn(pre, "\t");
+			n = snprintf(ipre, sizeof(ipre), "%.*s,idvendor=%x,idprod=%x",
+				     n, pre, suc->vendor_id, suc->product_id);
+			if (seq && (n < sizeof(ipre))) {
+				n += snprintf(ipre + n, sizeof(ipre) - n, ",seq=%d", seq);
+			}
+			if (n < sizeof(ipre)) {
+				snprintf(ipre + n, sizeof(ipre) - n, "%s", pre + strcspn(pre, "\t"));
+			}
+			upre = ipre;
+		}
+		else {
+			sprintf(id, "%x", suc->vendor_id);
+			render(isdb, pre, PT_USESTR,
+			       "bus%d\tidvendor",
+			       "%d",
+			       cons(iv, suc->bus_nr, NOVAL),
+			       NOVAL,
+			       NOVAL,
+			       id);
 
-		sprintf(id, "%x", suc->product_id);
-		render(isdb, pre, PT_USESTR,
-		       "bus%d\tidprod",
-		       NULL,
-		       cons(iv, suc->bus_nr, NOVAL),
-		       NOVAL,
-		       NOVAL,
-		       id);
+			sprintf(id, "%x", suc->product_id);
+			render(isdb, pre, PT_USESTR,
+			       "bus%d\tidprod",
+			       NULL,
+			       cons(iv, suc->bus_nr, NOVAL),
+			       NOVAL,
+			       NOVAL,
+			       id);
+		}
 
-		render(isdb, pre, PT_USEINT,
+		render(isdb, upre, PT_USEINT,
 		       "bus%d\tmaxpower",
 		       NULL,
 		       cons(iv, suc->bus_nr, NOVAL),
@@ -2875,7 +3203,7 @@ __print_funct_t render_pwr_usb_stats(struct activity *a, int isdb, char *pre,
 		       NOVAL,
 		       NULL);
 
-		render(isdb, pre, PT_USESTR,
+		render(isdb, upre, PT_USESTR,
 		       "bus%d\tmanufact",
 		       NULL,
 		       cons(iv, suc->bus_nr, NOVAL),
@@ -2883,7 +3211,7 @@ __print_funct_t render_pwr_usb_stats(struct activity *a, int isdb, char *pre,
 		       NOVAL,
 		       suc->manufacturer);
 
-		render(isdb, pre,
+		render(isdb, upre,
 		       (DISPLAY_HORIZONTALLY(flags) ? PT_USESTR : PT_USESTR | PT_NEWLIN),
 		       "bus%d\tproduct",
 		       NULL,
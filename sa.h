@@ -110,7 +110,7 @@
 #define S_F_SVG_HEIGHT		0x00200000
 #define S_F_SVG_PACKED		0x00400000
 #define S_F_SVG_SHOW_INFO	0x00800000
-/* Unused 			0x01000000 */
+#define S_F_CPU_TOPOLOGY	0x01000000	/* Only used by sadc */
 #define S_F_ZERO_OMIT		0x02000000
 #define S_F_SVG_SHOW_TOC	0x04000000
 #define S_F_FDATASYNC		0x08000000
@@ -121,6 +121,7 @@
 
 #define WANT_SINCE_BOOT(m)		(((m) & S_F_SINCE_BOOT)   == S_F_SINCE_BOOT)
 #define WANT_SA_ROTAT(m)		(((m) & S_F_SA_ROTAT)     == S_F_SA_ROTAT)
+#define WANT_CPU_TOPOLOGY(m)		(((m) & S_F_CPU_TOPOLOGY) == S_F_CPU_TOPOLOGY)
 #define USE_STABLE_ID(m)		(((m) & S_F_DEV_SID)      == S_F_DEV_SID)
 #define DISPLAY_PRETTY(m)		(((m) & S_F_PRETTY)       == S_F_PRETTY)
 #define FORCE_FILE(m)			(((m) & S_F_FORCE_FILE)   == S_F_FORCE_FILE)
@@ -152,6 +153,66 @@
 #define USE_OPTION_P(m)			(((m) & S_F_OPTION_P)     == S_F_OPTION_P)
 #define USE_OPTION_I(m)			(((m) & S_F_OPTION_I)     == S_F_OPTION_I)
 
+/*
+ ***************************************************************************
+ * Phases whose execution time is measured when option --profile is used
+ * (sar and sadf only).
+ ***************************************************************************
+ */
+
+#define PROF_READ	0	/* Reading data file */
+#define PROF_DECODE	1	/* Normalizing endianness and remapping structures */
+#define PROF_MATCH	2	/* Looking up devices and interfaces */
+#define PROF_PRINT	3	/* Computing and displaying statistics */
+#define PROF_NR		4
+
+/* Start of a measured phase */
+struct prof_ts {
+	struct timespec ts;
+	/* Time already accounted for (all phases) when the phase started */
+	unsigned long long done_ns;
+};
+
+/*
+ * Start and stop measuring time spent in a phase. @a is the activity the
+ * phase is performed for (may be NULL). Both do nothing unless option
+ * --profile has been entered. Time spent in a phase nested inside another
+ * one (e.g. PROF_MATCH inside PROF_PRINT) is accounted for the inner phase
+ * only.
+ */
+#define PROF_START(t)		do {						\
+					if (prof_enabled)			\
+						prof_start(&(t));		\
+				} while (0)
+#define PROF_STOP(t, a, ph)	do {						\
+					if (prof_enabled)			\
+						prof_add(&(t), (a), (ph));	\
+				} while (0)
+
+/*
+ ***************************************************************************
+ * USDT (User-level Statically Defined Tracing) probes, for use with e.g.
+ * bpftrace or perf. Probes belong to provider "sysstat":
+ * sadc:
+ *	sample__start(ust_time), sample__end(ust_time)
+ *	read__start(act_id), read__end(act_id, nr)
+ *	write__start(fd), write__end(fd, bytes)
+ * sar and sadf:
+ *	record__start(act_nr), record__end(act_nr)
+ *	print__start(act_id), print__end(act_id, nr)
+ * They are compiled out when <sys/sdt.h> is not available.
+ ***************************************************************************
+ */
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#define SA_PROBE1(n, a1)	DTRACE_PROBE1(sysstat, n, a1)
+#define SA_PROBE2(n, a1, a2)	DTRACE_PROBE2(sysstat, n, a1, a2)
+#else
+#define SA_PROBE1(n, a1)	do { (void) (a1); } while (0)
+#define SA_PROBE2(n, a1, a2)	do { (void) (a1); (void) (a2); } while (0)
+#endif
+
 #define AO_F_NULL		0x00000000
 
 /* Output flags for options -r / -S */
@@ -171,6 +232,22 @@
 #define DISPLAY_CPU_DEF(m)	(((m) & AO_F_CPU_DEF)     == AO_F_CPU_DEF)
 #define DISPLAY_CPU_ALL(m)	(((m) & AO_F_CPU_ALL)     == AO_F_CPU_ALL)
 
+/*
+ * Output flags for option --topology.
+ * NB: Not in the lower byte since A_CPU has multiple outputs.
+ */
+#define AO_F_CPU_NODE		0x00010000
+#define AO_F_CPU_SOCK		0x00020000
+#define AO_F_CPU_GRP		(AO_F_CPU_NODE | AO_F_CPU_SOCK)
+#define AO_F_CPU_GRP_TYPE(g)	(AO_F_CPU_NODE << (g))
+
+#define DISPLAY_CPU_GRP(m,g)	(((m) & AO_F_CPU_GRP_TYPE(g)) == AO_F_CPU_GRP_TYPE(g))
+
+/* Types of groups of CPU */
+#define CPU_GRP_NODE	0
+#define CPU_GRP_SOCK	1
+#define CPU_GRP_NR	2
+
 /* Output flags for option -d */
 #define AO_F_DISK_PART		0x00000001
 
@@ -211,6 +288,7 @@
 #define K_LOAD		"LOAD"
 #define K_PSI_MEM	"MEM"
 #define K_MOUNT		"MOUNT"
+#define K_NODE		"NODE"
 #define K_NFS		"NFS"
 #define K_NFSD		"NFSD"
 #define K_PSI		"PSI"
@@ -221,6 +299,7 @@
 #define K_SUM		"SUM"
 #define K_TCP		"TCP"
 #define K_TEMP		"TEMP"
+#define K_TOPOLOGY	"TOPOLOGY"
 #define K_UDP		"UDP"
 #define K_UDP6		"UDP6"
 #define K_XALL		"XALL"
@@ -266,7 +345,6 @@
 #define DEF_TMSTART	"08:00:00"
 #define DEF_TMEND	"18:00:00"
 
-#define UTSNAME_LEN	65
 #define TZNAME_LEN	8
 #define HEADER_LINE_LEN	512
 
@@ -340,7 +418,7 @@
  */
 
 /* Number of output formats */
-#define NR_FMT	9
+#define NR_FMT	11
 
 /* Output formats */
 #define F_SAR_OUTPUT	0
@@ -353,6 +431,14 @@
 #define F_SVG_OUTPUT	7
 #define F_RAW_OUTPUT	8
 #define F_PCP_OUTPUT	9
+#define F_INFLUX_OUTPUT	10
+#define F_ARROW_OUTPUT	11
+
+/* Rendering modes (@isdb parameter) for functions used by sadf's db, ppc, influx and arrow formats */
+#define RNDR_PPC	0
+#define RNDR_DB		1
+#define RNDR_INFLUX	2
+#define RNDR_ARROW	3
 
 
 /* Structure for SVG specific parameters */
@@ -367,6 +453,16 @@ struct svg_parm {
 	struct file_header *file_hdr;		/* Pointer on file header structure */
 };
 
+/*
+ * Buffer used by sadc to render statistics in OpenMetrics text format
+ * (option --metrics). It is allocated once and reused for each sample.
+ */
+struct om_buf {
+	char *buf;	/* Buffer contents */
+	size_t len;	/* Number of bytes used */
+	size_t size;	/* Number of bytes allocated */
+};
+
 /* Structure used when displaying SVG header */
 struct svg_hdr_parm {
 	int graph_nr;	   /* Number of rows of views to display or canvas height entered on the command line */
@@ -639,6 +735,11 @@ struct file_header {
  * unknown format (used for sadf -H only).
  */
 #define ACTIVITY_MAGIC_UNKNOWN	0x89
+/*
+ * Magical number for disk activity (A_DISK). Also used by iostat
+ * to save its statistics in a system activity data file.
+ */
+#define A_DISK_MAGIC		(ACTIVITY_MAGIC_BASE + 2)
 
 /* List of activities saved in file */
 struct file_activity {
@@ -715,6 +816,60 @@ struct extra_desc {
 #define MAX_EXTRA_NR		8192
 #define MAX_EXTRA_SIZE		1024
 
+/*
+ * Extra structure saved after the file header by sadc, giving the logical
+ * topology of each individual CPU. Such structures are recognized by their
+ * composition (see EXTRA_CPU_TOPOLOGY_*_NR below) and their magic number.
+ */
+#define EXTRA_CPU_TOPOLOGY_MAGIC	0x7a01
+
+struct extra_cpu_topology {
+	/*
+	 * Magic number for this kind of extra structure.
+	 */
+	unsigned int magic;
+	/*
+	 * CPU number (0, 1, etc.)
+	 */
+	unsigned int cpu;
+	/*
+	 * Node the CPU belongs to (-1 if none).
+	 */
+	int node;
+	/*
+	 * Logical core id number.
+	 */
+	int core;
+	/*
+	 * Physical package (socket) id number.
+	 */
+	int package;
+};
+
+#define EXTRA_CPU_TOPOLOGY_SIZE		(sizeof(struct extra_cpu_topology))
+#define EXTRA_CPU_TOPOLOGY_ULL_NR	0	/* Nr of unsigned long long in extra_cpu_topology structure */
+#define EXTRA_CPU_TOPOLOGY_UL_NR	0	/* Nr of unsigned long in extra_cpu_topology structure */
+#define EXTRA_CPU_TOPOLOGY_U_NR		5	/* Nr of [unsigned] int in extra_cpu_topology structure */
+
+/*
+ * CPU topology, as read from a system activity file.
+ * Used by sar and sadf to compute statistics for groups of CPU.
+ */
+struct sa_cpu_topology {
+	/*
+	 * Number of CPU whose topology is known.
+	 */
+	int cpu_nr;
+	/*
+	 * Number of groups of each type (highest group number + 1).
+	 */
+	int grp_nr[CPU_GRP_NR];
+	/*
+	 * Group each CPU belongs to, for each type of group (-1 if none).
+	 */
+	int *cpu2grp[CPU_GRP_NR];
+};
+
 /* Record type */
 /*
  * R_STATS means that this is a record of statistics.
@@ -955,8 +1110,9 @@ struct activity {
 	__print_funct_t (*f_print_avg) (struct activity *, int, int, unsigned long long);
 	/*
 	 * This function is used by sadf to display activity in a format that can
-	 * easily be ingested by a relational database, or a format that can be
-	 * handled by pattern processing commands like "awk".
+	 * easily be ingested by a relational database, a format that can be
+	 * handled by pattern processing commands like "awk", InfluxDB
+	 * line protocol or Arrow IPC stream.
 	 */
 	__print_funct_t (*f_render) (struct activity *, int, char *, int, unsigned long long);
 	/*
@@ -981,6 +1137,11 @@ struct activity {
 	 */
 	__print_funct_t (*f_pcp_print) (struct activity *, int, unsigned long long,
 					struct record_header *);
+	/*
+	 * This function is used by sadc to render activity statistics in
+	 * OpenMetrics text format (option --metrics).
+	 */
+	__print_funct_t (*f_om_print) (struct activity *, struct om_buf *, unsigned long long);
 	/*
 	 * This function is used by sadf to count the number of new items in current
 	 * sample and add them to the linked list @item_list.
@@ -1112,6 +1273,12 @@ struct activity {
 	 * if @bitmap is not NULL.
 	 */
 	struct act_bitmap *bitmap;
+	/*
+	 * Time spent (in nanoseconds) and number of calls for each phase
+	 * (PROF_*) when option --profile is used.
+	 */
+	unsigned long long prof_ns[PROF_NR];
+	unsigned long long prof_calls[PROF_NR];
 };
 
 
@@ -1492,6 +1659,10 @@ int skip_extra_struct
 	(int, int, int);
 int write_all
 	(int, const void *, int);
+int write_disk_file_hdr
+	(int, unsigned int, __nr_t, time_t, struct tm *);
+int write_disk_record
+	(int, unsigned long long, time_t, struct tm *, struct stats_disk *, __nr_t);
 
 #ifndef SOURCE_SADC
 int add_list_item
@@ -1519,6 +1690,8 @@ void display_sa_file_version
 	(FILE *, struct file_magic *);
 void free_bitmaps
 	(struct activity * []);
+void free_cpu_topology
+	(void);
 void free_structures
 	(struct activity * []);
 char *get_devname
@@ -1531,6 +1704,9 @@ char *get_fs_name_to_display
 	(struct activity *, uint64_t, struct stats_filesystem *);
 unsigned long long get_global_cpu_statistics
 	(struct activity *, int, int, uint64_t, unsigned char []);
+int get_cpu_grp_statistics
+	(struct activity *, int, int, uint64_t, int, unsigned char [],
+	 struct stats_cpu **, struct stats_cpu **);
 void get_global_soft_statistics
 	(struct activity *, int, int, uint64_t, unsigned char []);
 void get_itv_value
@@ -1547,6 +1723,8 @@ int parse_sar_I_opt
 	(char * [], int *, uint64_t *, struct activity * []);
 int parse_sa_P_opt
 	(char * [], int *, uint64_t *, struct activity * []);
+int parse_sa_topology_opt
+	(char * [], int *, struct activity * []);
 int parse_sar_m_opt
 	(char * [], int *, struct activity * []);
 int parse_sar_n_opt
@@ -1555,6 +1733,8 @@ int parse_sar_q_opt
 	(char * [], int *, struct activity * []);
 int parse_timestamp
 	(char * [], int *, struct tstamp *, const char *);
+void print_profile
+	(struct activity * []);
 void print_report_hdr
 	(uint64_t, struct tm *, struct file_header *);
 void print_sar_comment
@@ -1566,9 +1746,15 @@ int print_special_record
 	(struct record_header *, uint64_t, struct tstamp *, struct tstamp *,
 	 int, int, struct tm *, char *, int, struct file_magic *,
 	 struct file_header *, struct activity * [], struct report_format *, int, int);
+void prof_add
+	(struct prof_ts *, struct activity *, int);
+void prof_start
+	(struct prof_ts *);
 int read_file_stat_bunch
 	(struct activity * [], int, int, int, struct file_activity *, int, int,
 	 char *, struct file_magic *, int);
+int read_hdr_extra_struct
+	(int, int, int);
 __nr_t read_nr_value
 	(int, char *, struct file_magic *, int, int, int);
 int read_record_hdr
@@ -1584,6 +1770,8 @@ int sa_get_record_timestamp_struct
 	(uint64_t, struct record_header *, struct tm *);
 int sa_open_read_magic
 	(int *, char *, struct file_magic *, int, int *, int);
+int save_cpu_topology
+	(struct extra_desc *, void *, int, int);
 int search_list_item
 	(struct sa_item *, char *);
 void select_all_activities
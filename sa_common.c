@@ -32,6 +32,7 @@
 #include <libgen.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/utsname.h>
 #include <ctype.h>
 
 #include "version.h"
@@ -47,6 +48,12 @@
 #endif
 
 int default_file_used = FALSE;
+/* Set to TRUE when option --profile has been entered (sar and sadf only) */
+int prof_enabled = FALSE;
+/* CPU topology read from file */
+struct sa_cpu_topology cpu_topo;
+/* Names of groups of CPU (nodes, sockets) */
+char *cpu_grp_name[CPU_GRP_NR] = {"node", "sock"};
 extern struct act_bitmap cpu_bitmap;
 extern unsigned int dm_major;
 
@@ -434,7 +441,160 @@ int write_all(int fd, const void *buf, int nr_bytes)
 	return offset;
 }
 
+/*
+ ***************************************************************************
+ * Write the header of a system activity data file containing only disk
+ * statistics (A_DISK activity). This is used by commands other than sadc
+ * (e.g. iostat) to save their statistics in a file that sar and sadf can
+ * read. The header is followed by a RESTART record, as a new file is
+ * started each time, so that statistics saved in it are not compared with
+ * those of another run.
+ *
+ * IN:
+ * @fd		Output file descriptor.
+ * @cpu_nr	Number of CPU for current machine (1 .. CPU_NR + 1).
+ * @nr		Number of block devices.
+ * @ust_time	Time of the first sample in seconds since the Epoch.
+ * @rectime	Date and time of the first sample.
+ *
+ * RETURNS:
+ * 0 on success, -1 on write error.
+ ***************************************************************************
+ */
+int write_disk_file_hdr(int fd, unsigned int cpu_nr, __nr_t nr,
+			time_t ust_time, struct tm *rectime)
+{
+	int i;
+	__nr_t new_cpu_nr = (__nr_t) cpu_nr;
+	struct utsname header;
+	struct record_header record_hdr;
+	struct file_magic file_magic;
+	struct file_header file_hdr;
+	struct file_activity file_act;
+
+	/* Fill then write file magic header */
+	memset(&file_magic, 0, FILE_MAGIC_SIZE);
+	file_magic.sysstat_magic = SYSSTAT_MAGIC;
+	file_magic.format_magic  = FORMAT_MAGIC;
+	enum_version_nr(&file_magic);
+	file_magic.header_size = FILE_HEADER_SIZE;
+	for (i = 0; i < 3; i++) {
+		file_magic.hdr_types_nr[i] = hdr_types_nr[i];
+	}
+
+	if (write_all(fd, &file_magic, FILE_MAGIC_SIZE) != FILE_MAGIC_SIZE)
+		return -1;
+
+	/* Fill then write file header */
+	memset(&file_hdr, 0, FILE_HEADER_SIZE);
+	file_hdr.sa_ust_time    = (unsigned long long) ust_time;
+	file_hdr.sa_act_nr      = 1;
+	file_hdr.sa_day         = rectime->tm_mday;
+	file_hdr.sa_month       = rectime->tm_mon;
+	file_hdr.sa_year        = rectime->tm_year;
+	file_hdr.sa_sizeof_long = sizeof(long);
+	file_hdr.sa_hz		= HZ;
+	file_hdr.sa_cpu_nr	= cpu_nr;
+
+	for (i = 0; i < 3; i++) {
+		file_hdr.act_types_nr[i] = act_types_nr[i];
+		file_hdr.rec_types_nr[i] = rec_types_nr[i];
+	}
+	file_hdr.act_size = FILE_ACTIVITY_SIZE;
+	file_hdr.rec_size = RECORD_HEADER_SIZE;
+
+	__uname(&header);
+	strncpy(file_hdr.sa_sysname, header.sysname, sizeof(file_hdr.sa_sysname));
+	file_hdr.sa_sysname[sizeof(file_hdr.sa_sysname) - 1]  = '\0';
+	strncpy(file_hdr.sa_nodename, header.nodename, sizeof(file_hdr.sa_nodename));
+	file_hdr.sa_nodename[sizeof(file_hdr.sa_nodename) - 1] = '\0';
+	strncpy(file_hdr.sa_release, header.release, sizeof(file_hdr.sa_release));
+	file_hdr.sa_release[sizeof(file_hdr.sa_release) - 1]  = '\0';
+	strncpy(file_hdr.sa_machine, header.machine, sizeof(file_hdr.sa_machine));
+	file_hdr.sa_machine[sizeof(file_hdr.sa_machine) - 1]  = '\0';
+
+	tzset();
+	strncpy(file_hdr.sa_tzname, tzname[0], TZNAME_LEN);
+	file_hdr.sa_tzname[TZNAME_LEN - 1] = '\0';
+
+	if (write_all(fd, &file_hdr, FILE_HEADER_SIZE) != FILE_HEADER_SIZE)
+		return -1;
+
+	/* Then write the only activity saved in file */
+	memset(&file_act, 0, FILE_ACTIVITY_SIZE);
+	file_act.id     = A_DISK;
+	file_act.magic  = A_DISK_MAGIC;
+	file_act.nr     = (nr > 0 ? nr : 1);
+	file_act.nr2    = 1;
+	file_act.size   = STATS_DISK_SIZE;
+	file_act.has_nr = TRUE;
+	file_act.types_nr[0] = STATS_DISK_ULL;
+	file_act.types_nr[1] = STATS_DISK_UL;
+	file_act.types_nr[2] = STATS_DISK_U;
+
+	if (write_all(fd, &file_act, FILE_ACTIVITY_SIZE) != FILE_ACTIVITY_SIZE)
+		return -1;
+
+	/* Write a RESTART record followed by the number of CPU */
+	memset(&record_hdr, 0, RECORD_HEADER_SIZE);
+	record_hdr.record_type = R_RESTART;
+	record_hdr.ust_time    = (unsigned long long) ust_time;
+	record_hdr.hour        = rectime->tm_hour;
+	record_hdr.minute      = rectime->tm_min;
+	record_hdr.second      = rectime->tm_sec;
+
+	if ((write_all(fd, &record_hdr, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE) ||
+	    (write_all(fd, &new_cpu_nr, sizeof(__nr_t)) != sizeof(__nr_t)))
+		return -1;
+
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Write a record with disk statistics to a system activity data file
+ * created with write_disk_file_hdr().
+ *
+ * IN:
+ * @fd		Output file descriptor.
+ * @uptime_cs	System uptime in 1/100th of a second.
+ * @ust_time	Time of the sample in seconds since the Epoch.
+ * @rectime	Date and time of the sample.
+ * @st_disk	Disk statistics.
+ * @nr		Number of block devices in @st_disk.
+ *
+ * RETURNS:
+ * 0 on success, -1 on write error.
+ ***************************************************************************
+ */
+int write_disk_record(int fd, unsigned long long uptime_cs, time_t ust_time,
+		      struct tm *rectime, struct stats_disk *st_disk, __nr_t nr)
+{
+	struct record_header record_hdr;
+
+	memset(&record_hdr, 0, RECORD_HEADER_SIZE);
+	record_hdr.record_type = R_STATS;
+	record_hdr.uptime_cs   = uptime_cs;
+	record_hdr.ust_time    = (unsigned long long) ust_time;
+	record_hdr.hour        = rectime->tm_hour;
+	record_hdr.minute      = rectime->tm_min;
+	record_hdr.second      = rectime->tm_sec;
+
+	if ((write_all(fd, &record_hdr, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE) ||
+	    (write_all(fd, &nr, sizeof(__nr_t)) != sizeof(__nr_t)) ||
+	    (write_all(fd, st_disk, STATS_DISK_SIZE * nr) != STATS_DISK_SIZE * nr))
+		return -1;
+
+	return 0;
+}
+
 #ifndef SOURCE_SADC
+/* Time spent in phases not related to a particular activity (option --profile) */
+unsigned long long prof_other_ns[PROF_NR];
+unsigned long long prof_other_calls[PROF_NR];
+/* Total time accounted for so far, all phases and activities included */
+unsigned long long prof_done_ns = 0;
+
 /*
  ***************************************************************************
  * Allocate structures.
@@ -815,7 +975,7 @@ void print_report_hdr(uint64_t flags, struct tm *rectime,
  * registered again on the interval.
  ***************************************************************************
  */
-int check_net_dev_reg(struct activity *a, int curr, int ref, int pos)
+static int do_check_net_dev_reg(struct activity *a, int curr, int ref, int pos)
 {
 	struct stats_net_dev *sndc, *sndp;
 	int j0, j = pos;
@@ -909,6 +1069,36 @@ int check_net_dev_reg(struct activity *a, int curr, int ref, int pos)
 	return -1;
 }
 
+/*
+ ***************************************************************************
+ * Wrapper for do_check_net_dev_reg(): Account for the time spent looking up
+ * current network interface when option --profile is used.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @curr	Index in array for current sample statistics.
+ * @ref		Index in array for sample statistics used as reference.
+ * @pos		Index on current network interface.
+ *
+ * RETURNS:
+ * Same as do_check_net_dev_reg().
+ ***************************************************************************
+ */
+int check_net_dev_reg(struct activity *a, int curr, int ref, int pos)
+{
+	struct prof_ts ts;
+	int rc;
+
+	if (!prof_enabled)
+		return do_check_net_dev_reg(a, curr, ref, pos);
+
+	PROF_START(ts);
+	rc = do_check_net_dev_reg(a, curr, ref, pos);
+	PROF_STOP(ts, a, PROF_MATCH);
+
+	return rc;
+}
+
 /*
  ***************************************************************************
  * Network interfaces may now be registered (and unregistered) dynamically.
@@ -928,7 +1118,7 @@ int check_net_dev_reg(struct activity *a, int curr, int ref, int pos)
  * registered again on the interval.
  ***************************************************************************
  */
-int check_net_edev_reg(struct activity *a, int curr, int ref, int pos)
+static int do_check_net_edev_reg(struct activity *a, int curr, int ref, int pos)
 {
 	struct stats_net_edev *snedc, *snedp;
 	int j0, j = pos;
@@ -982,6 +1172,36 @@ int check_net_edev_reg(struct activity *a, int curr, int ref, int pos)
 	return -1;
 }
 
+/*
+ ***************************************************************************
+ * Wrapper for do_check_net_edev_reg(): Account for the time spent looking up
+ * current network interface when option --profile is used.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @curr	Index in array for current sample statistics.
+ * @ref		Index in array for sample statistics used as reference.
+ * @pos		Index on current network interface.
+ *
+ * RETURNS:
+ * Same as do_check_net_edev_reg().
+ ***************************************************************************
+ */
+int check_net_edev_reg(struct activity *a, int curr, int ref, int pos)
+{
+	struct prof_ts ts;
+	int rc;
+
+	if (!prof_enabled)
+		return do_check_net_edev_reg(a, curr, ref, pos);
+
+	PROF_START(ts);
+	rc = do_check_net_edev_reg(a, curr, ref, pos);
+	PROF_STOP(ts, a, PROF_MATCH);
+
+	return rc;
+}
+
 /*
  ***************************************************************************
  * Disks may be registered dynamically (true in /proc/diskstats file).
@@ -1000,7 +1220,7 @@ int check_net_edev_reg(struct activity *a, int curr, int ref, int pos)
  * again on the interval.
  ***************************************************************************
  */
-int check_disk_reg(struct activity *a, int curr, int ref, int pos)
+static int do_check_disk_reg(struct activity *a, int curr, int ref, int pos)
 {
 	struct stats_disk *sdc, *sdp;
 	int j0, j = pos;
@@ -1053,6 +1273,36 @@ int check_disk_reg(struct activity *a, int curr, int ref, int pos)
 	return -1;
 }
 
+/*
+ ***************************************************************************
+ * Wrapper for do_check_disk_reg(): Account for the time spent looking up
+ * current disk when option --profile is used.
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @curr	Index in array for current sample statistics.
+ * @ref		Index in array for sample statistics used as reference.
+ * @pos		Index on current disk.
+ *
+ * RETURNS:
+ * Same as do_check_disk_reg().
+ ***************************************************************************
+ */
+int check_disk_reg(struct activity *a, int curr, int ref, int pos)
+{
+	struct prof_ts ts;
+	int rc;
+
+	if (!prof_enabled)
+		return do_check_disk_reg(a, curr, ref, pos);
+
+	PROF_START(ts);
+	rc = do_check_disk_reg(a, curr, ref, pos);
+	PROF_STOP(ts, a, PROF_MATCH);
+
+	return rc;
+}
+
 /*
  ***************************************************************************
  * Allocate bitmaps for activities that have one.
@@ -1374,6 +1624,123 @@ int sa_fread(int ifd, void *buffer, size_t size, int mode, int oneof)
 	return 0;
 }
 
+/*
+ ***************************************************************************
+ * Start measuring the time spent in a phase (option --profile).
+ *
+ * OUT:
+ * @ts		Time when the phase started.
+ ***************************************************************************
+ */
+void prof_start(struct prof_ts *ts)
+{
+	clock_gettime(CLOCK_MONOTONIC, &ts->ts);
+	ts->done_ns = prof_done_ns;
+}
+
+/*
+ ***************************************************************************
+ * Account for the time spent in a phase since @ts (option --profile).
+ * Time already accounted for by phases nested inside this one is not
+ * counted again.
+ *
+ * IN:
+ * @ts		Time when the phase started.
+ * @a		Activity the phase has been performed for. NULL if the
+ *		phase is not related to a particular activity (e.g. reading
+ *		record headers).
+ * @phase	Phase (PROF_READ, PROF_DECODE...)
+ ***************************************************************************
+ */
+void prof_add(struct prof_ts *ts, struct activity *a, int phase)
+{
+	struct timespec now;
+	unsigned long long *ns, *calls, elapsed, nested;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	elapsed = (now.tv_sec - ts->ts.tv_sec) * 1000000000ULL + now.tv_nsec - ts->ts.tv_nsec;
+	nested = prof_done_ns - ts->done_ns;
+	elapsed = (elapsed > nested) ? elapsed - nested : 0;
+
+	if (a) {
+		ns = &a->prof_ns[phase];
+		calls = &a->prof_calls[phase];
+	}
+	else {
+		ns = &prof_other_ns[phase];
+		calls = &prof_other_calls[phase];
+	}
+	*ns += elapsed;
+	(*calls)++;
+	prof_done_ns += elapsed;
+}
+
+/*
+ ***************************************************************************
+ * Display on stderr the time spent in each phase and for each activity
+ * (option --profile).
+ *
+ * IN:
+ * @act		Array of activities.
+ ***************************************************************************
+ */
+void print_profile(struct activity *act[])
+{
+	int i, j;
+	unsigned long long tot_ns[PROF_NR], tot_calls[PROF_NR];
+	char *phase_name[PROF_NR] = {"read", "decode", "match", "print"};
+
+	fprintf(stderr, "%-16s", "Activity");
+	for (j = 0; j < PROF_NR; j++) {
+		fprintf(stderr, " %8s(ms) %10s", phase_name[j], "calls");
+	}
+	fprintf(stderr, "\n");
+
+	for (j = 0; j < PROF_NR; j++) {
+		tot_ns[j] = prof_other_ns[j];
+		tot_calls[j] = prof_other_calls[j];
+	}
+
+	for (i = 0; i <= NR_ACT; i++) {
+		unsigned long long *ns, *calls;
+		char *name;
+
+		if (i < NR_ACT) {
+			ns = act[i]->prof_ns;
+			calls = act[i]->prof_calls;
+			name = act[i]->name;
+
+			for (j = 0; j < PROF_NR; j++) {
+				tot_ns[j] += ns[j];
+				tot_calls[j] += calls[j];
+			}
+		}
+		else {
+			/* Phases not related to a particular activity */
+			ns = prof_other_ns;
+			calls = prof_other_calls;
+			name = "(other)";
+		}
+
+		for (j = 0; (j < PROF_NR) && !calls[j]; j++);
+		if (j == PROF_NR)
+			/* Activity not used */
+			continue;
+
+		fprintf(stderr, "%-16s", name);
+		for (j = 0; j < PROF_NR; j++) {
+			fprintf(stderr, " %12.3f %10llu", (double) ns[j] / 1000000, calls[j]);
+		}
+		fprintf(stderr, "\n");
+	}
+
+	fprintf(stderr, "%-16s", "Total");
+	for (j = 0; j < PROF_NR; j++) {
+		fprintf(stderr, " %12.3f %10llu", (double) tot_ns[j] / 1000000, tot_calls[j]);
+	}
+	fprintf(stderr, "\n");
+}
+
 /*
  ***************************************************************************
  * Skip unknown extra structures present in file.
@@ -1434,6 +1801,162 @@ int skip_extra_struct(int ifd, int endian_mismatch, int arch_64)
 	return 0;
 }
 
+/*
+ ***************************************************************************
+ * Free structures used to save CPU topology read from file.
+ ***************************************************************************
+ */
+void free_cpu_topology(void)
+{
+	int g;
+
+	for (g = 0; g < CPU_GRP_NR; g++) {
+		if (cpu_topo.cpu2grp[g]) {
+			free(cpu_topo.cpu2grp[g]);
+		}
+	}
+	memset(&cpu_topo, 0, sizeof(struct sa_cpu_topology));
+}
+
+/*
+ ***************************************************************************
+ * Save CPU topology if extra structures read from file are CPU topology
+ * ones.
+ *
+ * IN:
+ * @xtra_d	Description of the extra structures.
+ * @buf		Buffer containing the extra structures.
+ * @endian_mismatch
+ *		TRUE if file's data don't match current machine's endianness.
+ * @arch_64	TRUE if file's data come from a 64 bit machine.
+ *
+ * RETURNS:
+ * 1 if CPU topology has been saved, 0 otherwise.
+ ***************************************************************************
+ */
+int save_cpu_topology(struct extra_desc *xtra_d, void *buf, int endian_mismatch, int arch_64)
+{
+	int i, g, id[CPU_GRP_NR];
+	unsigned int cpu_nr = 0;
+	struct extra_cpu_topology *xtopo;
+
+	if (!xtra_d->extra_nr || (xtra_d->extra_size < EXTRA_CPU_TOPOLOGY_SIZE) ||
+	    (xtra_d->extra_types_nr[0] != EXTRA_CPU_TOPOLOGY_ULL_NR) ||
+	    (xtra_d->extra_types_nr[1] != EXTRA_CPU_TOPOLOGY_UL_NR) ||
+	    (xtra_d->extra_types_nr[2] < EXTRA_CPU_TOPOLOGY_U_NR))
+		return 0;
+
+	for (i = 0; i < xtra_d->extra_nr; i++) {
+		xtopo = (struct extra_cpu_topology *) ((char *) buf + i * xtra_d->extra_size);
+
+		if (endian_mismatch) {
+			swap_struct(xtra_d->extra_types_nr, xtopo, arch_64);
+		}
+		if ((xtopo->magic != EXTRA_CPU_TOPOLOGY_MAGIC) || (xtopo->cpu >= NR_CPUS))
+			/* Not a CPU topology structure */
+			return 0;
+
+		if (xtopo->cpu >= cpu_nr) {
+			cpu_nr = xtopo->cpu + 1;
+		}
+	}
+
+	free_cpu_topology();
+	cpu_topo.cpu_nr = cpu_nr;
+
+	for (g = 0; g < CPU_GRP_NR; g++) {
+		if ((cpu_topo.cpu2grp[g] = (int *) malloc(sizeof(int) * cpu_nr)) == NULL) {
+			perror("malloc");
+			exit(4);
+		}
+		/* CPU belongs to no group by default */
+		memset(cpu_topo.cpu2grp[g], -1, sizeof(int) * cpu_nr);
+	}
+
+	for (i = 0; i < xtra_d->extra_nr; i++) {
+		xtopo = (struct extra_cpu_topology *) ((char *) buf + i * xtra_d->extra_size);
+
+		id[CPU_GRP_NODE] = xtopo->node;
+		id[CPU_GRP_SOCK] = xtopo->package;
+
+		for (g = 0; g < CPU_GRP_NR; g++) {
+			if ((id[g] < 0) || (id[g] >= NR_CPUS))
+				continue;
+
+			cpu_topo.cpu2grp[g][xtopo->cpu] = id[g];
+			if (id[g] >= cpu_topo.grp_nr[g]) {
+				cpu_topo.grp_nr[g] = id[g] + 1;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/*
+ ***************************************************************************
+ * Read extra structures present in file after the file header. CPU
+ * topology is saved, other (unknown) extra structures are ignored.
+ *
+ * IN:
+ * @ifd		System activity data file descriptor.
+ * @endian_mismatch
+ *		TRUE if file's data don't match current machine's endianness.
+ * @arch_64	TRUE if file's data come from a 64 bit machine.
+ *
+ * RETURNS:
+ * -1 on error, 0 otherwise.
+ ***************************************************************************
+ */
+int read_hdr_extra_struct(int ifd, int endian_mismatch, int arch_64)
+{
+	struct extra_desc xtra_d;
+	void *buf = NULL;
+	size_t buf_size = 0;
+
+	do {
+		/* Read extra structure description */
+		sa_fread(ifd, &xtra_d, EXTRA_DESC_SIZE, HARD_SIZE, UEOF_STOP);
+
+		if (endian_mismatch) {
+			swap_struct(extra_desc_types_nr, &xtra_d, arch_64);
+		}
+
+		/* Check values consistency */
+		if ((MAP_SIZE(xtra_d.extra_types_nr) > xtra_d.extra_size) ||
+		    (xtra_d.extra_nr > MAX_EXTRA_NR) || (xtra_d.extra_size > MAX_EXTRA_SIZE)) {
+#ifdef DEBUG
+			fprintf(stderr, "%s: extra_size=%u extra_nr=%u types=%d,%d,%d\n",
+				__FUNCTION__, xtra_d.extra_size, xtra_d.extra_nr,
+				xtra_d.extra_types_nr[0], xtra_d.extra_types_nr[1], xtra_d.extra_types_nr[2]);
+#endif
+			if (buf) {
+				free(buf);
+			}
+			return -1;
+		}
+
+		if (!xtra_d.extra_nr)
+			continue;
+
+		if ((size_t) xtra_d.extra_nr * xtra_d.extra_size > buf_size) {
+			buf_size = (size_t) xtra_d.extra_nr * xtra_d.extra_size;
+			SREALLOC(buf, void, buf_size);
+		}
+
+		/* Read extra structures then save them if they are known ones */
+		sa_fread(ifd, buf, (size_t) xtra_d.extra_nr * xtra_d.extra_size, HARD_SIZE, UEOF_STOP);
+		save_cpu_topology(&xtra_d, buf, endian_mismatch, arch_64);
+	}
+	while (xtra_d.extra_next);
+
+	if (buf) {
+		free(buf);
+	}
+
+	return 0;
+}
+
 /*
  ***************************************************************************
  * Read the record header of current sample and process it.
@@ -1468,13 +1991,17 @@ int read_record_hdr(int ifd, void *buffer, struct record_header *record_hdr,
 		    int oneof, size_t b_size, uint64_t flags, struct report_format *ofmt)
 {
 	int rc;
+	struct prof_ts ts;
 
 	do {
+		PROF_START(ts);
 		if ((rc = sa_fread(ifd, buffer, (size_t) file_hdr->rec_size, SOFT_SIZE, oneof)) != 0)
 			/* End of sa data file */
 			return rc;
+		PROF_STOP(ts, NULL, PROF_READ);
 
 		/* Remap record header structure to that expected by current version */
+		PROF_START(ts);
 		if (remap_struct(rec_types_nr, file_hdr->rec_types_nr, buffer,
 				 file_hdr->rec_size, RECORD_HEADER_SIZE, b_size) < 0)
 			return 2;
@@ -1484,6 +2011,7 @@ int read_record_hdr(int ifd, void *buffer, struct record_header *record_hdr,
 		if (endian_mismatch) {
 			swap_struct(rec_types_nr, record_hdr, arch_64);
 		}
+		PROF_STOP(ts, NULL, PROF_DECODE);
 
 		/* Raw output in debug mode */
 		if (DISPLAY_DEBUG_MODE(flags) && (ofmt->id == F_RAW_OUTPUT)) {
@@ -1628,9 +2156,14 @@ int read_file_stat_bunch(struct activity *act[], int curr, int ifd, int act_nr,
 	struct file_activity *fal = file_actlst;
 	off_t offset;
 	__nr_t nr_value;
+	struct prof_ts ts;
+
+	SA_PROBE1(record__start, act_nr);
 
 	for (i = 0; i < act_nr; i++, fal++) {
 
+		PROF_START(ts);
+
 		/* Read __nr_t value preceding statistics structures if it exists */
 		if (fal->has_nr) {
 			nr_value = read_nr_value(ifd, dfile, file_magic,
@@ -1663,6 +2196,7 @@ int read_file_stat_bunch(struct activity *act[], int curr, int ifd, int act_nr,
 					exit(2);
 				}
 			}
+			PROF_STOP(ts, NULL, PROF_READ);
 			continue;
 		}
 
@@ -1715,10 +2249,13 @@ int read_file_stat_bunch(struct activity *act[], int curr, int ifd, int act_nr,
 		}
 		else {
 			/* nr_value == 0: Nothing to read */
+			PROF_STOP(ts, act[p], PROF_READ);
 			continue;
 		}
+		PROF_STOP(ts, act[p], PROF_READ);
 
 		/* Normalize endianness for current activity's structures */
+		PROF_START(ts);
 		if (endian_mismatch) {
 			for (j = 0; j < (nr_value * act[p]->nr2); j++) {
 				swap_struct(act[p]->ftypes_nr, (char *) act[p]->buf[curr] + j * act[p]->msize,
@@ -1733,8 +2270,11 @@ int read_file_stat_bunch(struct activity *act[], int curr, int ifd, int act_nr,
 					 act[p]->fsize, act[p]->msize, act[p]->msize) < 0)
 				return 2;
 		}
+		PROF_STOP(ts, act[p], PROF_DECODE);
 	}
 
+	SA_PROBE1(record__end, act_nr);
+
 	return 0;
 }
 
@@ -2137,9 +2677,10 @@ void check_file_actlst(int *ifd, char *dfile, struct activity *act[], uint64_t f
 
 	/*
 	 * Check if there are some extra structures.
-	 * We will just skip them as they are unknown for now.
+	 * CPU topology is saved, unknown extra structures are skipped.
 	 */
-	if (file_hdr->extra_next && (skip_extra_struct(*ifd, *endian_mismatch, *arch_64) < 0))
+	free_cpu_topology();
+	if (file_hdr->extra_next && (read_hdr_extra_struct(*ifd, *endian_mismatch, *arch_64) < 0))
 		goto format_error;
 
 	return;
@@ -2196,7 +2737,7 @@ int parse_sar_opt(char *argv[], int *opt, struct activity *act[],
 			act[p]->opt_flags |= AO_F_MEMORY + AO_F_SWAP + AO_F_MEM_ALL;
 
 			p = get_activity_position(act, A_CPU, EXIT_IF_NOT_FOUND);
-			act[p]->opt_flags = AO_F_CPU_ALL;
+			act[p]->opt_flags = (act[p]->opt_flags & AO_F_CPU_GRP) | AO_F_CPU_ALL;
 
 			p = get_activity_position(act, A_FS, EXIT_IF_NOT_FOUND);
 			act[p]->opt_flags = AO_F_FILESYSTEM;
@@ -2309,11 +2850,11 @@ int parse_sar_opt(char *argv[], int *opt, struct activity *act[],
 			act[p]->options |= AO_SELECTED;
 			if (!*(argv[*opt] + i + 1) && argv[*opt + 1] && !strcmp(argv[*opt + 1], K_ALL)) {
 				(*opt)++;
-				act[p]->opt_flags = AO_F_CPU_ALL;
+				act[p]->opt_flags = (act[p]->opt_flags & AO_F_CPU_GRP) | AO_F_CPU_ALL;
 				return 0;
 			}
 			else {
-				act[p]->opt_flags = AO_F_CPU_DEF;
+				act[p]->opt_flags = (act[p]->opt_flags & AO_F_CPU_GRP) | AO_F_CPU_DEF;
 			}
 			break;
 
@@ -2635,6 +3176,49 @@ int parse_sa_P_opt(char *argv[], int *opt, uint64_t *flags, struct activity *act
 	return 1;
 }
 
+/*
+ ***************************************************************************
+ * Parse option --topology (used by sar and sadf).
+ *
+ * IN:
+ * @argv	Arguments list.
+ * @opt		Index in list of arguments.
+ *
+ * OUT:
+ * @act		Array of activities. A_CPU output flags are updated.
+ *
+ * RETURNS:
+ * 0 on success, 1 otherwise.
+ ***************************************************************************
+ */
+int parse_sa_topology_opt(char *argv[], int *opt, struct activity *act[])
+{
+	int p;
+	char *t;
+
+	p = get_activity_position(act, A_CPU, EXIT_IF_NOT_FOUND);
+
+	if (!argv[*opt][11])
+		return 1;
+
+	for (t = strtok(argv[*opt] + 11, ","); t; t = strtok(NULL, ",")) {
+		if (!strcmp(t, K_NODE)) {
+			act[p]->opt_flags |= AO_F_CPU_NODE;
+		}
+		else if (!strcmp(t, K_SOCK)) {
+			act[p]->opt_flags |= AO_F_CPU_SOCK;
+		}
+		else if (!strcmp(t, K_ALL)) {
+			act[p]->opt_flags |= AO_F_CPU_GRP;
+		}
+		else
+			return 1;
+	}
+	(*opt)++;
+
+	return 0;
+}
+
 /*
  ***************************************************************************
  * If option -A has been used, force -P ALL -I ALL only if corresponding
@@ -3207,6 +3791,62 @@ unsigned long long get_global_cpu_statistics(struct activity *a, int prev, int c
 	return deltot_jiffies;
 }
 
+/*
+ ***************************************************************************
+ * Compute statistics for groups of CPU (nodes or sockets) as the sum of
+ * individual CPU ones, using CPU topology read from file.
+ * Global CPU statistics must have been computed before (see function
+ * get_global_cpu_statistics()).
+ *
+ * IN:
+ * @a		Activity structure with statistics.
+ * @prev	Index in array where stats used as reference are.
+ * @curr	Index in array for current sample statistics.
+ * @flags	Flags for common options and system state.
+ * @grp		Type of group of CPU (CPU_GRP_NODE, CPU_GRP_SOCK).
+ * @offline_cpu_bitmap
+ *		CPU bitmap for offline CPU (see get_global_cpu_statistics()).
+ *
+ * OUT:
+ * @sgp		Array with reference statistics for each group. First item
+ *		is for group "all".
+ * @sgc		Array with current statistics for each group.
+ *
+ * RETURNS:
+ * Number of groups (not including group "all"). 0 if CPU topology is
+ * unknown.
+ ***************************************************************************
+ */
+int get_cpu_grp_statistics(struct activity *a, int prev, int curr, uint64_t flags,
+			   int grp, unsigned char offline_cpu_bitmap[],
+			   struct stats_cpu **sgp, struct stats_cpu **sgc)
+{
+	static struct stats_cpu *grp_buf[2] = {NULL, NULL};
+	static int grp_buf_nr = 0;
+	int nr_cpus;
+
+	if ((a->nr_ini <= 1) || !cpu_topo.grp_nr[grp])
+		return 0;
+
+	if (cpu_topo.grp_nr[grp] > grp_buf_nr) {
+		grp_buf_nr = cpu_topo.grp_nr[grp];
+		SREALLOC(grp_buf[0], struct stats_cpu, STATS_CPU_SIZE * (grp_buf_nr + 1));
+		SREALLOC(grp_buf[1], struct stats_cpu, STATS_CPU_SIZE * (grp_buf_nr + 1));
+	}
+
+	nr_cpus = MINIMUM(a->nr_ini - 1, cpu_topo.cpu_nr);
+
+	set_node_cpu_stats(a->buf[prev], a->buf[curr], a->msize, nr_cpus,
+			   cpu_topo.cpu2grp[grp], cpu_topo.grp_nr[grp],
+			   grp_buf[0], grp_buf[1], !WANT_SINCE_BOOT(flags),
+			   offline_cpu_bitmap);
+
+	*sgp = grp_buf[0];
+	*sgc = grp_buf[1];
+
+	return cpu_topo.grp_nr[grp];
+}
+
 /*
  ***************************************************************************
  * Compute softnet statistics for CPU "all" as the sum of individual CPU
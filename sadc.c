@@ -33,9 +33,15 @@
 #include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/utsname.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
 
 #include "version.h"
 #include "sa.h"
+#include "om_stats.h"
 
 #ifdef USE_NLS
 #include <locale.h>
@@ -84,6 +90,19 @@ extern __nr_t (*f_count[]) (struct activity *);
 
 struct sigaction alrm_act, int_act;
 int sigint_caught = 0;
+volatile sig_atomic_t alarm_caught = 0;
+
+/* Address where statistics are served in OpenMetrics format (--metrics option) */
+char metrics_addr[MAX_FILE_LEN];
+int metrics_fd = -1;
+/*
+ * Pipe written to by signal handlers so that a signal received just before
+ * poll() is called doesn't get lost (self-pipe trick).
+ */
+int metrics_pipe[2] = {-1, -1};
+struct om_buf metrics_buf;
+/* Number of items allocated for the previous sample of each activity (buf[1]) */
+__nr_t metrics_alloc[NR_ACT];
 
 /*
  ***************************************************************************
@@ -100,7 +119,8 @@ void usage(char *progname)
 
 	fprintf(stderr, _("Options are:\n"
 			  "[ -C <comment> ] [ -D ] [ -F ] [ -f ] [ -L ] [ -V ]\n"
-			  "[ -S { INT | DISK | IPV6 | POWER | SNMP | XDISK | ALL | XALL } ]\n"));
+			  "[ -S { INT | DISK | IPV6 | POWER | SNMP | TOPOLOGY | XDISK | ALL | XALL } ]\n"
+			  "[ --metrics={ <socket_path> | <port> } ]\n"));
 	exit(1);
 }
 
@@ -166,6 +186,10 @@ void parse_sadc_S_option(char *argv[], int opt)
 			/* Select group of activities related to power management */
 			collect_group_activities(G_POWER, AO_F_NULL);
 		}
+		else if (!strcmp(p, K_TOPOLOGY)) {
+			/* Save CPU topology in file header */
+			flags |= S_F_CPU_TOPOLOGY;
+		}
 		else if (!strcmp(p, K_ALL) || !strcmp(p, K_XALL)) {
 			/* Select all activities */
 			for (i = 0; i < NR_ACT; i++) {
@@ -220,6 +244,22 @@ void parse_sadc_S_option(char *argv[], int opt)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Wake up serve_metrics() if it is waiting for a request: Called by signal
+ * handlers.
+ ***************************************************************************
+ */
+void wake_metrics_loop(void)
+{
+	int save_errno = errno;
+
+	if ((metrics_pipe[1] >= 0) && (write(metrics_pipe[1], "", 1) < 0)) {
+		/* Pipe is non-blocking and already full: poll() won't block anyway */
+	}
+	errno = save_errno;
+}
+
 /*
  ***************************************************************************
  * SIGALRM signal handler. No need to reset handler here.
@@ -230,6 +270,8 @@ void parse_sadc_S_option(char *argv[], int opt)
  */
 void alarm_handler(int sig)
 {
+	alarm_caught = 1;
+	wake_metrics_loop();
 	__alarm(interval);
 }
 
@@ -246,6 +288,7 @@ void int_handler(int sig)
 	pid_t ppid = getppid();
 
 	sigint_caught = 1;
+	wake_metrics_loop();
 
 	if (!optz || (ppid == 1)) {
 		/* sadc hasn't been called by sar or sar process is already dead */
@@ -399,6 +442,11 @@ void sa_sys_free(void)
 				act[i]->nr_allocated = 0;
 			}
 		}
+		if (act[i]->buf[1]) {
+			free(act[i]->buf[1]);
+			act[i]->buf[1] = NULL;
+			metrics_alloc[i] = 0;
+		}
 	}
 }
 
@@ -471,6 +519,63 @@ void fill_magic_header(struct file_magic *file_magic)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Get CPU topology (node, logical core and physical package each CPU
+ * belongs to). It will be saved as extra structures after the activity
+ * list in file header.
+ *
+ * IN:
+ * @nr_cpus	Number of CPU on this machine.
+ *
+ * OUT:
+ * @xtopo	Array of extra structures with CPU topology (allocated
+ *		here, to be freed by caller).
+ *
+ * RETURNS:
+ * Number of extra structures in @xtopo.
+ ***************************************************************************
+ */
+int get_extra_cpu_topology(int nr_cpus, struct extra_cpu_topology **xtopo)
+{
+	int cpu;
+	int *cpu_per_node, *cpu2node;
+	struct cpu_topology *cpu_topo;
+
+	if (nr_cpus > MAX_EXTRA_NR) {
+		nr_cpus = MAX_EXTRA_NR;
+	}
+
+	if (((cpu_per_node = (int *) malloc(sizeof(int) * (nr_cpus + 1))) == NULL) ||
+	    ((cpu2node = (int *) malloc(sizeof(int) * nr_cpus)) == NULL) ||
+	    ((cpu_topo = (struct cpu_topology *) malloc(sizeof(struct cpu_topology) * nr_cpus)) == NULL) ||
+	    ((*xtopo = (struct extra_cpu_topology *) malloc(EXTRA_CPU_TOPOLOGY_SIZE * nr_cpus)) == NULL)) {
+		perror("malloc");
+		exit(4);
+	}
+
+	if (get_node_placement(nr_cpus, cpu_per_node, cpu2node) < 0) {
+		/* No nodes found */
+		memset(cpu2node, -1, sizeof(int) * nr_cpus);
+	}
+	read_topology(nr_cpus, cpu_topo);
+
+	memset(*xtopo, 0, EXTRA_CPU_TOPOLOGY_SIZE * nr_cpus);
+	for (cpu = 0; cpu < nr_cpus; cpu++) {
+		(*xtopo)[cpu].magic   = EXTRA_CPU_TOPOLOGY_MAGIC;
+		(*xtopo)[cpu].cpu     = cpu;
+		(*xtopo)[cpu].node    = cpu2node[cpu];
+		(*xtopo)[cpu].core    = cpu_topo[cpu].logical_core_id;
+		(*xtopo)[cpu].package = cpu_topo[cpu].phys_package_id;
+	}
+
+	free(cpu_per_node);
+	free(cpu2node);
+	free(cpu_topo);
+
+	return nr_cpus;
+}
+
 /*
  ***************************************************************************
  * Fill system activity file header, then write it (or print it if stdout).
@@ -481,11 +586,13 @@ void fill_magic_header(struct file_magic *file_magic)
  */
 void setup_file_hdr(int fd)
 {
-	int i, j, p;
+	int i, j, p, xtopo_nr = 0;
 	struct tm rectime;
 	struct utsname header;
 	struct file_magic file_magic;
 	struct file_activity file_act;
+	struct extra_desc xtra_d;
+	struct extra_cpu_topology *xtopo = NULL;
 
 	/* Fill then write file magic header */
 	fill_magic_header(&file_magic);
@@ -521,7 +628,18 @@ void setup_file_hdr(int fd)
 	 * online or offline, when sadc was started.
 	 * A_CPU activity is always counted in sa_sys_init(), even if it's not collected.
 	 */
-	file_hdr.sa_cpu_nr = act[get_activity_position(act, A_CPU, EXIT_IF_NOT_FOUND)]->nr_ini;
+	p = get_activity_position(act, A_CPU, EXIT_IF_NOT_FOUND);
+	file_hdr.sa_cpu_nr = act[p]->nr_ini;
+
+	/*
+	 * Save CPU topology (on SMP machines) so that sar and sadf can display
+	 * statistics for each node or socket. This is done only if explicitly
+	 * requested since older sysstat versions cannot read extra structures.
+	 */
+	if (WANT_CPU_TOPOLOGY(flags) && IS_COLLECTED(act[p]->options) && (act[p]->nr_ini > 1)) {
+		xtopo_nr = get_extra_cpu_topology(act[p]->nr_ini - 1, &xtopo);
+	}
+	file_hdr.extra_next = (xtopo_nr > 0);
 
 	/* Get system name, release number, hostname and machine architecture */
 	__uname(&header);
@@ -577,6 +695,22 @@ void setup_file_hdr(int fd)
 		}
 	}
 
+	if (xtopo_nr) {
+		/* Write CPU topology as extra structures */
+		memset(&xtra_d, 0, EXTRA_DESC_SIZE);
+		xtra_d.extra_nr          = xtopo_nr;
+		xtra_d.extra_size        = EXTRA_CPU_TOPOLOGY_SIZE;
+		xtra_d.extra_types_nr[0] = EXTRA_CPU_TOPOLOGY_ULL_NR;
+		xtra_d.extra_types_nr[1] = EXTRA_CPU_TOPOLOGY_UL_NR;
+		xtra_d.extra_types_nr[2] = EXTRA_CPU_TOPOLOGY_U_NR;
+
+		if ((write_all(fd, &xtra_d, EXTRA_DESC_SIZE) != EXTRA_DESC_SIZE) ||
+		    (write_all(fd, xtopo, EXTRA_CPU_TOPOLOGY_SIZE * xtopo_nr) != EXTRA_CPU_TOPOLOGY_SIZE * xtopo_nr)) {
+			p_write_error();
+		}
+		free(xtopo);
+	}
+
 	return;
 }
 
@@ -662,6 +796,7 @@ void write_special_record(int ofd, int rtype)
 void write_stats(int ofd)
 {
 	int i, p;
+	size_t bytes = RECORD_HEADER_SIZE;
 
 	/* Try to lock file */
 	if (!FILE_LOCKED(flags)) {
@@ -672,6 +807,7 @@ void write_stats(int ofd)
 			 */
 			return;
 	}
+	SA_PROBE1(write__start, ofd);
 
 	/* Write record header */
 	if (write_all(ofd, &record_hdr, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE) {
@@ -691,13 +827,16 @@ void write_stats(int ofd)
 				if (write_all(ofd, &(act[p]->_nr0), sizeof(__nr_t)) != sizeof(__nr_t)) {
 					p_write_error();
 				}
+				bytes += sizeof(__nr_t);
 			}
 			if (write_all(ofd, act[p]->_buf0, act[p]->fsize * act[p]->_nr0 * act[p]->nr2) !=
 			    (act[p]->fsize * act[p]->_nr0 * act[p]->nr2)) {
 				p_write_error();
 			}
+			bytes += act[p]->fsize * act[p]->_nr0 * act[p]->nr2;
 		}
 	}
+	SA_PROBE2(write__end, ofd, bytes);
 }
 
 /*
@@ -1034,12 +1173,262 @@ void read_stats(void)
 	/* Read system uptime in 1/100th of a second */
 	read_uptime(&(record_hdr.uptime_cs));
 
+	/* hwmon devices are checked once per sample for fans, temperature and voltage inputs */
+	sensors_new_sample();
+
 	for (i = 0; i < NR_ACT; i++) {
 		if (IS_COLLECTED(act[i]->options)) {
 			/* Read statistics for current activity */
+			SA_PROBE1(read__start, act[i]->id);
 			(*act[i]->f_read)(act[i]);
+			SA_PROBE2(read__end, act[i]->id, act[i]->_nr0);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Open the socket where statistics will be served in OpenMetrics format.
+ * If @metrics_addr contains only digits, it is a TCP port number on the
+ * loopback interface. Otherwise it is the path of a Unix domain socket.
+ ***************************************************************************
+ */
+void open_metrics_socket(void)
+{
+	struct sockaddr_un sun;
+	struct sockaddr_in sin;
+	struct stat st;
+	int opt = 1, rc;
+
+	SREALLOC(metrics_buf.buf, char, OM_BUF_SIZE);
+	metrics_buf.size = OM_BUF_SIZE;
+	metrics_buf.len = 0;
+
+#ifdef TEST
+	if (!strcmp(metrics_addr, "-"))
+		/* Statistics are displayed on stdout by render_metrics() */
+		return;
+#endif
+
+	if (strspn(metrics_addr, DIGITS) == strlen(metrics_addr)) {
+		/* Listen on 127.0.0.1:<port> */
+		memset(&sin, 0, sizeof(sin));
+		sin.sin_family = AF_INET;
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		sin.sin_port = htons((unsigned short) atoi(metrics_addr));
+
+		if ((metrics_fd = socket(AF_INET, SOCK_STREAM, 0)) >= 0) {
+			setsockopt(metrics_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+			rc = bind(metrics_fd, (struct sockaddr *) &sin, sizeof(sin));
+		}
+	}
+	else {
+		if (strlen(metrics_addr) >= sizeof(sun.sun_path)) {
+			fprintf(stderr, _("Cannot open %s: %s\n"), metrics_addr, strerror(ENAMETOOLONG));
+			exit(2);
+		}
+		memset(&sun, 0, sizeof(sun));
+		sun.sun_family = AF_UNIX;
+		strcpy(sun.sun_path, metrics_addr);
+
+		if ((metrics_fd = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0) {
+			if (!lstat(metrics_addr, &st) && S_ISSOCK(st.st_mode)) {
+				/*
+				 * Remove a stale socket left by a previous instance of sadc,
+				 * but not the socket of an instance still running.
+				 */
+				if (!connect(metrics_fd, (struct sockaddr *) &sun, sizeof(sun))) {
+					fprintf(stderr, _("Cannot open %s: %s\n"),
+						metrics_addr, strerror(EADDRINUSE));
+					exit(2);
+				}
+				unlink(metrics_addr);
+
+				/* A socket cannot be reused after a failed connect() */
+				close(metrics_fd);
+				metrics_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			}
+			if (metrics_fd >= 0) {
+				rc = bind(metrics_fd, (struct sockaddr *) &sun, sizeof(sun));
+			}
+		}
+	}
+
+	if ((metrics_fd < 0) || (rc < 0) || (listen(metrics_fd, 8) < 0)) {
+		fprintf(stderr, _("Cannot open %s: %s\n"), metrics_addr, strerror(errno));
+		exit(2);
+	}
+
+	if ((pipe(metrics_pipe) < 0) ||
+	    (fcntl(metrics_pipe[0], F_SETFL, O_NONBLOCK) < 0) ||
+	    (fcntl(metrics_pipe[1], F_SETFL, O_NONBLOCK) < 0)) {
+		perror("pipe");
+		exit(4);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Close the socket where statistics are served in OpenMetrics format.
+ ***************************************************************************
+ */
+void close_metrics_socket(void)
+{
+	free(metrics_buf.buf);
+	metrics_buf.buf = NULL;
+	metrics_buf.size = metrics_buf.len = 0;
+
+	if (metrics_fd < 0)
+		return;
+
+	close(metrics_fd);
+	metrics_fd = -1;
+	close(metrics_pipe[0]);
+	close(metrics_pipe[1]);
+	metrics_pipe[0] = metrics_pipe[1] = -1;
+
+	if (strspn(metrics_addr, DIGITS) != strlen(metrics_addr)) {
+		unlink(metrics_addr);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Render statistics of the last sample in OpenMetrics format, then save
+ * them (in buf[1]) so that rates can be computed at next sample.
+ ***************************************************************************
+ */
+void render_metrics(void)
+{
+	static unsigned long long uptime_cs = 0;
+	unsigned long long itv;
+	size_t size;
+	int i;
+
+	/* Interval of time since previous sample (0 if there is none) */
+	itv = (uptime_cs && (record_hdr.uptime_cs > uptime_cs))
+	      ? record_hdr.uptime_cs - uptime_cs : 0;
+	uptime_cs = record_hdr.uptime_cs;
+
+	metrics_buf.len = 0;
+
+	for (i = 0; i < NR_ACT; i++) {
+
+		if (!IS_COLLECTED(act[i]->options) || !act[i]->f_om_print)
+			continue;
+
+		if (act[i]->_nr0 > 0) {
+			(*act[i]->f_om_print)(act[i], &metrics_buf, itv);
+		}
+
+		/* Keep current sample as previous one for next interval */
+		if (act[i]->nr_allocated > metrics_alloc[i]) {
+			SREALLOC(act[i]->buf[1], void,
+				 (size_t) act[i]->msize * (size_t) act[i]->nr_allocated * (size_t) act[i]->nr2);
+			metrics_alloc[i] = act[i]->nr_allocated;
+		}
+		if (act[i]->_nr0 > 0) {
+			size = (size_t) act[i]->msize * (size_t) act[i]->_nr0 * (size_t) act[i]->nr2;
+			memcpy(act[i]->buf[1], act[i]->_buf0, size);
+		}
+		act[i]->nr[1] = act[i]->_nr0;
+	}
+
+	om_printf(&metrics_buf, "# EOF\n");
+
+#ifdef TEST
+	if (!strcmp(metrics_addr, "-")) {
+		/* Display the statistics that would be served */
+		fwrite(metrics_buf.buf, 1, metrics_buf.len, stdout);
+		fflush(stdout);
+	}
+#endif
+}
+
+/*
+ ***************************************************************************
+ * Serve statistics in OpenMetrics format until a signal (probably SIGALRM
+ * or SIGINT) is received. Any request received on the socket is answered
+ * with the statistics of the last sample, using a minimal HTTP/1.0
+ * response.
+ ***************************************************************************
+ */
+void serve_metrics(void)
+{
+#ifdef TEST
+	__pause();
+#else
+	struct pollfd pfd[2];
+	struct timeval tv;
+	char hdr[256], req[1024];
+	int cfd, len, rc = 0;
+	size_t off;
+	ssize_t n;
+
+	pfd[0].fd = metrics_fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = metrics_pipe[0];
+	pfd[1].events = POLLIN;
+
+	/*
+	 * A signal received after the flags have been tested but before poll()
+	 * has been called has written to the pipe: poll() won't block then.
+	 */
+	while (!alarm_caught && !sigint_caught) {
+
+		if ((rc = poll(pfd, 2, -1)) < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (pfd[0].revents & (POLLERR | POLLNVAL)) {
+			rc = -1;
+			break;
 		}
+
+		if (pfd[1].revents) {
+			/* Signal received: Empty the pipe then check flags again */
+			while (read(metrics_pipe[0], req, sizeof(req)) > 0);
+			continue;
+		}
+
+		if (!(pfd[0].revents & POLLIN) ||
+		    ((cfd = accept(metrics_fd, NULL, NULL)) < 0))
+			continue;
+
+		/* Don't let a slow client delay next sample */
+		tv.tv_sec = 1;
+		tv.tv_usec = 0;
+		setsockopt(cfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		setsockopt(cfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+		/* Whatever the request, the answer is the same */
+		if (recv(cfd, req, sizeof(req), 0) >= 0) {
+			len = snprintf(hdr, sizeof(hdr),
+				       "HTTP/1.0 200 OK\r\n"
+				       "Content-Type: " OM_CONTENT_TYPE "\r\n"
+				       "Content-Length: %zu\r\n"
+				       "Connection: close\r\n\r\n",
+				       metrics_buf.len);
+
+			if (send(cfd, hdr, len, MSG_NOSIGNAL) == len) {
+				for (off = 0; off < metrics_buf.len; off += n) {
+					if ((n = send(cfd, metrics_buf.buf + off,
+						      metrics_buf.len - off, MSG_NOSIGNAL)) <= 0)
+						break;
+				}
+			}
+		}
+		close(cfd);
+	}
+
+	if (!alarm_caught && !sigint_caught && (rc < 0)) {
+		/* Unexpected error: Wait for next sample as usual */
+		pause();
 	}
+	alarm_caught = 0;
+#endif
 }
 
 /*
@@ -1079,6 +1468,7 @@ void rw_sa_stat_loop(long count, int stdfd, int ofd, char ofile[],
 		record_hdr.hour     = rectime.tm_hour;
 		record_hdr.minute   = rectime.tm_min;
 		record_hdr.second   = rectime.tm_sec;
+		SA_PROBE1(sample__start, record_hdr.ust_time);
 
 		/* Set record type */
 		if (do_sa_rotat) {
@@ -1151,6 +1541,12 @@ void rw_sa_stat_loop(long count, int stdfd, int ofd, char ofile[],
 				exit(4);
 			}
 		}
+		SA_PROBE1(sample__end, record_hdr.ust_time);
+
+		if (metrics_addr[0]) {
+			/* Update statistics served in OpenMetrics format */
+			render_metrics();
+		}
 
 		if (count > 0) {
 			count--;
@@ -1158,7 +1554,12 @@ void rw_sa_stat_loop(long count, int stdfd, int ofd, char ofile[],
 
 		if (count) {
 			/* Wait for a signal (probably SIGALRM or SIGINT) */
-			__pause();
+			if (metrics_addr[0]) {
+				serve_metrics();
+			}
+			else {
+				__pause();
+			}
 		}
 
 		if (sigint_caught)
@@ -1256,6 +1657,14 @@ int main(int argc, char **argv)
 			flags |= S_F_FDATASYNC;
 		}
 
+		else if (!strncmp(argv[opt], "--metrics=", 10)) {
+			strncpy(metrics_addr, argv[opt] + 10, sizeof(metrics_addr));
+			metrics_addr[sizeof(metrics_addr) - 1] = '\0';
+			if (!strlen(metrics_addr)) {
+				usage(argv[0]);
+			}
+		}
+
 		else if (!strcmp(argv[opt], "-C")) {
 			if (!argv[++opt]) {
 				usage(argv[0]);
@@ -1418,6 +1827,11 @@ int main(int argc, char **argv)
 		exit(0);
 	}
 
+	if (metrics_addr[0]) {
+		/* Open socket where statistics will be served in OpenMetrics format */
+		open_metrics_socket();
+	}
+
 	/* Set a handler for SIGALRM */
 	memset(&alrm_act, 0, sizeof(alrm_act));
 	alrm_act.sa_handler = alarm_handler;
@@ -1429,9 +1843,13 @@ int main(int argc, char **argv)
 
 #if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
 	/* Cleanup sensors */
+	free_sensors_cache();
 	sensors_cleanup();
 #endif /* HAVE_SENSORS */
 
+	/* Close OpenMetrics socket */
+	close_metrics_socket();
+
 	/* Free structures */
 	sa_sys_free();
 
@@ -30,6 +30,7 @@
 
 #include "version.h"
 #include "sadf.h"
+#include "arrow_stats.h"
 
 # include <locale.h>	/* For setlocale() */
 #ifdef USE_NLS
@@ -90,6 +91,7 @@ char *args[MAX_ARGV_NR];
 
 extern struct activity *act[];
 extern struct report_format *fmt[];
+extern int prof_enabled;
 
 /*
  ***************************************************************************
@@ -106,9 +108,10 @@ void usage(char *progname)
 		progname);
 
 	fprintf(stderr, _("Options are:\n"
-			  "[ -C ] [ -c | -d | -g | -j | -l | -p | -r | -x ] [ -H ] [ -h ] [ -T | -t | -U ] [ -V ]\n"
+			  "[ -C ] [ -a | -c | -d | -g | -i | -j | -l | -p | -r | -x ] [ -H ] [ -h ] [ -T | -t | -U ] [ -V ]\n"
 			  "[ -O <opts> [,...] ] [ -P { <cpu> [,...] | ALL } ]\n"
 			  "[ --dev=<dev_list> ] [ --fs=<fs_list> ] [ --iface=<iface_list> ]\n"
+			  "[ --profile ] [ --topology={ NODE | SOCK | ALL } ]\n"
 			  "[ -s [ <hh:mm[:ss]> ] ] [ -e [ <hh:mm[:ss]> ] ]\n"
 			  "[ -- <sar_options> ]\n"));
 	exit(1);
@@ -655,6 +658,7 @@ int generic_write_stats(int curr, int use_tm_start, int use_tm_end, int reset,
 	unsigned long long dt, itv;
 	char cur_date[TIMESTAMP_LEN], cur_time[TIMESTAMP_LEN], *pre = NULL;
 	static int cross_day = FALSE;
+	struct prof_ts ts;
 
 	if (reset_cd) {
 		/*
@@ -719,6 +723,9 @@ int generic_write_stats(int curr, int use_tm_start, int use_tm_end, int reset,
 		    (IS_SELECTED(act[i]->options) && (act[i]->nr[curr] > 0)) ||
 		    (format == F_RAW_OUTPUT)) {
 
+			SA_PROBE1(print__start, act[i]->id);
+			PROF_START(ts);
+
 			if (format == F_JSON_OUTPUT) {
 				/* JSON output */
 				int *tab = (int *) parm;
@@ -768,10 +775,24 @@ int generic_write_stats(int curr, int use_tm_start, int use_tm_end, int reset,
 				}
 			}
 
+			else if (format == F_INFLUX_OUTPUT) {
+				/* InfluxDB line protocol */
+				(*act[i]->f_render)(act[i], RNDR_INFLUX, get_influx_prefix(act[i], pre),
+						    curr, itv);
+			}
+
+			else if (format == F_ARROW_OUTPUT) {
+				/* Arrow IPC stream */
+				(*act[i]->f_render)(act[i], RNDR_ARROW, pre, curr, itv);
+			}
+
 			else {
 				/* Other output formats: db, ppc */
 				(*act[i]->f_render)(act[i], (format == F_DB_OUTPUT), pre, curr, itv);
 			}
+
+			PROF_STOP(ts, act[i], PROF_PRINT);
+			SA_PROBE2(print__end, act[i]->id, act[i]->nr[curr]);
 		}
 	}
 
@@ -899,6 +920,7 @@ void display_curr_act_graphs(int ifd, int *curr, long *cnt, int *eosaf,
 			     int *g_nr, int nr_act_dispd)
 {
 	struct svg_parm parm;
+	struct prof_ts ts;
 	int rtype;
 	int next, reset_cd;
 
@@ -923,7 +945,9 @@ void display_curr_act_graphs(int ifd, int *curr, long *cnt, int *eosaf,
 	reset_cd = 1;
 
 	/* Allocate graphs arrays */
+	PROF_START(ts);
 	(*act[p]->f_svg_print)(act[p], !*curr, F_BEGIN, &parm, 0, &record_hdr[!*curr]);
+	PROF_STOP(ts, act[p], PROF_PRINT);
 
 	do {
 		*eosaf = read_next_sample(ifd, IGNORE_RESTART | IGNORE_COMMENT | SET_TIMESTAMPS,
@@ -977,7 +1001,9 @@ void display_curr_act_graphs(int ifd, int *curr, long *cnt, int *eosaf,
 	}
 
 	/* Actually display graphs for current activity */
+	PROF_START(ts);
 	(*act[p]->f_svg_print)(act[p], *curr, F_END, &parm, 0, &record_hdr[!*curr]);
+	PROF_STOP(ts, act[p], PROF_PRINT);
 
 	/* Update total number of graphs already displayed */
 	*g_nr = parm.graph_no;
@@ -1188,7 +1214,7 @@ terminate:
  * Display file contents in selected format (logic #2).
  * Logic #2:	Grouped by activity. Sorted by timestamp. Stop on RESTART
  * 		records.
- * Formats:	ppc, CSV, raw
+ * Formats:	ppc, CSV, raw, InfluxDB line protocol, Arrow
  *
  * NB: All statistics data for one activity will be displayed before
  * displaying stats for next activity. This is what sar does in its report.
@@ -1481,12 +1507,22 @@ void read_stats_from_file(char dfile[], char pcparchive[])
 		setlocale(LC_NUMERIC, "C");
 	}
 
+	if ((format == F_INFLUX_OUTPUT) || (format == F_ARROW_OUTPUT)) {
+		/* These output formats are meant for bulk loads: Use a large buffer */
+		setvbuf(stdout, NULL, _IOFBF, BULK_BUF_SIZE);
+	}
+
 	/* Call function corresponding to selected output format */
 	if (*fmt[f_position]->f_display) {
 		(*fmt[f_position]->f_display)(ifd, dfile, file_actlst, &file_magic,
 					      &rectime, pcparchive);
 	}
 
+	if (format == F_ARROW_OUTPUT) {
+		/* Write pending rows and terminate the stream */
+		arrow_end_stream();
+	}
+
 	close(ifd);
 
 	free(file_actlst);
@@ -1564,6 +1600,19 @@ int main(int argc, char **argv)
 			act[q]->options |= AO_LIST_ON_CMDLINE;
 		}
 
+		else if (!strncmp(argv[opt], "--topology=", 11)) {
+			/* Display statistics for each node and/or socket */
+			if (parse_sa_topology_opt(argv, &opt, act)) {
+				usage(argv[0]);
+			}
+		}
+
+		else if (!strcmp(argv[opt], "--profile")) {
+			/* Display time spent in each processing phase */
+			prof_enabled = TRUE;
+			opt++;
+		}
+
 		else if (!strcmp(argv[opt], "-s")) {
 			/* Get time start */
 			if (parse_timestamp(argv, &opt, &tm_start, DEF_TMSTART)) {
@@ -1713,6 +1762,13 @@ int main(int argc, char **argv)
 
 					switch (*(argv[opt] + i)) {
 
+					case 'a':
+						if (format) {
+							usage(argv[0]);
+						}
+						format = F_ARROW_OUTPUT;
+						break;
+
 					case 'C':
 						flags |= S_F_COMMENT;
 						break;
@@ -1746,6 +1802,13 @@ int main(int argc, char **argv)
 						flags |= S_F_HDR_ONLY;
 						break;
 
+					case 'i':
+						if (format) {
+							usage(argv[0]);
+						}
+						format = F_INFLUX_OUTPUT;
+						break;
+
 					case 'j':
 						if (format) {
 							usage(argv[0]);
@@ -1898,6 +1961,20 @@ int main(int argc, char **argv)
 	/* Check options consistency with selected output format. Default is PPC display */
 	check_format_options();
 
+	if ((format == F_ARROW_OUTPUT) &&
+	    (get_activity_nr(act, AO_SELECTED, COUNT_OUTPUTS) > 1)) {
+		/* All the rows of an Arrow stream have the same columns */
+		fprintf(stderr, _("Only one activity can be selected with option -a\n"));
+		exit(1);
+	}
+
+	/* Option --topology cannot be used with some output formats */
+	p = get_activity_position(act, A_CPU, EXIT_IF_NOT_FOUND);
+	if ((act[p]->opt_flags & AO_F_CPU_GRP) &&
+	    !ACCEPT_CPU_TOPOLOGY(fmt[f_position]->options)) {
+		usage(argv[0]);
+	}
+
 	if (interval < 0) {
 		interval = 1;
 	}
@@ -1911,6 +1988,10 @@ int main(int argc, char **argv)
 		read_stats_from_file(dfile, pcparchive);
 	}
 
+	if (prof_enabled) {
+		print_profile(act);
+	}
+
 	/* Free bitmaps */
 	free_bitmaps(act);
 
@@ -11,6 +11,9 @@
 /* DTD version for XML output */
 #define XML_DTD_VERSION	"3.9"
 
+/* Size of stdout buffer for output formats meant for bulk loads (influx, arrow) */
+#define BULK_BUF_SIZE	(1024 * 1024)
+
 /* Various constants */
 #define DO_SAVE		0
 #define DO_RESTORE	1
@@ -89,6 +92,12 @@
  */
 #define FO_FULL_ORDER		0x400
 
+/*
+ * Indicate that statistics for each node and/or socket may be displayed
+ * with CPU statistics if option --topology has been used.
+ */
+#define FO_CPU_TOPOLOGY		0x800
+
 #define SET_LC_NUMERIC_C(m)		(((m) & FO_LC_NUMERIC_C)	== FO_LC_NUMERIC_C)
 #define ACCEPT_HEADER_ONLY(m)		(((m) & FO_HEADER_ONLY)		== FO_HEADER_ONLY)
 #define ACCEPT_LOCAL_TIME(m)		(((m) & FO_LOCAL_TIME)		== FO_LOCAL_TIME)
@@ -99,6 +108,7 @@
 #define REJECT_TRUE_TIME(m)		(((m) & FO_NO_TRUE_TIME)	== FO_NO_TRUE_TIME)
 #define CREATE_ITEM_LIST(m)		(((m) & FO_ITEM_LIST)		== FO_ITEM_LIST)
 #define ORDER_ALL_RECORDS(m)		(((m) & FO_FULL_ORDER)		== FO_FULL_ORDER)
+#define ACCEPT_CPU_TOPOLOGY(m)		(((m) & FO_CPU_TOPOLOGY)	== FO_CPU_TOPOLOGY)
 
 
 /*
@@ -109,6 +119,10 @@
 
 void convert_file
 	(char [], struct activity *[]);
+char *get_influx_prefix
+	(struct activity *, char *);
+char *influx_escape
+	(const char *, const char *, char *, size_t);
 
 /*
  * Prototypes used to display restart messages
@@ -175,6 +189,12 @@ __tm_funct_t print_raw_timestamp
 __tm_funct_t print_pcp_timestamp
 	(void *, int, char *, char *, unsigned long long,
 	 struct record_header *, struct file_header *, unsigned int);
+__tm_funct_t print_influx_timestamp
+	(void *, int, char *, char *, unsigned long long,
+	 struct record_header *, struct file_header *, unsigned int);
+__tm_funct_t print_arrow_timestamp
+	(void *, int, char *, char *, unsigned long long,
+	 struct record_header *, struct file_header *, unsigned int);
 
 /*
  * Prototypes used to display the report header
@@ -24,6 +24,7 @@
 #include <time.h>
 
 #include "sadf.h"
+#include "arrow_stats.h"
 #include "pcp_def_metrics.h"
 
 #ifdef USE_NLS
@@ -1024,6 +1025,124 @@ __tm_funct_t print_raw_timestamp(void *parm, int action, char *cur_date,
 	return NULL;
 }
 
+/*
+ ***************************************************************************
+ * Display the "timestamp" part of the report (InfluxDB line protocol).
+ * Timestamps are expressed in nanoseconds since the epoch.
+ *
+ * IN:
+ * @parm	Pointer on specific parameters (unused here).
+ * @action	Action expected from current function.
+ * @cur_date	Date string of current record (unused here).
+ * @cur_time	Time string of current record (unused here).
+ * @itv		Interval of time with preceding record (unused here).
+ * @record_hdr	Record header for current sample.
+ * @file_hdr	System activity file standard header.
+ * @flags	Flags for common options (unused here).
+ *
+ * RETURNS:
+ * Pointer on the "timestamp" string (",host=<host>\t<timestamp>").
+ ***************************************************************************
+ */
+__tm_funct_t print_influx_timestamp(void *parm, int action, char *cur_date,
+				    char *cur_time, unsigned long long itv,
+				    struct record_header *record_hdr,
+				    struct file_header *file_hdr, unsigned int flags)
+{
+	static char pre[UTSNAME_LEN * 2 + 64];
+	char host[UTSNAME_LEN * 2];
+
+	if (action & F_BEGIN) {
+		snprintf(pre, sizeof(pre), ",host=%s\t%llu",
+			 influx_escape(file_hdr->sa_nodename, ", =", host, sizeof(host)),
+			 record_hdr->ust_time * 1000000000ULL);
+		return pre;
+	}
+
+	return NULL;
+}
+
+/*
+ ***************************************************************************
+ * Display the "timestamp" part of the report (Arrow IPC stream).
+ * Nothing is displayed here: Timestamp and hostname are saved so that
+ * they can be added to each row of statistics.
+ *
+ * IN:
+ * @parm	Pointer on specific parameters (unused here).
+ * @action	Action expected from current function.
+ * @cur_date	Date string of current record (unused here).
+ * @cur_time	Time string of current record (unused here).
+ * @itv		Interval of time with preceding record (unused here).
+ * @record_hdr	Record header for current sample.
+ * @file_hdr	System activity file standard header.
+ * @flags	Flags for common options (unused here).
+ *
+ * RETURNS:
+ * NULL (rendering functions don't use any prefix string for this format).
+ ***************************************************************************
+ */
+__tm_funct_t print_arrow_timestamp(void *parm, int action, char *cur_date,
+				   char *cur_time, unsigned long long itv,
+				   struct record_header *record_hdr,
+				   struct file_header *file_hdr, unsigned int flags)
+{
+	if (action & F_BEGIN) {
+		arrow_set_record(record_hdr->ust_time, file_hdr->sa_nodename);
+	}
+
+	return NULL;
+}
+
+/*
+ ***************************************************************************
+ * Build the string passed to rendering functions for InfluxDB line
+ * protocol. The measurement is the name of the activity (without its "A_"
+ * prefix, in lower case). The key of the tag identifying items (disks,
+ * network interfaces, filesystems...) is the first upper case field name
+ * from the activity header line, in lower case ("device" if none).
+ *
+ * IN:
+ * @a		Activity structure.
+ * @pre		String returned by print_influx_timestamp().
+ *
+ * RETURNS:
+ * Pointer on the string "<measurement>,host=<host>\t<timestamp>\t<tag key>".
+ ***************************************************************************
+ */
+char *get_influx_prefix(struct activity *a, char *pre)
+{
+	static char ipre[UTSNAME_LEN * 2 + 256];
+	char key[32] = "device", *s, *e;
+	int i, n;
+
+	/* Look for first field name in upper case */
+	for (s = a->hdr_line; s && *s; s = e + 1) {
+		n = strcspn(s, ";|&");
+		e = s + n;
+		for (i = 0; (i < n) && (s[i] >= 'A') && (s[i] <= 'Z'); i++);
+		if ((i == n) && n && (n < sizeof(key))) {
+			for (i = 0; i < n; i++) {
+				key[i] = s[i] - 'A' + 'a';
+			}
+			key[n] = '\0';
+			break;
+		}
+		if (!*e)
+			break;
+	}
+
+	n = snprintf(ipre, sizeof(ipre), "%s", a->name + 2);
+	for (i = 0; i < n; i++) {
+		if ((ipre[i] >= 'A') && (ipre[i] <= 'Z')) {
+			ipre[i] += 'a' - 'A';
+		}
+	}
+	snprintf(ipre + n, sizeof(ipre) - n, "%s\t%s", pre, key);
+
+	return ipre;
+}
+
 /*
  ***************************************************************************
  * Display the "timestamp" part of the report (PCP format).
@@ -66,6 +66,7 @@ uint64_t flags = 0;
 
 char timestamp[2][TIMESTAMP_LEN];
 extern unsigned int rec_types_nr[];
+extern int prof_enabled;
 
 unsigned long avg_count = 0;
 
@@ -127,7 +128,8 @@ void usage(char *progname)
 			  "[ -m { <keyword> [,...] | ALL } ] [ -n { <keyword> [,...] | ALL } ]\n"
 			  "[ -q [ <keyword> [,...] | ALL ] ]\n"
 			  "[ --dev=<dev_list> ] [ --fs=<fs_list> ] [ --iface=<iface_list> ]\n"
-			  "[ --dec={ 0 | 1 | 2 } ] [ --help ] [ --human ] [ --pretty ] [ --sadc ]\n"
+			  "[ --dec={ 0 | 1 | 2 } ] [ --help ] [ --human ] [ --pretty ] [ --profile ]\n"
+			  "[ --sadc ] [ --topology={ NODE | SOCK | ALL } ]\n"
 			  "[ -j { SID | ID | LABEL | PATH | UUID | ... } ]\n"
 			  "[ -f [ <filename> ] | -o [ <filename> ] | -[0-9]+ ]\n"
 			  "[ -i <interval> ] [ -s [ <hh:mm[:ss]> ] ] [ -e [ <hh:mm[:ss]> ] ]\n"));
@@ -375,6 +377,7 @@ void write_stats_avg(int curr, int read_from_file, unsigned int act_id)
 {
 	int i;
 	unsigned long long itv;
+	struct prof_ts ts;
 
 	/* Interval value in 1/100th of a second */
 	itv = get_interval(record_hdr[2].uptime_cs, record_hdr[curr].uptime_cs);
@@ -393,7 +396,11 @@ void write_stats_avg(int curr, int read_from_file, unsigned int act_id)
 
 		if (IS_SELECTED(act[i]->options) && (act[i]->nr[curr] > 0)) {
 			/* Display current average activity statistics */
+			SA_PROBE1(print__start, act[i]->id);
+			PROF_START(ts);
 			(*act[i]->f_print_avg)(act[i], 2, curr, itv);
+			PROF_STOP(ts, act[i], PROF_PRINT);
+			SA_PROBE2(print__end, act[i]->id, act[i]->nr[curr]);
 		}
 	}
 
@@ -438,6 +445,7 @@ int write_stats(int curr, int read_from_file, long *cnt, int use_tm_start,
 	int i, prev_hour, rc = 0;
 	unsigned long long itv;
 	static int cross_day = FALSE;
+	struct prof_ts ts;
 
 	if (reset_cd) {
 		/*
@@ -508,7 +516,11 @@ int write_stats(int curr, int read_from_file, long *cnt, int use_tm_start,
 
 		if (IS_SELECTED(act[i]->options) && (act[i]->nr[curr] > 0)) {
 			/* Display current activity statistics */
+			SA_PROBE1(print__start, act[i]->id);
+			PROF_START(ts);
 			(*act[i]->f_print)(act[i], !curr, curr, itv);
+			PROF_STOP(ts, act[i], PROF_PRINT);
+			SA_PROBE2(print__end, act[i]->id, act[i]->nr[curr]);
 			rc = 1;
 		}
 	}
@@ -556,6 +568,10 @@ void write_stats_startup(int curr)
 	write_stats(curr, USE_SADC, &count, NO_TM_START, NO_TM_END, NO_RESET,
 		    ALL_ACTIVITIES, TRUE);
 
+	if (prof_enabled) {
+		print_profile(act);
+	}
+
 	exit(0);
 }
 
@@ -869,7 +885,9 @@ void read_header_data(void)
 {
 	struct file_magic file_magic;
 	struct file_activity file_act;
-	int rc, i, p;
+	struct extra_desc xtra_d;
+	void *buf;
+	int rc, i, p, next;
 	char version[16];
 
 	/* Read magic header */
@@ -984,6 +1002,29 @@ void read_header_data(void)
 		id_seq[i++] = 0;
 	}
 
+	/* Read extra structures (CPU topology) */
+	free_cpu_topology();
+	for (next = file_hdr.extra_next; next; next = xtra_d.extra_next) {
+
+		if (sa_read(&xtra_d, EXTRA_DESC_SIZE) ||
+		    (xtra_d.extra_nr > MAX_EXTRA_NR) || (xtra_d.extra_size > MAX_EXTRA_SIZE)) {
+#ifdef DEBUG
+			fprintf(stderr, "%s: Extra structures\n", __FUNCTION__);
+#endif
+			print_read_error(INCONSISTENT_INPUT_DATA);
+		}
+
+		if ((buf = malloc((size_t) xtra_d.extra_nr * xtra_d.extra_size + 1)) == NULL) {
+			perror("malloc");
+			exit(4);
+		}
+		if (sa_read(buf, (size_t) xtra_d.extra_nr * xtra_d.extra_size)) {
+			print_read_error(END_OF_DATA_UNEXPECTED);
+		}
+		save_cpu_topology(&xtra_d, buf, FALSE, TRUE);
+		free(buf);
+	}
+
 	/* Check that all selected activties are actually sent by sadc */
 	reverse_check_act(file_hdr.sa_act_nr);
 
@@ -1334,6 +1375,13 @@ int main(int argc, char **argv)
 			act[q]->options |= AO_LIST_ON_CMDLINE;
 		}
 
+		else if (!strncmp(argv[opt], "--topology=", 11)) {
+			/* Display statistics for each node and/or socket */
+			if (parse_sa_topology_opt(argv, &opt, act)) {
+				usage(argv[0]);
+			}
+		}
+
 		else if (!strcmp(argv[opt], "--help")) {
 			/* Display help message */
 			display_help(argv[0]);
@@ -1351,6 +1399,12 @@ int main(int argc, char **argv)
 			opt++;
 		}
 
+		else if (!strcmp(argv[opt], "--profile")) {
+			/* Display time spent in each processing phase */
+			prof_enabled = TRUE;
+			opt++;
+		}
+
 		else if (!strncmp(argv[opt], "--dec=", 6) && (strlen(argv[opt]) == 7)) {
 			/* Get number of decimal places */
 			dplaces_nr = atoi(argv[opt] + 6);
@@ -1597,6 +1651,10 @@ int main(int argc, char **argv)
 		/* Read stats from file */
 		read_stats_from_file(from_file);
 
+		if (prof_enabled) {
+			print_profile(act);
+		}
+
 		/* Free structures and activity bitmaps */
 		free_bitmaps(act);
 		free_structures(act);
@@ -1692,6 +1750,13 @@ int main(int argc, char **argv)
 			salloc(args_idx++, ltemp);
 		}
 
+		/* Tell sadc to save CPU topology if option --topology has been used */
+		p = get_activity_position(act, A_CPU, EXIT_IF_NOT_FOUND);
+		if (act[p]->opt_flags & AO_F_CPU_GRP) {
+			salloc(args_idx++, "-S");
+			salloc(args_idx++, K_TOPOLOGY);
+		}
+
 		/* Last arg is NULL */
 		args[args_idx] = NULL;
 
@@ -1724,6 +1789,10 @@ int main(int argc, char **argv)
 		/* Get now the statistics */
 		read_stats();
 
+		if (prof_enabled) {
+			print_profile(act);
+		}
+
 		break;
 	}
 
@@ -22,6 +22,7 @@
 #ifdef TEST
 
 #include <stdio.h>
+#include <ctype.h>
 #include <string.h>
 #include <errno.h>
 #include <stdlib.h>
@@ -145,13 +146,18 @@ void next_time_step(void)
 {
 	int root_nr = 1;
 	char rootf[64], testf[128];
-	char *resolved_name;
+	char *resolved_name, *p;
 
 	__unix_time += interval;
 
 	if ((resolved_name = realpath(ROOTDIR, NULL)) != NULL) {
 		if (strlen(resolved_name) > 4) {
-			root_nr = atoi(resolved_name + strlen(resolved_name) - 1);
+			/* Root number may have several digits (e.g. "root12") */
+			p = resolved_name + strlen(resolved_name);
+			while ((p > resolved_name) && isdigit(*(p - 1))) {
+				p--;
+			}
+			root_nr = atoi(p);
 		}
 		free(resolved_name);
 	}
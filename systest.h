@@ -47,7 +47,10 @@
 
 #else
 
+/* An alternate root directory may be given at compile time (see bench target) */
+#ifndef PRE
 #define PRE	""
+#endif
 
 #define __time(m)		time(m)
 #define __uname(m)		uname(m)
@@ -26,6 +26,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <stddef.h>
 #include <time.h>
 #include <dirent.h>
 #define __DO_NOT_DEFINE_COMPILE
@@ -35,6 +37,7 @@
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <sys/utsname.h>
 
 #ifdef HAVE_SYS_PARAM_H
@@ -91,6 +94,37 @@ struct tape_stats *tape_new_stats = { NULL };
 struct tape_stats *tape_old_stats = { NULL };
 regex_t tape_reg;
 
+/*
+ * Statistics files are kept open between samples and read again from their
+ * beginning. There are TAPE_STAT_NR file descriptors per tape (-1 if the
+ * file is not currently open).
+ */
+int *tape_fd = NULL;
+/*
+ * Maximum number of statistics files that can be kept open (it depends on
+ * the limit on the number of open files), and number of those currently
+ * open. Once the maximum is reached, other files are opened, read and
+ * closed at each sample.
+ */
+int tape_fd_max = 0;
+int tape_fd_nr = 0;
+
+/* Files read in each tape stats directory */
+struct tape_stat_file tape_stat_files[TAPE_STAT_NR] = {
+	{"read_ns",		offsetof(struct tape_stats, read_time)},
+	{"write_ns",		offsetof(struct tape_stats, write_time)},
+	{"io_ns",		offsetof(struct tape_stats, other_time)},
+	{"read_byte_cnt",	offsetof(struct tape_stats, read_bytes)},
+	{"write_byte_cnt",	offsetof(struct tape_stats, write_bytes)},
+	{"read_cnt",		offsetof(struct tape_stats, read_count)},
+	{"write_cnt",		offsetof(struct tape_stats, write_count)},
+	{"other_cnt",		offsetof(struct tape_stats, other_count)},
+	{"resid_cnt",		offsetof(struct tape_stats, resid_count)}
+};
+
+/* Tape directory generation when it was last scanned */
+struct dir_gen tape_dir_gen;
+
 /*
  ***************************************************************************
  * Print usage and exit.
@@ -128,15 +162,48 @@ void alarm_handler(int sig)
  */
 void tape_initialise(void)
 {
+	struct rlimit rlim;
+
 	/* How many processors on this machine? */
 	cpu_nr = get_cpu_nr(~0, FALSE);
 
+	/* How many statistics files can be kept open? */
+	if (getrlimit(RLIMIT_NOFILE, &rlim) < 0) {
+		tape_fd_max = 0;
+	}
+	else if ((rlim.rlim_cur == RLIM_INFINITY) || (rlim.rlim_cur > INT_MAX)) {
+		tape_fd_max = INT_MAX;
+	}
+	else if (rlim.rlim_cur > TAPE_FD_RESERVED) {
+		tape_fd_max = rlim.rlim_cur - TAPE_FD_RESERVED;
+	}
+
 	/* Compile regular expression for tape names */
         if (regcomp(&tape_reg, "^st[0-9]+$", REG_EXTENDED) != 0) {
 		exit(1);
         }
 }
 
+/*
+ ***************************************************************************
+ * Close a statistics file kept open between samples.
+ *
+ * IN:
+ * @fd		File descriptor for the file (-1 if not open).
+ *
+ * OUT:
+ * @fd		File descriptor set to -1.
+ ***************************************************************************
+ */
+void tape_close_fd(int *fd)
+{
+	if (*fd >= 0) {
+		close(*fd);
+		*fd = -1;
+		tape_fd_nr--;
+	}
+}
+
 /*
  ***************************************************************************
  * Free structures.
@@ -144,7 +211,15 @@ void tape_initialise(void)
  */
 void tape_uninitialise(void)
 {
+	int i;
+
 	regfree(&tape_reg);
+	if (tape_fd != NULL) {
+		for (i = 0; i < max_tape_drives * TAPE_STAT_NR; i++) {
+			tape_close_fd(&tape_fd[i]);
+		}
+		free(tape_fd);
+	}
 	if (tape_old_stats != NULL) {
 		free(tape_old_stats);
 	}
@@ -203,6 +278,26 @@ int get_max_tape_drives(void)
 	return new_max_tape_drives;
 }
 
+/*
+ ***************************************************************************
+ * Allocate file descriptors for tapes up to @new_max_tape_drives. New
+ * descriptors are marked as not open.
+ *
+ * IN:
+ * @new_max_tape_drives	New number of tapes.
+ ***************************************************************************
+ */
+void tape_realloc_fd(int new_max_tape_drives)
+{
+	int i;
+
+	SREALLOC(tape_fd, int, sizeof(int) * new_max_tape_drives * TAPE_STAT_NR);
+
+	for (i = max_tape_drives * TAPE_STAT_NR; i < new_max_tape_drives * TAPE_STAT_NR; i++) {
+		tape_fd[i] = -1;
+	}
+}
+
 /*
  ***************************************************************************
  * Check if new tapes have been added and reallocate structures accordingly.
@@ -212,6 +307,15 @@ void tape_check_tapes_and_realloc(void)
 {
 	int new_max_tape_drives, i;
 
+	/* Don't scan the tape directory again if it hasn't changed */
+	if (!sysfs_dir_changed(SYSFS_CLASS_TAPE_DIR, &tape_dir_gen))
+		return;
+
+	/* Tapes may have been removed: Open statistics files again */
+	for (i = 0; i < max_tape_drives * TAPE_STAT_NR; i++) {
+		tape_close_fd(&tape_fd[i]);
+	}
+
 	/* Count again number of tapes */
 	new_max_tape_drives = get_max_tape_drives();
 
@@ -243,6 +347,7 @@ void tape_check_tapes_and_realloc(void)
 
 		tape_old_stats = tape_old_stats_t;
 		tape_new_stats = tape_new_stats_t;
+		tape_realloc_fd(new_max_tape_drives);
 
 		for (i = max_tape_drives; i < new_max_tape_drives; i++) {
 			tape_old_stats[i].valid = TAPE_STATS_INVALID;
@@ -252,6 +357,115 @@ void tape_check_tapes_and_realloc(void)
 	}
 }
 
+/*
+ ***************************************************************************
+ * Read one statistics file for a tape. The file is opened the first time
+ * then kept open and read again from its beginning. If it cannot be read
+ * (e.g. the tape has been removed and added again) it is opened again.
+ * If too many files are already open, the file is closed once read.
+ *
+ * IN:
+ * @fd		File descriptor for the file (-1 if not open yet).
+ * @i		Index of the tape.
+ * @name	Name of the statistics file.
+ *
+ * OUT:
+ * @fd		File descriptor to use at next sample.
+ * @val		Value read from the file.
+ *
+ * RETURNS:
+ * 0 on success, 1 if the value couldn't be parsed, -1 if the file
+ * couldn't be opened or read.
+ ***************************************************************************
+ */
+int tape_read_stat_file(int *fd, int i, char *name, uint64_t *val)
+{
+	char filename[MAXPATHLEN + 1], buf[32];
+	ssize_t n = -1;
+	int retry, tmp_fd;
+
+	for (retry = 0; retry < 2; retry++) {
+		if (*fd < 0) {
+			snprintf(filename, MAXPATHLEN, TAPE_STAT_PATH "%s", i, name);
+			if ((tmp_fd = open(filename, O_RDONLY)) < 0)
+				return -1;
+
+			if (tape_fd_nr >= tape_fd_max) {
+				/* Too many files already open: Don't keep this one open */
+				n = read(tmp_fd, buf, sizeof(buf) - 1);
+				close(tmp_fd);
+				break;
+			}
+			*fd = tmp_fd;
+			tape_fd_nr++;
+		}
+#ifdef TEST
+		else {
+			/*
+			 * tests/root link changes between samples: Make the file
+			 * kept open be the one of current root, as if its contents
+			 * had been updated by the kernel.
+			 */
+			snprintf(filename, MAXPATHLEN, TAPE_STAT_PATH "%s", i, name);
+			if ((tmp_fd = open(filename, O_RDONLY)) < 0) {
+				/* Tape has been removed: Reading the file would fail */
+				tape_close_fd(fd);
+				continue;
+			}
+			dup2(tmp_fd, *fd);
+			close(tmp_fd);
+		}
+#endif
+
+		n = pread(*fd, buf, sizeof(buf) - 1, 0);
+		if (n >= 0)
+			break;
+
+		tape_close_fd(fd);
+	}
+
+	if (n < 0)
+		return -1;
+
+	buf[n] = '\0';
+	if (sscanf(buf, "%"SCNu64, val) != 1)
+		return 1;
+
+	return 0;
+}
+
+/*
+ ***************************************************************************
+ * Read all the statistics files for a tape.
+ *
+ * IN:
+ * @i		Index of the tape.
+ *
+ * OUT:
+ * @ts		Statistics for the tape. Marked as invalid if a file
+ *		couldn't be read or parsed.
+ *
+ * RETURNS:
+ * -1 if a file couldn't be opened or read, 0 otherwise.
+ ***************************************************************************
+ */
+int tape_read_stats(int i, struct tape_stats *ts)
+{
+	int j, rc;
+
+	for (j = 0; j < TAPE_STAT_NR; j++) {
+		rc = tape_read_stat_file(&TAPE_FD(i, j), i, tape_stat_files[j].name,
+					 (uint64_t *) ((char *) ts + tape_stat_files[j].offset));
+		if (rc) {
+			ts->valid = TAPE_STATS_INVALID;
+			if (rc < 0)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
 /*
  ***************************************************************************
  * Collect initial statistics for all existing tapes in the system.
@@ -261,10 +475,9 @@ void tape_check_tapes_and_realloc(void)
 void tape_gather_initial_stats(void)
 {
 	int new_max_tape_drives, i;
-	FILE *fp;
-	char filename[MAXPATHLEN + 1];
 
 	/* Get number of tapes in the system */
+	sysfs_dir_changed(SYSFS_CLASS_TAPE_DIR, &tape_dir_gen);
 	new_max_tape_drives = get_max_tape_drives();
 
 	if (new_max_tape_drives == 0) {
@@ -283,6 +496,7 @@ void tape_gather_initial_stats(void)
 				tape_old_stats[i].valid = TAPE_STATS_INVALID;
 				tape_new_stats[i].valid = TAPE_STATS_INVALID;
 			}
+			tape_realloc_fd(new_max_tape_drives);
 			max_tape_drives = new_max_tape_drives;
 		} else
 			/* This should only be called once */
@@ -303,15 +517,8 @@ void tape_gather_initial_stats(void)
 		tape_new_stats[i].tv.tv_sec = tape_old_stats[i].tv.tv_sec;
 		tape_new_stats[i].tv.tv_usec = tape_old_stats[i].tv.tv_usec;
 
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "read_ns", read_time)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "write_ns", write_time)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "io_ns", other_time)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "read_byte_cnt", read_bytes)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "write_byte_cnt", write_bytes)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "read_cnt", read_count)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "write_cnt", write_count)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "other_cnt", other_count)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "resid_cnt", resid_count)
+		if (tape_read_stats(i, &tape_new_stats[i]) < 0)
+			continue;
 
 		tape_old_stats[i].read_time = 0;
 		tape_old_stats[i].write_time = 0;
@@ -333,8 +540,6 @@ void tape_gather_initial_stats(void)
 void tape_get_updated_stats(void)
 {
 	int i;
-	FILE *fp;
-	char filename[MAXPATHLEN + 1] = { 0 };
 
 	/* Check tapes and realloc structures if  needed */
 	tape_check_tapes_and_realloc();
@@ -347,15 +552,8 @@ void tape_get_updated_stats(void)
 		tape_new_stats[i].valid = TAPE_STATS_VALID;
 		__gettimeofday(&tape_new_stats[i].tv, NULL);
 
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "read_ns", read_time)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "write_ns", write_time)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "io_ns", other_time)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "read_byte_cnt", read_bytes)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "write_byte_cnt", write_bytes)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "read_cnt", read_count)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "write_cnt", write_count)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "other_cnt", other_count)
-		TAPE_STAT_FILE_VAL(TAPE_STAT_PATH "resid_cnt", resid_count)
+		if (tape_read_stats(i, &tape_new_stats[i]) < 0)
+			continue;
 
 		if ((tape_new_stats[i].read_time < tape_old_stats[i].read_time) ||
 		    (tape_new_stats[i].write_time < tape_old_stats[i].write_time) ||
@@ -34,17 +34,17 @@
 #define SYSFS_CLASS_TAPE_DIR 	PRE "/sys/class/scsi_tape"
 #define TAPE_STAT_PATH		PRE "/sys/class/scsi_tape/st%i/stats/"
 
-#define TAPE_STAT_FILE_VAL(A, B)					\
-	snprintf(filename, MAXPATHLEN, A, i);				\
-	if ((fp = fopen(filename, "r")) != NULL) {			\
-		if (fscanf(fp, "%"PRId64, &tape_new_stats[i].B) != 1) {	\
-			tape_new_stats[i].valid = TAPE_STATS_INVALID;	\
-		}							\
-		fclose(fp);						\
-	} else {							\
-		tape_new_stats[i].valid = TAPE_STATS_INVALID;		\
-		continue;						\
-	}
+/* Number of statistics files in each tape stats directory */
+#define TAPE_STAT_NR		9
+
+/*
+ * Number of file descriptors left available to the process when statistics
+ * files are kept open (see tape_fd_max).
+ */
+#define TAPE_FD_RESERVED	32
+
+/* Position of file descriptor for statistics file @j of tape @i */
+#define TAPE_FD(i, j)		tape_fd[(i) * TAPE_STAT_NR + (j)]
 
 
 /*
@@ -104,6 +104,12 @@ struct tape_stats {
         char valid;
         struct timeval tv;
 };
+/* Statistics file name and corresponding tape_stats structure member */
+struct tape_stat_file {
+	char *name;
+	size_t offset;
+};
+
 struct calc_stats {
         uint64_t reads_per_second;
         uint64_t writes_per_second;
@@ -116,6 +122,10 @@ struct calc_stats {
         uint64_t resids_per_second;
 };
 
+int tape_read_stat_file(int *, int, char *, uint64_t *);
+int tape_read_stats(int, struct tape_stats *);
+void tape_realloc_fd(int);
+void tape_close_fd(int *);
 void tape_get_updated_stats(void);
 void tape_gather_initial_stats(void);
 void tape_check_tapes_and_realloc(void);
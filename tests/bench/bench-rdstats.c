@@ -0,0 +1,482 @@
+/*
+ * bench-rdstats: Benchmark of sadc statistics collection functions.
+ * (C) 2026 by agent (agent <at> local)
+ *
+ ***************************************************************************
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published  by  the *
+ * Free Software Foundation; either version 2 of the License, or (at  your *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it  will  be  useful,  but *
+ * WITHOUT ANY WARRANTY; without the implied warranty  of  MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License *
+ * for more details.                                                       *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA              *
+ ***************************************************************************
+ *
+ * Each activity's read function (wrap_read_*() from sa_wrap.c) is called
+ * a given number of times on a fixture directory created by
+ * tests/fixture/mkroot. Objects linked with this program are built with
+ * PRE set to "./tests/root" (but not in TEST mode, so that the code paths
+ * used in production are measured), hence the fixture directory is the
+ * current directory when the functions are called.
+ *
+ * For each activity the program reports, in JSON format:
+ * - the time spent per call, in nanoseconds,
+ * - the number of system calls per call. This is the number of read and
+ *   write system calls accounted by the kernel (/proc/self/io) plus the
+ *   number of calls to open/close/stat-like functions made by sysstat code,
+ * - the number of memory allocations per call made by sysstat code.
+ * Functions made by sysstat code are counted using the linker's --wrap
+ * option (see bench target in Makefile).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#include "../../sa.h"
+
+#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
+#include "sensors/sensors.h"
+#endif
+
+#define PROC_SELF_IO	"/proc/self/io"
+
+/* Default number of calls to each read function */
+#define BENCH_ITER	100
+
+/* Globals normally defined in sadc.c */
+long interval = 0;
+uint64_t flags = 0;
+struct record_header record_hdr;
+int sigint_caught = 0;
+
+extern struct activity *act[];
+extern __nr_t (*f_count[]) (struct activity *);
+
+/* Counters updated by the functions wrapped at link time */
+unsigned long long sc_nr = 0;		/* Open/close/stat calls */
+unsigned long long alloc_nr = 0;	/* Memory allocations */
+
+/* Snapshot of the counters */
+struct bench_counters {
+	struct timespec ts;
+	unsigned long long syscalls;
+	unsigned long long allocs;
+};
+
+/*
+ ***************************************************************************
+ * Functions wrapped at link time (-Wl,--wrap=<function>).
+ ***************************************************************************
+ */
+void *__real_malloc(size_t);
+void *__real_calloc(size_t, size_t);
+void *__real_realloc(void *, size_t);
+char *__real_strdup(const char *);
+FILE *__real_fopen(const char *, const char *);
+int __real_fclose(FILE *);
+int __real_open(const char *, int, ...);
+int __real_openat(int, const char *, int, ...);
+int __real_close(int);
+DIR *__real_opendir(const char *);
+int __real_closedir(DIR *);
+int __real_stat(const char *, struct stat *);
+int __real_lstat(const char *, struct stat *);
+int __real_fstat(int, struct stat *);
+int __real_access(const char *, int);
+ssize_t __real_readlink(const char *, char *, size_t);
+int __real_statvfs(const char *, struct statvfs *);
+
+void *__wrap_malloc(size_t size)
+{
+	alloc_nr++;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+	alloc_nr++;
+	return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	alloc_nr++;
+	return __real_realloc(ptr, size);
+}
+
+char *__wrap_strdup(const char *s)
+{
+	alloc_nr++;
+	return __real_strdup(s);
+}
+
+FILE *__wrap_fopen(const char *pathname, const char *mode)
+{
+	sc_nr++;
+	return __real_fopen(pathname, mode);
+}
+
+int __wrap_fclose(FILE *fp)
+{
+	sc_nr++;
+	return __real_fclose(fp);
+}
+
+int __wrap_open(const char *pathname, int oflags, ...)
+{
+	va_list args;
+	mode_t mode = 0;
+
+	if (oflags & O_CREAT) {
+		va_start(args, oflags);
+		mode = va_arg(args, mode_t);
+		va_end(args);
+	}
+	sc_nr++;
+	return __real_open(pathname, oflags, mode);
+}
+
+int __wrap_openat(int dirfd, const char *pathname, int oflags, ...)
+{
+	va_list args;
+	mode_t mode = 0;
+
+	if (oflags & O_CREAT) {
+		va_start(args, oflags);
+		mode = va_arg(args, mode_t);
+		va_end(args);
+	}
+	sc_nr++;
+	return __real_openat(dirfd, pathname, oflags, mode);
+}
+
+int __wrap_close(int fd)
+{
+	sc_nr++;
+	return __real_close(fd);
+}
+
+DIR *__wrap_opendir(const char *name)
+{
+	sc_nr++;
+	return __real_opendir(name);
+}
+
+int __wrap_closedir(DIR *dir)
+{
+	sc_nr++;
+	return __real_closedir(dir);
+}
+
+int __wrap_stat(const char *pathname, struct stat *buf)
+{
+	sc_nr++;
+	return __real_stat(pathname, buf);
+}
+
+int __wrap_lstat(const char *pathname, struct stat *buf)
+{
+	sc_nr++;
+	return __real_lstat(pathname, buf);
+}
+
+int __wrap_fstat(int fd, struct stat *buf)
+{
+	sc_nr++;
+	return __real_fstat(fd, buf);
+}
+
+int __wrap_access(const char *pathname, int mode)
+{
+	sc_nr++;
+	return __real_access(pathname, mode);
+}
+
+ssize_t __wrap_readlink(const char *pathname, char *buf, size_t bufsiz)
+{
+	sc_nr++;
+	return __real_readlink(pathname, buf, bufsiz);
+}
+
+int __wrap_statvfs(const char *path, struct statvfs *buf)
+{
+	sc_nr++;
+	return __real_statvfs(path, buf);
+}
+
+/*
+ ***************************************************************************
+ * Print usage and exit.
+ *
+ * IN:
+ * @progname	Name of the program.
+ ***************************************************************************
+ */
+void usage(char *progname)
+{
+	fprintf(stderr, "Usage: %s [ -n <iterations> ] [ -a <activity>[,...] ] <fixture_dir>\n",
+		progname);
+	exit(1);
+}
+
+/*
+ ***************************************************************************
+ * Take a snapshot of the counters.
+ *
+ * OUT:
+ * @bc	Current values of the counters.
+ ***************************************************************************
+ */
+void get_counters(struct bench_counters *bc)
+{
+	char buf[1024], *p;
+	unsigned long long syscr = 0, syscw = 0;
+	ssize_t len;
+	int fd;
+
+	bc->syscalls = sc_nr;
+	bc->allocs = alloc_nr;
+
+	/* A single read() so that the cost of the snapshot is constant */
+	if ((fd = __real_open(PROC_SELF_IO, O_RDONLY)) >= 0) {
+		if ((len = read(fd, buf, sizeof(buf) - 1)) > 0) {
+			buf[len] = '\0';
+			if ((p = strstr(buf, "syscr:")) != NULL) {
+				sscanf(p + 6, "%llu", &syscr);
+			}
+			if ((p = strstr(buf, "syscw:")) != NULL) {
+				sscanf(p + 6, "%llu", &syscw);
+			}
+		}
+		__real_close(fd);
+	}
+	bc->syscalls += syscr + syscw;
+
+	clock_gettime(CLOCK_MONOTONIC, &bc->ts);
+}
+
+/*
+ ***************************************************************************
+ * Compute the difference between two snapshots of the counters.
+ *
+ * IN:
+ * @bc0	First snapshot.
+ * @bc1	Second snapshot.
+ *
+ * OUT:
+ * @ns		Time elapsed between the snapshots, in nanoseconds.
+ * @syscalls	Number of system calls made between the snapshots.
+ * @allocs	Number of memory allocations made between the snapshots.
+ ***************************************************************************
+ */
+void diff_counters(struct bench_counters *bc0, struct bench_counters *bc1,
+		   double *ns, double *syscalls, double *allocs)
+{
+	*ns = (bc1->ts.tv_sec - bc0->ts.tv_sec) * 1e9 +
+	      (bc1->ts.tv_nsec - bc0->ts.tv_nsec);
+	*syscalls = (double) (bc1->syscalls - bc0->syscalls);
+	*allocs = (double) (bc1->allocs - bc0->allocs);
+}
+
+/*
+ ***************************************************************************
+ * Allocate structures for the selected activities, as sadc does.
+ * Activities for which no items are found are deselected.
+ ***************************************************************************
+ */
+void bench_sys_init(void)
+{
+	int i, idx;
+	__nr_t f_count_results[NR_F_COUNT];
+
+	for (i = 0; i < NR_F_COUNT; i++) {
+		f_count_results[i] = -1;
+	}
+
+	for (i = 0; i < NR_ACT; i++) {
+
+		if ((HAS_COUNT_FUNCTION(act[i]->options) && IS_COLLECTED(act[i]->options)) ||
+		    ALWAYS_COUNT_ITEMS(act[i]->options)) {
+			idx = act[i]->f_count_index;
+
+			if (f_count_results[idx] < 0) {
+				f_count_results[idx] = (f_count[idx])(act[i]);
+			}
+			act[i]->nr_ini = f_count_results[idx];
+		}
+
+		if ((act[i]->nr_ini > 0) && act[i]->f_count2) {
+			act[i]->nr2 = (*act[i]->f_count2)(act[i]);
+			if (!act[i]->nr2) {
+				act[i]->nr_ini = 0;
+			}
+		}
+
+		if (IS_COLLECTED(act[i]->options) && (act[i]->nr_ini > 0)) {
+			SREALLOC(act[i]->_buf0, void,
+				 (size_t) act[i]->msize * (size_t) act[i]->nr_ini * (size_t) act[i]->nr2);
+			act[i]->nr_allocated = act[i]->nr_ini;
+		}
+		else {
+			act[i]->options &= ~AO_COLLECTED;
+		}
+
+		if (HAS_DETECT_FUNCTION(act[i]->options) && IS_COLLECTED(act[i]->options)) {
+			idx = act[i]->f_count_index;
+
+			if (f_count_results[idx] < 0) {
+				f_count_results[idx] = (f_count[idx])(act[i]);
+			}
+			if (f_count_results[idx] == 0) {
+				act[i]->options &= ~AO_COLLECTED;
+			}
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Select activities to benchmark.
+ *
+ * IN:
+ * @list	Comma-separated list of activity names (e.g. "A_CPU,A_DISK"),
+ *		or NULL to select every activity.
+ ***************************************************************************
+ */
+void select_activities(char *list)
+{
+	char *t;
+	int i, found;
+
+	for (i = 0; i < NR_ACT; i++) {
+		if (list) {
+			act[i]->options &= ~AO_COLLECTED;
+		}
+		else {
+			act[i]->options |= AO_COLLECTED;
+		}
+	}
+	if (!list)
+		return;
+
+	for (t = strtok(list, ","); t; t = strtok(NULL, ",")) {
+		found = FALSE;
+		for (i = 0; i < NR_ACT; i++) {
+			if (!strcmp(act[i]->name, t)) {
+				act[i]->options |= AO_COLLECTED;
+				found = TRUE;
+				break;
+			}
+		}
+		if (!found) {
+			fprintf(stderr, "Unknown activity: %s\n", t);
+			exit(1);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Main entry to the bench-rdstats program.
+ ***************************************************************************
+ */
+int main(int argc, char **argv)
+{
+	struct bench_counters bc0, bc1;
+	double ns, syscalls, allocs, ns_ref, syscalls_ref, allocs_ref;
+	char *list = NULL, *dir;
+	int opt, i, n, iter = BENCH_ITER, first = TRUE;
+
+	while ((opt = getopt(argc, argv, "n:a:")) != -1) {
+		switch (opt) {
+		case 'n':
+			iter = atoi(optarg);
+			break;
+		case 'a':
+			list = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if ((optind != argc - 1) || (iter < 1)) {
+		usage(argv[0]);
+	}
+	dir = argv[optind];
+
+	if (chdir(dir) < 0) {
+		perror(dir);
+		exit(2);
+	}
+	if (access(PRE, F_OK) < 0) {
+		fprintf(stderr, "%s/%s: No such fixture directory\n", dir, PRE);
+		exit(2);
+	}
+
+	get_HZ();
+	get_kb_shift();
+
+#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
+	if (sensors_init(NULL)) {
+		fprintf(stderr, "sensors_init failed\n");
+	}
+#endif
+
+	select_activities(list);
+	bench_sys_init();
+
+	/* Cost of a snapshot of the counters, subtracted from the results */
+	get_counters(&bc0);
+	get_counters(&bc1);
+	diff_counters(&bc0, &bc1, &ns_ref, &syscalls_ref, &allocs_ref);
+
+	printf("{\n\t\"bench\": \"rdstats\",\n\t\"fixture\": \"%s\",\n"
+	       "\t\"iterations\": %d,\n\t\"activities\": [", dir, iter);
+
+	for (i = 0; i < NR_ACT; i++) {
+		if (!IS_COLLECTED(act[i]->options) || !act[i]->f_read)
+			continue;
+
+		/* First call may fill caches and reallocate buffers */
+		(*act[i]->f_read)(act[i]);
+
+		get_counters(&bc0);
+		for (n = 0; n < iter; n++) {
+			(*act[i]->f_read)(act[i]);
+		}
+		get_counters(&bc1);
+		diff_counters(&bc0, &bc1, &ns, &syscalls, &allocs);
+
+		printf("%s\n\t\t{\"name\": \"%s\", \"items\": %d, \"ns_per_op\": %.1f, "
+		       "\"syscalls_per_op\": %.2f, \"allocs_per_op\": %.2f}",
+		       first ? "" : ",", act[i]->name,
+		       HAS_COUNT_FUNCTION(act[i]->options) ? act[i]->_nr0 : act[i]->nr_ini,
+		       (ns - ns_ref) / iter,
+		       (syscalls - syscalls_ref) / iter,
+		       (allocs - allocs_ref) / iter);
+		first = FALSE;
+	}
+
+	printf("\n\t]\n}\n");
+
+#if (defined(HAVE_SENSORS) && !defined(ARCH32)) || (defined(ARCH32) && defined(HAVE_SENSORS32))
+	free_sensors_cache();
+	sensors_cleanup();
+#endif
+
+	return 0;
+}
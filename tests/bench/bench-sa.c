@@ -0,0 +1,243 @@
+/*
+ * bench-sa: Benchmark of sar and sadf data files processing.
+ * (C) 2026 by agent (agent <at> local)
+ *
+ ***************************************************************************
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published  by  the *
+ * Free Software Foundation; either version 2 of the License, or (at  your *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it  will  be  useful,  but *
+ * WITHOUT ANY WARRANTY; without the implied warranty  of  MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License *
+ * for more details.                                                       *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA              *
+ ***************************************************************************
+ *
+ * sar and each output format of sadf are run on a data file (typically
+ * created by tests/bench/mksa) for several sets of activities. Output is
+ * sent to /dev/null. Each command is run several times and the best time
+ * is kept. Records per second, MB of data file per second and peak
+ * resident set size of the command are reported in JSON format.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define FALSE	0
+#define TRUE	1
+
+#define MAX_ARGS	16
+
+/* Default number of runs for each command */
+#define BENCH_RUNS	3
+
+/* Commands to benchmark */
+struct bench_cmd {
+	char *prog;		/* sar or sadf */
+	char *fmt;		/* sadf output format (NULL for sar) */
+} bench_cmds[] = {
+	{"sar", NULL},
+	{"sadf", "-d"},
+	{"sadf", "-j"},
+	{"sadf", "-x"},
+	{"sadf", "-p"},
+	{"sadf", "-g"},
+	{"sadf", "-r"},
+	{"sadf", "-a"}
+};
+#define BENCH_CMD_NR	(sizeof(bench_cmds) / sizeof(bench_cmds[0]))
+
+/* Sets of activities */
+struct bench_set {
+	char *name;
+	char *opts[4];
+} bench_sets[] = {
+	{"cpu",  {"-u", NULL}},
+	{"disk", {"-d", NULL}},
+	{"net",  {"-n", "DEV", NULL}},
+	{"all",  {"-A", NULL}}
+};
+#define BENCH_SET_NR	(sizeof(bench_sets) / sizeof(bench_sets[0]))
+
+/*
+ ***************************************************************************
+ * Print usage and exit.
+ *
+ * IN:
+ * @progname	Name of the program.
+ ***************************************************************************
+ */
+void usage(char *progname)
+{
+	fprintf(stderr, "Usage: %s [ -b <bindir> ] [ -n <runs> ] [ -s <set>[,...] ] "
+		"-r <records> <datafile>\n"
+		"Sets are: cpu, disk, net, all\n",
+		progname);
+	exit(1);
+}
+
+/*
+ ***************************************************************************
+ * Run a command with its output redirected to /dev/null.
+ *
+ * IN:
+ * @argv	Command and its arguments.
+ *
+ * OUT:
+ * @secs	Elapsed time, in seconds.
+ * @maxrss	Peak resident set size of the command, in kB.
+ *
+ * RETURNS:
+ * Exit status of the command (-1 if it didn't exit normally).
+ ***************************************************************************
+ */
+int run_cmd(char *argv[], double *secs, long *maxrss)
+{
+	struct timespec ts0, ts1;
+	struct rusage ru;
+	pid_t pid;
+	int status, fd;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts0);
+
+	switch (pid = fork()) {
+	case -1:
+		perror("fork");
+		exit(4);
+
+	case 0:
+		if ((fd = open("/dev/null", O_WRONLY)) >= 0) {
+			dup2(fd, STDOUT_FILENO);
+			dup2(fd, STDERR_FILENO);
+			close(fd);
+		}
+		execv(argv[0], argv);
+		_exit(127);
+	}
+
+	if (wait4(pid, &status, 0, &ru) < 0) {
+		perror("wait4");
+		exit(4);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts1);
+
+	*secs = (ts1.tv_sec - ts0.tv_sec) + (ts1.tv_nsec - ts0.tv_nsec) / 1e9;
+	*maxrss = ru.ru_maxrss;
+
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/*
+ ***************************************************************************
+ * Main entry to the bench-sa program.
+ ***************************************************************************
+ */
+int main(int argc, char **argv)
+{
+	char *args[MAX_ARGS], path[1024], *bindir = ".", *sets = "cpu,disk,net,all";
+	char *dfile, *s;
+	struct stat st;
+	double secs, best;
+	long maxrss, best_rss;
+	int opt, runs = BENCH_RUNS, rec_nr = 0, first = TRUE;
+	int i, j, k, n, rc, na;
+
+	while ((opt = getopt(argc, argv, "b:n:s:r:")) != -1) {
+		switch (opt) {
+		case 'b':
+			bindir = optarg;
+			break;
+		case 'n':
+			runs = atoi(optarg);
+			break;
+		case 's':
+			sets = optarg;
+			break;
+		case 'r':
+			rec_nr = atoi(optarg);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if ((optind != argc - 1) || (runs < 1) || (rec_nr < 1)) {
+		usage(argv[0]);
+	}
+	dfile = argv[optind];
+
+	if (stat(dfile, &st) < 0) {
+		perror(dfile);
+		exit(2);
+	}
+
+	printf("{\n\t\"bench\": \"sa\",\n\t\"file\": \"%s\",\n\t\"size\": %lld,\n"
+	       "\t\"records\": %d,\n\t\"runs\": %d,\n\t\"results\": [",
+	       dfile, (long long) st.st_size, rec_nr, runs);
+
+	for (j = 0; j < BENCH_SET_NR; j++) {
+		/* Is this set selected? */
+		s = strstr(sets, bench_sets[j].name);
+		if (!s || ((s != sets) && (*(s - 1) != ',')) ||
+		    ((s[strlen(bench_sets[j].name)] != '\0') && (s[strlen(bench_sets[j].name)] != ',')))
+			continue;
+
+		for (i = 0; i < BENCH_CMD_NR; i++) {
+			/* Build command line: sar <set> -f <file> or sadf <fmt> <file> -- <set> */
+			snprintf(path, sizeof(path), "%s/%s", bindir, bench_cmds[i].prog);
+			na = 0;
+			args[na++] = path;
+			if (bench_cmds[i].fmt) {
+				args[na++] = bench_cmds[i].fmt;
+				args[na++] = dfile;
+				args[na++] = "--";
+			}
+			for (k = 0; bench_sets[j].opts[k]; k++) {
+				args[na++] = bench_sets[j].opts[k];
+			}
+			if (!bench_cmds[i].fmt) {
+				args[na++] = "-f";
+				args[na++] = dfile;
+			}
+			args[na] = NULL;
+
+			best = -1.0;
+			best_rss = 0;
+			rc = 0;
+			for (n = 0; n < runs; n++) {
+				rc = run_cmd(args, &secs, &maxrss);
+				if ((best < 0) || (secs < best)) {
+					best = secs;
+				}
+				if (maxrss > best_rss) {
+					best_rss = maxrss;
+				}
+			}
+
+			printf("%s\n\t\t{\"command\": \"%s\", \"format\": \"%s\", \"set\": \"%s\", "
+			       "\"status\": %d, \"seconds\": %.4f, \"records_per_sec\": %.1f, "
+			       "\"mb_per_sec\": %.2f, \"max_rss_kb\": %ld}",
+			       first ? "" : ",", bench_cmds[i].prog,
+			       bench_cmds[i].fmt ? bench_cmds[i].fmt : "", bench_sets[j].name,
+			       rc, best, best > 0 ? rec_nr / best : 0.0,
+			       best > 0 ? st.st_size / best / 1048576 : 0.0, best_rss);
+			first = FALSE;
+		}
+	}
+
+	printf("\n\t]\n}\n");
+
+	return 0;
+}
@@ -0,0 +1,576 @@
+/*
+ * mksa: Generate synthetic system activity data files for benchmarks.
+ * (C) 2026 by agent (agent <at> local)
+ *
+ ***************************************************************************
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published  by  the *
+ * Free Software Foundation; either version 2 of the License, or (at  your *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it  will  be  useful,  but *
+ * WITHOUT ANY WARRANTY; without the implied warranty  of  MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License *
+ * for more details.                                                       *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA              *
+ ***************************************************************************
+ *
+ * mksa writes a data file containing every activity known to sadc, with
+ * a given number of items per activity and a given number of records,
+ * without reading anything from /proc or /sys. Counters are increased at
+ * each record by pseudo-random amounts from a seeded generator, so that
+ * the same file is generated for a given set of options.
+ *
+ * The file may be written with the opposite endianness of current machine
+ * (option -e), and/or with structures containing more fields than those
+ * known by current sysstat version (option -x), as if it had been created
+ * by another sysstat version. In this latter case sar and sadf have to
+ * remap every structure read from the file (see remap_struct()).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "../../sa.h"
+
+/* Time of first record (Tue Nov 14 22:13:20 UTC 2023) */
+#define MKSA_BASE_TIME	1700000000ULL
+
+/* Number of CPU frequencies for A_PWR_FREQ activity */
+#define MKSA_FREQ_NR	4
+
+/* Globals normally defined in sadc.c */
+long interval = 0;
+uint64_t flags = 0;
+struct record_header record_hdr;
+int sigint_caught = 0;
+
+extern struct activity *act[];
+extern unsigned int hdr_types_nr[];
+extern unsigned int act_types_nr[];
+extern unsigned int rec_types_nr[];
+
+/* File shape */
+struct config {
+	int cpu_nr;
+	int disk_nr;
+	int iface_nr;
+	int irq_nr;
+	int item_nr;		/* Number of items for other activities */
+	int rec_nr;
+	int interval;
+	int swap;		/* TRUE if file should have opposite endianness */
+	int extra;		/* TRUE if structures should have extra fields */
+	unsigned long long seed;
+} cfg = {
+	.cpu_nr		= 4,
+	.disk_nr	= 4,
+	.iface_nr	= 2,
+	.irq_nr		= 16,
+	.item_nr	= 2,
+	.rec_nr		= 100,
+	.interval	= 10,
+	.swap		= FALSE,
+	.extra		= FALSE,
+	.seed		= 1
+};
+
+/* Number of extra fields for each type when option -x is used */
+unsigned int extra_types_nr[] = {1, 1, 1};
+
+/* Buffer used to build items as they will be written to file */
+char *obuf = NULL;
+size_t obuf_size = 0;
+
+/*
+ ***************************************************************************
+ * Print usage and exit.
+ *
+ * IN:
+ * @progname	Name of the program.
+ ***************************************************************************
+ */
+void usage(char *progname)
+{
+	fprintf(stderr, "Usage: %s [ options ] <datafile>\n"
+		"Options are:\n"
+		"[ -c <cpus> ] [ -d <disks> ] [ -n <interfaces> ] [ -i <interrupts> ]\n"
+		"[ -m <items_for_other_activities> ] [ -r <records> ] [ -I <interval> ]\n"
+		"[ -S <seed> ] [ -e ] [ -x ]\n",
+		progname);
+	exit(1);
+}
+
+/*
+ ***************************************************************************
+ * Pseudo-random number generator (xorshift64*), as in tests/fixture/mkroot.
+ *
+ * IN:
+ * @max		Upper bound (excluded). Must be > 0.
+ *
+ * RETURNS:
+ * A number between 0 and @max - 1.
+ ***************************************************************************
+ */
+unsigned long long rnd(unsigned long long max)
+{
+	cfg.seed ^= cfg.seed >> 12;
+	cfg.seed ^= cfg.seed << 25;
+	cfg.seed ^= cfg.seed >> 27;
+
+	return (cfg.seed * 2685821657736338717ULL) % max;
+}
+
+/*
+ ***************************************************************************
+ * Write data to file or exit.
+ *
+ * IN:
+ * @fp		Data file.
+ * @buf		Data to write.
+ * @size	Number of bytes to write.
+ ***************************************************************************
+ */
+void xwrite(FILE *fp, void *buf, size_t size)
+{
+	if (size && (fwrite(buf, size, 1, fp) != 1)) {
+		perror("fwrite");
+		exit(2);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Swap bytes of the numerical fields of a structure. The same layout as
+ * that described for swap_struct() in sa_common.c is assumed.
+ *
+ * IN:
+ * @types_nr	Number of long long, long and int fields in structure.
+ * @ps		Pointer on structure.
+ ***************************************************************************
+ */
+void mksa_swap(unsigned int types_nr[], void *ps)
+{
+	char *p = (char *) ps;
+	uint64_t x;
+	uint32_t y;
+	int i;
+
+	for (i = 0; i < types_nr[0]; i++) {
+		memcpy(&x, p, sizeof(x));
+		x = __builtin_bswap64(x);
+		memcpy(p, &x, sizeof(x));
+		p += ULL_ALIGNMENT_WIDTH;
+	}
+	for (i = 0; i < types_nr[1]; i++) {
+		if (sizeof(long) == 8) {
+			memcpy(&x, p, sizeof(x));
+			x = __builtin_bswap64(x);
+			memcpy(p, &x, sizeof(x));
+		}
+		else {
+			memcpy(&y, p, sizeof(y));
+			y = __builtin_bswap32(y);
+			memcpy(p, &y, sizeof(y));
+		}
+		p += UL_ALIGNMENT_WIDTH;
+	}
+	for (i = 0; i < types_nr[2]; i++) {
+		memcpy(&y, p, sizeof(y));
+		y = __builtin_bswap32(y);
+		memcpy(p, &y, sizeof(y));
+		p += U_ALIGNMENT_WIDTH;
+	}
+}
+
+/*
+ ***************************************************************************
+ * Get the number of items and sub-items to write for an activity.
+ *
+ * IN:
+ * @a	Activity structure.
+ *
+ * OUT:
+ * @a	Activity structure with @nr_ini and @nr2 set.
+ ***************************************************************************
+ */
+void set_item_nr(struct activity *a)
+{
+	switch (a->f_count_index) {
+	case 0:		/* wrap_get_cpu_nr() */
+		a->nr_ini = cfg.cpu_nr + 1;
+		break;
+	case 1:		/* wrap_get_irq_nr() */
+		a->nr_ini = cfg.irq_nr + 1;
+		break;
+	case 3:		/* wrap_get_disk_nr() */
+		a->nr_ini = cfg.disk_nr;
+		break;
+	case 4:		/* wrap_get_iface_nr() */
+		a->nr_ini = cfg.iface_nr;
+		break;
+	case -1:
+	case 11:	/* wrap_detect_psi() */
+		/* Number of items is a constant */
+		break;
+	default:
+		a->nr_ini = cfg.item_nr;
+	}
+	if (a->nr_ini > a->nr_max) {
+		a->nr_ini = a->nr_max;
+	}
+
+	if (a->f_count2) {
+		/* A_PWR_FREQ */
+		a->nr2 = MKSA_FREQ_NR;
+	}
+}
+
+/*
+ ***************************************************************************
+ * Fill the items of an activity with their initial values. long long and
+ * long fields are counters, int fields are constant and unique for each
+ * item (so that e.g. disks have different major/minor numbers), and the
+ * remaining part of the structure begins with an item name.
+ *
+ * IN:
+ * @a	Activity structure.
+ *
+ * OUT:
+ * @a	Activity structure with initialized buffer.
+ ***************************************************************************
+ */
+void init_items(struct activity *a)
+{
+	char *item;
+	unsigned long long ull;
+	unsigned int u;
+	int i, k, off;
+
+	a->nr_allocated = a->nr_ini * a->nr2;
+	SREALLOC(a->_buf0, void, (size_t) a->msize * (size_t) a->nr_allocated);
+	memset(a->_buf0, 0, (size_t) a->msize * (size_t) a->nr_allocated);
+
+	for (i = 0; i < a->nr_allocated; i++) {
+		item = (char *) a->_buf0 + (size_t) i * a->msize;
+		off = 0;
+
+		for (k = 0; k < a->gtypes_nr[0] + a->gtypes_nr[1]; k++) {
+			ull = rnd(1000000);
+			memcpy(item + off, &ull, sizeof(ull));
+			off += ULL_ALIGNMENT_WIDTH;
+		}
+		for (k = 0; k < a->gtypes_nr[2]; k++) {
+			u = i * 8 + k;
+			memcpy(item + off, &u, sizeof(u));
+			off += U_ALIGNMENT_WIDTH;
+		}
+		if (off < a->msize) {
+			snprintf(item + off, a->msize - off, "%s%d",
+				 (a->id == A_NET_DEV) || (a->id == A_NET_EDEV) ? "eth" : "dev",
+				 i / a->nr2);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Update the items of an activity for a new record.
+ *
+ * IN:
+ * @a	Activity structure.
+ *
+ * OUT:
+ * @a	Activity structure with updated buffer.
+ ***************************************************************************
+ */
+void update_items(struct activity *a)
+{
+	char *item;
+	unsigned long long ull;
+	double dbl;
+	int i, k;
+
+	for (i = 0; i < a->nr_allocated; i++) {
+		item = (char *) a->_buf0 + (size_t) i * a->msize;
+
+		for (k = 0; k < a->gtypes_nr[0] + a->gtypes_nr[1]; k++) {
+			if ((a->id == A_PWR_FAN) || (a->id == A_PWR_TEMP) ||
+			    (a->id == A_PWR_IN)) {
+				/* Sensors values are gauges of type double */
+				dbl = 20.0 + rnd(6000) / 100.0;
+				memcpy(item + k * ULL_ALIGNMENT_WIDTH, &dbl, sizeof(dbl));
+			}
+			else {
+				memcpy(&ull, item + k * ULL_ALIGNMENT_WIDTH, sizeof(ull));
+				ull += rnd(10 * cfg.interval * HZ);
+				memcpy(item + k * ULL_ALIGNMENT_WIDTH, &ull, sizeof(ull));
+			}
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Get the description of the structures of an activity as written to
+ * file.
+ *
+ * IN:
+ * @a		Activity structure.
+ *
+ * OUT:
+ * @ftypes_nr	Number of long long, long and int fields in structures.
+ *
+ * RETURNS:
+ * Size of a structure.
+ ***************************************************************************
+ */
+int get_file_item_size(struct activity *a, unsigned int ftypes_nr[])
+{
+	int j;
+
+	for (j = 0; j < 3; j++) {
+		ftypes_nr[j] = a->gtypes_nr[j] + (cfg.extra ? extra_types_nr[j] : 0);
+	}
+
+	return a->fsize + MAP_SIZE(ftypes_nr) - MAP_SIZE(a->gtypes_nr);
+}
+
+/*
+ ***************************************************************************
+ * Write the statistics of an activity for current record.
+ *
+ * IN:
+ * @fp	Data file.
+ * @a	Activity structure.
+ ***************************************************************************
+ */
+void write_items(FILE *fp, struct activity *a)
+{
+	unsigned int ftypes_nr[3];
+	char *item, *oitem;
+	__nr_t nr = a->nr_ini;
+	int i, fsize, len[3];
+
+	if (HAS_COUNT_FUNCTION(a->options) && (a->f_count_index >= 0)) {
+		if (cfg.swap) {
+			nr = __builtin_bswap32(nr);
+		}
+		xwrite(fp, &nr, sizeof(__nr_t));
+	}
+
+	fsize = get_file_item_size(a, ftypes_nr);
+	if ((size_t) fsize * a->nr_allocated > obuf_size) {
+		obuf_size = (size_t) fsize * a->nr_allocated;
+		SREALLOC(obuf, char, obuf_size);
+	}
+	memset(obuf, 0, (size_t) fsize * a->nr_allocated);
+
+	len[0] = a->gtypes_nr[0] * ULL_ALIGNMENT_WIDTH;
+	len[1] = a->gtypes_nr[1] * UL_ALIGNMENT_WIDTH;
+	len[2] = a->gtypes_nr[2] * U_ALIGNMENT_WIDTH;
+
+	for (i = 0; i < a->nr_allocated; i++) {
+		item = (char *) a->_buf0 + (size_t) i * a->msize;
+		oitem = obuf + (size_t) i * fsize;
+
+		/* Each group of fields is followed by the extra fields (set to 0) */
+		memcpy(oitem, item, len[0]);
+		oitem += ftypes_nr[0] * ULL_ALIGNMENT_WIDTH;
+		memcpy(oitem, item + len[0], len[1]);
+		oitem += ftypes_nr[1] * UL_ALIGNMENT_WIDTH;
+		memcpy(oitem, item + len[0] + len[1], len[2]);
+		oitem += ftypes_nr[2] * U_ALIGNMENT_WIDTH;
+		memcpy(oitem, item + MAP_SIZE(a->gtypes_nr), a->fsize - MAP_SIZE(a->gtypes_nr));
+
+		if (cfg.swap) {
+			mksa_swap(ftypes_nr, obuf + (size_t) i * fsize);
+		}
+	}
+
+	xwrite(fp, obuf, (size_t) fsize * a->nr_allocated);
+}
+
+/*
+ ***************************************************************************
+ * Write file magic header, file header and activity list.
+ *
+ * IN:
+ * @fp	Data file.
+ ***************************************************************************
+ */
+void write_file_hdr(FILE *fp)
+{
+	struct file_magic file_magic;
+	struct file_header file_hdr;
+	struct file_activity file_act;
+	unsigned int fm_types_nr[] = {FILE_MAGIC_ULL_NR, FILE_MAGIC_UL_NR, FILE_MAGIC_U_NR};
+	time_t t = (time_t) MKSA_BASE_TIME;
+	struct tm rectime;
+	int i;
+
+	memset(&file_magic, 0, FILE_MAGIC_SIZE);
+	file_magic.sysstat_magic = SYSSTAT_MAGIC;
+	file_magic.format_magic = FORMAT_MAGIC;
+	enum_version_nr(&file_magic);
+	file_magic.header_size = FILE_HEADER_SIZE;
+	for (i = 0; i < 3; i++) {
+		file_magic.hdr_types_nr[i] = hdr_types_nr[i];
+	}
+
+	memset(&file_hdr, 0, FILE_HEADER_SIZE);
+	gmtime_r(&t, &rectime);
+	file_hdr.sa_ust_time = MKSA_BASE_TIME;
+	file_hdr.sa_hz = HZ;
+	file_hdr.sa_cpu_nr = cfg.cpu_nr + 1;
+	file_hdr.sa_act_nr = NR_ACT;
+	file_hdr.sa_year = rectime.tm_year;
+	file_hdr.sa_day = rectime.tm_mday;
+	file_hdr.sa_month = rectime.tm_mon;
+	file_hdr.sa_sizeof_long = sizeof(long);
+	for (i = 0; i < 3; i++) {
+		file_hdr.act_types_nr[i] = act_types_nr[i];
+		file_hdr.rec_types_nr[i] = rec_types_nr[i];
+	}
+	file_hdr.act_size = FILE_ACTIVITY_SIZE;
+	file_hdr.rec_size = RECORD_HEADER_SIZE;
+	strcpy(file_hdr.sa_sysname, "Linux");
+	strcpy(file_hdr.sa_nodename, "mksa");
+	strcpy(file_hdr.sa_release, "1.2.3-BENCH");
+	strcpy(file_hdr.sa_machine, "x86_64");
+	strcpy(file_hdr.sa_tzname, "UTC");
+
+	if (cfg.swap) {
+		file_magic.sysstat_magic = SYSSTAT_MAGIC_SWAPPED;
+		file_magic.format_magic = FORMAT_MAGIC_SWAPPED;
+		mksa_swap(fm_types_nr, &file_magic.header_size);
+		mksa_swap(hdr_types_nr, &file_hdr);
+	}
+	xwrite(fp, &file_magic, FILE_MAGIC_SIZE);
+	xwrite(fp, &file_hdr, FILE_HEADER_SIZE);
+
+	for (i = 0; i < NR_ACT; i++) {
+		memset(&file_act, 0, FILE_ACTIVITY_SIZE);
+		file_act.id = act[i]->id;
+		file_act.magic = act[i]->magic;
+		file_act.nr = act[i]->nr_ini;
+		file_act.nr2 = act[i]->nr2;
+		file_act.size = get_file_item_size(act[i], file_act.types_nr);
+		file_act.has_nr = HAS_COUNT_FUNCTION(act[i]->options);
+
+		if (cfg.swap) {
+			mksa_swap(act_types_nr, &file_act);
+		}
+		xwrite(fp, &file_act, FILE_ACTIVITY_SIZE);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Main entry to the mksa program.
+ ***************************************************************************
+ */
+int main(int argc, char **argv)
+{
+	struct record_header rec_hdr;
+	struct tm rectime;
+	time_t t;
+	FILE *fp;
+	int opt, i, r;
+
+	while ((opt = getopt(argc, argv, "c:d:n:i:m:r:I:S:ex")) != -1) {
+		switch (opt) {
+		case 'c':
+			cfg.cpu_nr = atoi(optarg);
+			break;
+		case 'd':
+			cfg.disk_nr = atoi(optarg);
+			break;
+		case 'n':
+			cfg.iface_nr = atoi(optarg);
+			break;
+		case 'i':
+			cfg.irq_nr = atoi(optarg);
+			break;
+		case 'm':
+			cfg.item_nr = atoi(optarg);
+			break;
+		case 'r':
+			cfg.rec_nr = atoi(optarg);
+			break;
+		case 'I':
+			cfg.interval = atoi(optarg);
+			break;
+		case 'S':
+			cfg.seed = strtoull(optarg, NULL, 10);
+			break;
+		case 'e':
+			cfg.swap = TRUE;
+			break;
+		case 'x':
+			cfg.extra = TRUE;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if ((optind != argc - 1) || (cfg.cpu_nr < 1) || (cfg.disk_nr < 1) ||
+	    (cfg.iface_nr < 1) || (cfg.irq_nr < 1) || (cfg.item_nr < 1) ||
+	    (cfg.rec_nr < 1) || (cfg.interval < 1)) {
+		usage(argv[0]);
+	}
+	if (!cfg.seed) {
+		cfg.seed = 1;
+	}
+
+	HZ = 100;
+
+	for (i = 0; i < NR_ACT; i++) {
+		set_item_nr(act[i]);
+		init_items(act[i]);
+	}
+
+	if ((fp = fopen(argv[optind], "w")) == NULL) {
+		perror(argv[optind]);
+		exit(2);
+	}
+
+	write_file_hdr(fp);
+
+	for (r = 0; r < cfg.rec_nr; r++) {
+		t = (time_t) (MKSA_BASE_TIME + (unsigned long long) r * cfg.interval);
+		gmtime_r(&t, &rectime);
+
+		memset(&rec_hdr, 0, RECORD_HEADER_SIZE);
+		rec_hdr.uptime_cs = (100000ULL + (unsigned long long) r * cfg.interval) * 100;
+		rec_hdr.ust_time = (unsigned long long) t;
+		rec_hdr.record_type = R_STATS;
+		rec_hdr.hour = rectime.tm_hour;
+		rec_hdr.minute = rectime.tm_min;
+		rec_hdr.second = rectime.tm_sec;
+
+		if (cfg.swap) {
+			mksa_swap(rec_types_nr, &rec_hdr);
+		}
+		xwrite(fp, &rec_hdr, RECORD_HEADER_SIZE);
+
+		for (i = 0; i < NR_ACT; i++) {
+			update_items(act[i]);
+			write_items(fp, act[i]);
+		}
+	}
+
+	if (fclose(fp)) {
+		perror("fclose");
+		exit(2);
+	}
+
+	return 0;
+}
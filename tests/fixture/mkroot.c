@@ -0,0 +1,953 @@
+/*
+ * mkroot: Generate synthetic /proc and /sys trees of configurable size.
+ * (C) 2026 by agent (agent <at> local)
+ *
+ ***************************************************************************
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published  by  the *
+ * Free Software Foundation; either version 2 of the License, or (at  your *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it  will  be  useful,  but *
+ * WITHOUT ANY WARRANTY; without the implied warranty  of  MERCHANTABILITY *
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License *
+ * for more details.                                                       *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335 USA              *
+ ***************************************************************************
+ *
+ * sysstat commands compiled in TEST mode (make TFLAGS="-DTEST") read their
+ * data from ./tests/root, a symbolic link to ./tests/root1, and go to
+ * ./tests/root2, ./tests/root3... at each new sample. mkroot creates such
+ * a set of directories for a machine of arbitrary size, e.g.:
+ *
+ *	tests/fixture/mkroot -c 512 -d 10000 -n 20000 -p 1000 -t 100 -s 5 /tmp/big
+ *	cd /tmp/big && /path/to/sysstat/mpstat -P ALL 1 4
+ *
+ * Counters are increased at each sample by pseudo-random amounts. The
+ * generator is seeded (option -S) so that the same trees are generated
+ * for a given set of options. Files whose contents don't change between
+ * samples are hard-linked to those of the first sample.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define MAX_PATH_LEN	1024
+
+/* Number of jiffies per second used for counters in /proc/stat */
+#define HZ		100
+
+/* Number of softirqs listed in /proc/softirqs */
+#define SOFTIRQ_NR	10
+
+/* Number of counters in /proc/net/dev (receive + transmit) */
+#define NETDEV_NR	16
+
+/* Number of counters in /proc/diskstats (after device name) */
+#define DISKSTATS_NR	15
+
+/* Number of counters in /proc/net/softnet_stat used by sysstat */
+#define SOFTNET_NR	5
+
+/* Number of counters in /proc/stat for each CPU */
+#define CPUSTAT_NR	10
+
+/* Machine configuration */
+struct config {
+	int cpu_nr;
+	int node_nr;
+	int disk_nr;
+	int iface_nr;
+	int proc_nr;
+	int thread_nr;		/* Threads per process (including the main one) */
+	int irq_nr;
+	int sample_nr;
+	int interval;		/* Seconds between two samples */
+	unsigned long long seed;
+} cfg = {
+	.cpu_nr		= 4,
+	.node_nr	= 1,
+	.disk_nr	= 4,
+	.iface_nr	= 2,
+	.proc_nr	= 10,
+	.thread_nr	= 1,
+	.irq_nr		= 16,
+	.sample_nr	= 2,
+	.interval	= 1,
+	.seed		= 1
+};
+
+/* Counters kept from one sample to the next one */
+struct task_counters {
+	unsigned long long utime;
+	unsigned long long stime;
+	unsigned long long minflt;
+	unsigned long long majflt;
+	unsigned long long rchar;
+	unsigned long long wchar;
+	unsigned long long read_bytes;
+	unsigned long long write_bytes;
+	unsigned long long nvcsw;
+	unsigned long long nivcsw;
+	unsigned long long rss;
+	unsigned long long run_ns;
+	unsigned long long wait_ns;
+};
+
+unsigned long long *cpu_cnt;		/* [cpu_nr][CPUSTAT_NR] */
+unsigned long long *irq_cnt;		/* [irq_nr][cpu_nr] */
+unsigned long long *softirq_cnt;	/* [SOFTIRQ_NR][cpu_nr] */
+unsigned long long *disk_cnt;		/* [disk_nr][DISKSTATS_NR] */
+unsigned long long *net_cnt;		/* [iface_nr][NETDEV_NR] */
+unsigned long long *softnet_cnt;	/* [cpu_nr][SOFTNET_NR] */
+unsigned long long *freq_cnt;		/* [cpu_nr][3] (time in each P-state) */
+struct task_counters *task_cnt;		/* [proc_nr * thread_nr] */
+unsigned long long ctxt = 0, forks = 0;
+double uptime = 1000.0;
+
+char *softirq_name[SOFTIRQ_NR] = {
+	"HI", "TIMER", "NET_TX", "NET_RX", "BLOCK",
+	"IRQ_POLL", "TASKLET", "SCHED", "HRTIMER", "RCU"
+};
+
+char *proc_comm[] = {
+	"systemd", "sshd", "java", "postgres", "nginx", "qemu-kvm", "python3", "bash"
+};
+#define PROC_COMM_NR	(sizeof(proc_comm) / sizeof(proc_comm[0]))
+
+unsigned int freq_khz[3] = {3000000, 2400000, 1200000};
+
+/* First PID used for generated processes */
+#define FIRST_PID	1000
+
+/*
+ ***************************************************************************
+ * Print usage and exit.
+ *
+ * IN:
+ * @progname	Name of the program.
+ ***************************************************************************
+ */
+void usage(char *progname)
+{
+	fprintf(stderr, "Usage: %s [ options ] <directory>\n"
+		"Options are:\n"
+		"[ -c <cpus> ] [ -N <nodes> ] [ -d <disks> ] [ -n <interfaces> ]\n"
+		"[ -p <processes> ] [ -t <threads_per_process> ] [ -i <interrupts> ]\n"
+		"[ -s <samples> ] [ -I <interval> ] [ -S <seed> ]\n",
+		progname);
+	exit(1);
+}
+
+/*
+ ***************************************************************************
+ * Pseudo-random number generator (xorshift64*). Used instead of rand() so
+ * that generated trees are the same on every system for a given seed.
+ *
+ * IN:
+ * @max		Upper bound (excluded). Must be > 0.
+ *
+ * RETURNS:
+ * A number between 0 and @max - 1.
+ ***************************************************************************
+ */
+unsigned long long rnd(unsigned long long max)
+{
+	cfg.seed ^= cfg.seed >> 12;
+	cfg.seed ^= cfg.seed << 25;
+	cfg.seed ^= cfg.seed >> 27;
+
+	return (cfg.seed * 2685821657736338717ULL) % max;
+}
+
+/*
+ ***************************************************************************
+ * Allocate a zeroed array or exit.
+ *
+ * IN:
+ * @nmemb	Number of elements.
+ * @size	Size of an element.
+ *
+ * RETURNS:
+ * Pointer on the array.
+ ***************************************************************************
+ */
+void *xcalloc(size_t nmemb, size_t size)
+{
+	void *p;
+
+	if ((p = calloc(nmemb ? nmemb : 1, size)) == NULL) {
+		perror("calloc");
+		exit(4);
+	}
+
+	return p;
+}
+
+/*
+ ***************************************************************************
+ * Create a directory (and its parents if needed).
+ *
+ * IN:
+ * @fmt		Format of the directory pathname, followed by its arguments.
+ ***************************************************************************
+ */
+void mkpath(const char *fmt, ...)
+{
+	char path[MAX_PATH_LEN], *p;
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(path, sizeof(path), fmt, args);
+	va_end(args);
+
+	for (p = path + 1; *p; p++) {
+		if (*p == '/') {
+			*p = '\0';
+			if ((mkdir(path, 0755) < 0) && (errno != EEXIST)) {
+				perror(path);
+				exit(2);
+			}
+			*p = '/';
+		}
+	}
+	if ((mkdir(path, 0755) < 0) && (errno != EEXIST)) {
+		perror(path);
+		exit(2);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Create a file.
+ *
+ * IN:
+ * @fmt		Format of the file pathname, followed by its arguments.
+ *
+ * RETURNS:
+ * Pointer on the file, open for writing.
+ ***************************************************************************
+ */
+FILE *wopen(const char *fmt, ...)
+{
+	char path[MAX_PATH_LEN];
+	va_list args;
+	FILE *fp;
+
+	va_start(args, fmt);
+	vsnprintf(path, sizeof(path), fmt, args);
+	va_end(args);
+
+	if ((fp = fopen(path, "w")) == NULL) {
+		perror(path);
+		exit(2);
+	}
+
+	return fp;
+}
+
+/*
+ ***************************************************************************
+ * Close a file created with wopen().
+ *
+ * IN:
+ * @fp		Pointer on the file.
+ ***************************************************************************
+ */
+void wclose(FILE *fp)
+{
+	if (fclose(fp)) {
+		perror("fclose");
+		exit(2);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Hard-link a file from the first sample directory to current one.
+ *
+ * IN:
+ * @dir		Output directory.
+ * @sample	Current sample number (> 1).
+ * @file	File pathname relative to the sample directory.
+ ***************************************************************************
+ */
+void link_static(char *dir, int sample, char *file)
+{
+	char src[MAX_PATH_LEN], dst[MAX_PATH_LEN];
+
+	snprintf(src, sizeof(src), "%s/tests/root1/%s", dir, file);
+	snprintf(dst, sizeof(dst), "%s/tests/root%d/%s", dir, sample, file);
+
+	if (link(src, dst) < 0) {
+		perror(dst);
+		exit(2);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Get name of a disk, using the same scheme as the kernel for SCSI disks
+ * (sda, ..., sdz, sdaa, ...).
+ *
+ * IN:
+ * @i		Disk number.
+ *
+ * OUT:
+ * @name	Disk name.
+ ***************************************************************************
+ */
+void disk_name(int i, char *name)
+{
+	char suffix[8];
+	int n = 0, k;
+
+	do {
+		suffix[n++] = 'a' + i % 26;
+		i = i / 26 - 1;
+	}
+	while (i >= 0);
+
+	name[0] = 's';
+	name[1] = 'd';
+	for (k = 0; k < n; k++) {
+		name[2 + k] = suffix[n - 1 - k];
+	}
+	name[2 + n] = '\0';
+}
+
+/*
+ ***************************************************************************
+ * Increase all the counters to simulate a new interval of time.
+ ***************************************************************************
+ */
+void update_counters(void)
+{
+	int i, j, k, ticks = HZ * cfg.interval;
+	struct task_counters *tc;
+
+	uptime += cfg.interval;
+	ctxt += rnd(10000 * cfg.interval * cfg.cpu_nr) + 1;
+	forks += rnd(50 * cfg.interval) + 1;
+
+	for (i = 0; i < cfg.cpu_nr; i++) {
+		/* Share CPU time between user, nice, system, idle, iowait, irq, softirq, steal */
+		int left = ticks, used;
+
+		for (k = 0; k < 8; k++) {
+			if (k == 3)
+				continue;	/* idle gets what's left */
+			used = rnd(left / 4 + 1);
+			cpu_cnt[i * CPUSTAT_NR + k] += used;
+			left -= used;
+		}
+		cpu_cnt[i * CPUSTAT_NR + 3] += left;
+
+		for (k = 0; k < 3; k++) {
+			freq_cnt[i * 3 + k] += rnd(ticks);
+		}
+
+		/* Processed, dropped, time squeeze, received RPS, flow limit */
+		softnet_cnt[i * SOFTNET_NR] += rnd(10000 * cfg.interval);
+		softnet_cnt[i * SOFTNET_NR + 1] += rnd(2);
+		softnet_cnt[i * SOFTNET_NR + 2] += rnd(5);
+		softnet_cnt[i * SOFTNET_NR + 3] += rnd(100 * cfg.interval);
+		softnet_cnt[i * SOFTNET_NR + 4] += rnd(2);
+	}
+
+	for (i = 0; i < cfg.irq_nr; i++) {
+		/* Most interrupts fire rarely, and not on every CPU */
+		for (j = 0; j < cfg.cpu_nr; j++) {
+			if (rnd(4) == 0) {
+				irq_cnt[i * cfg.cpu_nr + j] += rnd(100 * cfg.interval);
+			}
+		}
+	}
+
+	for (i = 0; i < SOFTIRQ_NR; i++) {
+		for (j = 0; j < cfg.cpu_nr; j++) {
+			softirq_cnt[i * cfg.cpu_nr + j] += rnd(1000 * cfg.interval);
+		}
+	}
+
+	for (i = 0; i < cfg.disk_nr; i++) {
+		unsigned long long *dc = disk_cnt + i * DISKSTATS_NR;
+		unsigned long long rd = rnd(200 * cfg.interval), wr = rnd(200 * cfg.interval);
+
+		dc[0] += rd;				/* reads completed */
+		dc[1] += rnd(rd + 1);			/* reads merged */
+		dc[2] += rd * 8 * (rnd(32) + 1);	/* sectors read */
+		dc[3] += rd * (rnd(10) + 1);		/* ms reading */
+		dc[4] += wr;				/* writes completed */
+		dc[5] += rnd(wr + 1);			/* writes merged */
+		dc[6] += wr * 8 * (rnd(32) + 1);	/* sectors written */
+		dc[7] += wr * (rnd(10) + 1);		/* ms writing */
+		dc[8] = rnd(4);				/* I/Os in progress */
+		dc[9] += rnd(1000 * cfg.interval);	/* ms doing I/Os */
+		dc[10] += dc[3] / 4 + dc[7] / 4;	/* weighted ms doing I/Os */
+		dc[11] += rnd(4);			/* discards completed */
+		dc[13] += dc[11] * 8;			/* sectors discarded */
+		dc[14] += rnd(4);			/* ms discarding */
+	}
+
+	for (i = 0; i < cfg.iface_nr; i++) {
+		unsigned long long *nc = net_cnt + i * NETDEV_NR;
+		unsigned long long rxp = rnd(5000 * cfg.interval), txp = rnd(5000 * cfg.interval);
+
+		nc[0] += rxp * (rnd(1400) + 60);	/* rx bytes */
+		nc[1] += rxp;				/* rx packets */
+		nc[2] += rnd(2);			/* rx errs */
+		nc[3] += rnd(2);			/* rx drop */
+		nc[7] += rnd(10);			/* rx multicast */
+		nc[8] += txp * (rnd(1400) + 60);	/* tx bytes */
+		nc[9] += txp;				/* tx packets */
+		nc[10] += rnd(2);			/* tx errs */
+		nc[11] += rnd(2);			/* tx drop */
+	}
+
+	for (i = 0; i < cfg.proc_nr * cfg.thread_nr; i++) {
+		tc = task_cnt + i;
+		tc->utime += rnd(ticks / 2 + 1);
+		tc->stime += rnd(ticks / 4 + 1);
+		tc->minflt += rnd(1000);
+		tc->majflt += rnd(3);
+		tc->rchar += rnd(1 << 20);
+		tc->wchar += rnd(1 << 20);
+		tc->read_bytes += rnd(256) * 4096;
+		tc->write_bytes += rnd(256) * 4096;
+		tc->nvcsw += rnd(500);
+		tc->nivcsw += rnd(50);
+		tc->rss = 1000 + rnd(100000);
+		tc->run_ns += rnd(1000000000ULL * cfg.interval / 2);
+		tc->wait_ns += rnd(10000000ULL * cfg.interval);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Write files that don't change between samples (only for first sample).
+ *
+ * IN:
+ * @root	Directory of first sample.
+ ***************************************************************************
+ */
+void write_static_files(char *root)
+{
+	FILE *fp;
+	int i, p, t;
+
+	/* /proc/cpuinfo */
+	fp = wopen("%s/proc/cpuinfo", root);
+	for (i = 0; i < cfg.cpu_nr; i++) {
+		fprintf(fp, "processor\t: %d\n"
+			"vendor_id\t: GenuineIntel\n"
+			"model name\t: Synthetic CPU @ 3.00GHz\n"
+			"cpu MHz\t\t: %u.000\n"
+			"physical id\t: %d\n"
+			"core id\t\t: %d\n\n",
+			i, freq_khz[i % 3] / 1000, i * cfg.node_nr / cfg.cpu_nr, i);
+	}
+	wclose(fp);
+
+	/* /proc/meminfo */
+	fp = wopen("%s/proc/meminfo", root);
+	fprintf(fp, "MemTotal:       %llu kB\n"
+		"MemFree:        %llu kB\n"
+		"MemAvailable:   %llu kB\n"
+		"Buffers:          260172 kB\n"
+		"Cached:         %llu kB\n"
+		"SwapCached:            0 kB\n"
+		"Active:         %llu kB\n"
+		"Inactive:       %llu kB\n"
+		"SwapTotal:       8388604 kB\n"
+		"SwapFree:        8388604 kB\n"
+		"Dirty:               128 kB\n"
+		"AnonPages:      %llu kB\n"
+		"Slab:             524288 kB\n"
+		"KernelStack:       16384 kB\n"
+		"PageTables:        65536 kB\n"
+		"Committed_AS:   %llu kB\n"
+		"VmallocUsed:       65536 kB\n",
+		cfg.cpu_nr * 4194304ULL, cfg.cpu_nr * 1048576ULL, cfg.cpu_nr * 2097152ULL,
+		cfg.cpu_nr * 1048576ULL, cfg.cpu_nr * 1572864ULL, cfg.cpu_nr * 524288ULL,
+		cfg.cpu_nr * 1048576ULL, cfg.cpu_nr * 3145728ULL);
+	wclose(fp);
+
+	/* /proc/loadavg */
+	fp = wopen("%s/proc/loadavg", root);
+	fprintf(fp, "%.2f %.2f %.2f 4/%d %d\n", cfg.cpu_nr / 4.0, cfg.cpu_nr / 5.0,
+		cfg.cpu_nr / 6.0, cfg.proc_nr * cfg.thread_nr,
+		FIRST_PID + cfg.proc_nr * cfg.thread_nr);
+	wclose(fp);
+
+	/* Command lines of processes and threads */
+	for (p = 0; p < cfg.proc_nr; p++) {
+		int pid = FIRST_PID + p * cfg.thread_nr;
+
+		fp = wopen("%s/proc/%d/cmdline", root, pid);
+		fprintf(fp, "/usr/bin/%s", proc_comm[p % PROC_COMM_NR]);
+		fputc('\0', fp);
+		fprintf(fp, "--id=%d", p);
+		fputc('\0', fp);
+		wclose(fp);
+
+		for (t = 0; t < cfg.thread_nr; t++) {
+			fp = wopen("%s/proc/%d/task/%d/cmdline", root, pid, pid + t);
+			fprintf(fp, "/usr/bin/%s", proc_comm[p % PROC_COMM_NR]);
+			fputc('\0', fp);
+			wclose(fp);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Create the directories of a sample, and the "_list" files used by
+ * commands compiled in TEST mode to enumerate directories contents.
+ *
+ * IN:
+ * @root	Directory of current sample.
+ ***************************************************************************
+ */
+void write_tree(char *root)
+{
+	FILE *fp, *fpl;
+	char name[16];
+	int i, p, t;
+
+	mkpath("%s/proc/net", root);
+	mkpath("%s/sys/block", root);
+	mkpath("%s/sys/class/net", root);
+	mkpath("%s/sys/devices/system/cpu/cpufreq", root);
+	mkpath("%s/sys/devices/system/node", root);
+
+	/* Processes and threads */
+	fp = wopen("%s/proc/_list", root);
+	for (p = 0; p < cfg.proc_nr; p++) {
+		int pid = FIRST_PID + p * cfg.thread_nr;
+
+		fprintf(fp, "%d\n", pid);
+		mkpath("%s/proc/%d/task", root, pid);
+		fpl = wopen("%s/proc/%d/task/_list", root, pid);
+		for (t = 0; t < cfg.thread_nr; t++) {
+			mkpath("%s/proc/%d/task/%d", root, pid, pid + t);
+			fprintf(fpl, "%d\n", pid + t);
+		}
+		wclose(fpl);
+	}
+	wclose(fp);
+
+	/* CPU topology and nodes */
+	for (i = 0; i < cfg.cpu_nr; i++) {
+		int node = i * cfg.node_nr / cfg.cpu_nr;
+
+		mkpath("%s/sys/devices/system/cpu/cpu%d/node%d", root, i, node);
+		mkpath("%s/sys/devices/system/cpu/cpu%d/topology", root, i);
+		mkpath("%s/sys/devices/system/cpu/cpu%d/cpufreq/stats", root, i);
+
+		fp = wopen("%s/sys/devices/system/cpu/cpu%d/topology/physical_package_id", root, i);
+		fprintf(fp, "%d\n", node);
+		wclose(fp);
+		fp = wopen("%s/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", root, i);
+		fprintf(fp, "%d\n", i);
+		wclose(fp);
+	}
+	for (i = 0; i < cfg.node_nr; i++) {
+		mkpath("%s/sys/devices/system/node/node%d", root, i);
+	}
+
+	/* Block devices */
+	fp = wopen("%s/sys/block/_list", root);
+	fprintf(fp, ".\n..\n");
+	for (i = 0; i < cfg.disk_nr; i++) {
+		disk_name(i, name);
+		fprintf(fp, "%s\n", name);
+		mkpath("%s/sys/block/%s/device", root, name);
+		fpl = wopen("%s/sys/block/%s/_list", root, name);
+		fprintf(fpl, ".\n..\ndevice\nstat\n");
+		wclose(fpl);
+	}
+	wclose(fp);
+
+	/* Network interfaces */
+	for (i = 0; i < cfg.iface_nr; i++) {
+		mkpath("%s/sys/class/net/eth%d", root, i);
+		fp = wopen("%s/sys/class/net/eth%d/speed", root, i);
+		fprintf(fp, "10000\n");
+		wclose(fp);
+		fp = wopen("%s/sys/class/net/eth%d/duplex", root, i);
+		fprintf(fp, "full\n");
+		wclose(fp);
+	}
+}
+
+/*
+ ***************************************************************************
+ * Write files containing counters for current sample.
+ *
+ * IN:
+ * @root	Directory of current sample.
+ ***************************************************************************
+ */
+void write_counters(char *root)
+{
+	FILE *fp;
+	char name[16];
+	int i, j, k, p, t;
+	unsigned long long tot[CPUSTAT_NR], sum, idle = 0;
+
+	/* /proc/stat */
+	fp = wopen("%s/proc/stat", root);
+	memset(tot, 0, sizeof(tot));
+	for (i = 0; i < cfg.cpu_nr; i++) {
+		for (k = 0; k < CPUSTAT_NR; k++) {
+			tot[k] += cpu_cnt[i * CPUSTAT_NR + k];
+		}
+	}
+	fprintf(fp, "cpu ");
+	for (k = 0; k < CPUSTAT_NR; k++) {
+		fprintf(fp, " %llu", tot[k]);
+	}
+	fprintf(fp, "\n");
+	for (i = 0; i < cfg.cpu_nr; i++) {
+		fprintf(fp, "cpu%d", i);
+		for (k = 0; k < CPUSTAT_NR; k++) {
+			fprintf(fp, " %llu", cpu_cnt[i * CPUSTAT_NR + k]);
+		}
+		fprintf(fp, "\n");
+		idle += cpu_cnt[i * CPUSTAT_NR + 3];
+	}
+	sum = 0;
+	for (i = 0; i < cfg.irq_nr * cfg.cpu_nr; i++) {
+		sum += irq_cnt[i];
+	}
+	fprintf(fp, "intr %llu", sum);
+	for (i = 0; i < cfg.irq_nr; i++) {
+		unsigned long long s = 0;
+
+		for (j = 0; j < cfg.cpu_nr; j++) {
+			s += irq_cnt[i * cfg.cpu_nr + j];
+		}
+		fprintf(fp, " %llu", s);
+	}
+	fprintf(fp, "\nctxt %llu\nbtime 1555568347\nprocesses %llu\n"
+		"procs_running %d\nprocs_blocked %d\n",
+		ctxt, forks, (int) rnd(cfg.cpu_nr) + 1, (int) rnd(4));
+	sum = 0;
+	for (i = 0; i < SOFTIRQ_NR * cfg.cpu_nr; i++) {
+		sum += softirq_cnt[i];
+	}
+	fprintf(fp, "softirq %llu", sum);
+	for (i = 0; i < SOFTIRQ_NR; i++) {
+		unsigned long long s = 0;
+
+		for (j = 0; j < cfg.cpu_nr; j++) {
+			s += softirq_cnt[i * cfg.cpu_nr + j];
+		}
+		fprintf(fp, " %llu", s);
+	}
+	fprintf(fp, "\n");
+	wclose(fp);
+
+	/* /proc/uptime */
+	fp = wopen("%s/proc/uptime", root);
+	fprintf(fp, "%.2f %.2f\n", uptime, (double) idle / HZ);
+	wclose(fp);
+
+	/* /proc/interrupts (same layout as the kernel) */
+	fp = wopen("%s/proc/interrupts", root);
+	fprintf(fp, "%*s", 3 + 8, "");
+	for (j = 0; j < cfg.cpu_nr; j++) {
+		fprintf(fp, "CPU%-8d", j);
+	}
+	fprintf(fp, "\n");
+	for (i = 0; i < cfg.irq_nr; i++) {
+		fprintf(fp, "%3d:", i);
+		for (j = 0; j < cfg.cpu_nr; j++) {
+			fprintf(fp, " %10llu", irq_cnt[i * cfg.cpu_nr + j]);
+		}
+		fprintf(fp, "  IR-PCI-MSI %d-edge      dev%d\n", i, i);
+	}
+	wclose(fp);
+
+	/* /proc/softirqs */
+	fp = wopen("%s/proc/softirqs", root);
+	fprintf(fp, "%20s", "");
+	for (j = 0; j < cfg.cpu_nr; j++) {
+		fprintf(fp, "CPU%-8d", j);
+	}
+	fprintf(fp, "\n");
+	for (i = 0; i < SOFTIRQ_NR; i++) {
+		fprintf(fp, "%12s:", softirq_name[i]);
+		for (j = 0; j < cfg.cpu_nr; j++) {
+			fprintf(fp, " %10llu", softirq_cnt[i * cfg.cpu_nr + j]);
+		}
+		fprintf(fp, "\n");
+	}
+	wclose(fp);
+
+	/* /proc/diskstats and /sys/block/<disk>/stat */
+	fp = wopen("%s/proc/diskstats", root);
+	for (i = 0; i < cfg.disk_nr; i++) {
+		unsigned long long *dc = disk_cnt + i * DISKSTATS_NR;
+		FILE *fps;
+
+		disk_name(i, name);
+		fprintf(fp, "%4d %7d %s", 8, i * 16, name);
+		fps = wopen("%s/sys/block/%s/stat", root, name);
+		for (k = 0; k < DISKSTATS_NR; k++) {
+			fprintf(fp, " %llu", dc[k]);
+			fprintf(fps, " %8llu", dc[k]);
+		}
+		fprintf(fp, "\n");
+		fprintf(fps, "\n");
+		wclose(fps);
+	}
+	wclose(fp);
+
+	/* /proc/net/dev */
+	fp = wopen("%s/proc/net/dev", root);
+	fprintf(fp, "Inter-|   Receive                                                |  Transmit\n"
+		" face |bytes    packets errs drop fifo frame compressed multicast|"
+		"bytes    packets errs drop fifo colls carrier compressed\n");
+	for (i = 0; i < cfg.iface_nr; i++) {
+		unsigned long long *nc = net_cnt + i * NETDEV_NR;
+
+		snprintf(name, sizeof(name), "eth%d", i);
+		fprintf(fp, "%6s:%8llu %7llu %4llu %4llu %4llu %5llu %10llu %9llu "
+			"%8llu %7llu %4llu %4llu %4llu %5llu %7llu %10llu\n",
+			name, nc[0], nc[1], nc[2], nc[3], nc[4], nc[5], nc[6], nc[7],
+			nc[8], nc[9], nc[10], nc[11], nc[12], nc[13], nc[14], nc[15]);
+	}
+	wclose(fp);
+
+	/* /proc/net/softnet_stat (counters are 32-bit hexadecimal values) */
+	fp = wopen("%s/proc/net/softnet_stat", root);
+	for (i = 0; i < cfg.cpu_nr; i++) {
+		unsigned long long *sc = softnet_cnt + i * SOFTNET_NR;
+
+		fprintf(fp, "%08x %08x %08x 00000000 00000000 00000000 00000000 "
+			"00000000 00000000 %08x %08x %08x 00000000\n",
+			(unsigned int) sc[0], (unsigned int) sc[1], (unsigned int) sc[2],
+			(unsigned int) sc[3], (unsigned int) sc[4], i);
+	}
+	wclose(fp);
+
+	/* CPU frequency statistics */
+	for (i = 0; i < cfg.cpu_nr; i++) {
+		fp = wopen("%s/sys/devices/system/cpu/cpu%d/cpufreq/stats/time_in_state", root, i);
+		for (k = 0; k < 3; k++) {
+			fprintf(fp, "%u %llu\n", freq_khz[k], freq_cnt[i * 3 + k]);
+		}
+		wclose(fp);
+	}
+
+	/* Processes and threads */
+	for (p = 0; p < cfg.proc_nr; p++) {
+		int pid = FIRST_PID + p * cfg.thread_nr;
+		char *comm = proc_comm[p % PROC_COMM_NR];
+		struct task_counters pc;
+
+		/* Process counters are the sum of its threads counters */
+		memset(&pc, 0, sizeof(pc));
+		for (t = 0; t < cfg.thread_nr; t++) {
+			struct task_counters *tc = task_cnt + p * cfg.thread_nr + t;
+
+			pc.utime += tc->utime;
+			pc.stime += tc->stime;
+			pc.minflt += tc->minflt;
+			pc.majflt += tc->majflt;
+			pc.rchar += tc->rchar;
+			pc.wchar += tc->wchar;
+			pc.read_bytes += tc->read_bytes;
+			pc.write_bytes += tc->write_bytes;
+			pc.nvcsw += tc->nvcsw;
+			pc.nivcsw += tc->nivcsw;
+			pc.run_ns += tc->run_ns;
+			pc.wait_ns += tc->wait_ns;
+		}
+		pc.rss = task_cnt[p * cfg.thread_nr].rss;
+
+		for (t = -1; t < cfg.thread_nr; t++) {
+			struct task_counters *tc = (t < 0) ? &pc : task_cnt + p * cfg.thread_nr + t;
+			char dir[MAX_PATH_LEN];
+
+			if (t < 0) {
+				snprintf(dir, sizeof(dir), "%s/proc/%d", root, pid);
+			}
+			else {
+				snprintf(dir, sizeof(dir), "%s/proc/%d/task/%d", root, pid, pid + t);
+			}
+
+			fp = wopen("%s/stat", dir);
+			fprintf(fp, "%d (%s) S 1 %d %d 0 -1 4194560 %llu 0 %llu 0 %llu %llu 0 0 "
+				"20 0 %d 0 %d %llu %llu 18446744073709551615 1 1 0 0 0 0 0 "
+				"4096 0 0 0 0 17 %d 0 0 %llu 0 0\n",
+				(t < 0) ? pid : pid + t, comm, pid, pid,
+				tc->minflt, tc->majflt, tc->utime, tc->stime,
+				cfg.thread_nr, 1000 + p, (tc->rss + 10000) * 4096, tc->rss,
+				(p + t + 1) % cfg.cpu_nr, tc->wait_ns / 10000000);
+			wclose(fp);
+
+			fp = wopen("%s/status", dir);
+			fprintf(fp, "Name:\t%s\nUmask:\t0022\nState:\tS (sleeping)\n"
+				"Tgid:\t%d\nPid:\t%d\nPPid:\t1\nUid:\t%d\t%d\t%d\t%d\n"
+				"Gid:\t%d\t%d\t%d\t%d\nVmSize:\t%8llu kB\nVmRSS:\t%8llu kB\n"
+				"VmStk:\t     136 kB\nThreads:\t%d\n"
+				"voluntary_ctxt_switches:\t%llu\n"
+				"nonvoluntary_ctxt_switches:\t%llu\n",
+				comm, pid, (t < 0) ? pid : pid + t,
+				p % 3 * 1000, p % 3 * 1000, p % 3 * 1000, p % 3 * 1000,
+				p % 3 * 1000, p % 3 * 1000, p % 3 * 1000, p % 3 * 1000,
+				(tc->rss + 10000) * 4, tc->rss * 4, cfg.thread_nr,
+				tc->nvcsw, tc->nivcsw);
+			wclose(fp);
+
+			fp = wopen("%s/io", dir);
+			fprintf(fp, "rchar: %llu\nwchar: %llu\nsyscr: %llu\nsyscw: %llu\n"
+				"read_bytes: %llu\nwrite_bytes: %llu\ncancelled_write_bytes: 0\n",
+				tc->rchar, tc->wchar, tc->rchar / 4096, tc->wchar / 4096,
+				tc->read_bytes, tc->write_bytes);
+			wclose(fp);
+
+			fp = wopen("%s/schedstat", dir);
+			fprintf(fp, "%llu %llu %llu\n", tc->run_ns, tc->wait_ns, tc->nvcsw + tc->nivcsw);
+			wclose(fp);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Hard-link files that don't change from first sample to current one.
+ *
+ * IN:
+ * @dir		Output directory.
+ * @sample	Current sample number (> 1).
+ ***************************************************************************
+ */
+void link_static_files(char *dir, int sample)
+{
+	char file[MAX_PATH_LEN];
+	int p, t;
+
+	link_static(dir, sample, "proc/cpuinfo");
+	link_static(dir, sample, "proc/meminfo");
+	link_static(dir, sample, "proc/loadavg");
+
+	for (p = 0; p < cfg.proc_nr; p++) {
+		int pid = FIRST_PID + p * cfg.thread_nr;
+
+		snprintf(file, sizeof(file), "proc/%d/cmdline", pid);
+		link_static(dir, sample, file);
+		for (t = 0; t < cfg.thread_nr; t++) {
+			snprintf(file, sizeof(file), "proc/%d/task/%d/cmdline", pid, pid + t);
+			link_static(dir, sample, file);
+		}
+	}
+}
+
+/*
+ ***************************************************************************
+ * Main entry to the mkroot program.
+ ***************************************************************************
+ */
+int main(int argc, char **argv)
+{
+	char root[MAX_PATH_LEN], *dir;
+	int opt, s;
+
+	while ((opt = getopt(argc, argv, "c:N:d:n:p:t:i:s:I:S:")) != -1) {
+		switch (opt) {
+		case 'c':
+			cfg.cpu_nr = atoi(optarg);
+			break;
+		case 'N':
+			cfg.node_nr = atoi(optarg);
+			break;
+		case 'd':
+			cfg.disk_nr = atoi(optarg);
+			break;
+		case 'n':
+			cfg.iface_nr = atoi(optarg);
+			break;
+		case 'p':
+			cfg.proc_nr = atoi(optarg);
+			break;
+		case 't':
+			cfg.thread_nr = atoi(optarg);
+			break;
+		case 'i':
+			cfg.irq_nr = atoi(optarg);
+			break;
+		case 's':
+			cfg.sample_nr = atoi(optarg);
+			break;
+		case 'I':
+			cfg.interval = atoi(optarg);
+			break;
+		case 'S':
+			cfg.seed = strtoull(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if ((optind != argc - 1) || (cfg.cpu_nr < 1) || (cfg.node_nr < 1) ||
+	    (cfg.node_nr > cfg.cpu_nr) || (cfg.disk_nr < 0) || (cfg.iface_nr < 0) ||
+	    (cfg.proc_nr < 0) || (cfg.thread_nr < 1) || (cfg.irq_nr < 0) ||
+	    (cfg.sample_nr < 1) || (cfg.interval < 1)) {
+		usage(argv[0]);
+	}
+	dir = argv[optind];
+	if (!cfg.seed) {
+		/* xorshift generator must not be seeded with 0 */
+		cfg.seed = 1;
+	}
+
+	cpu_cnt = xcalloc(cfg.cpu_nr * CPUSTAT_NR, sizeof(unsigned long long));
+	irq_cnt = xcalloc(cfg.irq_nr * cfg.cpu_nr, sizeof(unsigned long long));
+	softirq_cnt = xcalloc(SOFTIRQ_NR * cfg.cpu_nr, sizeof(unsigned long long));
+	disk_cnt = xcalloc(cfg.disk_nr * DISKSTATS_NR, sizeof(unsigned long long));
+	net_cnt = xcalloc(cfg.iface_nr * NETDEV_NR, sizeof(unsigned long long));
+	softnet_cnt = xcalloc(cfg.cpu_nr * SOFTNET_NR, sizeof(unsigned long long));
+	freq_cnt = xcalloc(cfg.cpu_nr * 3, sizeof(unsigned long long));
+	task_cnt = xcalloc(cfg.proc_nr * cfg.thread_nr, sizeof(struct task_counters));
+
+	for (s = 1; s <= cfg.sample_nr; s++) {
+		snprintf(root, sizeof(root), "%s/tests/root%d", dir, s);
+		if (access(root, F_OK) == 0) {
+			fprintf(stderr, "%s already exists\n", root);
+			exit(2);
+		}
+
+		update_counters();
+		write_tree(root);
+		if (s == 1) {
+			write_static_files(root);
+		}
+		else {
+			link_static_files(dir, s);
+		}
+		write_counters(root);
+	}
+
+	/* Commands start reading from first sample */
+	snprintf(root, sizeof(root), "%s/tests/root", dir);
+	unlink(root);
+	if (symlink("root1", root) < 0) {
+		perror(root);
+		exit(2);
+	}
+
+	return 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * sysstat: System performance tools for Linux
+ * (C) 1999-2021 by Sebastien Godard (sysstat <at> orange.fr)
+ */
+
+#ifndef _VERSION_H
+#define _VERSION_H
+
+#ifndef TEST
+/* sysstat version number */
+#define VERSION	"12.5.4"
+#else
+#define VERSION "99.9.9"
+#endif	/* TEST */
+
+#endif  /* _VERSION_H */